@@ -0,0 +1,319 @@
+#include "Fr3File.h"
+
+#include <atomic>
+
+#include "common/util/Assert.h"
+#include "common/util/SimpleThreadGroup.h"
+#include "common/util/compress.h"
+
+#include "fmt/core.h"
+
+namespace tfrag3 {
+
+namespace {
+constexpr u32 FR3_MAGIC = 0x43335246;  // "FR3C"
+// change this if the layout of the file or its chunks changes.
+constexpr u32 FR3_FORMAT_VERSION = 1;
+constexpr size_t FR3_CHUNK_ALIGN = 16;
+// textures are grouped into chunks of about this size, so they can be loaded in parallel.
+constexpr size_t FR3_TEXTURE_CHUNK_SIZE = 1024 * 1024;
+
+struct ChunkData {
+  Fr3ChunkEntry entry;
+  std::vector<u8> data;
+};
+
+struct LevelCounts {
+  size_t textures = 0;
+  size_t index_textures = 0;
+  std::array<size_t, TFRAG_GEOS> tfrag_trees;
+  std::array<size_t, TIE_GEOS> tie_trees;
+  size_t shrub_trees = 0;
+};
+
+void serialize_header(Serializer& ser, Level& level, LevelCounts& counts) {
+  ser.from_str(&level.level_name);
+  ser.from_ptr(&counts.textures);
+  ser.from_ptr(&counts.index_textures);
+  ser.from_ptr(&counts.tfrag_trees);
+  ser.from_ptr(&counts.tie_trees);
+  ser.from_ptr(&counts.shrub_trees);
+}
+
+ChunkData make_chunk(Fr3ChunkKind kind, u32 index, u32 first, u32 count, Serializer& ser) {
+  ChunkData result;
+  auto [data, size] = ser.get_save_result();
+  result.entry.kind = (u32)kind;
+  result.entry.index = index;
+  result.entry.first = first;
+  result.entry.count = count;
+  result.entry.size = size;
+  result.entry.pad = 0;
+
+  auto compressed = compression::compress_zstd_no_header(data, size);
+  if (compressed.size() < size) {
+    result.data = std::move(compressed);
+    result.entry.compressed = 1;
+  } else {
+    result.data.assign(data, data + size);
+    result.entry.compressed = 0;
+  }
+  result.entry.stored_size = result.data.size();
+  return result;
+}
+
+template <typename T>
+void add_tree_chunks(std::vector<ChunkData>& chunks,
+                     Fr3ChunkKind kind,
+                     u32 geom,
+                     std::vector<T>& trees) {
+  for (u32 i = 0; i < trees.size(); i++) {
+    Serializer ser;
+    trees[i].serialize(ser);
+    chunks.push_back(make_chunk(kind, geom, i, 1, ser));
+  }
+}
+
+size_t align_chunk(size_t offset) {
+  return (offset + FR3_CHUNK_ALIGN - 1) & ~(FR3_CHUNK_ALIGN - 1);
+}
+}  // namespace
+
+/*!
+ * Split a level into chunks, and compress them.
+ */
+Fr3WriteResult write_fr3(Level& level) {
+  std::vector<ChunkData> chunks;
+
+  {
+    LevelCounts counts;
+    counts.textures = level.textures.size();
+    counts.index_textures = level.index_textures.size();
+    for (int geom = 0; geom < TFRAG_GEOS; geom++) {
+      counts.tfrag_trees[geom] = level.tfrag_trees[geom].size();
+    }
+    for (int geom = 0; geom < TIE_GEOS; geom++) {
+      counts.tie_trees[geom] = level.tie_trees[geom].size();
+    }
+    counts.shrub_trees = level.shrub_trees.size();
+    Serializer ser;
+    serialize_header(ser, level, counts);
+    chunks.push_back(make_chunk(Fr3ChunkKind::HEADER, 0, 0, 0, ser));
+  }
+
+  for (u32 first = 0; first < level.textures.size();) {
+    Serializer ser;
+    u32 count = 0;
+    while (first + count < level.textures.size() &&
+           ser.get_save_result().second < FR3_TEXTURE_CHUNK_SIZE) {
+      level.textures[first + count].serialize(ser);
+      count++;
+    }
+    chunks.push_back(make_chunk(Fr3ChunkKind::TEXTURES, 0, first, count, ser));
+    first += count;
+  }
+
+  {
+    Serializer ser;
+    for (auto& tex : level.index_textures) {
+      tex.serialize(ser);
+    }
+    chunks.push_back(
+        make_chunk(Fr3ChunkKind::INDEX_TEXTURES, 0, 0, level.index_textures.size(), ser));
+  }
+
+  for (u32 geom = 0; geom < TFRAG_GEOS; geom++) {
+    add_tree_chunks(chunks, Fr3ChunkKind::TFRAG_TREE, geom, level.tfrag_trees[geom]);
+  }
+  for (u32 geom = 0; geom < TIE_GEOS; geom++) {
+    add_tree_chunks(chunks, Fr3ChunkKind::TIE_TREE, geom, level.tie_trees[geom]);
+  }
+  add_tree_chunks(chunks, Fr3ChunkKind::SHRUB_TREE, 0, level.shrub_trees);
+
+  {
+    Serializer ser;
+    level.hfrag.serialize(ser);
+    chunks.push_back(make_chunk(Fr3ChunkKind::HFRAG, 0, 0, 1, ser));
+  }
+  {
+    Serializer ser;
+    level.collision.serialize(ser);
+    chunks.push_back(make_chunk(Fr3ChunkKind::COLLISION, 0, 0, 1, ser));
+  }
+  {
+    Serializer ser;
+    level.merc_data.serialize(ser);
+    chunks.push_back(make_chunk(Fr3ChunkKind::MERC, 0, 0, 1, ser));
+  }
+
+  // lay out the file: header, table of contents, then the aligned chunks.
+  Fr3WriteResult result;
+  size_t offset = align_chunk(sizeof(Fr3FileHeader) + chunks.size() * sizeof(Fr3ChunkEntry));
+  for (auto& chunk : chunks) {
+    chunk.entry.offset = offset;
+    offset = align_chunk(offset + chunk.data.size());
+    result.uncompressed_size += chunk.entry.size;
+  }
+  result.data.resize(offset);
+
+  Fr3FileHeader header;
+  header.magic = FR3_MAGIC;
+  header.format_version = FR3_FORMAT_VERSION;
+  header.tfrag3_version = TFRAG3_VERSION;
+  header.num_chunks = chunks.size();
+  memcpy(result.data.data(), &header, sizeof(Fr3FileHeader));
+  for (size_t i = 0; i < chunks.size(); i++) {
+    memcpy(result.data.data() + sizeof(Fr3FileHeader) + i * sizeof(Fr3ChunkEntry),
+           &chunks[i].entry, sizeof(Fr3ChunkEntry));
+    memcpy(result.data.data() + chunks[i].entry.offset, chunks[i].data.data(),
+           chunks[i].data.size());
+  }
+  return result;
+}
+
+Fr3Reader::Fr3Reader(const fs::path& path) : m_file(path) {
+  auto data = m_file.data();
+  Fr3FileHeader header;
+  if (data.size() < sizeof(Fr3FileHeader)) {
+    return;
+  }
+  memcpy(&header, data.data(), sizeof(Fr3FileHeader));
+  if (header.magic != FR3_MAGIC) {
+    return;  // an older file, which is a single compressed Level.
+  }
+
+  ASSERT_MSG(header.format_version == FR3_FORMAT_VERSION,
+             fmt::format("{} has fr3 format version {}, expected {}", path.string(),
+                         header.format_version, FR3_FORMAT_VERSION));
+  ASSERT_MSG(header.tfrag3_version == TFRAG3_VERSION,
+             fmt::format("version mismatch when loading tfrag3 data. Got {}, expected {}, "
+                         "did you forget to re-decompile?",
+                         header.tfrag3_version, TFRAG3_VERSION));
+  ASSERT(data.size() >= sizeof(Fr3FileHeader) + header.num_chunks * sizeof(Fr3ChunkEntry));
+  m_chunks.resize(header.num_chunks);
+  memcpy(m_chunks.data(), data.data() + sizeof(Fr3FileHeader),
+         header.num_chunks * sizeof(Fr3ChunkEntry));
+  for (auto& chunk : m_chunks) {
+    ASSERT(chunk.offset + chunk.stored_size <= data.size());
+  }
+  ASSERT(!m_chunks.empty() && m_chunks[0].kind == (u32)Fr3ChunkKind::HEADER);
+  m_chunked = true;
+}
+
+/*!
+ * Get the contents of a chunk. Uncompressed chunks are read straight from the mapping, and
+ * compressed ones are decompressed into buffer.
+ */
+const u8* Fr3Reader::chunk_data(const Fr3ChunkEntry& chunk, std::vector<u8>* buffer) const {
+  const u8* data = m_file.data().data() + chunk.offset;
+  if (!chunk.compressed) {
+    return data;
+  }
+  buffer->resize(chunk.size);
+  compression::decompress_zstd_no_header(data, chunk.stored_size, buffer->data(), buffer->size());
+  return buffer->data();
+}
+
+void Fr3Reader::read_chunk(const Fr3ChunkEntry& chunk, Level* level) {
+  std::vector<u8> buffer;
+  Serializer ser(chunk_data(chunk, &buffer), chunk.size, Serializer::View());
+
+  switch ((Fr3ChunkKind)chunk.kind) {
+    case Fr3ChunkKind::TEXTURES:
+      ASSERT(chunk.first + chunk.count <= level->textures.size());
+      for (u32 i = 0; i < chunk.count; i++) {
+        level->textures[chunk.first + i].serialize(ser);
+      }
+      break;
+    case Fr3ChunkKind::INDEX_TEXTURES:
+      ASSERT(chunk.count == level->index_textures.size());
+      for (auto& tex : level->index_textures) {
+        tex.serialize(ser);
+      }
+      break;
+    case Fr3ChunkKind::TFRAG_TREE:
+      level->tfrag_trees.at(chunk.index).at(chunk.first).serialize(ser);
+      break;
+    case Fr3ChunkKind::TIE_TREE:
+      level->tie_trees.at(chunk.index).at(chunk.first).serialize(ser);
+      break;
+    case Fr3ChunkKind::SHRUB_TREE:
+      level->shrub_trees.at(chunk.first).serialize(ser);
+      break;
+    case Fr3ChunkKind::HFRAG:
+      level->hfrag.serialize(ser);
+      break;
+    case Fr3ChunkKind::COLLISION:
+      level->collision.serialize(ser);
+      break;
+    case Fr3ChunkKind::MERC:
+      level->merc_data.serialize(ser);
+      break;
+    default:
+      ASSERT_MSG(false, fmt::format("unknown fr3 chunk kind {}", chunk.kind));
+  }
+  ASSERT(ser.get_load_finished());
+}
+
+/*!
+ * Load the parts of the level selected by chunk_mask. The header is always loaded, so the level
+ * will have the right number of textures and trees, even if they aren't loaded.
+ * Older files can only be loaded completely.
+ */
+void Fr3Reader::read(Level* level, u32 chunk_mask, int num_threads) {
+  auto data = m_file.data();
+  if (!m_chunked) {
+    auto decompressed = compression::decompress_zstd(data.data(), data.size());
+    Serializer ser(decompressed.data(), decompressed.size(), Serializer::View());
+    level->serialize(ser);
+    return;
+  }
+
+  {
+    std::vector<u8> buffer;
+    Serializer ser(chunk_data(m_chunks[0], &buffer), m_chunks[0].size, Serializer::View());
+    LevelCounts counts;
+    serialize_header(ser, *level, counts);
+    ASSERT(ser.get_load_finished());
+    level->version = TFRAG3_VERSION;
+    level->version2 = TFRAG3_VERSION;
+    level->textures.resize(counts.textures);
+    level->index_textures.resize(counts.index_textures);
+    for (int geom = 0; geom < TFRAG_GEOS; geom++) {
+      level->tfrag_trees[geom].resize(counts.tfrag_trees[geom]);
+    }
+    for (int geom = 0; geom < TIE_GEOS; geom++) {
+      level->tie_trees[geom].resize(counts.tie_trees[geom]);
+    }
+    level->shrub_trees.resize(counts.shrub_trees);
+  }
+
+  std::vector<const Fr3ChunkEntry*> to_read;
+  for (size_t i = 1; i < m_chunks.size(); i++) {
+    if (chunk_mask & fr3_chunk_bit((Fr3ChunkKind)m_chunks[i].kind)) {
+      to_read.push_back(&m_chunks[i]);
+    }
+  }
+
+  // each chunk fills in different parts of the level, so they can be read in any order.
+  num_threads = std::min(num_threads, (int)to_read.size());
+  if (num_threads <= 1) {
+    for (auto* chunk : to_read) {
+      read_chunk(*chunk, level);
+    }
+  } else {
+    // chunks vary a lot in size, so workers take the next chunk when they're done with one.
+    std::atomic<size_t> next_chunk = 0;
+    SimpleThreadGroup threads;
+    threads.run(
+        [&](int) {
+          for (size_t i = next_chunk++; i < to_read.size(); i = next_chunk++) {
+            read_chunk(*to_read[i], level);
+          }
+        },
+        num_threads, num_threads);
+    threads.join();
+  }
+}
+
+}  // namespace tfrag3
@@ -0,0 +1,82 @@
+#pragma once
+
+/*!
+ * @file Fr3File.h
+ * The .fr3 file format, which stores a tfrag3::Level for the PC renderer.
+ *
+ * The level is split into chunks: a header, blocks of textures, one chunk per tfrag/tie/shrub tree,
+ * and one for each of the remaining parts. Each chunk is compressed on its own, and a table of
+ * contents at the start of the file gives their locations. The file is memory mapped and loaded
+ * one chunk at a time, so the whole file never has to be read and decompressed into memory at
+ * once. Chunks can be loaded in parallel, and a reader can skip the parts of the level it doesn't
+ * need.
+ *
+ * Older files, which are a single zstd compressed Level::serialize, can still be read.
+ */
+
+#include "common/custom_data/Tfrag3Data.h"
+#include "common/util/FileUtil.h"
+#include "common/util/MappedFile.h"
+
+namespace tfrag3 {
+
+enum class Fr3ChunkKind : u32 {
+  HEADER = 0,          // level name and the number of textures and trees
+  TEXTURES = 1,        // a block of consecutive textures
+  INDEX_TEXTURES = 2,  // all index textures
+  TFRAG_TREE = 3,      // a single tfrag tree
+  TIE_TREE = 4,        // a single tie tree
+  SHRUB_TREE = 5,      // a single shrub tree
+  HFRAG = 6,
+  COLLISION = 7,
+  MERC = 8,
+};
+
+constexpr u32 fr3_chunk_bit(Fr3ChunkKind kind) {
+  return 1u << (u32)kind;
+}
+constexpr u32 FR3_ALL_CHUNKS = UINT32_MAX;
+
+struct Fr3FileHeader {
+  u32 magic;
+  u32 format_version;
+  u32 tfrag3_version;
+  u32 num_chunks;
+};
+
+struct Fr3ChunkEntry {
+  u32 kind;
+  u32 index;  // for trees, the geometry index.
+  u32 first;  // for textures and trees, the index of the first one in the chunk
+  u32 count;
+  u64 offset;       // from the start of the file
+  u64 stored_size;  // size in the file
+  u64 size;         // size after decompressing
+  u32 compressed;
+  u32 pad;
+};
+static_assert(sizeof(Fr3ChunkEntry) == 48);
+
+struct Fr3WriteResult {
+  std::vector<u8> data;
+  size_t uncompressed_size = 0;
+};
+
+Fr3WriteResult write_fr3(Level& level);
+
+class Fr3Reader {
+ public:
+  explicit Fr3Reader(const fs::path& path);
+  void read(Level* level, u32 chunk_mask = FR3_ALL_CHUNKS, int num_threads = 1);
+  size_t file_size() const { return m_file.size(); }
+
+ private:
+  const u8* chunk_data(const Fr3ChunkEntry& chunk, std::vector<u8>* buffer) const;
+  void read_chunk(const Fr3ChunkEntry& chunk, Level* level);
+
+  MappedFile m_file;
+  bool m_chunked = false;
+  std::vector<Fr3ChunkEntry> m_chunks;
+};
+
+}  // namespace tfrag3
@@ -0,0 +1,98 @@
+#include "dma_capture.h"
+
+#include <cstring>
+
+#include "common/util/Assert.h"
+#include "common/util/Serializer.h"
+#include "common/util/compress.h"
+
+#include "fmt/core.h"
+
+namespace {
+constexpr u32 DMA_CAPTURE_MAGIC = 0x50434d44;  // "DMCP"
+// change this if the layout of the capture changes.
+constexpr u32 DMA_CAPTURE_VERSION = 1;
+
+bool chunk_is_zero(const u8* data) {
+  const u64* words = (const u64*)data;
+  for (u32 i = 0; i < DmaCapture::CHUNK_SIZE / sizeof(u64); i++) {
+    if (words[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void serialize_capture(Serializer& ser, DmaCapture& capture) {
+  ser.from_ptr(&capture.version);
+  ser.from_ptr(&capture.chain_offset);
+  ser.from_ptr(&capture.s7_offset);
+  ser.from_ptr(&capture.pmode_alp);
+  ser.from_string_vector(&capture.levels);
+  ser.from_string_vector(&capture.active_levels);
+  ser.from_ptr(&capture.memory_size);
+  ser.from_pod_vector(&capture.chunk_indices);
+  ser.from_pod_vector(&capture.chunk_data);
+}
+}  // namespace
+
+/*!
+ * Copy the non-zero chunks of memory into the capture.
+ */
+void DmaCapture::capture_memory(const u8* memory, u32 size) {
+  ASSERT(size % CHUNK_SIZE == 0);
+  memory_size = size;
+  chunk_indices.clear();
+  chunk_data.clear();
+  for (u32 i = 0; i < size / CHUNK_SIZE; i++) {
+    const u8* chunk = memory + i * CHUNK_SIZE;
+    if (!chunk_is_zero(chunk)) {
+      chunk_indices.push_back(i);
+      chunk_data.insert(chunk_data.end(), chunk, chunk + CHUNK_SIZE);
+    }
+  }
+}
+
+/*!
+ * Fill memory (which must be memory_size bytes) with the captured memory.
+ */
+void DmaCapture::restore_memory(u8* memory) const {
+  ASSERT(chunk_data.size() == chunk_indices.size() * CHUNK_SIZE);
+  memset(memory, 0, memory_size);
+  for (size_t i = 0; i < chunk_indices.size(); i++) {
+    ASSERT((chunk_indices[i] + 1) * CHUNK_SIZE <= memory_size);
+    memcpy(memory + chunk_indices[i] * CHUNK_SIZE, chunk_data.data() + i * CHUNK_SIZE,
+           CHUNK_SIZE);
+  }
+}
+
+void write_dma_capture(const fs::path& path, DmaCapture& capture) {
+  Serializer ser;
+  u32 magic = DMA_CAPTURE_MAGIC;
+  u32 version = DMA_CAPTURE_VERSION;
+  ser.from_ptr(&magic);
+  ser.from_ptr(&version);
+  serialize_capture(ser, capture);
+  auto [data, size] = ser.get_save_result();
+  auto compressed = compression::compress_zstd(data, size);
+  file_util::create_dir_if_needed_for_file(path);
+  file_util::write_binary_file(path, compressed.data(), compressed.size());
+}
+
+DmaCapture read_dma_capture(const fs::path& path) {
+  auto compressed = file_util::read_binary_file(path);
+  auto data = compression::decompress_zstd(compressed.data(), compressed.size());
+  Serializer ser(data.data(), data.size());
+  u32 magic, version;
+  ser.from_ptr(&magic);
+  ser.from_ptr(&version);
+  ASSERT_MSG(magic == DMA_CAPTURE_MAGIC,
+             fmt::format("{} is not a DMA capture", path.string()));
+  ASSERT_MSG(version == DMA_CAPTURE_VERSION,
+             fmt::format("DMA capture {} has version {}, but {} is required", path.string(),
+                         version, DMA_CAPTURE_VERSION));
+  DmaCapture capture;
+  serialize_capture(ser, capture);
+  ASSERT(ser.get_load_finished());
+  return capture;
+}
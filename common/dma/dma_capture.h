@@ -0,0 +1,38 @@
+#pragma once
+
+/*!
+ * @file dma_capture.h
+ * A capture of a single frame sent to the renderer, which can be replayed without running the game.
+ *
+ * The DMA chain alone isn't enough to replay a frame: texture uploads and texture animations point
+ * to data in EE memory that isn't part of the chain. So the capture stores all of EE memory, minus
+ * the chunks that are entirely zero, along with the levels the renderer's loader was asked for.
+ */
+
+#include <string>
+#include <vector>
+
+#include "common/common_types.h"
+#include "common/util/FileUtil.h"
+#include "common/versions/versions.h"
+
+struct DmaCapture {
+  static constexpr u32 CHUNK_SIZE = 0x20000;
+
+  GameVersion version = GameVersion::Jak1;
+  u32 chain_offset = 0;  // offset of the first DMA tag in EE memory
+  u32 s7_offset = 0;
+  float pmode_alp = 1.f;
+  std::vector<std::string> levels;
+  std::vector<std::string> active_levels;
+
+  u32 memory_size = 0;
+  std::vector<u32> chunk_indices;  // index of each stored chunk in EE memory
+  std::vector<u8> chunk_data;      // CHUNK_SIZE bytes per stored chunk
+
+  void capture_memory(const u8* memory, u32 size);
+  void restore_memory(u8* memory) const;
+};
+
+void write_dma_capture(const fs::path& path, DmaCapture& capture);
+DmaCapture read_dma_capture(const fs::path& path);
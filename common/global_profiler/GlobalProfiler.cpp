@@ -1,69 +1,256 @@
-// clang-format off
 #include "GlobalProfiler.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstring>
-#include <thread>
+#include <deque>
+#include <iterator>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
 
+#include "common/common_types.h"
+#include "common/log/log.h"
 #include "common/util/Assert.h"
 #include "common/util/FileUtil.h"
-#include "common/common_types.h"
+#include "common/util/compress.h"
+#include "common/util/string_util.h"
 
 #include "fmt/core.h"
 #include "third-party/json.hpp"
 
-#ifdef OS_POSIX
-u64 get_current_tid() {
-  return (u64)pthread_self();
+namespace {
+u64 get_current_ts() {
+  return std::chrono::steady_clock::now().time_since_epoch().count();
 }
-#else
-#define NOMINMAX
-#define WIN32_LEAN_AND_MEAN
-#include <windows.h>
-#include "Processthreadsapi.h"
-u64 get_current_tid() {
-  return (u64)GetCurrentThreadId();
+
+/*!
+ * The names of all events, shared by every profiler. Names are never removed, so the strings (and
+ * views of them) stay valid.
+ */
+struct EventNames {
+  EventNames() { add(""); }
+
+  u32 add(std::string_view name) {
+    names.emplace_back(name);
+    u32 id = names.size() - 1;
+    ids[names.back()] = id;
+    return id;
+  }
+
+  std::shared_mutex mutex;
+  std::deque<std::string> names;
+  std::unordered_map<std::string_view, u32> ids;
+};
+
+EventNames& event_names() {
+  static EventNames names;
+  return names;
 }
-#endif
-#include "common/log/log.h"
-#include "common/util/compress.h"
-#include "common/util/string_util.h"
-// clang-format on
 
-u64 get_current_ts() {
-  return std::chrono::steady_clock::now().time_since_epoch().count();
+const std::string& event_name(u32 id) {
+  auto& names = event_names();
+  std::shared_lock lock(names.mutex);
+  return names.names.at(id);
+}
+
+std::atomic<u64> g_next_profiler_id = 1;
+
+/*!
+ * Event names escaped as JSON strings, remembered by id.
+ */
+class EscapedNames {
+ public:
+  const std::string& get(u32 id) {
+    if (id >= m_names.size()) {
+      m_names.resize(id + 1);
+    }
+    auto& name = m_names[id];
+    if (!name) {
+      name = nlohmann::json(event_name(id)).dump();
+    }
+    return *name;
+  }
+
+ private:
+  std::vector<std::optional<std::string>> m_names;
+};
+
+/*!
+ * Append an event in the Chrome trace event format. ts_base is the time that will show as 0.
+ */
+void append_event(std::string& out,
+                  const ProfNode& node,
+                  u32 tid,
+                  u64 ts_base,
+                  EscapedNames& names) {
+  const char* phase = "";
+  switch (node.kind) {
+    case ProfNode::BEGIN:
+      phase = "B";
+      break;
+    case ProfNode::END:
+      phase = "E";
+      break;
+    case ProfNode::INSTANT:
+      phase = "i";
+      break;
+    case ProfNode::COUNTER:
+      phase = "C";
+      break;
+    case ProfNode::FLOW_START:
+      phase = "s";
+      break;
+    case ProfNode::FLOW_END:
+      phase = "f";
+      break;
+    default:
+      ASSERT(false);
+  }
+
+  auto it = std::back_inserter(out);
+  fmt::format_to(it, "{{\"ph\":\"{}\",\"pid\":1,\"tid\":{},\"ts\":{:.3f}", phase, tid,
+                 (node.ts - ts_base) / 1000.);
+  if (node.kind != ProfNode::END) {
+    fmt::format_to(it, ",\"name\":{}", names.get(node.name));
+  }
+  if (node.kind == ProfNode::COUNTER) {
+    double value;
+    memcpy(&value, &node.value, sizeof(double));
+    fmt::format_to(it, ",\"args\":{{\"value\":{}}}", value);
+  } else if (node.kind == ProfNode::FLOW_START || node.kind == ProfNode::FLOW_END) {
+    // flows end on the slice that encloses them, not the next one.
+    fmt::format_to(it, ",\"id\":{},\"bp\":\"e\"", node.value);
+  }
+  out.push_back('}');
+}
+
+void append_thread_name(std::string& out, u32 tid, const std::string& name) {
+  fmt::format_to(std::back_inserter(out),
+                 "{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":{},"
+                 "\"args\":{{\"name\":{}}}}}",
+                 tid, nlohmann::json(name.empty() ? fmt::format("thread {}", tid) : name).dump());
 }
 
+const u32 kRootName = GlobalProfiler::intern("ROOT");
+}  // namespace
+
 GlobalProfiler::GlobalProfiler() {
   m_t0 = get_current_ts();
-  m_nodes.resize(m_max_events);
+  m_id = g_next_profiler_id++;
+}
+
+GlobalProfiler::~GlobalProfiler() {
+  stop_streaming();
+}
+
+/*!
+ * Get the id for an event name. Each thread remembers the names it has used, so this only locks
+ * the first time a thread uses a name.
+ */
+u32 GlobalProfiler::intern(const char* name) {
+  thread_local std::unordered_map<std::string_view, u32> t_ids;
+  std::string_view view(name);
+  auto it = t_ids.find(view);
+  if (it != t_ids.end()) {
+    return it->second;
+  }
+
+  auto& names = event_names();
+  u32 id;
+  {
+    std::shared_lock lock(names.mutex);
+    auto global_it = names.ids.find(view);
+    if (global_it != names.ids.end()) {
+      t_ids.emplace(global_it->first, global_it->second);
+      return global_it->second;
+    }
+  }
+  {
+    std::unique_lock lock(names.mutex);
+    auto global_it = names.ids.find(view);
+    id = global_it != names.ids.end() ? global_it->second : names.add(view);
+    view = names.names.at(id);
+  }
+  t_ids.emplace(view, id);
+  return id;
+}
+
+/*!
+ * Get the calling thread's info, setting it up if this is the first event from the thread.
+ */
+GlobalProfiler::ThreadInfo& GlobalProfiler::thread_info() {
+  // a thread may record to more than one profiler (only in tests).
+  thread_local std::vector<std::pair<u64, ThreadInfo*>> t_infos;
+  for (auto& [id, info] : t_infos) {
+    if (id == m_id) {
+      return *info;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(m_threads_mutex);
+  auto* info = m_threads.emplace_back(std::make_unique<ThreadInfo>()).get();
+  info->short_id = m_threads.size() - 1;
+  info->buffer = m_buffers.emplace_back(std::make_unique<Buffer>(m_max_events)).get();
+  t_infos.emplace_back(m_id, info);
+  return *info;
 }
 
+/*!
+ * Change the number of events kept for each thread. The events recorded so far are thrown away.
+ */
 void GlobalProfiler::update_event_buffer_size(size_t new_size) {
+  std::lock_guard<std::mutex> drain_lock(m_drain_mutex);
+  std::lock_guard<std::mutex> lock(m_threads_mutex);
   m_max_events = new_size;
-  m_nodes.resize(m_max_events);
+  for (auto& info : m_threads) {
+    // the old buffers are kept, a thread may still be recording into one.
+    info->buffer = m_buffers.emplace_back(std::make_unique<Buffer>(m_max_events)).get();
+  }
 }
 
 void GlobalProfiler::set_waiting_for_event(const std::string& event_name) {
   if (!event_name.empty()) {
-    m_waiting_for_event = event_name;
+    m_waiting_for_event = intern(event_name.c_str());
   }
 }
 
+/*!
+ * Name the calling thread in traces.
+ */
+void GlobalProfiler::set_thread_name(const std::string& name) {
+  auto& info = thread_info();
+  std::lock_guard<std::mutex> lock(m_threads_mutex);
+  info.name = name;
+  info.name_written = false;
+}
+
+void GlobalProfiler::record(u32 name, ProfNode::Kind kind, u64 value) {
+  auto& info = thread_info();
+  auto* buffer = info.buffer.load(std::memory_order_acquire);
+  u64 idx = buffer->write_idx.load(std::memory_order_relaxed);
+  if (m_streaming &&
+      idx - buffer->read_idx.load(std::memory_order_acquire) >= buffer->nodes.size()) {
+    // the writer is behind, don't overwrite events it hasn't written yet.
+    info.dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  auto& node = buffer->nodes[idx % buffer->nodes.size()];
+  node.ts = get_current_ts() - m_t0;
+  node.value = value;
+  node.name = name;
+  node.kind = kind;
+  buffer->write_idx.store(idx + 1, std::memory_order_release);
+}
+
 void GlobalProfiler::event(const char* name, ProfNode::Kind kind) {
-  if (m_waiting_for_event && m_waiting_for_event.value() == name) {
+  if (m_waiting_for_event && m_waiting_for_event.value() == intern(name)) {
     m_ignore_events = true;
   }
   if (!m_enabled || m_ignore_events) {
     return;
   }
-  size_t my_idx = (m_next_idx++ % m_nodes.size());
-  auto& node = m_nodes[my_idx];
-  node.ts = get_current_ts() - m_t0;
-  node.tid = get_current_tid();
-  node.kind = kind;
-  strncpy(node.name, name, sizeof(node.name));
-  node.name[sizeof(node.name) - 1] = '\0';
+  record(kind == ProfNode::END ? 0 : intern(name), kind, 0);
 }
 
 void GlobalProfiler::instant_event(const char* name) {
@@ -74,10 +261,6 @@ void GlobalProfiler::root_event() {
   instant_event("ROOT");
 }
 
-size_t GlobalProfiler::get_next_idx() {
-  return (m_next_idx % m_nodes.size());
-}
-
 void GlobalProfiler::begin_event(const char* name) {
   event(name, ProfNode::BEGIN);
 }
@@ -86,117 +269,134 @@ void GlobalProfiler::end_event() {
   if (!m_enabled || m_ignore_events) {
     return;
   }
-  size_t my_idx = (m_next_idx++ % m_nodes.size());
-  auto& node = m_nodes[my_idx];
-  node.ts = get_current_ts() - m_t0;
-  node.tid = get_current_tid();
-  node.kind = ProfNode::END;
-  node.name[0] = '\0';
+  record(0, ProfNode::END, 0);
+}
+
+/*!
+ * Record the value of a counter, which is shown as a graph over time.
+ */
+void GlobalProfiler::counter(const char* name, double value) {
+  if (!m_enabled || m_ignore_events) {
+    return;
+  }
+  u64 bits;
+  memcpy(&bits, &value, sizeof(double));
+  record(intern(name), ProfNode::COUNTER, bits);
+}
+
+/*!
+ * Start a flow, an arrow from the current event to the event that calls flow_end with the same
+ * id, usually on another thread.
+ */
+void GlobalProfiler::flow_start(const char* name, u64 id) {
+  if (!m_enabled || m_ignore_events) {
+    return;
+  }
+  record(intern(name), ProfNode::FLOW_START, id);
+}
+
+void GlobalProfiler::flow_end(const char* name, u64 id) {
+  if (!m_enabled || m_ignore_events) {
+    return;
+  }
+  record(intern(name), ProfNode::FLOW_END, id);
 }
 
+/*!
+ * Forget the events recorded so far.
+ */
 void GlobalProfiler::clear() {
-  m_next_idx = 0;
+  std::lock_guard<std::mutex> drain_lock(m_drain_mutex);
+  std::lock_guard<std::mutex> lock(m_threads_mutex);
+  for (auto& info : m_threads) {
+    auto* buffer = info->buffer.load();
+    buffer->read_idx = buffer->write_idx.load();
+  }
 }
 
 void GlobalProfiler::set_enable(bool en) {
   m_enabled = en;
 }
 
+size_t GlobalProfiler::get_event_count() {
+  std::lock_guard<std::mutex> lock(m_threads_mutex);
+  size_t count = 0;
+  for (auto& info : m_threads) {
+    auto* buffer = info->buffer.load();
+    count += std::min<u64>(buffer->write_idx - buffer->read_idx, buffer->nodes.size());
+  }
+  return count;
+}
+
+u64 GlobalProfiler::get_dropped_events() {
+  std::lock_guard<std::mutex> lock(m_threads_mutex);
+  u64 count = 0;
+  for (auto& info : m_threads) {
+    count += info->dropped;
+  }
+  return count;
+}
+
+/*!
+ * Write the events in the buffers to a file. Each thread's events are cut to the ones between its
+ * first and last ROOT event, so no thread starts or ends in the middle of an event.
+ */
 void GlobalProfiler::dump_to_json() {
   if (m_enabled) {
     set_enable(false);
   }
 
-  nlohmann::json json;
-  auto& trace_events = json["traceEvents"];
-  json["displayTimeUnit"] = "ms";
+  std::lock_guard<std::mutex> drain_lock(m_drain_mutex);
+  std::lock_guard<std::mutex> lock(m_threads_mutex);
 
-  u64 lowest_ts = UINT64_MAX;
-  struct ThreadInfo {
-    size_t lowest_at_target = UINT64_MAX;
-    size_t highest_at_target = 0;
-    size_t debug = 0;
-    u32 short_id = 0;
+  struct Range {
+    const Buffer* buffer = nullptr;
+    u64 begin = UINT64_MAX;  // the first ROOT
+    u64 end = 0;             // after the last ROOT
   };
-  std::unordered_map<u32, ThreadInfo> info_per_thread;
+  std::vector<Range> ranges(m_threads.size());
 
-  // first, find all the threads
-  std::string kRootName = "ROOT";
-  for (size_t offset = m_nodes.size(); offset-- > 0;) {
-    size_t idx = (m_next_idx + offset) % m_nodes.size();
-    const auto& event = m_nodes[idx];
-
-    if (event.kind != ProfNode::UNUSED) {
-      lowest_ts = std::min(event.ts, lowest_ts);
-    }
-    if (event.kind == ProfNode::INSTANT && kRootName == event.name) {
-      auto& info = info_per_thread[event.tid];
-      info.lowest_at_target = std::min(info.lowest_at_target, offset);
-      info.highest_at_target = std::max(info.highest_at_target, offset);
+  // first, find the ROOT events of each thread.
+  u64 lowest_ts = UINT64_MAX;
+  for (size_t i = 0; i < m_threads.size(); i++) {
+    auto& range = ranges[i];
+    range.buffer = m_threads[i]->buffer.load();
+    const auto& nodes = range.buffer->nodes;
+    u64 write = range.buffer->write_idx.load(std::memory_order_acquire);
+    u64 oldest = write > nodes.size() ? write - nodes.size() : 0;
+    u64 read = std::max<u64>(range.buffer->read_idx, oldest);
+    for (u64 idx = read; idx < write; idx++) {
+      const auto& node = nodes[idx % nodes.size()];
+      lowest_ts = std::min(node.ts, lowest_ts);
+      if (node.kind == ProfNode::INSTANT && node.name == kRootName) {
+        range.begin = std::min(range.begin, idx);
+        range.end = idx + 1;
+      }
     }
   }
 
-  u32 i = 0;
-  for (auto& info : info_per_thread) {
-    info.second.short_id = i++;
-  }
-
-  for (size_t event_idx = 0; event_idx < m_nodes.size(); event_idx++) {
-    auto& event = m_nodes[(event_idx + m_next_idx) % m_nodes.size()];
-    if (event.kind == ProfNode::UNUSED) {
-      continue;
-    }
-    auto& info = info_per_thread.at(event.tid);
-    if (event_idx < info.lowest_at_target || event_idx > info.highest_at_target) {
-      continue;
+  std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  EscapedNames names;
+  bool first = true;
+  for (size_t i = 0; i < m_threads.size(); i++) {
+    auto& range = ranges[i];
+    const auto& nodes = range.buffer->nodes;
+    for (u64 idx = range.begin; idx < range.end; idx++) {
+      if (!first) {
+        json.push_back(',');
+      }
+      first = false;
+      append_event(json, nodes[idx % nodes.size()], i, lowest_ts, names);
     }
-
-    auto& json_event = trace_events.emplace_back();
-    // name
-    if (event.kind != ProfNode::END) {
-      json_event["name"] = event.name;
-    }
-
-    // cat
-    // json_event["cat"] = "a";  // ??
-    // ph BEi
-    switch (event.kind) {
-      case ProfNode::END:
-        json_event["ph"] = "E";
-        break;
-      case ProfNode::BEGIN:
-        json_event["ph"] = "B";
-        break;
-      case ProfNode::INSTANT:
-        json_event["ph"] = "i";
-        break;
-      default:
-        ASSERT(false);
+    if (range.begin < range.end) {
+      json.push_back(',');
+      append_thread_name(json, i, m_threads[i]->name);
     }
-    // pid
-    json_event["pid"] = 1;
-    // tid
-    json_event["tid"] = info.short_id;
-    // ts
-    json_event["ts"] = (event.ts - lowest_ts) / 1000.f;
-    if (event.ts < info.debug) {
-      lg::debug("out of order: {} {} {} ms", event.ts / 1000.f, info.debug / 1000.f,
-                (info.debug - event.ts) / 1000000.f);
-      lg::debug("  idx: {}, range {} {}", event_idx, info.lowest_at_target, info.highest_at_target);
-      lg::debug("  now: {}", m_next_idx.load());
-    }
-    info.debug = event.ts;
-  }
-
-  for (auto& t : info_per_thread) {
-    lg::debug("thread: {}: {} -> {}", t.first, t.second.lowest_at_target,
-              t.second.highest_at_target);
   }
+  json += "]}";
 
   if (m_enable_compression) {
-    const auto json_str = json.dump();
-    const auto compressed_data =
-        compression::compress_zstd_no_header(json_str.data(), json_str.size());
+    const auto compressed_data = compression::compress_zstd_no_header(json.data(), json.size());
     auto file_path = file_util::get_jak_project_dir() / "profile_data" /
                      fmt::format("prof-{}.json.zst", str_util::current_local_timestamp_no_colons());
     file_util::create_dir_if_needed_for_file(file_path);
@@ -205,8 +405,126 @@ void GlobalProfiler::dump_to_json() {
     auto file_path = file_util::get_jak_project_dir() / "profile_data" /
                      fmt::format("prof-{}.json", str_util::current_local_timestamp_no_colons());
     file_util::create_dir_if_needed_for_file(file_path);
-    file_util::write_text_file(file_path, json.dump());
+    file_util::write_text_file(file_path, json);
+  }
+}
+
+/*!
+ * Start recording, and writing every event recorded from now on to a zstd compressed trace file,
+ * until stop_streaming. Returns the path of the file.
+ */
+std::string GlobalProfiler::start_streaming() {
+  stop_streaming();
+  auto path = file_util::get_jak_project_dir() / "profile_data" /
+              fmt::format("prof-{}.json.zst", str_util::current_local_timestamp_no_colons());
+  file_util::create_dir_if_needed_for_file(path);
+
+  {
+    std::lock_guard<std::mutex> drain_lock(m_drain_mutex);
+    std::lock_guard<std::mutex> lock(m_threads_mutex);
+    for (auto& info : m_threads) {
+      auto* buffer = info->buffer.load();
+      buffer->read_idx = buffer->write_idx.load();
+      info->name_written = false;
+    }
+    m_stream_path = path.string();
+    m_stop_writer = false;
+  }
+
+  m_streaming = true;
+  m_writer = std::thread(&GlobalProfiler::writer_thread, this);
+  set_enable(true);
+  return m_stream_path;
+}
+
+/*!
+ * Stop recording, and finish the file being streamed to.
+ */
+void GlobalProfiler::stop_streaming() {
+  if (!m_writer.joinable()) {
+    return;
+  }
+  set_enable(false);
+  {
+    std::lock_guard<std::mutex> lock(m_drain_mutex);
+    m_stop_writer = true;
+  }
+  m_writer_cv.notify_one();
+  m_writer.join();
+  m_streaming = false;
+}
+
+/*!
+ * Move the events that haven't been written yet from the buffers to out.
+ * The caller must hold m_drain_mutex.
+ */
+void GlobalProfiler::drain(std::string& out) {
+  // once a thread is set up, its info doesn't move, so it can be used without holding the lock.
+  std::vector<ThreadInfo*> threads;
+  {
+    std::lock_guard<std::mutex> lock(m_threads_mutex);
+    for (auto& info : m_threads) {
+      threads.push_back(info.get());
+      if (!info->name_written) {
+        append_thread_name(out, info->short_id, info->name);
+        out += ",\n";
+        info->name_written = true;
+      }
+    }
+  }
+
+  thread_local EscapedNames names;
+  for (auto* info : threads) {
+    auto* buffer = info->buffer.load(std::memory_order_acquire);
+    u64 read = buffer->read_idx.load(std::memory_order_relaxed);
+    u64 write = buffer->write_idx.load(std::memory_order_acquire);
+    for (u64 idx = read; idx < write; idx++) {
+      append_event(out, buffer->nodes[idx % buffer->nodes.size()], info->short_id, 0, names);
+      out += ",\n";
+    }
+    buffer->read_idx.store(write, std::memory_order_release);
+  }
+}
+
+/*!
+ * Write events to the stream file until asked to stop. The file is a JSON array of events, which
+ * trace viewers can read even if it's cut short, so the file is usable if the game crashes.
+ */
+void GlobalProfiler::writer_thread() {
+  compression::ZstdFileWriter file(m_stream_path);
+  if (!file.is_open()) {
+    lg::error("Profiler: failed to open {}", m_stream_path);
+    return;
+  }
+
+  constexpr auto kWriteInterval = std::chrono::milliseconds(50);
+  constexpr auto kFlushInterval = std::chrono::seconds(1);
+  auto last_flush = std::chrono::steady_clock::now();
+  std::string out = "[\n";
+  std::unique_lock<std::mutex> lock(m_drain_mutex);
+  bool stop = false;
+  while (!stop) {
+    m_writer_cv.wait_for(lock, kWriteInterval, [&]() { return m_stop_writer; });
+    stop = m_stop_writer;
+    drain(out);
+    lock.unlock();
+
+    if (stop) {
+      // every event is followed by a comma, so end with one that isn't.
+      out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,";
+      out += "\"args\":{\"name\":\"gk\"}}";
+      out += "\n]\n";
+    }
+    file.write(out.data(), out.size());
+    out.clear();
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_flush > kFlushInterval) {
+      file.flush();
+      last_flush = now;
+    }
+    lock.lock();
   }
+  file.close();
 }
 
 GlobalProfiler gprof;
@@ -1,48 +1,108 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <optional>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "common/common_types.h"
 
 struct ProfNode {
   u64 ts;
-  u64 tid;
-  char name[128];
-  enum Kind : u8 { BEGIN, END, INSTANT, UNUSED } kind = UNUSED;
+  u64 value;  // the id of a flow, or the bits of a counter's double
+  u32 name;   // from GlobalProfiler::intern
+  // the first four are also used by GOAL code.
+  enum Kind : u8 { BEGIN, END, INSTANT, UNUSED, COUNTER, FLOW_START, FLOW_END } kind = UNUSED;
 };
 
+/*!
+ * Records events from any thread, to look at in a trace viewer (chrome://tracing or Perfetto).
+ *
+ * Each thread records into its own ring buffer, without locking. Event names are interned, so an
+ * event is just a timestamp and a few ids. The buffers are either dumped at once when asked, which
+ * keeps the last get_max_events() events of each thread, or drained by a background thread that
+ * streams all events to a compressed file, for capturing long sessions. When streaming, events are
+ * dropped (and counted) if a thread fills its buffer faster than the writer can empty it.
+ */
 class GlobalProfiler {
  public:
   GlobalProfiler();
+  ~GlobalProfiler();
+  GlobalProfiler(const GlobalProfiler&) = delete;
+  GlobalProfiler& operator=(const GlobalProfiler&) = delete;
+
+  static u32 intern(const char* name);
+
   size_t get_max_events() { return m_max_events; }
   void update_event_buffer_size(size_t new_size);
   void set_waiting_for_event(const std::string& event_name);
+  void set_thread_name(const std::string& name);
   void instant_event(const char* name);
   void begin_event(const char* name);
   void event(const char* name, ProfNode::Kind kind);
   void end_event();
+  void counter(const char* name, double value);
+  void flow_start(const char* name, u64 id);
+  void flow_end(const char* name, u64 id);
   void clear();
   void set_enable(bool en);
   void dump_to_json();
   void root_event();
   bool is_enabled() { return m_enabled; }
-  size_t get_next_idx();
+  size_t get_event_count();
+
+  std::string start_streaming();
+  void stop_streaming();
+  bool is_streaming() { return m_streaming; }
+  u64 get_dropped_events();
 
   bool m_enable_compression = false;
 
  private:
+  struct Buffer {
+    explicit Buffer(size_t size) : nodes(size) {}
+    std::vector<ProfNode> nodes;
+    std::atomic<u64> write_idx = 0;  // only changed by the thread that records
+    std::atomic<u64> read_idx = 0;   // only changed with m_drain_mutex held
+  };
+
+  struct ThreadInfo {
+    std::atomic<Buffer*> buffer = nullptr;
+    std::string name;
+    u32 short_id = 0;
+    std::atomic<u64> dropped = 0;
+    bool name_written = false;
+  };
+
+  ThreadInfo& thread_info();
+  void record(u32 name, ProfNode::Kind kind, u64 value);
+  void writer_thread();
+  void drain(std::string& out);
+
   std::atomic_bool m_enabled = false;
   size_t m_max_events = 65536;
   u64 m_t0 = 0;
-  std::atomic_size_t m_next_idx = 0;
-  std::vector<ProfNode> m_nodes;
+  u64 m_id = 0;
+
+  std::mutex m_threads_mutex;  // guards m_threads and m_buffers
+  std::vector<std::unique_ptr<ThreadInfo>> m_threads;
+  std::vector<std::unique_ptr<Buffer>> m_buffers;  // including ones replaced by a resize
+
+  std::mutex m_drain_mutex;
+  std::atomic_bool m_streaming = false;
+  bool m_stop_writer = false;
+  std::condition_variable m_writer_cv;
+  std::thread m_writer;
+  std::string m_stream_path;
+
   // this is very niche, but sometimes you want to capture up to a given event (ie. long startup)
   // instead of having to make the user quit and record as fast as possible, we can instead just
   // stop capturing events once we have received what we are looking for
-  std::optional<std::string> m_waiting_for_event = {};
+  std::optional<u32> m_waiting_for_event = {};
   bool m_ignore_events = false;
 };
 
@@ -816,8 +816,7 @@ Object Interpreter::eval_set(const Object& form,
 
   std::shared_ptr<EnvironmentObject> search_env = env;
   for (;;) {
-    auto kv = search_env->vars.lookup(to_define.as_symbol());
-    if (kv) {
+    if (search_env->vars.contains(to_define.as_symbol())) {
       search_env->vars.set(to_define.as_symbol(), to_set);
       return to_set;
     }
@@ -1980,6 +1979,10 @@ Object Interpreter::eval_hash_table_set(const Object& form,
     throw_eval_error(form, "Hash table must use symbol or string as the key.");
   }
 
+  if (AccessRecorder::active()) {
+    AccessRecorder::record(
+        std::static_pointer_cast<StringHashTableObject>(args.unnamed.at(0).heap_obj), str, true);
+  }
   args.unnamed.at(0).as_string_hash_table()->data[str] = args.unnamed.at(2);
   return Object::make_empty_list();
 }
@@ -2001,6 +2004,10 @@ Object Interpreter::eval_hash_table_try_ref(const Object& form,
   } else {
     throw_eval_error(form, "Hash table must use symbol or string as the key.");
   }
+  if (AccessRecorder::active()) {
+    AccessRecorder::record(
+        std::static_pointer_cast<StringHashTableObject>(args.unnamed.at(0).heap_obj), str, false);
+  }
   const auto& it = table->data.find(str);
   if (it == table->data.end()) {
     // not in table
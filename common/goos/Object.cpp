@@ -464,4 +464,36 @@ std::string StringObject::inspect() const {
   return "[string] \"" + escape_string(data) + "\"\n";
 }
 
+namespace {
+thread_local AccessRecorder* g_current_access_recorder = nullptr;
+}
+
+AccessRecorder::AccessRecorder() : m_previous(g_current_access_recorder) {
+  g_current_access_recorder = this;
+}
+
+AccessRecorder::~AccessRecorder() {
+  g_current_access_recorder = m_previous;
+}
+
+bool AccessRecorder::active() {
+  return g_current_access_recorder;
+}
+
+void AccessRecorder::record(const void* table, InternedSymbolPtr sym, bool set) {
+  auto* recorder = g_current_access_recorder;
+  if (recorder && recorder->m_seen_symbols.emplace(table, sym.name_ptr).second) {
+    recorder->symbols.push_back({table, sym, set});
+  }
+}
+
+void AccessRecorder::record(const std::shared_ptr<StringHashTableObject>& table,
+                            const std::string& key,
+                            bool set) {
+  auto* recorder = g_current_access_recorder;
+  if (recorder && recorder->m_seen_keys.emplace(table.get(), key).second) {
+    recorder->hash_table_keys.push_back({table, key, set});
+  }
+}
+
 }  // namespace goos
@@ -110,6 +110,56 @@ struct InternedSymbolPtr {
   bool operator!=(const InternedSymbolPtr& other) const { return other.name_ptr != name_ptr; }
 };
 
+class StringHashTableObject;
+
+/*!
+ * While one of these exists, the first access to each symbol of a recorded InternedPtrMap and to
+ * each key of a string hash table is recorded on this thread, along with whether it was a set.
+ * This is used to find the global state a compiled file depended on.
+ */
+class AccessRecorder {
+ public:
+  struct SymbolAccess {
+    const void* table = nullptr;
+    InternedSymbolPtr sym{nullptr};
+    bool set_first = false;
+  };
+
+  struct HashTableAccess {
+    std::shared_ptr<StringHashTableObject> table;
+    std::string key;
+    bool set_first = false;
+  };
+
+  AccessRecorder();
+  ~AccessRecorder();
+  AccessRecorder(const AccessRecorder&) = delete;
+  AccessRecorder& operator=(const AccessRecorder&) = delete;
+
+  static bool active();
+  static void record(const void* table, InternedSymbolPtr sym, bool set);
+  static void record(const std::shared_ptr<StringHashTableObject>& table,
+                     const std::string& key,
+                     bool set);
+
+  std::vector<SymbolAccess> symbols;
+  std::vector<HashTableAccess> hash_table_keys;
+
+ private:
+  struct PairHash {
+    size_t operator()(const std::pair<const void*, const void*>& p) const {
+      return std::hash<const void*>()(p.first) ^ (std::hash<const void*>()(p.second) * 31);
+    }
+    size_t operator()(const std::pair<const void*, std::string>& p) const {
+      return std::hash<const void*>()(p.first) ^ (std::hash<std::string>()(p.second) * 31);
+    }
+  };
+
+  std::unordered_set<std::pair<const void*, const void*>, PairHash> m_seen_symbols;
+  std::unordered_set<std::pair<const void*, std::string>, PairHash> m_seen_keys;
+  AccessRecorder* m_previous = nullptr;
+};
+
 /*!
  * By default, convert a fixed object data to string with std::to_string.
  * This will be used for integers, but float and char define their own.
@@ -465,34 +515,19 @@ class InternedPtrMap {
   InternedPtrMap() { clear(); }
 
   T* lookup(InternedSymbolPtr str) {
-    if (m_entries.size() < 10) {
-      for (auto& e : m_entries) {
-        if (e.key == str.name_ptr) {
-          return &e.value;
-        }
-      }
-      return nullptr;
+    if (m_recorded) {
+      AccessRecorder::record(this, str, false);
     }
-    u32 hash = crc32((const u8*)&str.name_ptr, sizeof(const char*));
+    return find(str);
+  }
 
-    // probe
-    for (u32 i = 0; i < m_entries.size(); i++) {
-      u32 slot_addr = (hash + i) & m_mask;
-      auto& slot = m_entries[slot_addr];
-      if (!slot.key) {
-        return nullptr;
-      } else {
-        if (slot.key != str.name_ptr) {
-          continue;  // bad hash
-        }
-        return &slot.value;
-      }
-    }
+  // like lookup, but not recorded. For checking if a value exists before setting it.
+  bool contains(InternedSymbolPtr str) { return find(str) != nullptr; }
 
-    // should be impossible to reach.
-    ASSERT_NOT_REACHED();
-  }
   void set(InternedSymbolPtr ptr, const T& obj) {
+    if (m_recorded) {
+      AccessRecorder::record(this, ptr, true);
+    }
     u32 hash = crc32((const u8*)&ptr.name_ptr, sizeof(const char*));
 
     // probe
@@ -529,6 +564,11 @@ class InternedPtrMap {
     m_mask = 0b111;
   }
 
+  /*!
+   * If set, lookups and sets are recorded by the current AccessRecorder.
+   */
+  void set_recorded(bool recorded) { m_recorded = recorded; }
+
  private:
   struct Entry {
     const char* key = nullptr;
@@ -536,6 +576,35 @@ class InternedPtrMap {
   };
   std::vector<Entry> m_entries;
 
+  T* find(InternedSymbolPtr str) {
+    if (m_entries.size() < 10) {
+      for (auto& e : m_entries) {
+        if (e.key == str.name_ptr) {
+          return &e.value;
+        }
+      }
+      return nullptr;
+    }
+    u32 hash = crc32((const u8*)&str.name_ptr, sizeof(const char*));
+
+    // probe
+    for (u32 i = 0; i < m_entries.size(); i++) {
+      u32 slot_addr = (hash + i) & m_mask;
+      auto& slot = m_entries[slot_addr];
+      if (!slot.key) {
+        return nullptr;
+      } else {
+        if (slot.key != str.name_ptr) {
+          continue;  // bad hash
+        }
+        return &slot.value;
+      }
+    }
+
+    // should be impossible to reach.
+    ASSERT_NOT_REACHED();
+  }
+
   void resize() {
     m_power_of_two_size++;
     m_mask = (1U << m_power_of_two_size) - 1;
@@ -566,6 +635,7 @@ class InternedPtrMap {
   int m_used_entries = 0;
   int m_next_resize = 0;
   u32 m_mask = 0;
+  bool m_recorded = false;
   static constexpr float kMaxUsed = 0.7;
 };
 
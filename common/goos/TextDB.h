@@ -83,6 +83,7 @@ class FileText : public SourceText {
   FileText(const std::string& file_path, const std::string& description_name);
 
   std::string get_description() { return m_desc_name; }
+  const std::string& get_path() const { return m_filepath; }
   ~FileText() = default;
 
  private:
@@ -117,6 +118,7 @@ class TextDb {
   bool has_info(const Object& o) const;
   void inherit_info(const Object& parent, const Object& child);
   void clear_info();
+  const std::vector<std::shared_ptr<SourceText>>& fragments() const { return m_fragments; }
 
  private:
   std::vector<std::shared_ptr<SourceText>> m_fragments;
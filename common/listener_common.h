@@ -40,7 +40,8 @@ enum ListenerToTargetMsgKind : u16 {
   LTT_MSG_RESET = 8,          //! Reset the game
   LTT_MSG_CODE = 9,           //! Send code to patch into the game
   // below here are added
-  LTT_MSG_SHUTDOWN = 10  //! Shut down the runtime.
+  LTT_MSG_SHUTDOWN = 10,   //! Shut down the runtime.
+  LTT_MSG_CODE_BATCH = 11  //! Part of a batch of objects to link and execute in order
 };
 
 /*!
@@ -58,6 +59,23 @@ struct ListenerMessageHeader {
   u64 msg_id;    //! Message ID number, target echoes this back.
 };
 
+/*!
+ * A batch of objects is sent as a stream of records, split into LTT_MSG_CODE_BATCH messages of up
+ * to LISTENER_BATCH_CHUNK_SIZE bytes. A record is this header, then the object's name, then its
+ * data. The target acks each message once it has run every object that ended in that message, and
+ * the compiler may have up to LISTENER_BATCH_WINDOW messages waiting for an ack.
+ */
+struct ListenerBatchRecord {
+  u32 name_size;
+  u32 size;             //! size of the object file
+  u32 compressed_size;  //! size of the zstd compressed data that follows, or 0 if not compressed
+};
+
+constexpr u32 LISTENER_BATCH_CHUNK_SIZE = 256 * 1024;
+constexpr int LISTENER_BATCH_WINDOW = 8;
+// set in the u6 field of the first message of a batch.
+constexpr u16 LISTENER_BATCH_FIRST_CHUNK = 1;
+
 constexpr int DECI2_PORT = 8112;  // TODO - is this a good choice?
 
 constexpr u16 DECI2_PROTOCOL = 0xe042;
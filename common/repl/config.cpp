@@ -14,6 +14,8 @@ void to_json(json& j, const Config& obj) {
       {"keybinds", obj.keybinds},
       {"perGameHistory", obj.per_game_history},
       {"permissiveRedefinitions", obj.permissive_redefinitions},
+      {"buildCacheDir", obj.build_cache_dir},
+      {"buildCacheHashTools", obj.build_cache_hash_tools},
   };
 }
 
@@ -64,6 +66,12 @@ void from_json(const json& j, Config& obj) {
   if (j.contains("permissiveRedefinitions")) {
     j.at("permissiveRedefinitions").get_to(obj.permissive_redefinitions);
   }
+  if (j.contains("buildCacheDir")) {
+    j.at("buildCacheDir").get_to(obj.build_cache_dir);
+  }
+  if (j.contains("buildCacheHashTools")) {
+    j.at("buildCacheHashTools").get_to(obj.build_cache_hash_tools);
+  }
   // if there is game specific configuration, override any values we just set
   if (j.contains(version_to_game_name(obj.game_version))) {
     from_json(j.at(version_to_game_name(obj.game_version)), obj);
@@ -49,6 +49,10 @@ struct Config {
       {KeyBind::Modifier::CTRL, "N", "Full build of the game", "(mi)"}};
   bool per_game_history = true;
   bool permissive_redefinitions = false;
+  // if set, make shares build outputs with other checkouts through this folder.
+  std::string build_cache_dir;
+  // only share build outputs with the exact same build of the tools, for local changes to them.
+  bool build_cache_hash_tools = false;
 
   int get_nrepl_port() {
     if (temp_nrepl_port != -1) {
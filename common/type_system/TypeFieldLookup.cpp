@@ -5,6 +5,7 @@
 
 #include <algorithm>
 
+#include "TypeQueryCache.h"
 #include "TypeSystem.h"
 
 #include "common/log/log.h"
@@ -511,6 +512,15 @@ FieldReverseLookupOutput TypeSystem::reverse_field_lookup(
 FieldReverseMultiLookupOutput TypeSystem::reverse_field_multi_lookup(
     const FieldReverseLookupInput& input,
     int max_count) const {
+  auto& cache = TypeQueryCache::get(m_query_cache_version);
+  return TypeQueryCache::memoize(cache.reverse_lookup, {input, max_count}, [&]() {
+    return reverse_field_multi_lookup_uncached(input, max_count);
+  });
+}
+
+FieldReverseMultiLookupOutput TypeSystem::reverse_field_multi_lookup_uncached(
+    const FieldReverseLookupInput& input,
+    int max_count) const {
   if (debug_reverse_lookup) {
     lg::debug("reverse_field_lookup on {} offset {} deref {} stride {}", input.base_type.print(),
               input.offset, input.deref.has_value(), input.stride);
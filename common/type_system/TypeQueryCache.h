@@ -0,0 +1,106 @@
+#pragma once
+
+/*!
+ * @file TypeQueryCache.h
+ * Remembered results of TypeSystem queries. Only used inside the type system.
+ */
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "TypeSystem.h"
+
+#include "common/common_types.h"
+
+/*!
+ * Results of TypeSystem queries that are asked over and over again with the same arguments, like
+ * typechecks between two base types or reverse field lookups.
+ *
+ * Each thread has its own cache, so a const TypeSystem can still be used from many threads at
+ * once. The cache only holds results for a single version of a single TypeSystem, and is cleared
+ * when it's used with a different one. TypeSystems get a new version whenever their types change.
+ *
+ * The queries look up types, and a TypeLookupRecorder must still see those lookups when the result
+ * comes from the cache. So each result keeps the names of the types used to compute it, and these
+ * are recorded again on every hit.
+ */
+class TypeQueryCache {
+ public:
+  struct BaseTypePair {
+    const std::string* a = nullptr;
+    const std::string* b = nullptr;
+    bool flag = false;
+
+    bool operator==(const BaseTypePair& other) const {
+      return a == other.a && b == other.b && flag == other.flag;
+    }
+  };
+
+  struct ReverseLookup {
+    FieldReverseLookupInput input;
+    int max_count = 0;
+
+    bool operator==(const ReverseLookup& other) const;
+  };
+
+  template <typename T>
+  struct Result {
+    T value;
+    std::vector<std::string> types;
+  };
+
+  static TypeQueryCache& get(u64 version);
+
+  /*!
+   * Get the result for key from results, computing it if it isn't there yet.
+   */
+  template <typename Key, typename T, typename Hash, typename F>
+  static const T& memoize(std::unordered_map<Key, Result<T>, Hash>& results,
+                          const Key& key,
+                          F&& compute) {
+    auto it = results.find(key);
+    if (it != results.end()) {
+      record_all(it->second.types);
+      return it->second.value;
+    }
+
+    Result<T> result;
+    std::optional<TypeLookupRecorder> recorder;
+    recorder.emplace();
+    try {
+      result.value = compute();
+    } catch (...) {
+      // the caller may still care about the types that were looked up before the failure.
+      std::vector<std::string> types(recorder->names.begin(), recorder->names.end());
+      recorder.reset();
+      record_all(types);
+      throw;
+    }
+    result.types.assign(recorder->names.begin(), recorder->names.end());
+    recorder.reset();
+
+    record_all(result.types);
+    return results.emplace(key, std::move(result)).first->second.value;
+  }
+
+  struct BaseTypePairHash {
+    size_t operator()(const BaseTypePair& key) const;
+  };
+
+  struct ReverseLookupHash {
+    size_t operator()(const ReverseLookup& key) const;
+  };
+
+  std::unordered_map<BaseTypePair, Result<bool>, BaseTypePairHash> typecheck_base_types;
+  std::unordered_map<BaseTypePair, Result<TypeSpec>, BaseTypePairHash> lca_base;
+  std::unordered_map<ReverseLookup, Result<FieldReverseMultiLookupOutput>, ReverseLookupHash>
+      reverse_lookup;
+
+ private:
+  static void record_all(const std::vector<std::string>& types);
+  void clear();
+
+  u64 m_version = 0;
+};
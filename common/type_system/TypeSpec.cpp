@@ -5,19 +5,84 @@
 
 #include "TypeSpec.h"
 
+#include <mutex>
+#include <shared_mutex>
 #include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "fmt/core.h"
 
+namespace {
+/*!
+ * Every base type name used by any TypeSpec. Strings are never removed, so pointers to them are
+ * stable. This is a function static so TypeSpecs can be created during static initialization.
+ */
+struct TypeNames {
+  std::unordered_set<std::string> names;
+  std::shared_mutex mutex;
+};
+
+TypeNames& type_names() {
+  static TypeNames names;
+  return names;
+}
+}  // namespace
+
 bool TypeTag::operator==(const TypeTag& other) const {
   return name == other.name && value == other.value;
 }
 
+/*!
+ * Get the shared copy of a type name. Each thread remembers the names it has used, so the lock is
+ * only taken the first time a thread sees a name.
+ */
+const std::string* TypeSpec::intern(const std::string& name) {
+  if (name.empty()) {
+    return &s_no_type;
+  }
+
+  thread_local std::unordered_map<std::string, const std::string*> names_seen_by_thread;
+  auto local_it = names_seen_by_thread.find(name);
+  if (local_it != names_seen_by_thread.end()) {
+    return local_it->second;
+  }
+
+  auto& all_names = type_names();
+  const std::string* result = nullptr;
+  {
+    std::shared_lock<std::shared_mutex> lock(all_names.mutex);
+    auto it = all_names.names.find(name);
+    if (it != all_names.names.end()) {
+      result = &*it;
+    }
+  }
+  if (!result) {
+    std::unique_lock<std::shared_mutex> lock(all_names.mutex);
+    result = &*all_names.names.insert(name).first;
+  }
+  names_seen_by_thread[name] = result;
+  return result;
+}
+
+/*!
+ * Get the arguments for modification. If they are shared with another TypeSpec, they are copied
+ * first.
+ */
+std::vector<TypeSpec>& TypeSpec::mutable_arguments() {
+  if (!m_arguments) {
+    m_arguments = std::make_shared<std::vector<TypeSpec>>();
+  } else if (m_arguments.use_count() > 1) {
+    m_arguments = std::make_shared<std::vector<TypeSpec>>(*m_arguments);
+  }
+  return *m_arguments;
+}
+
 std::string TypeSpec::print() const {
   if ((!m_arguments || m_arguments->empty()) && m_tags.empty()) {
-    return m_type;
+    return *m_type;
   } else {
-    std::string result = "(" + m_type;
+    std::string result = "(" + *m_type;
 
     if (m_arguments) {
       for (auto& x : *m_arguments) {
@@ -38,6 +103,7 @@ bool TypeSpec::operator!=(const TypeSpec& other) const {
 }
 
 bool TypeSpec::operator==(const TypeSpec& other) const {
+  // names are interned, so the pointers are equal if the names are.
   if (m_type != other.m_type) {
     return false;
   }
@@ -46,6 +112,10 @@ bool TypeSpec::operator==(const TypeSpec& other) const {
     return false;
   }
 
+  if (m_arguments == other.m_arguments) {
+    return true;
+  }
+
   if (m_arguments && other.m_arguments) {
     return *m_arguments == *other.m_arguments;
   }
@@ -53,13 +123,28 @@ bool TypeSpec::operator==(const TypeSpec& other) const {
   return empty() && other.empty();
 }
 
+size_t TypeSpec::hash() const {
+  size_t result = std::hash<const std::string*>()(m_type);
+  auto combine = [&](size_t h) { result ^= h + 0x9e3779b9 + (result << 6) + (result >> 2); };
+  if (m_arguments) {
+    for (const auto& arg : *m_arguments) {
+      combine(arg.hash());
+    }
+  }
+  for (const auto& tag : m_tags) {
+    combine(std::hash<std::string>()(tag.name));
+    combine(std::hash<std::string>()(tag.value));
+  }
+  return result;
+}
+
 TypeSpec TypeSpec::substitute_for_method_call(const std::string& method_type) const {
   TypeSpec result;
-  result.m_type = (m_type == "_type_") ? method_type : m_type;
+  result.m_type = (*m_type == "_type_") ? intern(method_type) : m_type;
   if (m_arguments) {
-    result.m_arguments = new std::vector<TypeSpec>();
+    auto& args = result.mutable_arguments();
     for (const auto& x : *m_arguments) {
-      result.m_arguments->push_back(x.substitute_for_method_call(method_type));
+      args.push_back(x.substitute_for_method_call(method_type));
     }
   }
 
@@ -70,7 +155,7 @@ bool TypeSpec::is_compatible_child_method(const TypeSpec& implementation,
                                           const std::string& child_type,
                                           int* bad_arg_idx_out) const {
   bool ok = implementation.m_type == m_type ||
-            (m_type == "_type_" && implementation.m_type == child_type);
+            (*m_type == "_type_" && *implementation.m_type == child_type);
   if (!ok || implementation.arg_count() != arg_count()) {
     if (bad_arg_idx_out)
       *bad_arg_idx_out = -1;
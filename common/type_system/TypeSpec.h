@@ -5,6 +5,7 @@
  * A GOAL TypeSpec is a reference to a type or compound type.
  */
 
+#include <memory>
 #include <optional>
 #include <string>
 #include <vector>
@@ -34,39 +35,10 @@ struct TypeTag {
 class TypeSpec {
  public:
   TypeSpec() = default;
-  TypeSpec(const std::string& type) : m_type(type) {}
+  TypeSpec(const std::string& type) : m_type(intern(type)) {}
 
   TypeSpec(const std::string& type, const std::vector<TypeSpec>& arguments)
-      : m_type(type), m_arguments(new std::vector<TypeSpec>(arguments)) {}
-
-  TypeSpec(const TypeSpec& other) {
-    m_type = other.m_type;
-    m_tags = other.m_tags;
-    if (other.m_arguments) {
-      m_arguments = new std::vector<TypeSpec>(*other.m_arguments);
-    }
-  }
-
-  TypeSpec& operator=(const TypeSpec& other) {
-    if (this == &other) {
-      return *this;
-    }
-
-    if (m_arguments) {
-      delete m_arguments;
-      m_arguments = nullptr;
-    }
-
-    m_type = other.m_type;
-    m_tags = other.m_tags;
-    if (other.m_arguments) {
-      m_arguments = new std::vector<TypeSpec>(*other.m_arguments);
-    }
-
-    return *this;
-  }
-
-  ~TypeSpec() { delete m_arguments; }
+      : m_type(intern(type)), m_arguments(std::make_shared<std::vector<TypeSpec>>(arguments)) {}
 
   //  TypeSpec(const std::string& type, const std::vector<TypeTag>& tags)
   //      : m_type(type), m_tags(tags) {}
@@ -78,17 +50,13 @@ class TypeSpec {
 
   bool operator!=(const TypeSpec& other) const;
   bool operator==(const TypeSpec& other) const;
+  size_t hash() const;
   bool is_compatible_child_method(const TypeSpec& implementation,
                                   const std::string& child_type,
                                   int* bad_arg_idx_out = nullptr) const;
   std::string print() const;
 
-  void add_arg(const TypeSpec& ts) {
-    if (!m_arguments) {
-      m_arguments = new std::vector<TypeSpec>();
-    }
-    m_arguments->push_back(ts);
-  }
+  void add_arg(const TypeSpec& ts) { mutable_arguments().push_back(ts); }
   void add_new_tag(const std::string& tag_name, const std::string& tag_value);
   std::optional<std::string> try_get_tag(const std::string& tag_name) const;
   const std::string& get_tag(const std::string& tag_name) const;
@@ -96,7 +64,13 @@ class TypeSpec {
   void add_or_modify_tag(const std::string& tag_name, const std::string& tag_value);
   void delete_tag(const std::string& tag_name);
 
-  const std::string& base_type() const { return m_type; }
+  const std::string& base_type() const { return *m_type; }
+
+  /*!
+   * The base type's name is interned, so TypeSpecs with the same base type share a pointer to
+   * the same string. This can be used as a cheap key for the base type.
+   */
+  const std::string* interned_base_type() const { return m_type; }
 
   bool has_single_arg() const {
     if (m_arguments) {
@@ -125,21 +99,23 @@ class TypeSpec {
     return m_arguments->at(idx);
   }
 
-  TypeSpec& get_arg(int idx) {
-    ASSERT(m_arguments);
-    return m_arguments->at(idx);
-  }
-
   const TypeSpec& last_arg() const {
     ASSERT(m_arguments);
     ASSERT(!m_arguments->empty());
     return m_arguments->back();
   }
 
-  TypeSpec& last_arg() {
+  // arguments may be shared with other TypeSpecs, so they can only be changed through these, which
+  // copy them first. A reference into them could be shared again by copying this TypeSpec.
+  void set_arg(int idx, const TypeSpec& ts) {
+    ASSERT(m_arguments);
+    mutable_arguments().at(idx) = ts;
+  }
+
+  void set_last_arg(const TypeSpec& ts) {
     ASSERT(m_arguments);
     ASSERT(!m_arguments->empty());
-    return m_arguments->back();
+    mutable_arguments().back() = ts;
   }
 
   bool empty() const {
@@ -154,9 +130,18 @@ class TypeSpec {
 
  private:
   friend class TypeSystem;
-  std::string m_type;
-  // hiding this behind a pointer makes things faster in the case where we have no
-  // arguments (most of the time) and makes the type analysis pass in the decompiler 2x faster.
-  std::vector<TypeSpec>* m_arguments = nullptr;
+  static const std::string* intern(const std::string& name);
+  std::vector<TypeSpec>& mutable_arguments();
+
+  inline static const std::string s_no_type;
+  // interned, so copying and comparing the base type doesn't touch the string.
+  const std::string* m_type = &s_no_type;
+  // arguments are shared between copies, and only copied when one of them is modified. Most
+  // TypeSpecs have no arguments, so this is usually null.
+  std::shared_ptr<std::vector<TypeSpec>> m_arguments;
   std::vector<TypeTag> m_tags;
 };
+
+struct TypeSpecHash {
+  size_t operator()(const TypeSpec& ts) const { return ts.hash(); }
+};
@@ -8,8 +8,12 @@
 #include "TypeSystem.h"
 
 #include <algorithm>
+#include <atomic>
+#include <map>
 #include <stdexcept>
 
+#include "TypeQueryCache.h"
+
 #include "common/log/log.h"
 #include "common/util/Assert.h"
 #include "common/util/math_util.h"
@@ -30,9 +34,91 @@ template <typename... Args>
   throw std::runtime_error(
       fmt::format("Type Error: {}", fmt::format(fmt::runtime(str), std::forward<Args>(args)...)));
 }
+thread_local TypeLookupRecorder* g_current_lookup_recorder = nullptr;
+
+// shared by all TypeSystems, so a version is never reused, even by a different TypeSystem.
+std::atomic<u64> g_next_query_cache_version = 1;
+
+size_t hash_combine(size_t seed, size_t value) {
+  return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
 }  // namespace
 
+TypeLookupRecorder::TypeLookupRecorder() : m_previous(g_current_lookup_recorder) {
+  g_current_lookup_recorder = this;
+}
+
+TypeLookupRecorder::~TypeLookupRecorder() {
+  g_current_lookup_recorder = m_previous;
+}
+
+void TypeLookupRecorder::record(const std::string& name) {
+  if (g_current_lookup_recorder) {
+    g_current_lookup_recorder->names.insert(name);
+  }
+}
+
+TypeQueryCache& TypeQueryCache::get(u64 version) {
+  thread_local TypeQueryCache cache;
+  if (cache.m_version != version) {
+    cache.clear();
+    cache.m_version = version;
+  }
+  return cache;
+}
+
+void TypeQueryCache::record_all(const std::vector<std::string>& types) {
+  if (g_current_lookup_recorder) {
+    for (const auto& type : types) {
+      g_current_lookup_recorder->names.insert(type);
+    }
+  }
+}
+
+void TypeQueryCache::clear() {
+  typecheck_base_types.clear();
+  lca_base.clear();
+  reverse_lookup.clear();
+}
+
+bool TypeQueryCache::ReverseLookup::operator==(const ReverseLookup& other) const {
+  if (input.deref.has_value() != other.input.deref.has_value()) {
+    return false;
+  }
+  if (input.deref) {
+    const auto& a = *input.deref;
+    const auto& b = *other.input.deref;
+    if (a.is_store != b.is_store || a.size != b.size || a.sign_extend != b.sign_extend ||
+        a.reg_kind != b.reg_kind) {
+      return false;
+    }
+  }
+  return input.offset == other.input.offset && input.stride == other.input.stride &&
+         max_count == other.max_count && input.base_type == other.input.base_type;
+}
+
+size_t TypeQueryCache::BaseTypePairHash::operator()(const BaseTypePair& key) const {
+  size_t result = std::hash<const std::string*>()(key.a);
+  result = hash_combine(result, std::hash<const std::string*>()(key.b));
+  return hash_combine(result, key.flag);
+}
+
+size_t TypeQueryCache::ReverseLookupHash::operator()(const ReverseLookup& key) const {
+  size_t result = key.input.base_type.hash();
+  result = hash_combine(result, key.input.offset);
+  result = hash_combine(result, key.input.stride);
+  result = hash_combine(result, key.max_count);
+  if (key.input.deref) {
+    const auto& deref = *key.input.deref;
+    result = hash_combine(result, deref.size);
+    result = hash_combine(result, deref.is_store | (deref.sign_extend << 1) |
+                                      ((int)deref.reg_kind << 2));
+  }
+  return result;
+}
+
 TypeSystem::TypeSystem() {
+  new_query_cache_version();
   // the "none" and "_type_" types are included by default.
   add_type("none", std::make_unique<NullType>("none"));
   add_type("_type_", std::make_unique<NullType>("_type_"));
@@ -44,6 +130,11 @@ TypeSystem::TypeSystem() {
  * throw_on_redefine is set. The type should be fully set up (fields, etc) before running this.
  */
 Type* TypeSystem::add_type(const std::string& name, std::unique_ptr<Type> type) {
+  // a brand new type can't change the result of a query that was already answered, because
+  // queries fail when a type is unknown.
+  if (m_types.count(name) || m_forward_declared_types.count(name)) {
+    new_query_cache_version();
+  }
   auto method_kv = m_forward_declared_method_counts.find(name);
   if (method_kv != m_forward_declared_method_counts.end()) {
     int method_count = get_next_method_id(type.get());
@@ -176,6 +267,7 @@ void TypeSystem::forward_declare_type_as(const std::string& new_type,
         if (tc(old_ts, new_ts)) {
           // new is more specific or equal to old:
           m_forward_declared_types[new_type] = new_ts.base_type();
+          new_query_cache_version();
         } else if (tc(new_ts, old_ts)) {
           // old is more specific or equal to new:
         } else {
@@ -258,6 +350,7 @@ int TypeSystem::get_type_method_count(const std::string& name) const {
 }
 
 std::optional<int> TypeSystem::try_get_type_method_count(const std::string& name) const {
+  TypeLookupRecorder::record(name);
   auto type_it = m_types.find(name);
   if (type_it != m_types.end()) {
     return get_next_method_id(type_it->second.get());
@@ -350,6 +443,7 @@ DerefInfo TypeSystem::get_deref_info(const TypeSpec& ts) const {
  * If you really need a TypeSpec which refers to a non-existent type, just construct your own.
  */
 TypeSpec TypeSystem::make_typespec(const std::string& name) const {
+  TypeLookupRecorder::record(name);
   if (m_types.find(name) != m_types.end() ||
       m_forward_declared_types.find(name) != m_forward_declared_types.end()) {
     return TypeSpec(name);
@@ -359,6 +453,7 @@ TypeSpec TypeSystem::make_typespec(const std::string& name) const {
 }
 
 bool TypeSystem::fully_defined_type_exists(const std::string& name) const {
+  TypeLookupRecorder::record(name);
   return m_types.find(name) != m_types.end();
 }
 
@@ -367,6 +462,7 @@ bool TypeSystem::fully_defined_type_exists(const TypeSpec& type) const {
 }
 
 bool TypeSystem::partially_defined_type_exists(const std::string& name) const {
+  TypeLookupRecorder::record(name);
   return m_forward_declared_types.find(name) != m_forward_declared_types.end();
 }
 
@@ -424,6 +520,7 @@ TypeSpec TypeSystem::make_inline_array_typespec(const TypeSpec& type) const {
  * lookup_type to find the most up-to-date type information.
  */
 Type* TypeSystem::lookup_type(const std::string& name) const {
+  TypeLookupRecorder::record(name);
   auto kv = m_types.find(name);
   if (kv != m_types.end()) {
     return kv->second.get();
@@ -455,6 +552,7 @@ Type* TypeSystem::lookup_type(const TypeSpec& ts) const {
  * Same as lookup_type, but returns null instead of throwing.
  */
 Type* TypeSystem::lookup_type_no_throw(const std::string& name) const {
+  TypeLookupRecorder::record(name);
   auto kv = m_types.find(name);
   if (kv != m_types.end()) {
     return kv->second.get();
@@ -483,6 +581,7 @@ Type* TypeSystem::lookup_type_allow_partial_def(const TypeSpec& ts) const {
  * forward defined as a basic or structure, just get basic/structure.
  */
 Type* TypeSystem::lookup_type_allow_partial_def(const std::string& name) const {
+  TypeLookupRecorder::record(name);
   // look up fully defined types first:
   auto kv = m_types.find(name);
   if (kv != m_types.end()) {
@@ -520,6 +619,7 @@ Type* TypeSystem::lookup_type_allow_partial_def(const std::string& name) const {
  * This should be safe to use to load a value from a field.
  */
 int TypeSystem::get_load_size_allow_partial_def(const TypeSpec& ts) const {
+  TypeLookupRecorder::record(ts.base_type());
   auto fully_defined_it = m_types.find(ts.base_type());
   if (fully_defined_it != m_types.end()) {
     return fully_defined_it->second->get_load_size();
@@ -803,6 +903,7 @@ MethodInfo TypeSystem::lookup_method(const std::string& type_name,
 bool TypeSystem::try_lookup_method(const std::string& type_name,
                                    const std::string& method_name,
                                    MethodInfo* info) const {
+  TypeLookupRecorder::record(type_name);
   auto kv = m_types.find(type_name);
   if (kv == m_types.end()) {
     // try to look up a forward declared type.
@@ -823,6 +924,7 @@ bool TypeSystem::try_lookup_method(const std::string& type_name,
 bool TypeSystem::try_lookup_method(const std::string& type_name,
                                    int method_id,
                                    MethodInfo* info) const {
+  TypeLookupRecorder::record(type_name);
   auto kv = m_types.find(type_name);
   if (kv == m_types.end()) {
     return false;
@@ -1025,6 +1127,7 @@ int TypeSystem::add_field_to_type(StructureType* type,
                                   bool skip_in_static_decomp,
                                   double score,
                                   const std::optional<TypeSpec> decomp_as_ts) {
+  type_modified(type);
   if (type->lookup_field(field_name, nullptr)) {
     throw_typesystem_error("Type {} already has a field named {}\n", type->get_name(), field_name);
   }
@@ -1285,6 +1388,44 @@ std::string TypeSystem::print_all_type_information() const {
   return result;
 }
 
+/*!
+ * Get a string that describes everything known about the given type: its definition, methods,
+ * states, or how it was forward declared. If the type changes, this string will change too.
+ */
+std::string TypeSystem::type_definition_text(const std::string& name) const {
+  std::string result;
+  auto type_it = m_types.find(name);
+  if (type_it != m_types.end()) {
+    const auto* type = type_it->second.get();
+    result += type->print();
+    result += type->print_method_info();
+    // an enum prints as just its name, but code using it depends on the values.
+    if (const auto* as_enum = dynamic_cast<const EnumType*>(type)) {
+      result += fmt::format(" {} of {}:", as_enum->is_bitfield() ? "bitfield" : "enum",
+                            as_enum->get_parent());
+      for (const auto& [entry, value] :
+           std::map<std::string, s64>(as_enum->entries().begin(), as_enum->entries().end())) {
+        result += fmt::format(" ({} {})", entry, value);
+      }
+      result += "\n";
+    }
+    for (const auto& [state_name, state_type] : type->get_states_declared_for_type()) {
+      result += fmt::format(" state: {} {}\n", state_name, state_type.print());
+    }
+  }
+
+  auto fwd_it = m_forward_declared_types.find(name);
+  if (fwd_it != m_forward_declared_types.end()) {
+    result += fmt::format(" forward declared as: {}\n", fwd_it->second);
+  }
+
+  auto count_it = m_forward_declared_method_counts.find(name);
+  if (count_it != m_forward_declared_method_counts.end()) {
+    result += fmt::format(" forward declared method count: {}\n", count_it->second);
+  }
+  return result;
+}
+
 /*!
  * Get the next free method ID of a type.
  */
@@ -1646,7 +1787,13 @@ bool TypeSystem::typecheck_and_throw(const TypeSpec& expected,
                                      bool allow_type_alias) const {
   bool success = true;
   // first, typecheck the base types:
-  if (!typecheck_base_types(expected.base_type(), actual.base_type(), allow_type_alias)) {
+  auto& cache = TypeQueryCache::get(m_query_cache_version);
+  if (!TypeQueryCache::memoize(
+          cache.typecheck_base_types,
+          {expected.interned_base_type(), actual.interned_base_type(), allow_type_alias}, [&]() {
+            return typecheck_base_types(expected.base_type(), actual.base_type(),
+                                        allow_type_alias);
+          })) {
     success = false;
   }
 
@@ -1765,6 +1912,7 @@ bool TypeSystem::typecheck_base_types(const std::string& input_expected,
 }
 
 EnumType* TypeSystem::try_enum_lookup(const std::string& type_name) const {
+  TypeLookupRecorder::record(type_name);
   auto it = m_types.find(type_name);
   if (it != m_types.end()) {
     return dynamic_cast<EnumType*>(it->second.get());
@@ -1830,8 +1978,11 @@ std::string TypeSystem::lca_base(const std::string& a, const std::string& b) con
  * (lca(a, b) lca(b, d)).
  */
 TypeSpec TypeSystem::lowest_common_ancestor(const TypeSpec& a, const TypeSpec& b) const {
-  auto result = make_typespec(lca_base(a.base_type(), b.base_type()));
-  if (result == TypeSpec("function") && a.arg_count() == 2 && b.arg_count() == 2 &&
+  auto& cache = TypeQueryCache::get(m_query_cache_version);
+  auto result = TypeQueryCache::memoize(
+      cache.lca_base, {a.interned_base_type(), b.interned_base_type()},
+      [&]() { return make_typespec(lca_base(a.base_type(), b.base_type())); });
+  if (result.base_type() == "function" && a.arg_count() == 2 && b.arg_count() == 2 &&
       (a.get_arg(0) == TypeSpec("_varargs_") || b.get_arg(0) == TypeSpec("_varargs_"))) {
     return TypeSpec("function");
   }
@@ -1919,6 +2070,7 @@ void TypeSystem::add_field_to_bitfield(BitFieldType* type,
                                        int offset,
                                        int field_size,
                                        bool skip_in_decomp) {
+  type_modified(type);
   // in bits
   auto load_size = lookup_type(field_type)->get_load_size() * 8;
   if (field_size == -1) {
@@ -2436,6 +2588,7 @@ bool TypeSystem::should_use_virtual_methods(const Type* type, int method_id) con
 }
 
 bool TypeSystem::should_use_virtual_methods(const TypeSpec& type, int method_id) const {
+  TypeLookupRecorder::record(type.base_type());
   auto it = m_types.find(type.base_type());
   if (it != m_types.end()) {
     // it's a fully defined type
@@ -2455,3 +2608,20 @@ bool TypeSystem::should_use_virtual_methods(const TypeSpec& type, int method_id)
     }
   }
 }
+
+/*!
+ * Types were added or changed, so results of earlier queries may be wrong now.
+ */
+void TypeSystem::new_query_cache_version() {
+  m_query_cache_version = g_next_query_cache_version++;
+}
+
+/*!
+ * Call before modifying a type. Types that haven't been added yet can't be used by queries.
+ */
+void TypeSystem::type_modified(const Type* type) {
+  auto it = m_types.find(type->get_name());
+  if (it != m_types.end() && it->second.get() == type) {
+    new_query_cache_version();
+  }
+}
@@ -18,6 +18,8 @@
 #include "Type.h"
 #include "TypeSpec.h"
 
+#include "common/common_types.h"
+
 struct TypeFlags {
   union {
     uint64_t flag = 0;
@@ -120,6 +122,25 @@ struct ReverseLookupNode {
   std::vector<FieldReverseLookupOutput::Token> to_vector() const;
 };
 
+/*!
+ * While a TypeLookupRecorder exists, the name of every type looked up in any TypeSystem on the
+ * current thread is added to it. The decompiler uses this to find out which type definitions
+ * an object depended on. Recorders can be nested, only the innermost one records.
+ */
+class TypeLookupRecorder {
+ public:
+  TypeLookupRecorder();
+  ~TypeLookupRecorder();
+  TypeLookupRecorder(const TypeLookupRecorder&) = delete;
+  TypeLookupRecorder& operator=(const TypeLookupRecorder&) = delete;
+
+  static void record(const std::string& name);
+  std::unordered_set<std::string> names;
+
+ private:
+  TypeLookupRecorder* m_previous = nullptr;
+};
+
 class TypeSystem {
  public:
   TypeSystem();
@@ -228,6 +249,7 @@ class TypeSystem {
   void add_builtin_types(GameVersion version);
 
   std::string print_all_type_information() const;
+  std::string type_definition_text(const std::string& name) const;
   bool typecheck_and_throw(const TypeSpec& expected,
                            const TypeSpec& actual,
                            const std::string& error_source_name = "",
@@ -299,6 +321,9 @@ class TypeSystem {
       const std::optional<std::vector<std::string>>& existing_matches = {});
 
  private:
+  FieldReverseMultiLookupOutput reverse_field_multi_lookup_uncached(
+      const FieldReverseLookupInput& input,
+      int max_count) const;
   std::string lca_base(const std::string& a, const std::string& b) const;
   bool typecheck_base_types(const std::string& expected,
                             const std::string& actual,
@@ -325,6 +350,11 @@ class TypeSystem {
 
   std::vector<std::string> m_types_allowed_to_be_redefined;
   bool m_allow_redefinition = false;
+
+  // changes whenever existing types are modified, so remembered query results can be dropped.
+  void new_query_cache_version();
+  void type_modified(const Type* type);
+  u64 m_query_cache_version = 0;
 };
 
 TypeSpec coerce_to_reg_type(const TypeSpec& in);
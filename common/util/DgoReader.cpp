@@ -1,6 +1,5 @@
 #include "DgoReader.h"
 
-#include <cstring>
 #include <unordered_set>
 #include <utility>
 
@@ -13,9 +12,9 @@
 
 #include "third-party/json.hpp"
 
-DgoReader::DgoReader(std::string file_name, const std::vector<u8>& data)
-    : m_file_name(std::move(file_name)) {
-  BinaryReader reader(data);
+DgoReader::DgoReader(std::string file_name, std::vector<u8> data)
+    : m_data(std::move(data)), m_file_name(std::move(file_name)) {
+  BinaryReader reader(m_data);
   auto header = reader.read<DgoHeader>();
   m_internal_name = header.name;
   std::unordered_set<std::string> all_unique_names;
@@ -47,11 +46,10 @@ DgoReader::DgoReader(std::string file_name, const std::vector<u8>& data)
     }
 
     all_unique_names.insert(entry.unique_name);
-    entry.data.resize(obj_header.size);
 
     ASSERT((reader.get_seek() % 16) == 0);
-    memcpy(entry.data.data(), reader.here(), obj_header.size);
-    m_entries.push_back(entry);
+    entry.data = {reader.here(), obj_header.size};
+    m_entries.push_back(std::move(entry));
 
     reader.ffwd(align16(obj_header.size));
   }
@@ -1,23 +1,31 @@
 #pragma once
 
+#include <span>
 #include <string>
 #include <vector>
 
 #include "common/common_types.h"
 
 struct DgoDataEntry {
-  std::vector<u8> data;
+  std::span<const u8> data;  // points into the DgoReader's buffer
   std::string internal_name;
   std::string unique_name;
 };
 
+/*!
+ * Splits a (decompressed) DGO into its object files. The reader keeps the DGO data, and the entries
+ * refer to it without copying, so they are only valid while the reader exists.
+ */
 class DgoReader {
  public:
-  DgoReader(std::string file_name, const std::vector<u8>& data);
-  const std::vector<DgoDataEntry> entries() const { return m_entries; }
+  DgoReader(std::string file_name, std::vector<u8> data);
+  DgoReader(const DgoReader&) = delete;
+  DgoReader& operator=(const DgoReader&) = delete;
+  const std::vector<DgoDataEntry>& entries() const { return m_entries; }
   std::string description_as_json() const;
 
  private:
+  std::vector<u8> m_data;
   std::vector<DgoDataEntry> m_entries;
   std::string m_internal_name, m_file_name;
 };
\ No newline at end of file
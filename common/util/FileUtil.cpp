@@ -16,6 +16,7 @@
 
 #include "common/common_types.h"
 #include "common/util/BinaryReader.h"
+#include "common/util/SimpleThreadGroup.h"
 #include "common/util/string_util.h"
 #include "common/util/unicode_util.h"
 
@@ -31,8 +32,10 @@
 #define NOMINMAX
 #define WIN32_LEAN_AND_MEAN
 #include <Windows.h>
+#include <io.h>
 #else
 #include <cstring>
+#include <fcntl.h>
 #include <unistd.h>
 #endif
 #include "common/log/log.h"
@@ -329,6 +332,54 @@ void write_binary_file(const std::string& name, const void* data, size_t size) {
   write_binary_file(fs::path(name), data, size);
 }
 
+/*!
+ * Write a file so that a crash or power loss leaves either the old file or the new one, never a
+ * partial one: the data goes to a temporary file next to it, which is flushed to disk and then
+ * renamed over the old file. Returns false if anything failed, in which case the old file is left
+ * alone.
+ */
+bool write_binary_file_atomic(const fs::path& name, const void* data, size_t size) {
+  auto temp_name = name;
+  temp_name += ".tmp";
+  FILE* fp = file_util::open_file(temp_name, "wb");
+  if (!fp) {
+    lg::error("couldn't open file {}", temp_name.string());
+    return false;
+  }
+
+  bool ok = size == 0 || fwrite(data, size, 1, fp) == 1;
+  ok = fflush(fp) == 0 && ok;
+#ifdef _WIN32
+  ok = ok && _commit(_fileno(fp)) == 0;
+#else
+  ok = ok && fsync(fileno(fp)) == 0;
+#endif
+  ok = fclose(fp) == 0 && ok;
+  std::error_code ec;
+  if (!ok) {
+    lg::error("couldn't write file {}", temp_name.string());
+    fs::remove(temp_name, ec);
+    return false;
+  }
+
+  fs::rename(temp_name, name, ec);
+  if (ec) {
+    lg::error("couldn't rename {} to {}: {}", temp_name.string(), name.string(), ec.message());
+    fs::remove(temp_name, ec);
+    return false;
+  }
+
+#ifndef _WIN32
+  // the rename itself is only on disk once the directory is.
+  int dir_fd = open(name.parent_path().empty() ? "." : name.parent_path().c_str(), O_RDONLY);
+  if (dir_fd >= 0) {
+    fsync(dir_fd);
+    close(dir_fd);
+  }
+#endif
+  return true;
+}
+
 void write_rgba_png(const fs::path& name, void* data, int w, int h) {
   auto flags = 0;
 
@@ -646,15 +697,30 @@ bool dgo_header_is_compressed(const std::vector<u8>& data) {
 
 /*!
  * Decompress a DGO. Resulting data will start at the DGO header.
+ * The data is compressed in chunks that each decompress to MAX_CHUNK_SIZE bytes (except the last
+ * one), so the chunks are found first, then decompressed in parallel.
  */
 std::vector<u8> decompress_dgo(const std::vector<u8>& data_in) {
   constexpr int MAX_CHUNK_SIZE = 0x8000;
+  // small DGOs aren't worth starting threads for.
+  constexpr int MIN_CHUNKS_PER_THREAD = 8;
+
+  struct Chunk {
+    size_t input_offset;
+    size_t input_size;
+    size_t output_offset;
+    size_t output_size;
+    bool compressed;
+  };
+
   BinaryReader compressed_reader(data_in);
   // seek past oZlB
   compressed_reader.ffwd(4);
   std::size_t decompressed_size = compressed_reader.read<uint32_t>();
   std::vector<uint8_t> decompressed_data;
   decompressed_data.resize(decompressed_size);
+
+  std::vector<Chunk> chunks;
   size_t output_offset = 0;
   while (true) {
     // seek past alignment bytes and read the next chunk size
@@ -663,21 +729,23 @@ std::vector<u8> decompress_dgo(const std::vector<u8>& data_in) {
       chunk_size = compressed_reader.read<uint32_t>();
     }
 
+    Chunk chunk;
+    chunk.input_offset = compressed_reader.get_seek();
+    chunk.output_offset = output_offset;
+    chunk.output_size = std::min((size_t)MAX_CHUNK_SIZE, decompressed_size - output_offset);
     if (chunk_size < MAX_CHUNK_SIZE) {
-      std::size_t bytes_written = 0;
-      lzokay::EResult ok = lzokay::decompress(
-          compressed_reader.here(), chunk_size, decompressed_data.data() + output_offset,
-          decompressed_data.size() - output_offset, bytes_written);
-      ASSERT(ok == lzokay::EResult::Success);
-      compressed_reader.ffwd(chunk_size);
-      output_offset += bytes_written;
+      chunk.input_size = chunk_size;
+      chunk.compressed = true;
     } else {
       // nope - sometimes chunk_size is bigger than MAX, but we should still use max.
       //        ASSERT(chunk_size == MAX_CHUNK_SIZE);
-      memcpy(decompressed_data.data() + output_offset, compressed_reader.here(), MAX_CHUNK_SIZE);
-      compressed_reader.ffwd(MAX_CHUNK_SIZE);
-      output_offset += MAX_CHUNK_SIZE;
+      chunk.input_size = MAX_CHUNK_SIZE;
+      chunk.compressed = false;
     }
+    ASSERT(compressed_reader.bytes_left() >= chunk.input_size);
+    chunks.push_back(chunk);
+    compressed_reader.ffwd(chunk.input_size);
+    output_offset += MAX_CHUNK_SIZE;
 
     if (output_offset >= decompressed_size)
       break;
@@ -686,6 +754,35 @@ std::vector<u8> decompress_dgo(const std::vector<u8>& data_in) {
     }
   }
 
+  auto decompress_chunk = [&](int idx) {
+    const auto& chunk = chunks[idx];
+    if (chunk.compressed) {
+      std::size_t bytes_written = 0;
+      lzokay::EResult ok = lzokay::decompress(
+          data_in.data() + chunk.input_offset, chunk.input_size,
+          decompressed_data.data() + chunk.output_offset, chunk.output_size, bytes_written);
+      ASSERT(ok == lzokay::EResult::Success);
+      ASSERT_MSG(bytes_written == chunk.output_size,
+                 fmt::format("DGO chunk {} decompressed to {} bytes, expected {}", idx,
+                             bytes_written, chunk.output_size));
+    } else {
+      memcpy(decompressed_data.data() + chunk.output_offset, data_in.data() + chunk.input_offset,
+             chunk.output_size);
+    }
+  };
+
+  int num_threads = std::min((int)std::thread::hardware_concurrency(),
+                             (int)chunks.size() / MIN_CHUNKS_PER_THREAD);
+  if (num_threads <= 1) {
+    for (int i = 0; i < (int)chunks.size(); i++) {
+      decompress_chunk(i);
+    }
+  } else {
+    SimpleThreadGroup threads;
+    threads.run(decompress_chunk, chunks.size(), num_threads);
+    threads.join();
+  }
+
   return decompressed_data;
 }
 
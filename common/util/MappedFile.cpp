@@ -0,0 +1,52 @@
+#include "MappedFile.h"
+
+#include "common/common_types.h"
+#ifdef OS_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#elif _WIN32
+#include <fcntl.h>
+#include <io.h>
+
+#include "third-party/mman/mman.h"
+#endif
+
+#include "fmt/core.h"
+
+MappedFile::MappedFile(const fs::path& path) {
+#ifdef _WIN32
+  int fd = _wopen(path.wstring().c_str(), _O_RDONLY | _O_BINARY);
+#else
+  int fd = open(path.string().c_str(), O_RDONLY);
+#endif
+  if (fd < 0) {
+    throw std::runtime_error(fmt::format("Failed to open {} for mapping", path.string()));
+  }
+
+  m_size = fs::file_size(path);
+  void* mem = nullptr;
+  // mapping an empty file isn't allowed, but there's nothing to map anyway.
+  if (m_size > 0) {
+    mem = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+
+  // the mapping stays valid after the file is closed.
+#ifdef _WIN32
+  _close(fd);
+#else
+  close(fd);
+#endif
+
+  if (mem == MAP_FAILED) {
+    throw std::runtime_error(fmt::format("Failed to map {}", path.string()));
+  }
+  m_data = (u8*)mem;
+}
+
+MappedFile::~MappedFile() {
+  if (m_data) {
+    munmap(m_data, m_size);
+  }
+}
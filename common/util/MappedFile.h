@@ -0,0 +1,28 @@
+#pragma once
+
+/*!
+ * @file MappedFile.h
+ * Read-only access to a file through a memory mapping. Pages are only read from disk when they are
+ * first accessed, and can be dropped by the OS under memory pressure, so large files can be used
+ * without reading them into a buffer first.
+ */
+
+#include <span>
+
+#include "common/common_types.h"
+#include "common/util/FileUtil.h"
+
+class MappedFile {
+ public:
+  explicit MappedFile(const fs::path& path);
+  ~MappedFile();
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  std::span<const u8> data() const { return {m_data, m_size}; }
+  size_t size() const { return m_size; }
+
+ private:
+  u8* m_data = nullptr;
+  size_t m_size = 0;
+};
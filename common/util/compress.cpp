@@ -4,6 +4,7 @@
 #include <cstring>
 
 #include "common/util/Assert.h"
+#include "common/util/FileUtil.h"
 
 #include "fmt/core.h"
 #include "third-party/zstd/lib/zstd.h"
@@ -59,4 +60,73 @@ std::vector<u8> compress_zstd_no_header(const void* data, size_t size) {
   result.resize(compressed_size);
   return result;
 }
+
+/*!
+ * Decompress data from compress_zstd_no_header. The decompressed size must be known, and dst must
+ * be exactly that size.
+ */
+void decompress_zstd_no_header(const void* data, size_t size, void* dst, size_t dst_size) {
+  auto decomp_size = ZSTD_decompress(dst, dst_size, data, size);
+  if (ZSTD_isError(decomp_size)) {
+    ASSERT_MSG(false, fmt::format("ZSTD error: {}", ZSTD_getErrorName(decomp_size)));
+  }
+  ASSERT(decomp_size == dst_size);
+}
+
+ZstdFileWriter::ZstdFileWriter(const std::string& path) {
+  m_file = file_util::open_file(path, "wb");
+  if (!m_file) {
+    return;
+  }
+  m_ctx = ZSTD_createCCtx();
+  ZSTD_CCtx_setParameter(m_ctx, ZSTD_c_compressionLevel, 1);
+  m_out.resize(ZSTD_CStreamOutSize());
+}
+
+ZstdFileWriter::~ZstdFileWriter() {
+  close();
+}
+
+void ZstdFileWriter::compress(const void* data, size_t size, int mode) {
+  ZSTD_inBuffer in = {data, size, 0};
+  bool done = false;
+  while (!done) {
+    ZSTD_outBuffer out = {m_out.data(), m_out.size(), 0};
+    auto remaining = ZSTD_compressStream2(m_ctx, &out, &in, (ZSTD_EndDirective)mode);
+    if (ZSTD_isError(remaining)) {
+      ASSERT_MSG(false, fmt::format("ZSTD error: {}", ZSTD_getErrorName(remaining)));
+    }
+    fwrite(m_out.data(), 1, out.pos, m_file);
+    // continue is done once all input is taken, flush and end once zstd has nothing left.
+    done = mode == ZSTD_e_continue ? in.pos == in.size : remaining == 0;
+  }
+}
+
+void ZstdFileWriter::write(const void* data, size_t size) {
+  if (m_file) {
+    compress(data, size, ZSTD_e_continue);
+  }
+}
+
+/*!
+ * Write out everything so far, so it can be read back even if the file is never closed.
+ */
+void ZstdFileWriter::flush() {
+  if (m_file) {
+    compress(nullptr, 0, ZSTD_e_flush);
+    fflush(m_file);
+  }
+}
+
+void ZstdFileWriter::close() {
+  if (m_file) {
+    compress(nullptr, 0, ZSTD_e_end);
+    fclose(m_file);
+    m_file = nullptr;
+  }
+  if (m_ctx) {
+    ZSTD_freeCCtx(m_ctx);
+    m_ctx = nullptr;
+  }
+}
 }  // namespace compression
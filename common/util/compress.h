@@ -1,12 +1,43 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdio>
+#include <string>
 #include <vector>
 
 #include "common/common_types.h"
+
+struct ZSTD_CCtx_s;
+
 namespace compression {
 // compress and decompress data with zstd
 std::vector<u8> compress_zstd(const void* data, size_t size);
 std::vector<u8> decompress_zstd(const void* data, size_t size);
 std::vector<u8> compress_zstd_no_header(const void* data, size_t size);
+void decompress_zstd_no_header(const void* data, size_t size, void* dst, size_t dst_size);
+
+/*!
+ * Compresses data with zstd as it is written to a file, so there's no need to have all of it in
+ * memory. The file is a single zstd frame, and everything up to the last flush can be read back
+ * even if the file is never closed.
+ */
+class ZstdFileWriter {
+ public:
+  explicit ZstdFileWriter(const std::string& path);
+  ~ZstdFileWriter();
+  ZstdFileWriter(const ZstdFileWriter&) = delete;
+  ZstdFileWriter& operator=(const ZstdFileWriter&) = delete;
+
+  bool is_open() const { return m_file; }
+  void write(const void* data, size_t size);
+  void flush();
+  void close();
+
+ private:
+  void compress(const void* data, size_t size, int mode);
+
+  FILE* m_file = nullptr;
+  ZSTD_CCtx_s* m_ctx = nullptr;
+  std::vector<u8> m_out;
+};
 }  // namespace compression
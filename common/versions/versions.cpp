@@ -1,10 +1,24 @@
 #include "versions.h"
 
+#include <mutex>
+#include <unordered_map>
+
 #include "common/util/Assert.h"
+#include "common/util/FileUtil.h"
+#include "common/util/unicode_util.h"
 #include "common/versions/revision.h"
 
 #include "fmt/core.h"
 #include "fmt/format.h"
+#include "third-party/zstd/lib/common/xxhash.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <dlfcn.h>
+#endif
 
 GameVersion game_name_to_version(const std::string& name) {
   if (name == "jak1") {
@@ -62,3 +76,46 @@ std::string build_revision() {
   }
   return "Unknown Revision";
 }
+
+/*!
+ * Get a hash of the executable or shared library that contains the code at the given address.
+ * Unlike build_revision, which is only updated when cmake runs, this changes whenever that code is
+ * rebuilt, so it can be used in the key of a cache of output that the code generates. Returns 0 if
+ * the file can't be found.
+ */
+u64 code_module_hash(const void* address) {
+  std::string path;
+#ifdef _WIN32
+  HMODULE module = nullptr;
+  wchar_t buffer[MAX_PATH];
+  if (GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                             GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                         (LPCWSTR)address, &module) &&
+      GetModuleFileNameW(module, buffer, MAX_PATH)) {
+    path = wide_string_to_utf8_string(buffer);
+  }
+#else
+  Dl_info info;
+  if (dladdr(address, &info) && info.dli_fname) {
+    path = info.dli_fname;
+  }
+#endif
+  if (path.empty()) {
+    return 0;
+  }
+
+  // only read each file once.
+  static std::mutex mutex;
+  static std::unordered_map<std::string, u64> hashes;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = hashes.find(path);
+  if (it == hashes.end()) {
+    u64 hash = 0;
+    if (fs::exists(path)) {
+      auto data = file_util::read_binary_file(path);
+      hash = XXH64(data.data(), data.size(), 0);
+    }
+    it = hashes.insert({path, hash}).first;
+  }
+  return it->second;
+}
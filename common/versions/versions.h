@@ -15,6 +15,10 @@ namespace versions {
 constexpr s32 GOAL_VERSION_MAJOR = 1;
 constexpr s32 GOAL_VERSION_MINOR = 0;
 
+// version of what the compiler and build tools produce. Increase this when a change to them changes
+// their output, so a shared build cache doesn't restore outputs from older tools.
+constexpr s32 BUILD_OUTPUT_VERSION = 1;
+
 namespace jak1 {
 // these versions are from the game
 constexpr u32 ART_FILE_VERSION = 6;
@@ -67,3 +71,4 @@ std::string version_to_game_name_external(GameVersion v);
 std::vector<std::string> valid_game_version_names();
 
 std::string build_revision();
+u64 code_module_hash(const void* address);
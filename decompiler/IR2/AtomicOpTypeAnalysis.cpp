@@ -1290,8 +1290,7 @@ TypeState CallOp::propagate_types_internal(const TypeState& input,
         TP_Type::make_from_ts(dts.type_prop_settings.current_method_type);
     // update the call type
     m_call_type = in_tp.get_method_new_object_typespec();
-    m_call_type.get_arg(m_call_type.arg_count() - 1) =
-        TypeSpec(dts.type_prop_settings.current_method_type);
+    m_call_type.set_last_arg(TypeSpec(dts.type_prop_settings.current_method_type));
     m_call_type_set = true;
 
     m_read_regs.clear();
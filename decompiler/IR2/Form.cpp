@@ -1,6 +1,7 @@
 #include "Form.h"
 
 #include <algorithm>
+#include <cstddef>
 #include <utility>
 
 #include "common/goos/PrettyPrinter.h"
@@ -20,13 +21,44 @@ namespace decompiler {
 // FormPool
 ///////////////////
 
+namespace {
+// most functions only need a few forms, so start small and grow for big functions.
+constexpr size_t FORM_POOL_MIN_BLOCK_SIZE = 4 * 1024;
+constexpr size_t FORM_POOL_MAX_BLOCK_SIZE = 256 * 1024;
+}  // namespace
+
+void* FormPool::allocate(size_t size, size_t align) {
+  ASSERT(align <= alignof(std::max_align_t));
+  size_t padding = (align - ((uintptr_t)m_next % align)) % align;
+  if (!m_next || padding + size > m_remaining) {
+    // blocks from new[] are aligned for any type.
+    size_t block_size = FORM_POOL_MIN_BLOCK_SIZE;
+    if (!m_blocks.empty()) {
+      block_size = std::min<size_t>(2 * m_stats.block_bytes, FORM_POOL_MAX_BLOCK_SIZE);
+    }
+    block_size = std::max(block_size, size);
+    m_blocks.emplace_back(new u8[block_size]);
+    m_next = m_blocks.back().get();
+    m_remaining = block_size;
+    m_stats.blocks++;
+    m_stats.block_bytes += block_size;
+    padding = 0;
+  }
+
+  void* result = m_next + padding;
+  m_next += padding + size;
+  m_remaining -= padding + size;
+  m_stats.bytes += size;
+  return result;
+}
+
 FormPool::~FormPool() {
   for (auto& x : m_forms) {
-    delete x;
+    x->~Form();
   }
 
   for (auto& x : m_elements) {
-    delete x;
+    x->~FormElement();
   }
 }
 
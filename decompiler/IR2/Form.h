@@ -13,6 +13,7 @@
 #include "decompiler/Disasm/DecompilerLabel.h"
 #include "decompiler/Disasm/Register.h"
 #include "decompiler/IR2/AtomicOp.h"
+#include "decompiler/IR2/FormPoolStats.h"
 #include "decompiler/IR2/LabelDB.h"
 #include "decompiler/ObjectFile/LinkedWord.h"
 
@@ -2050,55 +2051,55 @@ class CfgVtx;
  * It will clean up everything when it is destroyed.
  * As a result, you don't need to worry about deleting / referencing counting when manipulating
  * a Form graph.
+ *
+ * Forms and elements are placed one after another in large blocks, instead of getting their own
+ * heap allocation. Nothing is freed until the pool is destroyed, then all destructors are run and
+ * the blocks are released together.
  */
 class FormPool {
  public:
+  FormPool() = default;
+  FormPool(const FormPool&) = delete;
+  FormPool& operator=(const FormPool&) = delete;
+
   template <typename T, class... Args>
   T* alloc_element(Args&&... args) {
-    auto elt = new T(std::forward<Args>(args)...);
-    m_elements.emplace_back(elt);
+    static_assert(std::is_base_of_v<FormElement, T>);
+    auto elt = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    m_elements.push_back(elt);
+    m_stats.elements++;
     return elt;
   }
 
   template <typename T, class... Args>
   Form* alloc_single_element_form(FormElement* parent, Args&&... args) {
-    auto elt = new T(std::forward<Args>(args)...);
-    m_elements.emplace_back(elt);
+    auto elt = alloc_element<T>(std::forward<Args>(args)...);
     auto form = alloc_single_form(parent, elt);
     return form;
   }
 
   template <typename T, class... Args>
   Form* form(Args&&... args) {
-    auto elt = new T(std::forward<Args>(args)...);
-    m_elements.emplace_back(elt);
+    auto elt = alloc_element<T>(std::forward<Args>(args)...);
     auto form = alloc_single_form(nullptr, elt);
     return form;
   }
 
   Form* alloc_single_form(FormElement* parent, FormElement* elt) {
-    auto form = new Form(parent, elt);
-    m_forms.push_back(form);
-    return form;
+    return alloc_form(parent, elt);
   }
 
   Form* alloc_sequence_form(FormElement* parent, const std::vector<FormElement*> sequence) {
-    auto form = new Form(parent, sequence);
-    m_forms.push_back(form);
-    return form;
+    return alloc_form(parent, sequence);
   }
 
   Form* acquire(std::unique_ptr<Form> form_ptr) {
-    Form* form = form_ptr.release();
-    m_forms.push_back(form);
+    Form* form = form_ptr.get();
+    m_acquired_forms.push_back(std::move(form_ptr));
     return form;
   }
 
-  Form* alloc_empty_form() {
-    Form* form = new Form;
-    m_forms.push_back(form);
-    return form;
-  }
+  Form* alloc_empty_form() { return alloc_form(); }
 
   Form* lookup_cached_conversion(const CfgVtx* vtx) const {
     auto it = m_vtx_to_form_cache.find(vtx);
@@ -2113,11 +2114,28 @@ class FormPool {
     m_vtx_to_form_cache[vtx] = form;
   }
 
+  const FormPoolStats& stats() const { return m_stats; }
+
   ~FormPool();
 
  private:
+  template <class... Args>
+  Form* alloc_form(Args&&... args) {
+    auto form = new (allocate(sizeof(Form), alignof(Form))) Form(std::forward<Args>(args)...);
+    m_forms.push_back(form);
+    m_stats.forms++;
+    return form;
+  }
+
+  void* allocate(size_t size, size_t align);
+
   std::vector<Form*> m_forms;
   std::vector<FormElement*> m_elements;
+  std::vector<std::unique_ptr<Form>> m_acquired_forms;
+  std::vector<std::unique_ptr<u8[]>> m_blocks;
+  u8* m_next = nullptr;
+  size_t m_remaining = 0;
+  FormPoolStats m_stats;
   std::unordered_map<const CfgVtx*, Form*> m_vtx_to_form_cache;
 };
 
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+
+#include "common/common_types.h"
+
+#include "fmt/core.h"
+
+namespace decompiler {
+/*!
+ * Counts of what a FormPool has allocated.
+ */
+struct FormPoolStats {
+  u64 forms = 0;
+  u64 elements = 0;
+  u64 bytes = 0;  // bytes used by forms and elements
+  u64 blocks = 0;
+  u64 block_bytes = 0;  // bytes reserved from the heap
+
+  FormPoolStats& operator+=(const FormPoolStats& other) {
+    forms += other.forms;
+    elements += other.elements;
+    bytes += other.bytes;
+    blocks += other.blocks;
+    block_bytes += other.block_bytes;
+    return *this;
+  }
+
+  FormPoolStats operator-(const FormPoolStats& other) const {
+    FormPoolStats result;
+    result.forms = forms - other.forms;
+    result.elements = elements - other.elements;
+    result.bytes = bytes - other.bytes;
+    result.blocks = blocks - other.blocks;
+    result.block_bytes = block_bytes - other.block_bytes;
+    return result;
+  }
+
+  std::string print() const {
+    return fmt::format("{:9d} forms {:9d} elements {:8.2f} MB in {:6d} blocks ({:8.2f} MB)", forms,
+                       elements, bytes / (1024. * 1024.), blocks, block_bytes / (1024. * 1024.));
+  }
+};
+}  // namespace decompiler
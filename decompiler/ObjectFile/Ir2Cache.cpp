@@ -0,0 +1,250 @@
+#include "Ir2Cache.h"
+
+#include <map>
+#include <set>
+
+#include "common/log/log.h"
+#include "common/versions/versions.h"
+
+#include "decompiler/ObjectFile/ObjectFileDB.h"
+#include "decompiler/config.h"
+#include "decompiler/util/DecompilerTypeSystem.h"
+
+#include "fmt/core.h"
+#include "third-party/json.hpp"
+#include "third-party/zstd/lib/common/xxhash.h"
+
+namespace decompiler {
+namespace {
+// change this if the cache format changes, or to force everything to be decompiled again.
+constexpr int IR2_CACHE_VERSION = 2;
+
+u64 hash_string(const std::string& str) {
+  return XXH64(str.data(), str.size(), 0);
+}
+
+template <typename T>
+std::map<std::string, T> sorted(const std::unordered_map<std::string, T>& in) {
+  return std::map<std::string, T>(in.begin(), in.end());
+}
+
+std::string describe_metadata(const std::string& name,
+                              const std::unordered_map<std::string, DefinitionMetadata>& in) {
+  std::string result;
+  for (const auto& [handler, meta] : sorted(in)) {
+    result += fmt::format("{} {}: {}\n", name, handler, meta.docstring.value_or(""));
+  }
+  return result;
+}
+}  // namespace
+
+Ir2Cache::Ir2Cache(const fs::path& dir, const Config& config, const DecompilerTypeSystem& dts)
+    : m_dir(dir), m_dts(dts) {
+  file_util::create_dir_if_needed(m_dir);
+
+  // the decompiler and common code can be in different shared libraries, so check both. This
+  // catches rebuilds that build_revision misses, because it only changes when cmake runs.
+  std::string global = fmt::format(
+      "{} {:x} {:x} {} {:x}\n", IR2_CACHE_VERSION,
+      code_module_hash(reinterpret_cast<const void*>(&read_config_file)),
+      code_module_hash(reinterpret_cast<const void*>(&code_module_hash)),
+      (int)config.game_version, config.cache_inputs.global_hash);
+  // art groups, joints and textures are found in other objects, and any object can use them.
+  for (const auto& [group, elts] : sorted(dts.art_group_info)) {
+    for (const auto& [idx, elt] : std::map<int, std::string>(elts.begin(), elts.end())) {
+      global += fmt::format("ag {} {} {}\n", group, idx, elt);
+    }
+  }
+  for (const auto& [group, joints] : sorted(dts.jg_info)) {
+    for (const auto& [idx, joint] : std::map<int, std::string>(joints.begin(), joints.end())) {
+      global += fmt::format("jg {} {} {}\n", group, idx, joint);
+    }
+  }
+  for (const auto& [id, tex] : std::map<u32, TexInfo>(dts.textures.begin(), dts.textures.end())) {
+    global += fmt::format("tex {} {} {} {}\n", id, tex.name, tex.tpage_name, tex.idx);
+  }
+  m_global_hash = hash_string(global);
+}
+
+fs::path Ir2Cache::entry_path(const ObjectFileData& data) const {
+  return m_dir / (data.to_unique_name() + ".json");
+}
+
+/*!
+ * Everything about a symbol that the decompiled code for an object using it could depend on.
+ */
+std::string Ir2Cache::describe_symbol(const std::string& name) const {
+  std::string result = "symbol " + name;
+  auto type_it = m_dts.symbol_types.find(name);
+  if (type_it != m_dts.symbol_types.end()) {
+    result += " " + type_it->second.print();
+  }
+  auto meta_it = m_dts.symbol_metadata_map.find(name);
+  if (meta_it != m_dts.symbol_metadata_map.end()) {
+    result += " " + meta_it->second.docstring.value_or("");
+  }
+  result += "\n";
+  auto state_it = m_dts.state_metadata.find(name);
+  if (state_it != m_dts.state_metadata.end()) {
+    result += describe_metadata(name, state_it->second);
+  }
+  return result;
+}
+
+/*!
+ * Compute the part of the key that can be checked before decompiling. The type definitions used
+ * are only known after decompiling, so they are stored in the entry and checked in lookup.
+ */
+u64 Ir2Cache::compute_key(const ObjectFileData& data, const Config& config) const {
+  std::string key = fmt::format("{:x} {} {:x}\n", m_global_hash, data.to_unique_name(),
+                                XXH64(data.data.data(), data.data.size(), 0));
+
+  auto add_config = [&](const std::string& name) {
+    auto it = config.cache_inputs.by_name.find(name);
+    if (it != config.cache_inputs.by_name.end()) {
+      key += it->second;
+    }
+  };
+  add_config(data.to_unique_name());
+  // left over from the previous object, and used by functions that call an object new method.
+  key += fmt::format("method-type {}\n", m_dts.type_prop_settings.current_method_type);
+
+  // function types are found before IR2, so they won't be recorded as type lookups.
+  for (const auto& seg_functions : data.linked_data.functions_by_seg) {
+    for (const auto& func : seg_functions) {
+      key += fmt::format("function {} {}\n", func.name(), func.type.print());
+      add_config(func.name());
+      if (func.guessed_name.kind == FunctionName::FunctionKind::METHOD) {
+        auto states_it = m_dts.virtual_state_metadata.find(func.guessed_name.type_name);
+        if (states_it != m_dts.virtual_state_metadata.end()) {
+          for (const auto& [state, handlers] : sorted(states_it->second)) {
+            key += describe_metadata(state, handlers);
+          }
+        }
+      }
+    }
+  }
+
+  // the object can only use symbols that it links to.
+  std::set<std::string> symbols;
+  for (const auto& words : data.linked_data.words_by_seg) {
+    for (const auto& word : words) {
+      if (word.holds_string()) {
+        symbols.insert(word.symbol_name());
+      }
+    }
+  }
+  for (const auto& sym : symbols) {
+    key += describe_symbol(sym);
+  }
+
+  return hash_string(key);
+}
+
+u64 Ir2Cache::type_hash(const std::string& type_name) {
+  std::lock_guard<std::mutex> lock(m_type_hash_mutex);
+  auto it = m_type_hashes.find(type_name);
+  if (it == m_type_hashes.end()) {
+    it = m_type_hashes.insert({type_name, hash_string(m_dts.ts.type_definition_text(type_name))})
+             .first;
+  }
+  return it->second;
+}
+
+/*!
+ * Get the cached result for this object, if the key matches and none of the types it used
+ * have changed.
+ */
+std::optional<Ir2Cache::Result> Ir2Cache::lookup(const ObjectFileData& data, u64 key) {
+  auto path = entry_path(data);
+  std::optional<Result> result;
+  double saved_ms = 0;
+
+  if (fs::exists(path)) {
+    try {
+      auto json = nlohmann::json::parse(file_util::read_text_file(path));
+      bool valid = json.at("key").get<u64>() == key;
+      if (valid) {
+        for (const auto& [type_name, hash] : json.at("types").items()) {
+          if (type_hash(type_name) != hash.get<u64>()) {
+            valid = false;
+            break;
+          }
+        }
+      }
+
+      if (valid) {
+        result.emplace();
+        for (const auto& file : json.at("files")) {
+          result->files.emplace_back(file.at(0).get<std::string>(), file.at(1).get<std::string>());
+        }
+        const auto& defs = json.at("symbol_defs");
+        if (!defs.is_null()) {
+          auto& symbol_defs = result->symbol_defs.emplace();
+          symbol_defs.object_file_name = defs.at("name").get<std::string>();
+          symbol_defs.load_stores = defs.at("load_stores").get<std::vector<std::string>>();
+          symbol_defs.deftypes = defs.at("deftypes").get<std::vector<std::string>>();
+        }
+        result->method_type_after = json.at("method_type_after").get<std::string>();
+        saved_ms = json.at("decompile_ms").get<double>();
+      }
+    } catch (const std::exception& e) {
+      lg::warn("Ignoring bad IR2 cache entry {}: {}", path.string(), e.what());
+      result.reset();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(m_stats_mutex);
+  if (result) {
+    m_stats.hits++;
+    m_stats.saved_ms += saved_ms;
+  } else {
+    m_stats.misses++;
+  }
+  return result;
+}
+
+void Ir2Cache::store(const ObjectFileData& data,
+                     u64 key,
+                     const std::unordered_set<std::string>& types_used,
+                     const Result& result,
+                     double decompile_ms) {
+  nlohmann::json json;
+  json["key"] = key;
+  json["decompile_ms"] = decompile_ms;
+  json["method_type_after"] = result.method_type_after;
+
+  auto& types = json["types"] = nlohmann::json::object();
+  for (const auto& type_name : types_used) {
+    types[type_name] = type_hash(type_name);
+  }
+
+  auto& files = json["files"] = nlohmann::json::array();
+  for (const auto& [name, text] : result.files) {
+    files.push_back({name, text});
+  }
+
+  if (result.symbol_defs) {
+    json["symbol_defs"] = {{"name", result.symbol_defs->object_file_name},
+                           {"load_stores", result.symbol_defs->load_stores},
+                           {"deftypes", result.symbol_defs->deftypes}};
+  } else {
+    json["symbol_defs"] = nullptr;
+  }
+
+  // write to a temporary file first, so an interrupted decompile can't leave a truncated entry.
+  auto path = entry_path(data);
+  auto temp_path = path;
+  temp_path += ".tmp";
+  file_util::write_text_file(temp_path, json.dump());
+  fs::rename(temp_path, path);
+}
+
+std::string Ir2Cache::print_stats() const {
+  std::lock_guard<std::mutex> lock(m_stats_mutex);
+  int total = m_stats.hits + m_stats.misses;
+  return fmt::format("IR2 cache: {} hits, {} misses ({:.1f}% hit rate), saved {:.2f} s",
+                     m_stats.hits, m_stats.misses, total ? 100. * m_stats.hits / total : 0.,
+                     m_stats.saved_ms / 1000.);
+}
+}  // namespace decompiler
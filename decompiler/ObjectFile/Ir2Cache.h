@@ -0,0 +1,72 @@
+#pragma once
+
+/*!
+ * @file Ir2Cache.h
+ * An on-disk cache of IR2 output, so an object is only decompiled again when something it depends
+ * on has changed. An entry is reused if:
+ * - the object's bytes, function types, and config entries for its functions are the same
+ * - the global config and the decompiler build are the same
+ * - every type definition that was looked up while decompiling it is the same
+ */
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "common/common_types.h"
+#include "common/util/FileUtil.h"
+
+#include "decompiler/analysis/symbol_def_map.h"
+
+namespace decompiler {
+struct Config;
+struct ObjectFileData;
+class DecompilerTypeSystem;
+
+class Ir2Cache {
+ public:
+  /*!
+   * Everything that running IR2 on an object produces that's used later.
+   */
+  struct Result {
+    std::vector<std::pair<std::string, std::string>> files;  // name in output dir, text
+    std::optional<SymbolMapBuilder::ObjectSymbols> symbol_defs;
+    // the method type left in type_prop_settings, which carries over to the next object.
+    std::string method_type_after;
+  };
+
+  Ir2Cache(const fs::path& dir, const Config& config, const DecompilerTypeSystem& dts);
+  u64 compute_key(const ObjectFileData& data, const Config& config) const;
+  std::optional<Result> lookup(const ObjectFileData& data, u64 key);
+  void store(const ObjectFileData& data,
+             u64 key,
+             const std::unordered_set<std::string>& types_used,
+             const Result& result,
+             double decompile_ms);
+  std::string print_stats() const;
+
+ private:
+  u64 type_hash(const std::string& type_name);
+  fs::path entry_path(const ObjectFileData& data) const;
+  std::string describe_symbol(const std::string& name) const;
+
+  fs::path m_dir;
+  const DecompilerTypeSystem& m_dts;
+  u64 m_global_hash = 0;
+
+  // types can't change during IR2, so only print each one once.
+  std::mutex m_type_hash_mutex;
+  std::unordered_map<std::string, u64> m_type_hashes;
+
+  mutable std::mutex m_stats_mutex;
+  struct {
+    int hits = 0;
+    int misses = 0;
+    double saved_ms = 0;
+  } m_stats;
+};
+}  // namespace decompiler
@@ -7,23 +7,49 @@
  * (there may be different object files with the same name sometimes)
  */
 
+#include <condition_variable>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
+#include "Ir2Cache.h"
 #include "LinkedObjectFile.h"
 
 #include "common/common_types.h"
 #include "common/util/Assert.h"
 #include "common/util/FileUtil.h"
 
+#include "decompiler/IR2/FormPoolStats.h"
 #include "decompiler/analysis/symbol_def_map.h"
 #include "decompiler/data/TextureDB.h"
+#include "decompiler/types2/IterationStats.h"
 #include "decompiler/util/DecompilerTypeSystem.h"
 
 #include "fmt/core.h"
 
 namespace decompiler {
+/*!
+ * The type of the last method analyzed is carried over from one object to the next, see
+ * DecompilerTypeSystem::TypePropSettings. When objects are analyzed in parallel, this hands each
+ * object the method type that it would start with in a serial run.
+ */
+class MethodTypeChain {
+ public:
+  MethodTypeChain(int object_count, const std::string& initial);
+  bool known_before(int obj_idx);
+  bool wait_before(int obj_idx, std::string* result);
+  void set_after(int obj_idx, const std::string& method_type);
+  void abort();
+
+ private:
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::vector<std::optional<std::string>> m_before;  // index i is the type before object i
+  bool m_aborted = false;
+};
+
 /*!
  * A "record" which can be used to identify an object file.
  */
@@ -52,6 +78,9 @@ struct ObjectFileData {
 
   std::string full_output;
   std::string output_with_skips;
+
+  // symbols found by the IR2 pass, waiting to be added to the symbol map in object order.
+  std::optional<SymbolMapBuilder::ObjectSymbols> symbol_defs;
 };
 
 /*!
@@ -146,6 +175,7 @@ struct LetRewriteStats {
     ja += other.ja;
     set_vector += other.set_vector;
     set_vector2 += other.set_vector2;
+    set_vector3 += other.set_vector3;
     case_no_else += other.case_no_else;
     case_with_else += other.case_with_else;
     unused += other.unused;
@@ -157,6 +187,7 @@ struct LetRewriteStats {
     rand_float_gen += other.rand_float_gen;
     set_let += other.set_let;
     with_dma_buf_add_bucket += other.with_dma_buf_add_bucket;
+    dma_buffer_add_gs_set += other.dma_buffer_add_gs_set;
     launch_particles += other.launch_particles;
     return *this;
   }
@@ -191,7 +222,9 @@ class ObjectFileDB {
       const fs::path& output_dir,
       const Config& config,
       const std::unordered_set<std::string>& skip_functions,
-      const std::unordered_map<std::string, std::unordered_set<std::string>>& skip_states);
+      const std::unordered_map<std::string, std::unordered_set<std::string>>& skip_states,
+      MethodTypeChain* method_types = nullptr,
+      int obj_idx = 0);
   void analyze_functions_ir2(
       const fs::path& output_dir,
       const Config& config,
@@ -214,10 +247,11 @@ class ObjectFileDB {
   void ir2_rewrite_inline_asm_instructions(int seg, ObjectFileData& data);
   void ir2_insert_anonymous_functions(int seg, ObjectFileData& data);
   void ir2_symbol_definition_map(ObjectFileData& data);
-  void ir2_write_results(const fs::path& output_dir,
-                         const Config& config,
-                         const std::vector<std::string>& imports,
-                         ObjectFileData& data);
+  std::vector<std::pair<std::string, std::string>> ir2_write_results(
+      const fs::path& output_dir,
+      const Config& config,
+      const std::vector<std::string>& imports,
+      ObjectFileData& data);
   void ir2_do_segment_analysis_phase1(int seg, const Config& config, ObjectFileData& data);
   void ir2_do_segment_analysis_phase2(int seg, const Config& config, ObjectFileData& data);
   void ir2_setup_labels(const Config& config, ObjectFileData& data);
@@ -387,6 +421,14 @@ class ObjectFileDB {
 
   struct {
     LetRewriteStats let;
+    // what FormPools allocated, by the IR2 pass that allocated it.
+    struct {
+      FormPoolStats structure;
+      FormPoolStats expressions;
+      FormPoolStats lets;
+      FormPoolStats total;
+    } form_pool;
+    types2::IterationStats types2;
     uint32_t total_dgo_bytes = 0;
     uint32_t total_obj_files = 0;
     uint32_t unique_obj_files = 0;
@@ -396,7 +438,18 @@ class ObjectFileDB {
   GameVersion version() const { return m_version; }
 
  private:
+  void analyze_functions_ir2_parallel(
+      const fs::path& output_dir,
+      const Config& config,
+      int num_threads,
+      const std::unordered_set<std::string>& skip_functions,
+      const std::unordered_map<std::string, std::unordered_set<std::string>>& skip_states);
+  void flush_symbol_definitions(ObjectFileData& data);
+  std::optional<std::string> last_analyzed_method_type(const Config& config, ObjectFileData& data);
+
   GameVersion m_version;
+  std::unique_ptr<Ir2Cache> m_ir2_cache;
+  std::mutex m_stats_mutex;  // guards stats, which is updated by all IR2 workers
 };
 
 std::string print_art_elt_for_dump(const std::string& group_name, const std::string& name, int idx);
@@ -5,11 +5,16 @@
 
 #include "ObjectFileDB.h"
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
 #include "common/formatter/formatter.h"
 #include "common/goos/PrettyPrinter.h"
 #include "common/link_types.h"
 #include "common/log/log.h"
 #include "common/util/FileUtil.h"
+#include "common/util/SimpleThreadGroup.h"
 #include "common/util/Timer.h"
 #include "common/util/string_util.h"
 
@@ -35,16 +40,124 @@
 
 namespace decompiler {
 
+namespace {
+FormPoolStats form_pool_stats(const Function& func) {
+  return func.ir2.form_pool ? func.ir2.form_pool->stats() : FormPoolStats();
+}
+}  // namespace
+
+MethodTypeChain::MethodTypeChain(int object_count, const std::string& initial)
+    : m_before(object_count + 1) {
+  m_before.at(0) = initial;
+}
+
+bool MethodTypeChain::known_before(int obj_idx) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_before.at(obj_idx).has_value();
+}
+
+/*!
+ * Wait until the objects before this one have determined the method type it starts with.
+ * Returns false if the run was aborted instead.
+ */
+bool MethodTypeChain::wait_before(int obj_idx, std::string* result) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_cv.wait(lock, [&]() { return m_aborted || m_before.at(obj_idx).has_value(); });
+  if (m_aborted) {
+    return false;
+  }
+  *result = *m_before.at(obj_idx);
+  return true;
+}
+
+void MethodTypeChain::set_after(int obj_idx, const std::string& method_type) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_before.at(obj_idx + 1) = method_type;
+  }
+  m_cv.notify_all();
+}
+
+void MethodTypeChain::abort() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_aborted = true;
+  }
+  m_cv.notify_all();
+}
+
+/*!
+ * Run IR2 on a single object. When objects run in parallel, method_types gives the method type
+ * carried over from the objects before obj_idx, and receives the one this object leaves behind.
+ */
 void ObjectFileDB::process_object_file_data(
     ObjectFileData& data,
     const fs::path& output_dir,
     const Config& config,
     const std::unordered_set<std::string>& skip_functions,
-    const std::unordered_map<std::string, std::unordered_set<std::string>>& skip_states) {
+    const std::unordered_map<std::string, std::unordered_set<std::string>>& skip_states,
+    MethodTypeChain* method_types,
+    int obj_idx) {
   Timer file_timer;
-  ir2_do_segment_analysis_phase1(TOP_LEVEL_SEGMENT, config, data);
-  ir2_do_segment_analysis_phase1(DEBUG_SEGMENT, config, data);
-  ir2_do_segment_analysis_phase1(MAIN_SEGMENT, config, data);
+  bool did_phase1 = false;
+  bool sent_method_type = false;
+  auto run_phase1 = [&]() {
+    ir2_do_segment_analysis_phase1(TOP_LEVEL_SEGMENT, config, data);
+    ir2_do_segment_analysis_phase1(DEBUG_SEGMENT, config, data);
+    ir2_do_segment_analysis_phase1(MAIN_SEGMENT, config, data);
+    did_phase1 = true;
+    if (method_types) {
+      // if this object analyzes a method, the next object can start without waiting for us.
+      auto method_type = last_analyzed_method_type(config, data);
+      if (method_type) {
+        method_types->set_after(obj_idx, *method_type);
+        sent_method_type = true;
+      }
+    }
+  };
+
+  if (method_types) {
+    // phase 1 doesn't use the method type, so run it while earlier objects work out theirs. With
+    // the cache, a hit makes it unnecessary, so only start early if we would have to wait anyway.
+    if (!m_ir2_cache || !method_types->known_before(obj_idx)) {
+      run_phase1();
+    }
+    if (!method_types->wait_before(obj_idx, &dts.type_prop_settings.current_method_type)) {
+      return;
+    }
+  }
+
+  std::optional<u64> cache_key;
+  std::optional<TypeLookupRecorder> type_recorder;
+  if (m_ir2_cache) {
+    cache_key = m_ir2_cache->compute_key(data, config);
+    auto cached = m_ir2_cache->lookup(data, *cache_key);
+    if (cached) {
+      for (const auto& [file_name, text] : cached->files) {
+        file_util::write_text_file(output_dir / file_name, text);
+      }
+      data.symbol_defs = cached->symbol_defs;
+      dts.type_prop_settings.current_method_type = cached->method_type_after;
+      if (method_types && !sent_method_type) {
+        method_types->set_after(obj_idx, cached->method_type_after);
+      }
+      if (did_phase1) {
+        for_each_function_def_order_in_obj(data, [&](Function& f, int) { f.ir2 = {}; });
+      }
+      lg::info("Done (cached) in {:.2f}ms", file_timer.getMs());
+      return;
+    }
+    // remember which types are used, they are part of the cache key.
+    type_recorder.emplace();
+  }
+
+  if (!did_phase1) {
+    run_phase1();
+  }
+  if (method_types && !sent_method_type) {
+    // no method is analyzed here, so the method type passes through unchanged.
+    method_types->set_after(obj_idx, dts.type_prop_settings.current_method_type);
+  }
   ir2_setup_labels(config, data);
   ir2_do_segment_analysis_phase2(TOP_LEVEL_SEGMENT, config, data);
   if (data.linked_data.functions_by_seg.size() == 3) {
@@ -93,12 +206,25 @@ void ObjectFileDB::process_object_file_data(
   }
 
   if (!output_dir.string().empty()) {
-    ir2_write_results(output_dir, config, imports, data);
+    auto files = ir2_write_results(output_dir, config, imports, data);
+    if (cache_key) {
+      m_ir2_cache->store(data, *cache_key, type_recorder->names,
+                         {files, data.symbol_defs, dts.type_prop_settings.current_method_type},
+                         file_timer.getMs());
+    }
   } else {
     data.output_with_skips = ir2_final_out(data, imports, skip_functions);
     data.full_output = ir2_final_out(data, imports, {});
   }
 
+  FormPoolStats pool_stats;
+  for_each_function_def_order_in_obj(data,
+                                     [&](Function& f, int) { pool_stats += form_pool_stats(f); });
+  {
+    std::lock_guard<std::mutex> lock(m_stats_mutex);
+    stats.form_pool.total += pool_stats;
+  }
+
   if (!config.generate_all_types) {
     // this frees ir2 memory, but means future passes can't look back on this function.
     for_each_function_def_order_in_obj(data, [&](Function& f, int) { f.ir2 = {}; });
@@ -135,19 +261,49 @@ void ObjectFileDB::analyze_functions_ir2(
   for (auto& f : obj_files_by_name) {
     total_file_count += f.second.size();
   }
-  int file_idx = 1;
-  for_each_obj([&](ObjectFileData& data) {
-    if (prefile_callback) {
-      prefile_callback.value()(data.to_unique_name());
-    }
-    lg::info("[{:3d}/{}]------ {}", file_idx++, total_file_count, data.to_unique_name());
-    process_object_file_data(data, output_dir, config, skip_functions, skip_states);
-    if (postfile_callback) {
-      postfile_callback.value()();
-    }
-  });
+
+  // the cache only holds the files we write, so it's not used when keeping the output in memory.
+  // all-types generation needs the IR2 of inspect methods, which can't be cached.
+  if (!config.ir2_cache_dir.empty() && !output_dir.empty() && !config.generate_all_types &&
+      skip_states.empty()) {
+    m_ir2_cache = std::make_unique<Ir2Cache>(
+        file_util::get_jak_project_dir() / config.ir2_cache_dir, config, dts);
+  }
+
+  int num_threads = config.ir2_threads;
+  if (num_threads <= 0) {
+    num_threads = std::thread::hardware_concurrency();
+  }
+
+  // the callbacks are used to report progress on a single file at a time, so run serially.
+  if (num_threads > 1 && !prefile_callback && !postfile_callback) {
+    analyze_functions_ir2_parallel(output_dir, config, num_threads, skip_functions, skip_states);
+  } else {
+    int file_idx = 1;
+    for_each_obj([&](ObjectFileData& data) {
+      if (prefile_callback) {
+        prefile_callback.value()(data.to_unique_name());
+      }
+      lg::info("[{:3d}/{}]------ {}", file_idx++, total_file_count, data.to_unique_name());
+      process_object_file_data(data, output_dir, config, skip_functions, skip_states);
+      flush_symbol_definitions(data);
+      if (postfile_callback) {
+        postfile_callback.value()();
+      }
+    });
+  }
 
   lg::info("{}", stats.let.print());
+  lg::info("Form pools:\n structure   {}\n expressions {}\n lets        {}\n total       {}",
+           stats.form_pool.structure.print(), stats.form_pool.expressions.print(),
+           stats.form_pool.lets.print(), stats.form_pool.total.print());
+  if (stats.types2.functions) {
+    lg::info("Types2: {}", stats.types2.print());
+  }
+  if (m_ir2_cache) {
+    lg::info("{}", m_ir2_cache->print_stats());
+    m_ir2_cache.reset();
+  }
 
   if (config.generate_symbol_definition_map) {
     lg::info("Generating symbol definition map...");
@@ -157,6 +313,108 @@ void ObjectFileDB::analyze_functions_ir2(
   }
 }
 
+/*!
+ * Run IR2 on all objects, using a pool of threads. Each worker claims the next unprocessed object
+ * until there are none left. Results that are shared between objects (the symbol definition map,
+ * let stats) are combined in the same order as a serial run.
+ *
+ * A serial run carries the method type of the last method analyzed over into the next object.
+ * Objects are claimed in order and each one is given the method type it would have in a serial
+ * run, so the output is the same. It is known once the object before it has found its last
+ * analyzed method, which only needs the first analysis phase.
+ */
+void ObjectFileDB::analyze_functions_ir2_parallel(
+    const fs::path& output_dir,
+    const Config& config,
+    int num_threads,
+    const std::unordered_set<std::string>& skip_functions,
+    const std::unordered_map<std::string, std::unordered_set<std::string>>& skip_states) {
+  Timer timer;
+  std::vector<ObjectFileData*> objs;
+  for_each_obj([&](ObjectFileData& data) { objs.push_back(&data); });
+  if (objs.empty()) {
+    return;
+  }
+
+  num_threads = std::min(num_threads, (int)objs.size());
+  lg::info("Running IR2 on {} objects with {} threads", objs.size(), num_threads);
+
+  MethodTypeChain method_types(objs.size(), dts.type_prop_settings.current_method_type);
+  std::atomic<int> next_job = 0;
+  std::atomic<bool> failed = false;
+  std::vector<std::exception_ptr> errors(num_threads);
+
+  SimpleThreadGroup threads;
+  threads.run(
+      [&](int thread_idx) {
+        try {
+          while (!failed) {
+            int job = next_job++;
+            if (job >= (int)objs.size()) {
+              break;
+            }
+            auto& data = *objs.at(job);
+            lg::info("[{:3d}/{}]------ {}", job + 1, objs.size(), data.to_unique_name());
+            process_object_file_data(data, output_dir, config, skip_functions, skip_states,
+                                     &method_types, job);
+          }
+        } catch (...) {
+          errors.at(thread_idx) = std::current_exception();
+          failed = true;
+          method_types.abort();
+        }
+      },
+      num_threads, num_threads);
+  threads.join();
+
+  for (auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  for (auto* data : objs) {
+    flush_symbol_definitions(*data);
+  }
+
+  // leave the method type where a serial run would.
+  method_types.wait_before(objs.size(), &dts.type_prop_settings.current_method_type);
+
+  lg::info("IR2 on {} threads took {:.2f} s", num_threads, timer.getSeconds());
+}
+
+/*!
+ * The method type that type analysis of this object leaves behind, or nothing if it analyzes no
+ * methods. This must match the functions that ir2_type_analysis_pass runs on, and only needs the
+ * first analysis phase.
+ */
+std::optional<std::string> ObjectFileDB::last_analyzed_method_type(const Config& config,
+                                                                   ObjectFileData& data) {
+  std::optional<std::string> result;
+  for (int seg : {TOP_LEVEL_SEGMENT, DEBUG_SEGMENT, MAIN_SEGMENT}) {
+    for_each_function_in_seg_in_obj(seg, data, [&](Function& func) {
+      TypeSpec ts;
+      if (func.guessed_name.kind == FunctionName::FunctionKind::METHOD && !func.suspected_asm &&
+          lookup_function_type(func.guessed_name, data.to_unique_name(), config, &ts) &&
+          func.ir2.atomic_ops_succeeded) {
+        result = func.guessed_name.type_name;
+      }
+    });
+  }
+  return result;
+}
+
+/*!
+ * Add the symbols found in this object to the symbol definition map. This must be done in object
+ * order.
+ */
+void ObjectFileDB::flush_symbol_definitions(ObjectFileData& data) {
+  if (data.symbol_defs) {
+    map_builder.add_object_symbols(*data.symbol_defs);
+    data.symbol_defs.reset();
+  }
+}
+
 void ObjectFileDB::ir2_do_segment_analysis_phase1(int seg,
                                                   const Config& config,
                                                   ObjectFileData& data) {
@@ -559,7 +817,8 @@ void ObjectFileDB::ir2_atomic_op_pass(int seg, const Config& config, ObjectFileD
 }
 
 void ObjectFileDB::ir2_symbol_definition_map(ObjectFileData& data) {
-  map_builder.add_object(data);
+  // this is added to map_builder later, in object order.
+  data.symbol_defs = SymbolMapBuilder::collect_object(data);
 }
 
 template <typename Key, typename Value>
@@ -594,6 +853,7 @@ const std::string* find_file_override_for_art_group(const Config& config,
  */
 void ObjectFileDB::ir2_type_analysis_pass(int seg, const Config& config, ObjectFileData& data) {
   auto obj_name = data.to_unique_name();
+  types2::IterationStats types2_stats;
   for_each_function_in_seg_in_obj(seg, data, [&](Function& func) {
     if (!func.suspected_asm) {
       TypeSpec ts;
@@ -676,6 +936,7 @@ void ObjectFileDB::ir2_type_analysis_pass(int seg, const Config& config, ObjectF
             func.warnings.error("Type analysis failed: {}", e.what());
           }
           func.ir2.env.types_succeeded = out.succeeded;
+          types2_stats += out.stats;
         } else {
           // old type pass
           if (run_type_analysis_ir2(ts, dts, func)) {
@@ -690,6 +951,9 @@ void ObjectFileDB::ir2_type_analysis_pass(int seg, const Config& config, ObjectF
       }
     }
   });
+
+  std::lock_guard<std::mutex> lock(m_stats_mutex);
+  stats.types2 += types2_stats;
 }
 
 void ObjectFileDB::ir2_register_usage_pass(int seg, ObjectFileData& data) {
@@ -764,30 +1028,38 @@ void ObjectFileDB::ir2_cfg_build_pass(int seg, ObjectFileData& data) {
   int total = 0;
   int attempted = 0;
   int successful = 0;
+  FormPoolStats pool_stats;
   for_each_function_in_seg_in_obj(seg, data, [&](Function& func) {
     (void)data;
     total++;
     if (!func.suspected_asm && func.ir2.atomic_ops_succeeded && func.cfg->is_fully_resolved()) {
       attempted++;
+      auto before = form_pool_stats(func);
       try {
         build_initial_forms(func);
       } catch (std::exception& e) {
         func.warnings.error("Failed to structure: {}", e.what());
         func.ir2.top_form = nullptr;
       }
+      pool_stats += form_pool_stats(func) - before;
     }
 
     if (func.ir2.top_form) {
       successful++;
     }
   });
+
+  std::lock_guard<std::mutex> lock(m_stats_mutex);
+  stats.form_pool.structure += pool_stats;
 }
 
 void ObjectFileDB::ir2_build_expressions(int seg, const Config& config, ObjectFileData& data) {
+  FormPoolStats pool_stats;
   for_each_function_in_seg_in_obj(seg, data, [&](Function& func) {
     (void)data;
     if (func.ir2.top_form && func.ir2.env.has_type_analysis() && func.ir2.env.has_local_vars() &&
         func.ir2.env.types_succeeded) {
+      auto before = form_pool_stats(func);
       auto name = func.name();
       auto arg_config = config.function_arg_names.find(name);
       auto var_config = config.function_var_overrides.find(name);
@@ -802,15 +1074,22 @@ void ObjectFileDB::ir2_build_expressions(int seg, const Config& config, ObjectFi
         func.ir2.print_debug_forms = true;
         func.ir2.expressions_succeeded = true;
       }
+      pool_stats += form_pool_stats(func) - before;
     }
   });
+
+  std::lock_guard<std::mutex> lock(m_stats_mutex);
+  stats.form_pool.expressions += pool_stats;
 }
 
 void ObjectFileDB::ir2_insert_lets(int seg, ObjectFileData& data) {
+  LetRewriteStats let_stats;
+  FormPoolStats pool_stats;
   for_each_function_in_seg_in_obj(seg, data, [&](Function& func) {
     if (func.ir2.expressions_succeeded) {
+      auto before = form_pool_stats(func);
       try {
-        insert_lets(func, func.ir2.env, *func.ir2.form_pool, func.ir2.top_form, stats.let);
+        insert_lets(func, func.ir2.env, *func.ir2.form_pool, func.ir2.top_form, let_stats);
       } catch (const std::exception& e) {
         const auto err = fmt::format(
             "Error while inserting lets: {}. Make sure that the return type is not "
@@ -819,8 +1098,13 @@ void ObjectFileDB::ir2_insert_lets(int seg, ObjectFileData& data) {
         lg::warn("{}", err);
         func.warnings.error(err);
       }
+      pool_stats += form_pool_stats(func) - before;
     }
   });
+
+  std::lock_guard<std::mutex> lock(m_stats_mutex);
+  stats.let += let_stats;
+  stats.form_pool.lets += pool_stats;
 }
 
 void ObjectFileDB::ir2_add_store_errors(int seg, ObjectFileData& data) {
@@ -864,17 +1148,21 @@ void ObjectFileDB::ir2_insert_anonymous_functions(int seg, ObjectFileData& data)
   });
 }
 
-void ObjectFileDB::ir2_write_results(const fs::path& output_dir,
-                                     const Config& config,
-                                     const std::vector<std::string>& imports,
-                                     ObjectFileData& obj) {
+/*!
+ * Write the _ir2.asm and _disasm.gc files for an object. Returns the name and contents of each
+ * file written.
+ */
+std::vector<std::pair<std::string, std::string>> ObjectFileDB::ir2_write_results(
+    const fs::path& output_dir,
+    const Config& config,
+    const std::vector<std::string>& imports,
+    ObjectFileData& obj) {
+  std::vector<std::pair<std::string, std::string>> files;
   if (obj.linked_data.has_any_functions()) {
-    auto file_text = ir2_to_file(obj, config);
-    auto file_name = output_dir / (obj.to_unique_name() + "_ir2.asm");
-    file_util::write_text_file(file_name, file_text);
+    files.emplace_back(obj.to_unique_name() + "_ir2.asm", ir2_to_file(obj, config));
 
     auto unformatted_code = ir2_final_out(obj, imports, {});
-    auto final_name = output_dir / (obj.to_unique_name() + "_disasm.gc");
+    auto& final_file = files.emplace_back(obj.to_unique_name() + "_disasm.gc", unformatted_code);
     if (config.format_code) {
       const auto formatted_code = formatter::format_code(unformatted_code);
       if (!formatted_code) {
@@ -882,14 +1170,16 @@ void ObjectFileDB::ir2_write_results(const fs::path& output_dir,
             "Was unable to format the decompiled result of {}, make a github issue. Writing "
             "unformatted code",
             obj.to_unique_name());
-        file_util::write_text_file(final_name, unformatted_code);
       } else {
-        file_util::write_text_file(final_name, formatted_code.value());
+        final_file.second = formatted_code.value();
       }
-    } else {
-      file_util::write_text_file(final_name, unformatted_code);
+    }
+
+    for (const auto& [file_name, text] : files) {
+      file_util::write_text_file(output_dir / file_name, text);
     }
   }
+  return files;
 }
 
 std::string ObjectFileDB::ir2_to_file(ObjectFileData& data, const Config& config) {
@@ -159,7 +159,7 @@ std::vector<DefstateElement::Entry> get_defstate_entries(
       // NOTE : we set the return value of the handlers to "none" for a sneaky hack (see right
       // above) however we only need that when decompiling lambdas. so we revert that hack here.
       if (handler_type.last_arg() == TypeSpec("none")) {
-        handler_type.last_arg() = TypeSpec("object");
+        handler_type.set_last_arg(TypeSpec("object"));
       }
       // hack : delete the behavior tags and typecheck them separately.
       auto sym_behavior = sym_type.try_get_tag("behavior");
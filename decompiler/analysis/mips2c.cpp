@@ -1,5 +1,6 @@
 #include "mips2c.h"
 
+#include <atomic>
 #include <set>
 
 #include "common/log/log.h"
@@ -526,7 +527,7 @@ bool block_requires_label(const Function* f,
 
 namespace {
 // hack counter for total number of unknown instruction. TODO remove
-int g_unknown = 0;
+std::atomic<int> g_unknown = 0;
 }  // namespace
 
 /*!
@@ -1396,7 +1397,8 @@ void run_mips2c_jump_table(Function* f,
 
   f->mips2c_output = output.write_to_string(f->guessed_name, version, jump_loc_table);
   if (g_unknown > 0) {
-    lg::error("Mips to C pass in {} hit {} unknown instructions", f->name(), g_unknown);
+    lg::error("Mips to C pass in {} hit {} unknown instructions", f->name(),
+              g_unknown.load());
   }
 }
 
@@ -1514,7 +1516,8 @@ void run_mips2c(Function* f, GameVersion version) {
 
   f->mips2c_output = output.write_to_string(f->guessed_name, version);
   if (g_unknown > 0) {
-    lg::error("Mips to C pass in {} hit {} unknown instructions", f->name(), g_unknown);
+    lg::error("Mips to C pass in {} hit {} unknown instructions", f->name(),
+              g_unknown.load());
   }
 }
 }  // namespace decompiler
@@ -9,24 +9,50 @@
 
 namespace decompiler {
 
-void SymbolMapBuilder::add_object(const ObjectFileData& data) {
+std::optional<SymbolMapBuilder::ObjectSymbols> SymbolMapBuilder::collect_object(
+    const ObjectFileData& data) {
   // skip non-code files
   if (data.obj_version != 3) {
-    return;
+    return std::nullopt;
   }
-  m_first_detections.emplace_back();
-  m_first_detections.back().object_file_name = data.name_from_map;
+  ObjectSymbols result;
+  result.object_file_name = data.name_from_map;
   // add load/stores from all functions
+  std::unordered_set<std::string> seen_symbols;
   for (const auto& seg_functions : data.linked_data.functions_by_seg) {
     for (const auto& function : seg_functions) {
-      add_load_store_from_function(function, &m_first_detections.back());
+      add_load_store_from_function(function, &seen_symbols, &result);
     }
   }
 
   // add deftypes in the top level function
   const auto& top_level_functions = data.linked_data.functions_by_seg.at(TOP_LEVEL_SEGMENT);
   ASSERT(top_level_functions.size() == 1);
-  add_deftypes_from_top_level_function(top_level_functions.at(0), &m_first_detections.back());
+  std::unordered_set<std::string> seen_types;
+  add_deftypes_from_top_level_function(top_level_functions.at(0), &seen_types, &result);
+  return result;
+}
+
+void SymbolMapBuilder::add_object_symbols(const ObjectSymbols& symbols) {
+  auto& output = m_first_detections.emplace_back();
+  output.object_file_name = symbols.object_file_name;
+  for (const auto& name : symbols.load_stores) {
+    if (m_seen_symbols.insert(name).second) {
+      output.symbols.push_back({name, false});
+    }
+  }
+  for (const auto& name : symbols.deftypes) {
+    if (m_seen_types.insert(name).second) {
+      output.symbols.push_back({name, true});
+    }
+  }
+}
+
+void SymbolMapBuilder::add_object(const ObjectFileData& data) {
+  auto symbols = collect_object(data);
+  if (symbols) {
+    add_object_symbols(*symbols);
+  }
 }
 
 void SymbolMapBuilder::build_map() {
@@ -94,7 +120,9 @@ std::optional<std::string> get_loaded_or_stored_symbol_name(const AtomicOp* op)
 }
 }  // namespace
 
-void SymbolMapBuilder::add_load_store_from_function(const Function& f, ObjectSymbolList* output) {
+void SymbolMapBuilder::add_load_store_from_function(const Function& f,
+                                                    std::unordered_set<std::string>* seen,
+                                                    ObjectSymbols* output) {
   if (!f.ir2.atomic_ops_succeeded) {
     if (!f.suspected_asm) {
       // some asm functions will use mips2c which doesn't require atomic ops.
@@ -107,27 +135,18 @@ void SymbolMapBuilder::add_load_store_from_function(const Function& f, ObjectSym
 
   for (const auto& op : f.ir2.atomic_ops->ops) {
     const auto sym = get_loaded_or_stored_symbol_name(op.get());
-    if (sym) {
-      if (m_seen_symbols.find(*sym) == m_seen_symbols.end()) {
-        SymbolInfo info;
-        info.name = *sym;
-        info.is_type = false;
-        output->symbols.push_back(info);
-        m_seen_symbols.insert(*sym);
-      }
+    if (sym && seen->insert(*sym).second) {
+      output->load_stores.push_back(*sym);
     }
   }
 }
 
 void SymbolMapBuilder::add_deftypes_from_top_level_function(const Function& f,
-                                                            ObjectSymbolList* output) {
+                                                            std::unordered_set<std::string>* seen,
+                                                            ObjectSymbols* output) {
   for (const auto& name : f.types_defined) {
-    if (m_seen_types.find(name) == m_seen_types.end()) {
-      SymbolInfo info;
-      info.name = name;
-      info.is_type = true;
-      output->symbols.push_back(info);
-      m_seen_types.insert(name);
+    if (seen->insert(name).second) {
+      output->deftypes.push_back(name);
     }
   }
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <optional>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -11,6 +12,19 @@ class Function;
 
 class SymbolMapBuilder {
  public:
+  /*!
+   * The symbols referenced by a single object, before we've checked if they were already seen in
+   * a previous object. This can be computed independently for each object (in parallel), then
+   * added to the builder in object order with add_object_symbols.
+   */
+  struct ObjectSymbols {
+    std::string object_file_name;
+    std::vector<std::string> load_stores;
+    std::vector<std::string> deftypes;
+  };
+
+  static std::optional<ObjectSymbols> collect_object(const ObjectFileData& data);
+  void add_object_symbols(const ObjectSymbols& symbols);
   void add_object(const ObjectFileData& data);
   void build_map();
   std::string convert_to_json() const;
@@ -40,8 +54,12 @@ class SymbolMapBuilder {
   // - other symbols do not appear.
   std::vector<ObjectSymbolList> m_result;
 
-  void add_load_store_from_function(const Function& f, ObjectSymbolList* output);
-  void add_deftypes_from_top_level_function(const Function& f, ObjectSymbolList* output);
+  static void add_load_store_from_function(const Function& f,
+                                          std::unordered_set<std::string>* seen,
+                                          ObjectSymbols* output);
+  static void add_deftypes_from_top_level_function(const Function& f,
+                                                   std::unordered_set<std::string>* seen,
+                                                   ObjectSymbols* output);
 };
 
 }  // namespace decompiler
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "decompiler/util/config_parsers.h"
 
 #include "fmt/core.h"
+#include "third-party/zstd/lib/common/xxhash.h"
 
 namespace decompiler {
 
@@ -121,6 +122,12 @@ Config make_config_via_json(nlohmann::json& json) {
   config.dump_objs = json.at("dump_objs").get<bool>();
   config.print_cfgs = json.at("print_cfgs").get<bool>();
   config.generate_symbol_definition_map = json.at("generate_symbol_definition_map").get<bool>();
+  if (json.contains("ir2_threads")) {
+    config.ir2_threads = json.at("ir2_threads").get<int>();
+  }
+  if (json.contains("ir2_cache_dir")) {
+    config.ir2_cache_dir = json.at("ir2_cache_dir").get<std::string>();
+  }
   config.is_pal = json.at("is_pal").get<bool>();
   config.rip_levels = json.at("rip_levels").get<bool>();
   config.extract_collision = json.at("extract_collision").get<bool>();
@@ -150,6 +157,7 @@ Config make_config_via_json(nlohmann::json& json) {
   for (auto& kv : type_casts_json.items()) {
     auto& function_name = kv.key();
     auto& casts = kv.value();
+    config.cache_inputs.by_name[function_name] += "casts: " + casts.dump() + "\n";
     for (auto& cast : casts) {
       if (cast.at(0).is_string()) {
         auto cast_name = cast.at(0).get<std::string>();
@@ -184,6 +192,7 @@ Config make_config_via_json(nlohmann::json& json) {
   for (auto& kv : anon_func_json.items()) {
     auto& obj_file_name = kv.key();
     auto& anon_types = kv.value();
+    config.cache_inputs.by_name[obj_file_name] += "anon-functions: " + anon_types.dump() + "\n";
     for (auto& anon_type : anon_types) {
       auto id = anon_type.at(0).get<int>();
       const auto& type_name = anon_type.at(1).get<std::string>();
@@ -194,6 +203,7 @@ Config make_config_via_json(nlohmann::json& json) {
     auto var_names_json = read_json_file_from_config(json, "var_names_file");
     for (auto& kv : var_names_json.items()) {
       auto& function_name = kv.key();
+      config.cache_inputs.by_name[function_name] += "var-names: " + kv.value().dump() + "\n";
       auto arg = kv.value().find("args");
       if (arg != kv.value().end()) {
         for (auto& x : arg.value()) {
@@ -226,6 +236,7 @@ Config make_config_via_json(nlohmann::json& json) {
   for (auto& kv : label_types_json.items()) {
     auto& obj_name = kv.key();
     auto& types = kv.value();
+    config.cache_inputs.by_name[obj_name] += "label-types: " + types.dump() + "\n";
     for (auto& x : types) {
       const auto& name = x.at(0).get<std::string>();
       const auto& type_name = x.at(1).get<std::string>();
@@ -250,6 +261,8 @@ Config make_config_via_json(nlohmann::json& json) {
   for (auto& kv : stack_structures_json.items()) {
     auto& func_name = kv.key();
     auto& stack_structures = kv.value();
+    config.cache_inputs.by_name[func_name] +=
+        "stack-structures: " + stack_structures.dump() + "\n";
     config.stack_structure_hints_by_function[func_name] =
         parse_stack_structure_hints(stack_structures);
   }
@@ -367,6 +380,16 @@ Config make_config_via_json(nlohmann::json& json) {
   config.process_stack_size_overrides =
       process_stack_size_json.get<std::unordered_map<std::string, int>>();
 
+  // everything else can affect any object. The thread count and cache location don't change the
+  // output, so leave them out.
+  auto global_json = json;
+  global_json.erase("ir2_threads");
+  global_json.erase("ir2_cache_dir");
+  std::string global_inputs = global_json.dump() + inputs_json.dump() + hacks_json.dump() +
+                              art_info_json.dump() + import_deps.dump() +
+                              process_stack_size_json.dump();
+  config.cache_inputs.global_hash = XXH64(global_inputs.data(), global_inputs.size(), 0);
+
   return config;
 }
 }  // namespace
@@ -136,6 +136,11 @@ struct Config {
 
   bool generate_symbol_definition_map = false;
 
+  // number of threads used to run IR2 on object files. 1 is serial, 0 uses all cores.
+  int ir2_threads = 1;
+  // if set, reuse IR2 output for objects whose inputs haven't changed. relative to jak-project.
+  std::string ir2_cache_dir;
+
   bool generate_all_types = false;
   std::optional<std::string> old_all_types_file;
 
@@ -189,6 +194,15 @@ struct Config {
   std::unordered_map<std::string, std::vector<std::string>> import_deps_by_file;
 
   bool rip_collision = false;
+
+  // The settings from the config files, grouped by what they can affect.
+  // Used to tell if cached IR2 output is out of date.
+  struct {
+    // hash of every setting that could affect any object
+    u64 global_hash = 0;
+    // settings that only affect a single function or object, by function or object name.
+    std::unordered_map<std::string, std::string> by_name;
+  } cache_inputs;
 };
 
 Config read_config_file(const fs::path& path_to_config_file,
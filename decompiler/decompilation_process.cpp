@@ -172,6 +172,7 @@ int run_decompilation_process(decompiler::Config config,
   // main decompile.
   if (config.decompile_code) {
     db.analyze_functions_ir2(out_folder, config, {}, {}, {});
+    lg::info("[Mem] After IR2: {} MB", get_peak_rss() / (1024 * 1024));
   }
 
   if (config.generate_all_types) {
@@ -3,10 +3,10 @@
 #include <set>
 #include <thread>
 
+#include "common/custom_data/Fr3File.h"
 #include "common/log/log.h"
 #include "common/util/FileUtil.h"
 #include "common/util/SimpleThreadGroup.h"
-#include "common/util/compress.h"
 #include "common/util/string_util.h"
 
 #include "decompiler/level_extractor/BspHeader.h"
@@ -308,18 +308,15 @@ void extract_common(const ObjectFileDB& db,
     }
   }
 
-  Serializer ser;
-  tfrag_level.serialize(ser);
-  auto compressed =
-      compression::compress_zstd(ser.get_save_result().first, ser.get_save_result().second);
+  auto fr3 = tfrag3::write_fr3(tfrag_level);
 
   lg::info("stats for {}", dgo_name);
-  print_memory_usage(tfrag_level, ser.get_save_result().second);
-  lg::info("compressed: {} -> {} ({:.2f}%)", ser.get_save_result().second, compressed.size(),
-           100.f * compressed.size() / ser.get_save_result().second);
+  print_memory_usage(tfrag_level, fr3.uncompressed_size);
+  lg::info("compressed: {} -> {} ({:.2f}%)", fr3.uncompressed_size, fr3.data.size(),
+           100.f * fr3.data.size() / fr3.uncompressed_size);
   file_util::write_binary_file(
       output_folder / fmt::format("{}.fr3", dgo_name.substr(0, dgo_name.length() - 4)),
-      compressed.data(), compressed.size());
+      fr3.data.data(), fr3.data.size());
 
   if (config.rip_levels) {
     auto file_path = file_util::get_jak_project_dir() / "glb_out" / "common.glb";
@@ -347,16 +344,13 @@ void extract_from_level(const ObjectFileDB& db,
   extract_art_groups_from_level(db, tex_db, bsp_header.texture_remap_table, dgo_name, level_data,
                                 art_group_data);
 
-  Serializer ser;
-  level_data.serialize(ser);
-  auto compressed =
-      compression::compress_zstd(ser.get_save_result().first, ser.get_save_result().second);
+  auto fr3 = tfrag3::write_fr3(level_data);
   lg::info("stats for {}", level_data.level_name);
-  print_memory_usage(level_data, ser.get_save_result().second);
-  lg::info("compressed: {} -> {} ({:.2f}%)", ser.get_save_result().second, compressed.size(),
-           100.f * compressed.size() / ser.get_save_result().second);
+  print_memory_usage(level_data, fr3.uncompressed_size);
+  lg::info("compressed: {} -> {} ({:.2f}%)", fr3.uncompressed_size, fr3.data.size(),
+           100.f * fr3.data.size() / fr3.uncompressed_size);
   file_util::write_binary_file(output_folder / fmt::format("{}.fr3", level_data.level_name),
-                               compressed.data(), compressed.size());
+                               fr3.data.data(), fr3.data.size());
 
   if (config.rip_levels) {
     auto back_file_path = file_util::get_jak_project_dir() / "glb_out" /
@@ -2358,8 +2358,7 @@ void CallOp::propagate_types2(types2::Instruction& instr,
         TP_Type::make_from_ts(dts.type_prop_settings.current_method_type);
     // update the call type
     m_call_type = in_tp.get_method_new_object_typespec();
-    m_call_type.get_arg(m_call_type.arg_count() - 1) =
-        TypeSpec(dts.type_prop_settings.current_method_type);
+    m_call_type.set_last_arg(TypeSpec(dts.type_prop_settings.current_method_type));
     m_call_type_set = true;
 
     // update function call info info
@@ -2420,7 +2419,7 @@ void CallOp::propagate_types2(types2::Instruction& instr,
       auto& tpt = *arg2_type->type;
       if (tpt.kind == TP_Type::Kind::TYPE_OF_TYPE_NO_VIRTUAL) {
         ASSERT(in_type.last_arg() == TypeSpec("basic"));  // just to double check right function
-        in_type.last_arg() = tpt.get_type_objects_typespec();
+        in_type.set_last_arg(tpt.get_type_objects_typespec());
       }
     }
   }
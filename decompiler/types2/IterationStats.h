@@ -0,0 +1,46 @@
+#pragma once
+
+#include <string>
+
+#include "common/common_types.h"
+
+#include "fmt/core.h"
+
+namespace decompiler::types2 {
+/*!
+ * Counts of the work done by the types2 pass to reach a fixed point.
+ */
+struct IterationStats {
+  u64 functions = 0;
+  u64 blocks = 0;
+  u64 sweeps = 0;      // passes over the worklist, in block visit order
+  u64 block_runs = 0;  // times a block was propagated
+  u64 joins = 0;       // register, stack slot and next state types merged into a successor
+  u64 joins_changed = 0;
+  u64 max_block_runs = 0;  // in a single function
+  std::string max_block_runs_function;
+
+  IterationStats& operator+=(const IterationStats& other) {
+    functions += other.functions;
+    blocks += other.blocks;
+    sweeps += other.sweeps;
+    block_runs += other.block_runs;
+    joins += other.joins;
+    joins_changed += other.joins_changed;
+    if (other.max_block_runs > max_block_runs) {
+      max_block_runs = other.max_block_runs;
+      max_block_runs_function = other.max_block_runs_function;
+    }
+    return *this;
+  }
+
+  std::string print() const {
+    return fmt::format(
+        "{} functions, {:.2f} sweeps/function, {:.2f} runs/block, {} of {} joins changed a type, "
+        "most block runs: {} ({})",
+        functions, functions ? double(sweeps) / functions : 0.,
+        blocks ? double(block_runs) / blocks : 0., joins_changed, joins, max_block_runs,
+        max_block_runs_function);
+  }
+};
+}  // namespace decompiler::types2
@@ -20,9 +20,11 @@ TypeState make_typestate_from_block_types(BlockStartTypes& block_start_types) {
     result.gpr_types[i] = &block_start_types.gpr_types[i];
     result.fpr_types[i] = &block_start_types.fpr_types[i];
   }
+  auto stack_slots = std::make_shared<std::vector<StackSlotType*>>();
   for (auto& s : block_start_types.stack_slot_types) {
-    result.stack_slot_types.push_back(&s);
+    stack_slots->push_back(&s);
   }
+  result.stack_slot_types = std::move(stack_slots);
   result.next_state_type = &block_start_types.next_state_type;
   return result;
 }
@@ -110,6 +112,10 @@ void build_function(FunctionCache& function_cache,
   // figure out the order we'll visit all blocks
   // todo: do something with unreachables?
   function_cache.block_visit_order = func.bb_topo_sort().vist_order;
+  function_cache.block_visit_position.resize(function_cache.blocks.size(), -1);
+  for (size_t i = 0; i < function_cache.block_visit_order.size(); i++) {
+    function_cache.block_visit_position.at(function_cache.block_visit_order[i]) = i;
+  }
 
   // to save time, we store types at the entry of each block, then in the instructions inside
   // each block, store types sparsely. This saves very slow copying around of types.
@@ -162,15 +168,7 @@ void build_function(FunctionCache& function_cache,
         instr->written_stack_slot_type = ss;
 
         // and update state!
-        bool found = false;
-        for (auto& slot : state.stack_slot_types) {
-          if (slot->slot == ss.slot) {
-            ASSERT(!found);
-            slot = &instr->written_stack_slot_type.value();
-            found = true;
-          }
-        }
-        ASSERT(found);
+        state.set_stack_slot(&instr->written_stack_slot_type.value());
       }
 
       // do the same for next state (maybe)
@@ -195,6 +193,22 @@ void build_function(FunctionCache& function_cache,
   }
 }
 
+/*!
+ * Parse the register and stack casts from the config for this function.
+ */
+void parse_casts(FunctionCache& function_cache, const Env& env, const DecompilerTypeSystem& dts) {
+  for (const auto& [aop_idx, casts] : env.casts()) {
+    auto& parsed = function_cache.reg_casts[aop_idx];
+    for (auto& cast : casts) {
+      parsed.emplace_back(cast.reg, dts.parse_type_spec(cast.type_name));
+    }
+  }
+
+  for (const auto& [offset, cast] : env.stack_casts()) {
+    function_cache.stack_casts.emplace_back(offset, dts.parse_type_spec(cast.type_name));
+  }
+}
+
 /*!
  * Wrapper around a TypeState* that temporarily modifies types for a cast.
  * When this is destroyed, the casts will be reverted.
@@ -202,18 +216,18 @@ void build_function(FunctionCache& function_cache,
 class TypeStateCasted {
  public:
   TypeStateCasted(TypeState* state) : m_state(state) {}
-  TypeStateCasted(TypeState* state, const Env& env, int aop_idx, DecompilerTypeSystem& dts)
+  TypeStateCasted(TypeState* state, const FunctionCache& cache, int aop_idx, const Function* func)
       : TypeStateCasted(state) {
-    const auto& reg_cast_it = env.casts().find(aop_idx);
-    if (reg_cast_it != env.casts().end()) {
+    const auto& reg_cast_it = cache.reg_casts.find(aop_idx);
+    if (reg_cast_it != cache.reg_casts.end()) {
       // apply register casts!
-      for (auto& cast : reg_cast_it->second) {
-        push_reg_cast(cast.reg, dts.parse_type_spec(cast.type_name));
+      for (auto& [reg, type] : reg_cast_it->second) {
+        push_reg_cast(reg, type);
       }
     }
 
-    for (const auto& [offset, cast] : env.stack_casts()) {
-      push_stack_cast(offset, dts.parse_type_spec(cast.type_name), env.func);
+    for (const auto& [offset, type] : cache.stack_casts) {
+      push_stack_cast(offset, type, func);
     }
   }
   TypeStateCasted(const TypeStateCasted&) = delete;
@@ -324,7 +338,7 @@ void backprop_from_preds(FunctionCache& cache,
               ASSERT(!st.tag.has_tag());
               st.tag.kind = Tag::BLOCK_ENTRY;
               st.tag.block_entry = tag;
-              succ_cblock.needs_run = true;
+              cache.mark_needs_run(succ_idx);
             }
           }
         }
@@ -333,7 +347,7 @@ void backprop_from_preds(FunctionCache& cache,
         if (resolve_type) {
           if (backprop_tagged_type(*resolve_type, *(*block_end_typestate)[reg], dts)) {
             // if we've changed things, mark this block to be re-ran.
-            cblock.needs_run = true;
+            cache.mark_needs_run(block_idx);
           }
         }
       }
@@ -347,84 +361,79 @@ void backprop_from_preds(FunctionCache& cache,
       tags_updated = true;
       my_tag->updated = false;
       // lg::print("clearing {}\n", block_idx);
-      cblock.needs_run = true;      // maybe?
-      *my_tag->type_to_clear = {};  // meh..
+      cache.mark_needs_run(block_idx);  // maybe?
+      *my_tag->type_to_clear = {};      // meh..
     }
   }
 
   if (tags_updated) {
     for (auto& pred : block.pred) {
-      cache.blocks.at(pred).needs_run = true;
+      cache.mark_needs_run(pred);
     }
   }
 }
 
-std::optional<TP_Type> tp_lca(const types2::Type& existing,
-                              const types2::Type& add,
-                              bool* changed,
-                              DecompilerTypeSystem& dts) {
-  if (existing.type && add.type) {
-    return dts.tp_lca(*existing.type, *add.type, changed);
-  } else if (existing.type && !add.type) {
-    *changed = false;
-    return existing.type;
-  } else if (!existing.type && add.type) {
-    *changed = true;
-    return add.type;
+/*!
+ * Merge add into the type in combined. Returns true if combined changed.
+ */
+bool tp_lca(types2::Type* combined, const types2::Type& add, DecompilerTypeSystem& dts) {
+  if (combined->type && add.type) {
+    if (*combined->type == *add.type) {
+      // most joins don't change anything, skip copying the type around.
+      return false;
+    }
+    bool changed = false;
+    auto new_type = dts.tp_lca(*combined->type, *add.type, &changed);
+    if (changed) {
+      combined->type = std::move(new_type);
+    }
+    return changed;
+  } else if (!combined->type && add.type) {
+    combined->type = add.type;
+    return true;
   } else {
-    // neither
-    *changed = false;
-    return {};
+    // nothing to add.
+    return false;
   }
 }
 
 /*!
  * Find the least common ancestor of an entire typestate.
  */
-bool tp_lca(types2::TypeState* combined, const types2::TypeState& add, DecompilerTypeSystem& dts) {
+bool tp_lca(types2::TypeState* combined,
+            const types2::TypeState& add,
+            DecompilerTypeSystem& dts,
+            IterationStats& stats) {
   bool result = false;
-  for (int i = 0; i < 32; i++) {
-    bool diff = false;
-    auto new_type = tp_lca(*combined->gpr_types[i], *add.gpr_types[i], &diff, dts);
-    if (diff) {
+  auto join = [&](types2::Type* comb, const types2::Type& x) {
+    stats.joins++;
+    if (tp_lca(comb, x, dts)) {
+      stats.joins_changed++;
       result = true;
-      combined->gpr_types[i]->type = new_type;
     }
+  };
+
+  for (int i = 0; i < 32; i++) {
+    join(combined->gpr_types[i], *add.gpr_types[i]);
   }
 
   for (int i = 0; i < 32; i++) {
-    bool diff = false;
-    auto new_type = tp_lca(*combined->fpr_types[i], *add.fpr_types[i], &diff, dts);
-    if (diff) {
-      result = true;
-      combined->fpr_types[i]->type = new_type;
-    }
+    join(combined->fpr_types[i], *add.fpr_types[i]);
   }
 
-  for (auto& x : add.stack_slot_types) {
-    bool diff = false;
+  for (auto& x : add.stack_slots()) {
     auto comb = combined->try_find_stack_spill_slot(x->slot);
     if (!comb) {
       lg::print("failed to find {}\n", x->slot);
-      for (auto& x : combined->stack_slot_types) {
+      for (auto& x : combined->stack_slots()) {
         lg::print("x = {}\n", x->slot);
       }
     }
     ASSERT(comb);
-    auto new_type = tp_lca(*comb, x->type, &diff, dts);
-    if (diff) {
-      result = true;
-      comb->type = new_type;
-    }
-  }
-
-  bool diff = false;
-  auto new_type = tp_lca(*combined->next_state_type, *add.next_state_type, &diff, dts);
-  if (diff) {
-    result = true;
-    combined->next_state_type->type = new_type;
+    join(comb, x->type);
   }
 
+  join(combined->next_state_type, *add.next_state_type);
   return result;
 }
 
@@ -438,14 +447,12 @@ bool propagate_block(FunctionCache& cache,
                      bool tag_lock) {
   auto& cblock = cache.blocks.at(block_idx);
   auto& block = func.basic_blocks.at(block_idx);
-  // for now, assume we'll be done. something might change this later, we'll see
-  cblock.needs_run = false;
 
   // propagate through instructions
   TypeState* previous_typestate = &cblock.start_type_state;
   for (auto instr : cblock.instructions) {
     {
-      TypeStateCasted casted(previous_typestate, func.ir2.env, instr->aop_idx, *func.ir2.env.dts);
+      TypeStateCasted casted(previous_typestate, cache, instr->aop_idx, func.ir2.env.func);
       auto& aop = func.ir2.atomic_ops->ops.at(instr->aop_idx);
       TypePropExtras extras;
       extras.tags_locked = tag_lock;
@@ -460,7 +467,7 @@ bool propagate_block(FunctionCache& cache,
         return false;
       }
       if (extras.needs_rerun) {
-        cblock.needs_run = true;
+        cache.mark_needs_run(block_idx);
       }
       // propagate forward
       // TODO
@@ -483,15 +490,42 @@ bool propagate_block(FunctionCache& cache,
   for (auto succ_block_id : {block.succ_ft, block.succ_branch}) {
     if (succ_block_id != -1) {
       // set types to LCA (current, new)
-      if (tp_lca(&cache.blocks.at(succ_block_id).start_type_state, *previous_typestate, dts)) {
+      if (tp_lca(&cache.blocks.at(succ_block_id).start_type_state, *previous_typestate, dts,
+                 cache.stats)) {
         // if something changed, run again!
-        cache.blocks.at(succ_block_id).needs_run = true;
+        cache.mark_needs_run(succ_block_id);
       }
     }
   }
   return true;
 }
 
+/*!
+ * Propagate the blocks in the worklist, in visit order. Blocks added behind the current one wait
+ * for the next sweep, so blocks run in the same order as they would if every sweep went through
+ * the whole visit order, but the blocks that don't need to run are never looked at.
+ */
+bool run_sweep(FunctionCache& cache,
+               Function& func,
+               DecompilerTypeSystem& dts,
+               bool tag_lock,
+               bool* ran_blocks) {
+  cache.stats.sweeps++;
+  *ran_blocks = false;
+  auto it = cache.worklist.begin();
+  while (it != cache.worklist.end()) {
+    int position = *it;
+    cache.worklist.erase(it);
+    *ran_blocks = true;
+    cache.stats.block_runs++;
+    if (!propagate_block(cache, cache.block_visit_order.at(position), func, dts, tag_lock)) {
+      return false;
+    }
+    it = cache.worklist.upper_bound(position);
+  }
+  return true;
+}
+
 bool convert_to_old_format(TP_Type& out, const types2::Type* in, bool recovery_mode) {
   if (!in->type) {
     if (recovery_mode) {
@@ -510,9 +544,7 @@ bool convert_to_old_format(::decompiler::TypeState& out,
                            const types2::TypeState& in,
                            std::string& error_string,
                            int my_idx,
-                           const std::unordered_map<int, std::vector<RegisterTypeCast>>& casts,
-                           const std::unordered_map<int, StackTypeCast>& stack_casts,
-                           const DecompilerTypeSystem& dts,
+                           const FunctionCache& cache,
                            bool recovery_mode) {
   for (int i = 0; i < 32; i++) {
     ASSERT(in.fpr_types[i]);
@@ -531,14 +563,14 @@ bool convert_to_old_format(::decompiler::TypeState& out,
     return false;
   }
 
-  const auto& reg_casts = casts.find(my_idx);
-  if (reg_casts != casts.end()) {
-    for (auto& cast : reg_casts->second) {
-      out.get(cast.reg) = TP_Type::make_from_ts(dts.parse_type_spec(cast.type_name));
+  const auto& reg_casts = cache.reg_casts.find(my_idx);
+  if (reg_casts != cache.reg_casts.end()) {
+    for (auto& [reg, type] : reg_casts->second) {
+      out.get(reg) = TP_Type::make_from_ts(type);
     }
   }
 
-  for (auto& x : in.stack_slot_types) {
+  for (auto& x : in.stack_slots()) {
     TP_Type temp;
     if (!convert_to_old_format(temp, &x->type, recovery_mode)) {
       error_string += fmt::format("Failed to convert stack slot: {} ", x->slot);
@@ -547,8 +579,8 @@ bool convert_to_old_format(::decompiler::TypeState& out,
     out.spill_slots[x->slot] = temp;
   }
 
-  for (auto& [offset, type] : stack_casts) {
-    out.spill_slots[offset] = TP_Type::make_from_ts(dts.parse_type_spec(type.type_name));
+  for (auto& [offset, type] : cache.stack_casts) {
+    out.spill_slots[offset] = TP_Type::make_from_ts(type);
   }
   return true;
 }
@@ -556,9 +588,6 @@ bool convert_to_old_format(::decompiler::TypeState& out,
 bool convert_to_old_format(Output& out,
                            FunctionCache& in,
                            std::string& error_string,
-                           const std::unordered_map<int, std::vector<RegisterTypeCast>>& casts,
-                           const std::unordered_map<int, StackTypeCast>& stack_casts,
-                           const DecompilerTypeSystem& dts,
                            bool recovery_mode) {
   // for (auto& block : in.blocks) {
   out.op_end_types.resize(in.instructions.size());
@@ -566,15 +595,15 @@ bool convert_to_old_format(Output& out,
   for (int block_idx : in.block_visit_order) {
     auto& block = in.blocks[block_idx];
     if (!convert_to_old_format(out.block_init_types.at(block_idx), block.start_type_state,
-                               error_string, block.instructions.at(0)->aop_idx, casts, stack_casts,
-                               dts, recovery_mode)) {
+                               error_string, block.instructions.at(0)->aop_idx, in,
+                               recovery_mode)) {
       error_string += fmt::format(" at the start of block {}\n", block_idx);
       return false;
     }
 
     for (auto& instr : block.instructions) {
       if (!convert_to_old_format(out.op_end_types.at(instr->aop_idx), instr->types, error_string,
-                                 instr->aop_idx + 1, casts, stack_casts, dts, recovery_mode)) {
+                                 instr->aop_idx + 1, in, recovery_mode)) {
         error_string += fmt::format(" at op {}\n", instr->aop_idx);
         return false;
       }
@@ -588,15 +617,17 @@ bool convert_to_old_format(Output& out,
  * Main Types2 Analysis pass.
  */
 void run(Output& out, const Input& input) {
+  // annoying hack. This is set before anything that can fail, like the old type pass does, so the
+  // method type carried to the next function only depends on which functions are analyzed.
+  if (input.func->guessed_name.kind == FunctionName::FunctionKind::METHOD) {
+    input.dts->type_prop_settings.current_method_type = input.func->guessed_name.type_name;
+  }
+
   // First, construct our graph
   FunctionCache function_cache;
   auto stack_slots = find_stack_spill_slots(*input.func);
   build_function(function_cache, *input.func, stack_slots);
-
-  // annoying hack
-  if (input.func->guessed_name.kind == FunctionName::FunctionKind::METHOD) {
-    input.dts->type_prop_settings.current_method_type = input.func->guessed_name.type_name;
-  }
+  parse_casts(function_cache, input.func->ir2.env, *input.func->ir2.env.dts);
 
   if (input.function_type.last_arg() == TypeSpec("none")) {
     auto as_end = dynamic_cast<FunctionEndOp*>(input.func->ir2.atomic_ops->ops.back().get());
@@ -605,29 +636,17 @@ void run(Output& out, const Input& input) {
   }
 
   // mark the entry block
-  function_cache.blocks.at(0).needs_run = true;
+  function_cache.mark_needs_run(0);
   construct_function_entry_types(function_cache.blocks.at(0).start_types, input.function_type,
                                  stack_slots);
 
   // Run propagation, until we get through an iteration with no changes
-  [[maybe_unused]] int blocks_run = 0;
-  [[maybe_unused]] int outer_iterations = 0;
   bool needs_rerun = true;
   bool hit_error = false;
   while (needs_rerun) {
-    outer_iterations++;
-    needs_rerun = false;
-
-    for (auto block_idx : function_cache.block_visit_order) {
-      if (function_cache.blocks.at(block_idx).needs_run) {
-        blocks_run++;
-        needs_rerun = true;
-        if (!propagate_block(function_cache, block_idx, *input.func, *input.func->ir2.env.dts,
-                             false)) {
-          hit_error = true;
-          goto end_type_pass;
-        }
-      }
+    if (!run_sweep(function_cache, *input.func, *input.func->ir2.env.dts, false, &needs_rerun)) {
+      hit_error = true;
+      goto end_type_pass;
     }
 
     auto& return_type = input.function_type.last_arg();
@@ -663,27 +682,23 @@ void run(Output& out, const Input& input) {
   }
 
   needs_rerun = true;
-  function_cache.blocks.at(0).needs_run = true;
+  function_cache.mark_needs_run(0);
   while (needs_rerun) {
-    outer_iterations++;
-    needs_rerun = false;
-    for (auto block_idx : function_cache.block_visit_order) {
-      if (function_cache.blocks.at(block_idx).needs_run) {
-        blocks_run++;
-        needs_rerun = true;
-        if (!propagate_block(function_cache, block_idx, *input.func, *input.func->ir2.env.dts,
-                             true)) {
-          hit_error = true;
-          goto end_type_pass;
-        }
-      }
+    if (!run_sweep(function_cache, *input.func, *input.func->ir2.env.dts, true, &needs_rerun)) {
+      hit_error = true;
+      goto end_type_pass;
     }
   }
 
 end_type_pass:
+  out.stats = function_cache.stats;
+  out.stats.functions = 1;
+  out.stats.blocks = function_cache.block_visit_order.size();
+  out.stats.max_block_runs = out.stats.block_runs;
+  out.stats.max_block_runs_function = input.func->name();
+
   std::string error;
-  if (!convert_to_old_format(out, function_cache, error, input.func->ir2.env.casts(),
-                             input.func->ir2.env.stack_casts(), *input.dts, hit_error)) {
+  if (!convert_to_old_format(out, function_cache, error, hit_error)) {
     lg::print("Failed convert_to_old_format: {}\n", error);
   } else {
     input.func->ir2.env.types_succeeded = true;
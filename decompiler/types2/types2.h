@@ -2,11 +2,14 @@
 
 #include <memory>
 #include <optional>
+#include <set>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
 #include "decompiler/Function/Function.h"
 #include "decompiler/config.h"
+#include "decompiler/types2/IterationStats.h"
 #include "decompiler/util/DecompilerTypeSystem.h"
 #include "decompiler/util/TP_Type.h"
 
@@ -132,7 +135,7 @@ struct TypeState {
   }
 
   Type* try_find_stack_spill_slot(int slot) {
-    for (auto ss : stack_slot_types) {
+    for (auto ss : stack_slots()) {
       if (ss->slot == slot) {
         return &ss->type;
       }
@@ -141,7 +144,7 @@ struct TypeState {
   }
 
   const Type* try_find_stack_spill_slot(int slot) const {
-    for (auto& ss : stack_slot_types) {
+    for (auto ss : stack_slots()) {
       if (ss->slot == slot) {
         return &ss->type;
       }
@@ -157,13 +160,37 @@ struct TypeState {
     for (auto fpr_type : fpr_types) {
       f(*fpr_type);
     }
-    for (auto spill : stack_slot_types) {
+    for (auto spill : stack_slots()) {
       f(spill->type);
     }
     f(*next_state_type);
   }
 
-  std::vector<StackSlotType*> stack_slot_types;
+  const std::vector<StackSlotType*>& stack_slots() const {
+    static const std::vector<StackSlotType*> empty;
+    return stack_slot_types ? *stack_slot_types : empty;
+  }
+
+  /*!
+   * Point a stack slot at a new type. The slot list is shared by copies of this state, so it is
+   * copied first.
+   */
+  void set_stack_slot(StackSlotType* type) {
+    auto slots = std::make_shared<std::vector<StackSlotType*>>(stack_slots());
+    bool found = false;
+    for (auto& slot : *slots) {
+      if (slot->slot == type->slot) {
+        ASSERT(!found);
+        slot = type;
+        found = true;
+      }
+    }
+    ASSERT(found);
+    stack_slot_types = std::move(slots);
+  }
+
+  // most instructions don't write a stack slot, so their states share the list of the previous one.
+  std::shared_ptr<const std::vector<StackSlotType*>> stack_slot_types;
 };
 
 struct Instruction {
@@ -206,7 +233,6 @@ struct BlockStartTypes {
 };
 
 struct Block {
-  bool needs_run = false;
   BlockStartTypes start_types;
   TypeState start_type_state;
   std::vector<Instruction*> instructions;
@@ -216,15 +242,30 @@ struct Block {
 struct FunctionCache {
   std::vector<Block> blocks;
   std::vector<Instruction> instructions;
-  std::vector<RegType> reg_type_casts;
-  std::vector<StackSlotType> stack_slot_casts;
   std::vector<int> block_visit_order;
+  std::vector<int> block_visit_position;  // index in block_visit_order, or -1 if not visited
+
+  // the casts from the config, parsed once instead of on every instruction.
+  std::unordered_map<int, std::vector<std::pair<Register, TypeSpec>>> reg_casts;
+  std::vector<std::pair<int, TypeSpec>> stack_casts;
+
+  // blocks that need to be propagated again, by their position in block_visit_order.
+  std::set<int> worklist;
+  IterationStats stats;
+
+  void mark_needs_run(int block_idx) {
+    int position = block_visit_position.at(block_idx);
+    if (position >= 0) {
+      worklist.insert(position);
+    }
+  }
 };
 
 struct Output {
   std::vector<::decompiler::TypeState> block_init_types;
   std::vector<::decompiler::TypeState> op_end_types;
   std::vector<StackStructureHint> stack_structure_hints;
+  IterationStats stats;
   bool succeeded = false;
 };
 
@@ -12,8 +12,12 @@
 #include "decompiler/Disasm/Register.h"
 
 namespace decompiler {
+thread_local DecompilerTypeSystem::TypePropSettings DecompilerTypeSystem::type_prop_settings;
+
 DecompilerTypeSystem::DecompilerTypeSystem(GameVersion version) : m_version(version) {
   ts.add_builtin_types(version);
+  // start from nothing, like the settings did when each type system had its own.
+  type_prop_settings.reset();
 }
 
 namespace {
@@ -160,6 +164,7 @@ void DecompilerTypeSystem::parse_enum_defs(const std::vector<std::string>& file_
 }
 
 TypeSpec DecompilerTypeSystem::parse_type_spec(const std::string& str) const {
+  std::lock_guard<std::mutex> lock(m_reader_mutex);
   auto read = m_reader.read_from_string(str);
   auto data = cdr(read);
   return parse_typespec(&ts, car(data));
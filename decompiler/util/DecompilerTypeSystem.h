@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+
 #include "common/goos/Reader.h"
 #include "common/goos/TextDB.h"
 #include "common/type_system/TypeSystem.h"
@@ -92,15 +94,18 @@ class DecompilerTypeSystem {
   }
 
   // todo - totally eliminate this.
-  struct {
+  // This is per-thread so objects can be analyzed in parallel.
+  struct TypePropSettings {
     std::string current_method_type;
     void reset() { current_method_type.clear(); }
-  } type_prop_settings;
+  };
+  static thread_local TypePropSettings type_prop_settings;
 
   GameVersion version() const { return m_version; }
 
  private:
   GameVersion m_version;
   mutable goos::Reader m_reader;
+  mutable std::mutex m_reader_mutex;  // the reader is used by parse_type_spec from many threads
 };
 }  // namespace decompiler
@@ -85,6 +85,9 @@ struct GfxGlobalSettings {
   // frame timing things
   bool experimental_accurate_lag = false;
   bool sleep_in_frame_limiter = true;
+  // how many frames the game can send before the oldest one is rendered. With more than 1, chains
+  // are copied out of EE memory, so the game can build the next frame while the renderer is busy.
+  int frames_in_flight = 1;
 
   // fancy effect things
   bool hack_no_tex = false;
@@ -70,6 +70,9 @@ class OpenGLRenderer {
   // the graphics system.
   void render(DmaFollower dma, const RenderOptions& settings);
 
+  // profile of the last frame rendered
+  Profiler& profiler() { return m_profiler; }
+
  private:
   void setup_frame(const RenderOptions& settings);
   void dispatch_buckets(DmaFollower dma, ScopedProfilerNode& prof, bool sync_after_buckets);
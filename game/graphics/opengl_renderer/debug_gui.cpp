@@ -1,5 +1,8 @@
 #include "debug_gui.h"
 
+#include <algorithm>
+#include <array>
+
 #include "common/global_profiler/GlobalProfiler.h"
 #include "common/util/string_util.h"
 
@@ -22,10 +25,25 @@ void FrameTimeRecorder::finish_frame() {
 void FrameTimeRecorder::start_frame() {
   m_compute_timer.start();
   float frame_time = m_fps_timer.getSeconds();
+  m_frame_intervals[m_interval_idx++] = frame_time * 1000.f;
+  if (m_interval_idx == SIZE) {
+    m_interval_idx = 0;
+  }
   m_last_frame_time = (0.9 * m_last_frame_time) + (0.1 * frame_time);
   m_fps_timer.start();
 }
 
+/*!
+ * Get the time that p percent of the last SIZE frames took at most.
+ */
+float FrameTimeRecorder::interval_percentile(float p) const {
+  std::array<float, SIZE> sorted;
+  std::copy(std::begin(m_frame_intervals), std::end(m_frame_intervals), sorted.begin());
+  auto it = sorted.begin() + std::min<int>(SIZE - 1, SIZE * p / 100.f);
+  std::nth_element(sorted.begin(), it, sorted.end());
+  return *it;
+}
+
 void FrameTimeRecorder::draw_window(const DmaStats& /*dma_stats*/) {
   auto* p_open = &m_open;
   ImGuiWindowFlags window_flags = ImGuiWindowFlags_NoDecoration |
@@ -67,6 +85,8 @@ void FrameTimeRecorder::draw_window(const DmaStats& /*dma_stats*/) {
     }
     ImGui::SameLine();
     ImGui::Text("fps-avg: %.1f", 1.f / m_last_frame_time);
+    ImGui::Text("frame p50: %.1f p95: %.1f p99: %.1f", interval_percentile(50),
+                interval_percentile(95), interval_percentile(99));
 
     ImGui::Separator();
     ImGui::PlotLines(
@@ -121,6 +141,7 @@ void OpenGlDebugGui::draw(const DmaStats& dma_stats) {
         ImGui::Checkbox("Quick-Screenshot on F2", &screenshot_hotkey_enabled);
         ImGui::EndMenu();
       }
+      ImGui::MenuItem("Capture DMA Next Frame", nullptr, &m_want_dma_capture);
       ImGui::MenuItem("Subtitle Editor", nullptr, &m_subtitle_editor);
       ImGui::MenuItem("Debug Text Filter", nullptr, &m_filters_menu);
       ImGui::EndMenu();
@@ -149,6 +170,7 @@ void OpenGlDebugGui::draw(const DmaStats& dma_stats) {
         ImGui::Separator();
         ImGui::Checkbox("Accurate Lag Mode", &Gfx::g_global_settings.experimental_accurate_lag);
         ImGui::Checkbox("Sleep in Frame Limiter", &Gfx::g_global_settings.sleep_in_frame_limiter);
+        ImGui::SliderInt("Frames in Flight", &Gfx::g_global_settings.frames_in_flight, 1, 3);
         ImGui::TreePop();
       }
       ImGui::Checkbox("Treat Pad0 as Pad1", &Gfx::g_debug_settings.treat_pad0_as_pad1);
@@ -166,7 +188,8 @@ void OpenGlDebugGui::draw(const DmaStats& dma_stats) {
         prof().set_enable(record_events);
       }
       ImGui::SameLine();
-      ImGui::Text(fmt::format("({}/{})", prof().get_next_idx(), prof().get_max_events()).c_str());
+      ImGui::Text("%s", fmt::format("({}/{})", prof().get_event_count(), prof().get_max_events())
+                            .c_str());
       ImGui::InputInt("Event Buffer Size", &max_event_buffer_size);
       if (ImGui::Button("Resize")) {
         prof().update_event_buffer_size(max_event_buffer_size);
@@ -180,6 +203,21 @@ void OpenGlDebugGui::draw(const DmaStats& dma_stats) {
         record_events = false;
         prof().dump_to_json();
       }
+      ImGui::Separator();
+      if (!prof().is_streaming()) {
+        if (ImGui::Button("Stream to File")) {
+          record_events = true;
+          m_profile_stream_path = prof().start_streaming();
+        }
+      } else {
+        if (ImGui::Button("Stop Streaming")) {
+          record_events = false;
+          prof().stop_streaming();
+        }
+        ImGui::Text("%s", fmt::format("Writing {} ({} events dropped)", m_profile_stream_path,
+                                      prof().get_dropped_events())
+                              .c_str());
+      }
       // if (ImGui::Button("Open dump folder")) {
       //  // TODO - https://github.com/mlabbe/nativefiledialog
       // }
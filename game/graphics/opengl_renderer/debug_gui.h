@@ -5,6 +5,8 @@
  * The debug menu-bar and frame timing window
  */
 
+#include <string>
+
 #include "common/dma/dma.h"
 #include "common/util/Timer.h"
 #include "common/versions/versions.h"
@@ -27,7 +29,11 @@ class FrameTimeRecorder {
   bool do_gl_finish = false;
 
  private:
+  float interval_percentile(float p) const;
+
   float m_frame_times[SIZE] = {0};
+  float m_frame_intervals[SIZE] = {0};  // time between the start of frames, in ms
+  int m_interval_idx = 0;
   float m_last_frame_time = 0;
   int m_idx = 0;
   Timer m_compute_timer;
@@ -62,6 +68,14 @@ class OpenGlDebugGui {
     return false;
   }
 
+  bool get_dma_capture_flag() {
+    if (m_want_dma_capture) {
+      m_want_dma_capture = false;
+      return true;
+    }
+    return false;
+  }
+
   bool small_profiler = false;
   bool record_events = false;
   int max_event_buffer_size = 65536;
@@ -80,5 +94,7 @@ class OpenGlDebugGui {
   bool m_subtitle_editor = false;
   bool m_filters_menu = false;
   bool m_want_screenshot = false;
+  bool m_want_dma_capture = false;
   float target_fps_input = 60.f;
+  std::string m_profile_stream_path;
 };
@@ -1,9 +1,9 @@
 #include "Loader.h"
 
+#include "common/custom_data/Fr3File.h"
 #include "common/global_profiler/GlobalProfiler.h"
 #include "common/util/FileUtil.h"
 #include "common/util/Timer.h"
-#include "common/util/compress.h"
 
 #include "game/graphics/opengl_renderer/loader/LoaderStages.h"
 
@@ -89,6 +89,16 @@ void Loader::set_active_levels(const std::vector<std::string>& levels) {
   m_active_levels = levels;
 }
 
+std::vector<std::string> Loader::get_desired_levels() {
+  std::unique_lock<std::mutex> lk(m_loader_mutex);
+  return m_desired_levels;
+}
+
+std::vector<std::string> Loader::get_active_levels() {
+  std::unique_lock<std::mutex> lk(m_loader_mutex);
+  return m_active_levels;
+}
+
 /*!
  * Get all levels that are in memory and used very recently.
  */
@@ -182,26 +192,13 @@ void Loader::loader_thread() {
       // simulate slower hard drive (so that the loader thread can lose to the game loads)
       // std::this_thread::sleep_for(std::chrono::milliseconds(1500));
 
-      // load the fr3 file
+      // load the fr3 file. The file is mapped, and its chunks are decompressed and read back into
+      // the tfrag3::Level structure in parallel.
       prof().begin_event("read-file");
-      Timer disk_timer;
-      auto data = file_util::read_binary_file(m_base_path / fmt::format("{}.fr3", lev));
-      double disk_load_time = disk_timer.getSeconds();
-      prof().end_event();
-
-      // the FR3 files are compressed
-      prof().begin_event("decompress-file");
-      Timer decomp_timer;
-      auto decomp_data = compression::decompress_zstd(data.data(), data.size());
-      double decomp_time = decomp_timer.getSeconds();
-      prof().end_event();
-
-      // Read back into the tfrag3::Level structure
-      prof().begin_event("deserialize");
       Timer import_timer;
       auto result = std::make_unique<tfrag3::Level>();
-      Serializer ser(decomp_data.data(), decomp_data.size());
-      result->serialize(ser);
+      tfrag3::Fr3Reader(m_base_path / fmt::format("{}.fr3", lev))
+          .read(result.get(), tfrag3::FR3_ALL_CHUNKS, FILE_LOAD_THREADS);
       double import_time = import_timer.getSeconds();
       prof().end_event();
 
@@ -233,9 +230,8 @@ void Loader::loader_thread() {
         }
       }
 
-      fmt::print(
-          "------------> Load from file: {:.3f}s, import {:.3f}s, decomp {:.3f}s unpack {:.3f}s\n",
-          disk_load_time, import_time, decomp_time, unpack_timer.getSeconds());
+      fmt::print("------------> Load from file: {:.3f}s, unpack {:.3f}s\n", import_time,
+                 unpack_timer.getSeconds());
 
       // grab the lock again
       lk.lock();
@@ -255,12 +251,14 @@ void Loader::loader_thread() {
  * This should be called during initialization, before any threaded loading goes on.
  */
 const tfrag3::Level& Loader::load_common(TexturePool& tex_pool, const std::string& name) {
-  auto data = file_util::read_binary_file(m_base_path / fmt::format("{}.fr3", name));
-
-  auto decomp_data = compression::decompress_zstd(data.data(), data.size());
-  Serializer ser(decomp_data.data(), decomp_data.size());
+  // the common level only has textures and merc models, so skip the rest of the file.
   m_common_level.level = std::make_unique<tfrag3::Level>();
-  m_common_level.level->serialize(ser);
+  tfrag3::Fr3Reader(m_base_path / fmt::format("{}.fr3", name))
+      .read(m_common_level.level.get(),
+            tfrag3::fr3_chunk_bit(tfrag3::Fr3ChunkKind::TEXTURES) |
+                tfrag3::fr3_chunk_bit(tfrag3::Fr3ChunkKind::INDEX_TEXTURES) |
+                tfrag3::fr3_chunk_bit(tfrag3::Fr3ChunkKind::MERC),
+            FILE_LOAD_THREADS);
   for (auto& tex : m_common_level.level->textures) {
     m_common_level.textures.push_back(add_texture(tex_pool, tex, true));
   }
@@ -15,6 +15,8 @@ class Loader {
  public:
   static constexpr float TIE_LOAD_BUDGET = 1.5f;
   static constexpr float SHARED_TEXTURE_LOAD_BUDGET = 3.f;
+  // number of threads used to decompress and read the chunks of a level file.
+  static constexpr int FILE_LOAD_THREADS = 4;
   Loader(const fs::path& base_path, int max_levels);
   ~Loader();
   void update(TexturePool& tex_pool);
@@ -24,6 +26,8 @@ class Loader {
   const tfrag3::Level& load_common(TexturePool& tex_pool, const std::string& name);
   void set_want_levels(const std::vector<std::string>& levels);
   void set_active_levels(const std::vector<std::string>& levels);
+  std::vector<std::string> get_desired_levels();
+  std::vector<std::string> get_active_levels();
   std::vector<LevelData*> get_in_use_levels();
   void draw_debug_window();
   void debug_print_loaded_levels();
@@ -5,11 +5,15 @@
 
 #include "opengl.h"
 
+#include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <sstream>
 
+#include "common/dma/dma_capture.h"
 #include "common/dma/dma_copy.h"
 #include "common/global_profiler/GlobalProfiler.h"
 #include "common/goal_constants.h"
@@ -25,6 +29,7 @@
 #include "game/graphics/opengl_renderer/debug_gui.h"
 #include "game/graphics/screenshot.h"
 #include "game/graphics/texture/TexturePool.h"
+#include "game/kernel/common/kmachine.h"
 #include "game/runtime.h"
 #include "game/sce/libscf.h"
 #include "game/system/hid/input_manager.h"
@@ -48,10 +53,33 @@ constexpr PerGameVersion<int> fr3_level_count(jak1::LEVEL_TOTAL,
                                               jak2::LEVEL_TOTAL,
                                               jak3::LEVEL_TOTAL);
 
+/*!
+ * Renderer state set by the game, which is applied when a frame starts rendering.
+ */
+struct FrameState {
+  std::optional<std::vector<std::string>> levels;
+  std::optional<std::vector<std::string>> active_levels;
+  std::optional<float> pmode_alp;
+};
+
+/*!
+ * A chain sent by the game with more than one frame in flight. The chain is copied, because the
+ * game will reuse its DMA buffer before this is rendered.
+ */
+struct PipelinedFrame {
+  std::unique_ptr<FixedChunkDmaCopier> copier;
+  u64 texture_fence = 0;
+  // changes made by the game while this is the newest frame.
+  FrameState state;
+  // set when the renderer takes this frame. After that, changes are applied right away.
+  bool started = false;
+};
+
 struct GraphicsData {
   // vsync
   std::mutex sync_mutex;
   std::condition_variable sync_cv;
+  u64 frame_idx_of_last_vsync = 0;
 
   // dma chain transfer
   std::mutex dma_mutex;
@@ -61,6 +89,26 @@ struct GraphicsData {
   bool has_data_to_render = false;
   FixedChunkDmaCopier dma_copier;
 
+  // frames that are sent, but not done rendering. The front one may be rendering now. Only used
+  // with more than one frame in flight.
+  std::deque<PipelinedFrame> pipeline;
+  std::vector<std::unique_ptr<FixedChunkDmaCopier>> spare_copiers;
+  // a chain in EE memory, sent with one frame in flight, that the renderer hasn't taken yet.
+  bool has_direct_chain = false;
+  // a chain in EE memory is taken or waiting, and isn't done rendering. The game can't build the
+  // next frame until it is, even if frames_in_flight was raised after sending it.
+  std::atomic<bool> direct_chain_in_flight = false;
+  u64 direct_chain_texture_fence = 0;
+  std::atomic<int> frames_in_flight = 0;
+  // copy of the frames_in_flight setting, which is changed by the debug gui on the render thread,
+  // for the game thread to read.
+  std::atomic<int> max_frames_in_flight = 1;
+
+  // capture of a frame for the dma_replay tool. EE memory is copied when the game sends a chain,
+  // and the capture is written to disk after that frame is rendered.
+  std::atomic<bool> want_dma_capture = false;
+  std::unique_ptr<DmaCapture> dma_capture;
+
   // texture pool
   std::shared_ptr<TexturePool> texture_pool;
 
@@ -357,6 +405,31 @@ GLDisplay::~GLDisplay() {
   }
 }
 
+/*!
+ * Write a captured frame to the user's misc folder, so it can be used with the dma_replay tool.
+ */
+static void save_dma_capture(DmaCapture& capture) {
+  auto path = file_util::get_user_misc_dir(g_gfx_data->version) / "dma_captures" /
+              fmt::format("{}.dmacap", str_util::current_local_timestamp_no_colons());
+  write_dma_capture(path, capture);
+  lg::info("Saved DMA capture to {}", path.string());
+}
+
+/*!
+ * Apply the renderer state the game set for a pipelined frame. Called with the dma_mutex held.
+ */
+static void apply_frame_state(const FrameState& state) {
+  if (state.levels) {
+    g_gfx_data->loader->set_want_levels(*state.levels);
+  }
+  if (state.active_levels) {
+    g_gfx_data->loader->set_active_levels(*state.active_levels);
+  }
+  if (state.pmode_alp) {
+    g_gfx_data->pmode_alp = *state.pmode_alp;
+  }
+}
+
 void render_game_frame(int game_width,
                        int game_height,
                        int window_fb_width,
@@ -367,12 +440,34 @@ void render_game_frame(int game_width,
                        bool take_screenshot) {
   // wait for a copied chain.
   bool got_chain = false;
+  FixedChunkDmaCopier* pipelined_copier = nullptr;
+  u64 texture_fence = 0;
   {
     auto p = scoped_prof("wait-for-dma");
     std::unique_lock<std::mutex> lock(g_gfx_data->dma_mutex);
     // there's a timeout here, so imgui can still be responsive even if we don't render anything
     got_chain = g_gfx_data->dma_cv.wait_for(lock, std::chrono::milliseconds(40),
                                             [=] { return g_gfx_data->has_data_to_render; });
+    if (got_chain) {
+      if (g_gfx_data->has_direct_chain) {
+        g_gfx_data->has_direct_chain = false;
+        texture_fence = g_gfx_data->direct_chain_texture_fence;
+      } else {
+        auto& frame = g_gfx_data->pipeline.front();
+        frame.started = true;
+        apply_frame_state(frame.state);
+        pipelined_copier = frame.copier.get();
+        texture_fence = frame.texture_fence;
+      }
+    }
+  }
+  // the chain may use textures the game uploaded before sending it.
+  if (got_chain) {
+    auto p = scoped_prof("apply-texture-uploads");
+    g_gfx_data->texture_pool->apply_queued(texture_fence);
+  }
+  if (g_gfx_data->debug_gui.get_dma_capture_flag()) {
+    g_gfx_data->want_dma_capture = true;
   }
   // render that chain.
   if (got_chain) {
@@ -426,7 +521,11 @@ void render_game_frame(int game_width,
       options.msaa_samples = msaa_max;
     }
 
-    if constexpr (run_dma_copy) {
+    if (pipelined_copier) {
+      auto p = scoped_prof("ogl-render");
+      auto& chain = pipelined_copier->get_last_result();
+      g_gfx_data->ogl_renderer.render(DmaFollower(chain.data.data(), chain.start_offset), options);
+    } else if constexpr (run_dma_copy) {
       auto& chain = g_gfx_data->dma_copier.get_last_result();
       g_gfx_data->ogl_renderer.render(DmaFollower(chain.data.data(), chain.start_offset), options);
     } else {
@@ -437,13 +536,36 @@ void render_game_frame(int game_width,
     }
   }
 
+  if (got_chain) {
+    std::unique_ptr<DmaCapture> capture;
+    {
+      std::unique_lock<std::mutex> lock(g_gfx_data->dma_mutex);
+      capture = std::move(g_gfx_data->dma_capture);
+    }
+    if (capture) {
+      save_dma_capture(*capture);
+    }
+  }
+
   // before vsync, mark the chain as rendered.
   {
     // should be fine to remove this mutex if the game actually waits for vsync to call
     // send_chain again. but let's be safe for now.
     std::unique_lock<std::mutex> lock(g_gfx_data->dma_mutex);
     g_gfx_data->engine_timer.start();
-    g_gfx_data->has_data_to_render = false;
+    if (got_chain) {
+      if (pipelined_copier) {
+        g_gfx_data->spare_copiers.push_back(std::move(g_gfx_data->pipeline.front().copier));
+        g_gfx_data->pipeline.pop_front();
+      } else {
+        g_gfx_data->direct_chain_in_flight = false;
+      }
+      g_gfx_data->frames_in_flight--;
+      g_gfx_data->has_data_to_render = g_gfx_data->frames_in_flight > 0;
+    }
+    // the game waits on this with the sync_mutex, so take it to not notify between its check and
+    // its wait.
+    { std::lock_guard<std::mutex> sync_lock(g_gfx_data->sync_mutex); }
     g_gfx_data->sync_cv.notify_all();
   }
 }
@@ -550,6 +672,7 @@ void GLDisplay::render() {
     auto p = scoped_prof("debug-gui");
     g_gfx_data->debug_gui.draw(g_gfx_data->dma_copier.get_last_result().stats);
   }
+  g_gfx_data->max_frames_in_flight = std::max(1, Gfx::g_global_settings.frames_in_flight);
   {
     auto p = scoped_prof("imgui-render");
     ImGui::Render();
@@ -623,10 +746,15 @@ u32 gl_vsync() {
     return 0;
   }
   std::unique_lock<std::mutex> lock(g_gfx_data->sync_mutex);
-  auto init_frame = g_gfx_data->frame_idx_of_input_data;
+  // with frames in flight, the renderer may still be on an older frame, so just wait for the next
+  // frame to start.
+  auto init_frame = g_gfx_data->max_frames_in_flight > 1
+                        ? g_gfx_data->frame_idx_of_last_vsync
+                        : g_gfx_data->frame_idx_of_input_data;
   g_gfx_data->sync_cv.wait(lock, [=] {
     return (MasterExit != RuntimeExitStatus::RUNNING) || g_gfx_data->frame_idx > init_frame;
   });
+  g_gfx_data->frame_idx_of_last_vsync = g_gfx_data->frame_idx;
   return g_gfx_data->frame_idx & 1;
 }
 
@@ -636,21 +764,63 @@ u32 gl_sync_path() {
   }
   std::unique_lock<std::mutex> lock(g_gfx_data->sync_mutex);
   g_gfx_data->last_engine_time = g_gfx_data->engine_timer.getSeconds();
-  if (!g_gfx_data->has_data_to_render) {
-    return 0;
-  }
-  g_gfx_data->sync_cv.wait(lock, [=] { return !g_gfx_data->has_data_to_render; });
+  // wait until there's room for another frame. With one frame in flight, this is until the last
+  // frame is rendered. A chain that wasn't copied must always be rendered first, because the game
+  // will overwrite it.
+  const int max_in_flight = g_gfx_data->max_frames_in_flight;
+  g_gfx_data->sync_cv.wait(lock, [=] {
+    return g_gfx_data->frames_in_flight < max_in_flight && !g_gfx_data->direct_chain_in_flight;
+  });
   return 0;
 }
 
+/*!
+ * Get the state of the newest frame, if the renderer hasn't started it, or nullptr if changes can
+ * be applied right away. Called with the dma_mutex held.
+ */
+static FrameState* newest_waiting_frame_state() {
+  if (g_gfx_data->pipeline.empty() || g_gfx_data->pipeline.back().started) {
+    return nullptr;
+  }
+  return &g_gfx_data->pipeline.back().state;
+}
+
+/*!
+ * Fill the levels and pmode of a capture with the state the game has set for the frame it is
+ * sending: the renderer's state, with the changes stored in frames that haven't started rendering.
+ * Called with the dma_mutex held.
+ */
+static void fill_capture_state(DmaCapture& capture) {
+  FrameState state;
+  for (const auto& frame : g_gfx_data->pipeline) {
+    if (frame.started) {
+      continue;
+    }
+    if (frame.state.levels) {
+      state.levels = frame.state.levels;
+    }
+    if (frame.state.active_levels) {
+      state.active_levels = frame.state.active_levels;
+    }
+    if (frame.state.pmode_alp) {
+      state.pmode_alp = frame.state.pmode_alp;
+    }
+  }
+  capture.levels = state.levels ? *state.levels : g_gfx_data->loader->get_desired_levels();
+  capture.active_levels =
+      state.active_levels ? *state.active_levels : g_gfx_data->loader->get_active_levels();
+  capture.pmode_alp = state.pmode_alp.value_or(g_gfx_data->pmode_alp);
+}
+
 /*!
  * Send DMA to the renderer.
  * Called from the game thread, on a GOAL stack.
  */
 void gl_send_chain(const void* data, u32 offset) {
   if (g_gfx_data) {
+    const int max_in_flight = g_gfx_data->max_frames_in_flight;
     std::unique_lock<std::mutex> lock(g_gfx_data->dma_mutex);
-    if (g_gfx_data->has_data_to_render) {
+    if (g_gfx_data->frames_in_flight >= max_in_flight) {
       lg::error(
           "Gfx::send_chain called when the graphics renderer has pending data. Was this called "
           "multiple times per frame?");
@@ -670,8 +840,48 @@ void gl_send_chain(const void* data, u32 offset) {
     // The renderers should just operate on DMA chains, so eliminating this step in the future
     // may be easy.
 
-    g_gfx_data->dma_copier.set_input_data(data, offset, run_dma_copy);
+    // with more than one frame in flight, the game will reuse this DMA buffer before it's
+    // rendered, so the copy is required.
+
+    if (g_gfx_data->want_dma_capture) {
+      // the game is about to build the next frame in memory, so the capture must happen now.
+      g_gfx_data->want_dma_capture = false;
+      auto capture = std::make_unique<DmaCapture>();
+      capture->version = g_gfx_data->version;
+      capture->chain_offset = offset;
+      capture->s7_offset = offset_of_s7();
+      capture->capture_memory((const u8*)data, EE_MAIN_MEM_SIZE);
+      // the renderer may still be on an older frame, so its state isn't this frame's state.
+      fill_capture_state(*capture);
+      g_gfx_data->dma_capture = std::move(capture);
+    }
 
+    const u64 texture_fence = g_gfx_data->texture_pool->last_queued_fence();
+    if (max_in_flight > 1) {
+      PipelinedFrame frame;
+      frame.texture_fence = texture_fence;
+      if (g_gfx_data->spare_copiers.empty()) {
+        frame.copier = std::make_unique<FixedChunkDmaCopier>(EE_MAIN_MEM_SIZE);
+      } else {
+        frame.copier = std::move(g_gfx_data->spare_copiers.back());
+        g_gfx_data->spare_copiers.pop_back();
+      }
+      // copy without the lock, so the renderer can finish the frame it's on.
+      lock.unlock();
+      {
+        auto p = scoped_prof("copy-dma-chain");
+        frame.copier->run(data, offset);
+      }
+      lock.lock();
+      g_gfx_data->pipeline.push_back(std::move(frame));
+    } else {
+      g_gfx_data->dma_copier.set_input_data(data, offset, run_dma_copy);
+      g_gfx_data->has_direct_chain = true;
+      g_gfx_data->direct_chain_in_flight = true;
+      g_gfx_data->direct_chain_texture_fence = texture_fence;
+    }
+
+    g_gfx_data->frames_in_flight++;
     g_gfx_data->has_data_to_render = true;
     g_gfx_data->dma_cv.notify_all();
   }
@@ -679,39 +889,50 @@ void gl_send_chain(const void* data, u32 offset) {
 
 /*!
  * Upload texture outside of main DMA chain.
- * We trust the game to not remove textures that are currently being used, but if the game is messed
- * up, there is a possible race to updating this texture.
+ * The page is read now, and the render thread updates the pool before it renders the next chain
+ * from the game, so frames that were sent earlier don't see the change.
  */
 void gl_texture_upload_now(const u8* tpage, int mode, u32 s7_ptr) {
-  // block
   if (g_gfx_data) {
-    // just pass it to the texture pool.
-    // the texture pool will take care of locking.
-    // we don't want to lock here for the entire duration of the conversion.
-    g_gfx_data->texture_pool->handle_upload_now(tpage, mode, g_ee_main_mem, s7_ptr, false);
+    g_gfx_data->texture_pool->queue_upload_now(tpage, mode, g_ee_main_mem, s7_ptr);
   }
 }
 
 /*!
  * Handle a local->local texture copy. The texture pool can just update texture pointers.
- * This is called from the main thread and the texture pool itself will handle locking.
+ * This is called from the main thread, and is applied in order with the uploads.
  */
 void gl_texture_relocate(u32 destination, u32 source, u32 format) {
   if (g_gfx_data) {
-    g_gfx_data->texture_pool->relocate(destination, source, format);
+    g_gfx_data->texture_pool->queue_relocate(destination, source, format);
   }
 }
 
 void gl_set_levels(const std::vector<std::string>& levels) {
-  g_gfx_data->loader->set_want_levels(levels);
+  std::unique_lock<std::mutex> lock(g_gfx_data->dma_mutex);
+  if (auto* state = newest_waiting_frame_state()) {
+    state->levels = levels;
+  } else {
+    g_gfx_data->loader->set_want_levels(levels);
+  }
 }
 
 void gl_set_active_levels(const std::vector<std::string>& levels) {
-  g_gfx_data->loader->set_active_levels(levels);
+  std::unique_lock<std::mutex> lock(g_gfx_data->dma_mutex);
+  if (auto* state = newest_waiting_frame_state()) {
+    state->active_levels = levels;
+  } else {
+    g_gfx_data->loader->set_active_levels(levels);
+  }
 }
 
 void gl_set_pmode_alp(float val) {
-  g_gfx_data->pmode_alp = val;
+  std::unique_lock<std::mutex> lock(g_gfx_data->dma_mutex);
+  if (auto* state = newest_waiting_frame_state()) {
+    state->pmode_alp = val;
+  } else {
+    g_gfx_data->pmode_alp = val;
+  }
 }
 
 const GfxRendererModule gRendererOpenGL = {
@@ -178,24 +178,16 @@ void GpuTexture::add_slot(u32 slot) {
 }
 
 /*!
- * Handle a GOAL texture-page object being uploaded to VRAM.
- * The strategy:
- * - upload the texture-age to a fake 4MB VRAM, like the GOAL code would have done.
- * - "download" each texture in a reasonable format for the PC Port (currently RGBA8888)
- * - add this to the PC pool.
- *
- * The textures are scrambled around in a confusing way.
- *
- * NOTE: the actual conversion is currently done here, but this might be too slow.
- * We could store textures in the right format to begin with, or spread the conversion out over
- * multiple frames.
+ * Read which textures a GOAL texture-page upload puts in which VRAM slots. This only reads the game
+ * memory, so it doesn't need the pool lock. The texture data itself is already in the pool, from
+ * the level's fr3 file.
  */
-void TexturePool::handle_upload_now(const u8* tpage,
-                                    int mode,
-                                    const u8* memory_base,
-                                    u32 s7_ptr,
-                                    bool debug) {
-  std::unique_lock<std::mutex> lk(m_mutex);
+TexturePageUpload TexturePool::read_upload_now(const u8* tpage,
+                                               int mode,
+                                               const u8* memory_base,
+                                               u32 s7_ptr,
+                                               bool debug) {
+  TexturePageUpload upload;
   // extract the texture-page object. This is just a description of the page data.
   GoalTexturePage texture_page;
   memcpy(&texture_page, tpage, sizeof(GoalTexturePage));
@@ -214,50 +206,134 @@ void TexturePool::handle_upload_now(const u8* tpage,
   } else {
     // no reason to skip this, other than
     lg::error("TexturePool skipping upload now with mode {}.", mode);
-    return;
+    return upload;
   }
 
   // loop over all texture in the tpage and download them.
   for (int tex_idx = 0; tex_idx < texture_page.length; tex_idx++) {
     GoalTexture tex;
     if (texture_page.try_copy_texture_description(&tex, tex_idx, memory_base, tpage, s7_ptr)) {
+      TexturePageUpload::Texture texture;
+      texture.id = PcTextureId(texture_page.id, tex_idx);
+      texture.name = std::string(goal_string(texture_page.name_ptr, memory_base)) +
+                     goal_string(tex.name_ptr, memory_base);
       if (debug) {
-        fmt::print("Pool upload {} to {}\n",
-                   std::string(goal_string(texture_page.name_ptr, memory_base)) +
-                       goal_string(tex.name_ptr, memory_base),
-                   tex.dest[0]);
+        fmt::print("Pool upload {} to {}\n", texture.name, tex.dest[0]);
       }
       // each texture may have multiple mip levels.
       for (int mip_idx = 0; mip_idx < tex.num_mips; mip_idx++) {
         if (has_segment[tex.segment_of_mip(mip_idx)]) {
-          PcTextureId current_id(texture_page.id, tex_idx);
-          if (!m_id_to_name.lookup_existing(current_id)) {
-            auto name = std::string(goal_string(texture_page.name_ptr, memory_base)) +
-                        goal_string(tex.name_ptr, memory_base);
-            *m_id_to_name.lookup_or_insert(current_id).first = name;
-            m_name_to_id[name] = current_id;
-          }
-
-          auto& slot = m_textures[tex.dest[mip_idx]];
-
-          if (slot.source) {
-            if (slot.source->tex_id == current_id) {
-              // we already have it, no need to do anything
-            } else {
-              slot.source->remove_slot(tex.dest[mip_idx]);
-              slot.source = get_gpu_texture_for_slot(current_id, tex.dest[mip_idx]);
-              ASSERT(slot.gpu_texture != (GLuint)-1);
-            }
-          } else {
-            slot.source = get_gpu_texture_for_slot(current_id, tex.dest[mip_idx]);
-            ASSERT(slot.gpu_texture != (GLuint)-1);
-          }
+          texture.slots.push_back(tex.dest[mip_idx]);
         }
       }
+      if (!texture.slots.empty()) {
+        upload.textures.push_back(std::move(texture));
+      }
     } else {
       // texture was #f, skip it.
     }
   }
+  return upload;
+}
+
+/*!
+ * Point VRAM slots at the textures from a texture-page upload.
+ */
+void TexturePool::apply_upload_now(const TexturePageUpload& upload) {
+  std::unique_lock<std::mutex> lk(m_mutex);
+  for (auto& texture : upload.textures) {
+    const auto current_id = texture.id;
+    if (!m_id_to_name.lookup_existing(current_id)) {
+      *m_id_to_name.lookup_or_insert(current_id).first = texture.name;
+      m_name_to_id[texture.name] = current_id;
+    }
+
+    for (u32 dest : texture.slots) {
+      auto& slot = m_textures[dest];
+
+      if (slot.source) {
+        if (slot.source->tex_id == current_id) {
+          // we already have it, no need to do anything
+        } else {
+          slot.source->remove_slot(dest);
+          slot.source = get_gpu_texture_for_slot(current_id, dest);
+          ASSERT(slot.gpu_texture != (GLuint)-1);
+        }
+      } else {
+        slot.source = get_gpu_texture_for_slot(current_id, dest);
+        ASSERT(slot.gpu_texture != (GLuint)-1);
+      }
+    }
+  }
+}
+
+/*!
+ * Handle a GOAL texture-page object being uploaded to VRAM, right away.
+ */
+void TexturePool::handle_upload_now(const u8* tpage,
+                                    int mode,
+                                    const u8* memory_base,
+                                    u32 s7_ptr,
+                                    bool debug) {
+  apply_upload_now(read_upload_now(tpage, mode, memory_base, s7_ptr, debug));
+}
+
+/*!
+ * Queue a texture-page upload from the game. Returns a fence for apply_queued. The game memory is
+ * read now, so the game is free to change it after this returns.
+ */
+u64 TexturePool::queue_upload_now(const u8* tpage, int mode, const u8* memory_base, u32 s7_ptr) {
+  QueuedChange change;
+  change.upload = read_upload_now(tpage, mode, memory_base, s7_ptr, false);
+  std::unique_lock<std::mutex> lk(m_queue_mutex);
+  change.fence = ++m_last_queued_fence;
+  m_queue.push_back(std::move(change));
+  return m_last_queued_fence;
+}
+
+/*!
+ * Queue a relocate from the game. Returns a fence for apply_queued.
+ */
+u64 TexturePool::queue_relocate(u32 destination, u32 source, u32 format) {
+  std::unique_lock<std::mutex> lk(m_queue_mutex);
+  QueuedChange change;
+  change.fence = ++m_last_queued_fence;
+  change.relocate_destination = destination;
+  change.relocate_source = source;
+  change.relocate_format = format;
+  m_queue.push_back(std::move(change));
+  return m_last_queued_fence;
+}
+
+/*!
+ * Get a fence that covers everything queued so far.
+ */
+u64 TexturePool::last_queued_fence() {
+  std::unique_lock<std::mutex> lk(m_queue_mutex);
+  return m_last_queued_fence;
+}
+
+/*!
+ * Apply the queued uploads and relocates, in order, up to and including the given fence.
+ * Called from the render thread before it uses textures the game may have queued.
+ */
+void TexturePool::apply_queued(u64 fence) {
+  std::vector<QueuedChange> changes;
+  {
+    std::unique_lock<std::mutex> lk(m_queue_mutex);
+    while (!m_queue.empty() && m_queue.front().fence <= fence) {
+      changes.push_back(std::move(m_queue.front()));
+      m_queue.pop_front();
+    }
+  }
+
+  for (auto& change : changes) {
+    if (change.upload) {
+      apply_upload_now(*change.upload);
+    } else {
+      relocate(change.relocate_destination, change.relocate_source, change.relocate_format);
+    }
+  }
 }
 
 void TexturePool::relocate(u32 destination, u32 source, u32 format) {
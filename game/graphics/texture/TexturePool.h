@@ -1,11 +1,13 @@
 #pragma once
 
 #include <array>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "common/common_types.h"
 #include "common/util/Serializer.h"
@@ -274,6 +276,18 @@ struct GoalTexturePage {
   }
 };
 
+/*!
+ * The VRAM slots that a texture-page upload points at each of its textures.
+ */
+struct TexturePageUpload {
+  struct Texture {
+    PcTextureId id;
+    std::string name;
+    std::vector<u32> slots;  // one per uploaded mip
+  };
+  std::vector<Texture> textures;
+};
+
 /*!
  * The main texture pool.
  * Moving textures around should be done with locking. (the game EE thread and the loader run
@@ -294,6 +308,19 @@ class TexturePool {
  public:
   TexturePool(GameVersion version);
   void handle_upload_now(const u8* tpage, int mode, const u8* memory_base, u32 s7_ptr, bool debug);
+  static TexturePageUpload read_upload_now(const u8* tpage,
+                                           int mode,
+                                           const u8* memory_base,
+                                           u32 s7_ptr,
+                                           bool debug);
+  void apply_upload_now(const TexturePageUpload& upload);
+
+  // Uploads and relocates from the game thread are queued, and the render thread applies them
+  // before drawing the first chain sent after them, so the game never waits on the pool lock.
+  u64 queue_upload_now(const u8* tpage, int mode, const u8* memory_base, u32 s7_ptr);
+  u64 queue_relocate(u32 destination, u32 source, u32 format);
+  u64 last_queued_fence();
+  void apply_queued(u64 fence);
   GpuTexture* give_texture(const TextureInput& in);
   GpuTexture* give_texture_and_load_to_vram(const TextureInput& in, u32 vram_slot);
   void unload_texture(PcTextureId tex_id, u64 gpu_id);
@@ -376,4 +403,15 @@ class TexturePool {
   u32 m_tpage_dir_size = 0;
 
   std::mutex m_mutex;
+
+  struct QueuedChange {
+    u64 fence = 0;
+    std::optional<TexturePageUpload> upload;  // if not set, this is a relocate
+    u32 relocate_destination = 0;
+    u32 relocate_source = 0;
+    u32 relocate_format = 0;
+  };
+  std::mutex m_queue_mutex;
+  std::deque<QueuedChange> m_queue;
+  u64 m_last_queued_fence = 0;
 };
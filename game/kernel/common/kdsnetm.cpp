@@ -2,6 +2,7 @@
 
 #include <cstdio>
 
+#include "game/kernel/common/klisten.h"
 #include "game/kernel/common/kprint.h"
 #include "game/sce/deci2.h"
 #include "game/system/deci_common.h"
@@ -98,6 +99,13 @@ void GoalProtoHandler(int event, int param, void* opt) {
 
       // read is finished!
     case DECI2_READDONE:
+      // added: batch loads don't wait for the kernel to pick them up, see klisten.cpp
+      if (pb->receive_progress >= (int)sizeof(ListenerMessageHeader) &&
+          pb->receive_buffer->ltt_msg_kind == LTT_MSG_CODE_BATCH) {
+        ReceiveListenerBatchMessage(pb->receive_buffer);
+        pb->receive_progress = 0;
+        break;
+      }
       // set last_receive_size to indicate that there is a pending message in the buffer.
       pb->last_receive_size = pb->receive_progress;
       pb->receive_progress = 0;
@@ -2,9 +2,13 @@
 
 #include <cstdio>
 #include <cstring>
+#include <deque>
+#include <mutex>
 
 #include "common/listener_common.h"
 #include "common/log/log.h"
+#include "common/util/Assert.h"
+#include "common/util/compress.h"
 
 #include "game/kernel/common/kdsnetm.h"
 #include "game/kernel/common/kprint.h"
@@ -13,9 +17,18 @@
 Ptr<u32> print_column;
 u32 ListenerStatus;
 
+namespace {
+// batch loads are decoded on the DECI2 thread as they arrive, then run by the kernel.
+std::mutex batch_mutex;
+std::deque<ListenerBatchItem> batch_items;
+std::vector<u8> batch_stream;  // received data that isn't a full record yet, DECI2 thread only.
+}  // namespace
+
 void klisten_init_globals() {
   print_column.offset = 0;
   ListenerStatus = 0;
+  std::lock_guard<std::mutex> lk(batch_mutex);
+  batch_items.clear();
 }
 
 /*!
@@ -85,3 +98,71 @@ void SendAck() {
                     strlen(AckBufArea + sizeof(ListenerMessageHeader)));
   }
 }
+
+/*!
+ * Handle a LTT_MSG_CODE_BATCH message that has been fully received. This runs on the DECI2 thread,
+ * so the next message can be received and decompressed while the kernel runs the objects from this
+ * one. Not in the original game.
+ */
+void ReceiveListenerBatchMessage(const ListenerMessageHeader* header) {
+  if (header->u6 & LISTENER_BATCH_FIRST_CHUNK) {
+    batch_stream.clear();
+  }
+  const u8* data = (const u8*)(header + 1);
+  batch_stream.insert(batch_stream.end(), data, data + header->msg_size);
+
+  std::vector<ListenerBatchItem> items;
+  size_t offset = 0;
+  while (batch_stream.size() - offset >= sizeof(ListenerBatchRecord)) {
+    ListenerBatchRecord record;
+    memcpy(&record, batch_stream.data() + offset, sizeof(ListenerBatchRecord));
+    size_t stored_size = record.compressed_size ? record.compressed_size : record.size;
+    size_t record_size = sizeof(ListenerBatchRecord) + record.name_size + stored_size;
+    if (batch_stream.size() - offset < record_size) {
+      break;
+    }
+
+    auto& item = items.emplace_back();
+    const u8* name = batch_stream.data() + offset + sizeof(ListenerBatchRecord);
+    const u8* object = name + record.name_size;
+    item.name.assign((const char*)name, record.name_size);
+    if (record.compressed_size) {
+      item.data = compression::decompress_zstd(object, record.compressed_size);
+      ASSERT(item.data.size() == record.size);
+    } else {
+      item.data.assign(object, object + record.size);
+    }
+    offset += record_size;
+  }
+  batch_stream.erase(batch_stream.begin(), batch_stream.begin() + offset);
+  items.emplace_back().ack_id = header->msg_id;
+
+  std::lock_guard<std::mutex> lk(batch_mutex);
+  for (auto& item : items) {
+    batch_items.push_back(std::move(item));
+  }
+}
+
+/*!
+ * Get the next object or ack from batch loads, in the order they were received.
+ */
+bool PopListenerBatchItem(ListenerBatchItem* item) {
+  std::lock_guard<std::mutex> lk(batch_mutex);
+  if (batch_items.empty()) {
+    return false;
+  }
+  *item = std::move(batch_items.front());
+  batch_items.pop_front();
+  return true;
+}
+
+/*!
+ * Ack a batch message. Unlike SendAck, the id is given, because it isn't the most recent message.
+ */
+void SendBatchAck(u64 msg_id) {
+  if (MasterDebug) {
+    SendFromBufferD(u16(ListenerMessageKind::MSG_ACK), msg_id,
+                    AckBufArea + sizeof(ListenerMessageHeader),
+                    strlen(AckBufArea + sizeof(ListenerMessageHeader)));
+  }
+}
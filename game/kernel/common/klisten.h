@@ -1,6 +1,10 @@
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include "common/common_types.h"
+#include "common/listener_common.h"
 
 #include "game/kernel/common/Ptr.h"
 
@@ -9,4 +13,18 @@ extern u32 ListenerStatus;
 
 void klisten_init_globals();
 void ClearPending();
-void SendAck();
\ No newline at end of file
+void SendAck();
+
+/*!
+ * An object from a batch load, or, if it has no data, an ack to send once everything before it has
+ * run.
+ */
+struct ListenerBatchItem {
+  std::string name;
+  std::vector<u8> data;
+  u64 ack_id = 0;
+};
+
+void ReceiveListenerBatchMessage(const ListenerMessageHeader* header);
+bool PopListenerBatchItem(ListenerBatchItem* item);
+void SendBatchAck(u64 msg_id);
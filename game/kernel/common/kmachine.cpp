@@ -16,6 +16,7 @@
 #include "game/graphics/screenshot.h"
 #include "game/kernel/common/Ptr.h"
 #include "game/kernel/common/kernel_types.h"
+#include "game/kernel/common/kmalloc_tracker.h"
 #include "game/kernel/common/kprint.h"
 #include "game/kernel/common/kscheme.h"
 #include "game/mips2c/mips2c_table.h"
@@ -888,6 +889,14 @@ void pc_register_screen_shot_settings(u32 ptr) {
   register_screen_shot_settings(Ptr<ScreenShotSettings>(ptr).c());
 }
 
+void pc_kmalloc_track(u32 symptr) {
+  gKmallocTracking = symbol_to_bool(symptr);
+}
+
+void pc_kmalloc_report() {
+  kmalloc_tracker_print_report();
+}
+
 /// Initializes all functions that are common across all game versions
 /// These functions have the same implementation and do not use any game specific functions (other
 /// than the one to create a function in the first place)
@@ -992,4 +1001,6 @@ void init_common_pc_port_functions(
   make_func_symbol_func("pc-screen-shot", (void*)pc_screen_shot);
   make_func_symbol_func("pc-register-screen-shot-settings",
                         (void*)pc_register_screen_shot_settings);
+  make_func_symbol_func("pc-kmalloc-track", (void*)pc_kmalloc_track);
+  make_func_symbol_func("pc-kmalloc-report", (void*)pc_kmalloc_report);
 }
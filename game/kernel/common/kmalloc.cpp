@@ -5,6 +5,7 @@
 
 #include "common/goal_constants.h"
 
+#include "game/kernel/common/kmalloc_tracker.h"
 #include "game/kernel/common/kprint.h"
 #include "game/kernel/common/kscheme.h"
 #include "game/kernel/common/memory_layout.h"
@@ -27,6 +28,7 @@ void kmalloc_init_globals_common() {
   kglobalheap.offset = GLOBAL_HEAP_INFO_ADDR;
   kdebugheap.offset = DEBUG_HEAP_INFO_ADDR;
   kheaplogging = false;
+  kmalloc_tracker_reset();
   for (auto& x : MemItemsCount)
     x = 0;
   for (auto& x : MemItemsSize)
@@ -157,12 +159,18 @@ Ptr<u8> kmalloc(Ptr<kheapinfo> heap, s32 size, u32 flags, char const* name) {
     uint32_t memend = memstart + size;
 
     if (heap->top.offset < memend) {
+      if (gKmallocTracking.load(std::memory_order_relaxed)) {
+        kmalloc_track(heap, size, name, true);
+      }
       kheapstatus(heap);
       Msg(6, "kmalloc: !alloc mem %s (%d bytes) heap %x\n", name, size, heap.offset);
       return Ptr<u8>(0);
     }
 
     heap->current.offset = memend;
+    if (gKmallocTracking.load(std::memory_order_relaxed)) {
+      kmalloc_track(heap, size, name, false);
+    }
     if (flags & KMALLOC_MEMSET)
       std::memset(Ptr<u8>(memstart).c(), 0, (size_t)size);
     return Ptr<u8>(memstart);
@@ -180,12 +188,18 @@ Ptr<u8> kmalloc(Ptr<kheapinfo> heap, s32 size, u32 flags, char const* name) {
     }
 
     if (heap->current.offset >= memstart) {
+      if (gKmallocTracking.load(std::memory_order_relaxed)) {
+        kmalloc_track(heap, size, name, true);
+      }
       Msg(6, "kmalloc: !alloc mem from top %s (%d bytes) heap %x\n", name, size, heap.offset);
       kheapstatus(heap);
       return Ptr<u8>(0);
     }
 
     heap->top.offset = memstart;
+    if (gKmallocTracking.load(std::memory_order_relaxed)) {
+      kmalloc_track(heap, size, name, false);
+    }
 
     if (flags & KMALLOC_MEMSET)
       std::memset(Ptr<u8>(memstart).c(), 0, (size_t)size);
@@ -0,0 +1,330 @@
+#include "kmalloc_tracker.h"
+
+#include <algorithm>
+#include <bit>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common/log/log.h"
+#include "common/util/FileUtil.h"
+#include "common/util/Timer.h"
+#include "common/util/json_util.h"
+#include "common/util/string_util.h"
+
+#include "game/kernel/common/kprint.h"
+
+#include "fmt/core.h"
+
+std::atomic<bool> gKmallocTracking = false;
+
+namespace {
+constexpr int MAX_HEAPS = 64;
+constexpr int MAX_NAMES = 4096;  // must be a power of two
+constexpr int NAME_LENGTH = 48;
+constexpr int NUM_SIZE_BUCKETS = 32;  // bucket i has sizes from 2^i to 2^(i+1) - 1
+
+struct HeapStats {
+  std::atomic<u32> heap = 0;  // address of the kheapinfo, 0 if this slot isn't used yet.
+  std::atomic<u32> size = 0;
+  std::atomic<u32> peak_bottom = 0;
+  std::atomic<u32> peak_top = 0;
+  std::atomic<u32> free = 0;  // as of the last allocation
+  std::atomic<u32> min_free = UINT32_MAX;
+  std::atomic<u64> count = 0;
+  std::atomic<u64> bytes = 0;
+  std::atomic<u64> failed = 0;
+  std::atomic<u64> size_histogram[NUM_SIZE_BUCKETS] = {};
+};
+
+struct NameStats {
+  std::atomic<u64> key = 0;         // hash of the heap and name, 0 if this slot isn't used yet.
+  std::atomic<bool> ready = false;  // set once heap and name are filled in.
+  u32 heap = 0;
+  char name[NAME_LENGTH] = {};
+  std::atomic<u64> count = 0;
+  std::atomic<u64> bytes = 0;
+  std::atomic<u64> failed = 0;
+  std::atomic<u32> largest = 0;
+};
+
+HeapStats g_heaps[MAX_HEAPS];
+NameStats g_names[MAX_NAMES];
+std::atomic<u64> g_dropped = 0;  // allocations that didn't fit in the tables.
+
+struct SnapshotWriter {
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool stop = false;
+};
+
+SnapshotWriter g_snapshots;
+
+void atomic_max(std::atomic<u32>& value, u32 x) {
+  u32 current = value.load(std::memory_order_relaxed);
+  while (x > current && !value.compare_exchange_weak(current, x, std::memory_order_relaxed)) {
+  }
+}
+
+void atomic_min(std::atomic<u32>& value, u32 x) {
+  u32 current = value.load(std::memory_order_relaxed);
+  while (x < current && !value.compare_exchange_weak(current, x, std::memory_order_relaxed)) {
+  }
+}
+
+HeapStats* find_heap(u32 heap) {
+  for (int i = 0; i < MAX_HEAPS; i++) {
+    auto& stats = g_heaps[(heap / 16 + i) % MAX_HEAPS];
+    u32 slot_heap = stats.heap.load(std::memory_order_acquire);
+    if (slot_heap == heap) {
+      return &stats;
+    }
+    if (!slot_heap && stats.heap.compare_exchange_strong(slot_heap, heap)) {
+      return &stats;
+    }
+    // another thread may have just taken the slot for the same heap.
+    if (slot_heap == heap) {
+      return &stats;
+    }
+  }
+  return nullptr;
+}
+
+u64 name_key(u32 heap, const char* name) {
+  // fnv-1a
+  u64 hash = 0xcbf29ce484222325;
+  for (const char* c = name; *c; c++) {
+    hash = (hash ^ (u8)*c) * 0x100000001b3;
+  }
+  return (hash ^ (heap * 0x9e3779b97f4a7c15)) | 1;
+}
+
+NameStats* find_name(u32 heap, const char* name) {
+  u64 key = name_key(heap, name);
+  for (int i = 0; i < MAX_NAMES; i++) {
+    auto& stats = g_names[(key + i) & (MAX_NAMES - 1)];
+    u64 slot_key = stats.key.load(std::memory_order_acquire);
+    if (slot_key == key) {
+      return &stats;
+    }
+    if (!slot_key && stats.key.compare_exchange_strong(slot_key, key)) {
+      stats.heap = heap;
+      strncpy(stats.name, name, NAME_LENGTH - 1);
+      stats.ready.store(true, std::memory_order_release);
+      return &stats;
+    }
+    // another thread may have just taken the slot for the same name.
+    if (slot_key == key) {
+      return &stats;
+    }
+  }
+  return nullptr;
+}
+
+std::string heap_name(u32 heap) {
+  if (heap == kglobalheap.offset) {
+    return "global";
+  } else if (heap == kdebugheap.offset) {
+    return "debug";
+  } else {
+    return fmt::format("#x{:x}", heap);
+  }
+}
+
+std::vector<const NameStats*> names_by_bytes() {
+  std::vector<const NameStats*> result;
+  for (const auto& stats : g_names) {
+    if (stats.ready.load(std::memory_order_acquire)) {
+      result.push_back(&stats);
+    }
+  }
+  std::sort(result.begin(), result.end(), [](const NameStats* a, const NameStats* b) {
+    return a->bytes.load(std::memory_order_relaxed) > b->bytes.load(std::memory_order_relaxed);
+  });
+  return result;
+}
+
+void snapshot_thread(std::string path, int interval_seconds) {
+  Timer timer;
+  std::ofstream out(path, std::ios::app);
+  std::unique_lock<std::mutex> lock(g_snapshots.mutex);
+  while (!g_snapshots.stop) {
+    g_snapshots.cv.wait_for(lock, std::chrono::seconds(interval_seconds));
+    auto snapshot = json::parse(kmalloc_tracker_json());
+    snapshot["seconds"] = timer.getSeconds();
+    // one snapshot per line, so a file from a crash is still usable up to the last one.
+    out << snapshot.dump() << std::endl;
+  }
+}
+}  // namespace
+
+/*!
+ * Clear everything recorded so far.
+ */
+void kmalloc_tracker_reset() {
+  for (auto& stats : g_heaps) {
+    stats.heap = 0;
+    stats.size = 0;
+    stats.peak_bottom = 0;
+    stats.peak_top = 0;
+    stats.free = 0;
+    stats.min_free = UINT32_MAX;
+    stats.count = 0;
+    stats.bytes = 0;
+    stats.failed = 0;
+    for (auto& bucket : stats.size_histogram) {
+      bucket = 0;
+    }
+  }
+  for (auto& stats : g_names) {
+    stats.key = 0;
+    stats.ready = false;
+    stats.count = 0;
+    stats.bytes = 0;
+    stats.failed = 0;
+    stats.largest = 0;
+  }
+  g_dropped = 0;
+}
+
+/*!
+ * Record an allocation from heap. This is called by kmalloc, after the heap has been updated.
+ */
+void kmalloc_track(Ptr<kheapinfo> heap, s32 size, const char* name, bool failed) {
+  constexpr auto relaxed = std::memory_order_relaxed;
+  auto* heap_stats = find_heap(heap.offset);
+  auto* name_stats = find_name(heap.offset, name ? name : "");
+  if (!heap_stats || !name_stats) {
+    g_dropped.fetch_add(1, relaxed);
+  }
+
+  if (heap_stats) {
+    u32 free = heap->top - heap->current;
+    heap_stats->size.store(heap->top_base - heap->base, relaxed);
+    heap_stats->free.store(free, relaxed);
+    atomic_min(heap_stats->min_free, free);
+    atomic_max(heap_stats->peak_bottom, heap->current - heap->base);
+    atomic_max(heap_stats->peak_top, heap->top_base - heap->top);
+    if (failed) {
+      heap_stats->failed.fetch_add(1, relaxed);
+    } else {
+      heap_stats->count.fetch_add(1, relaxed);
+      heap_stats->bytes.fetch_add(size, relaxed);
+      if (size > 0) {
+        heap_stats->size_histogram[std::bit_width((u32)size) - 1].fetch_add(1, relaxed);
+      }
+    }
+  }
+
+  if (name_stats) {
+    if (failed) {
+      name_stats->failed.fetch_add(1, relaxed);
+    } else {
+      name_stats->count.fetch_add(1, relaxed);
+      name_stats->bytes.fetch_add(size, relaxed);
+      atomic_max(name_stats->largest, size);
+    }
+  }
+}
+
+/*!
+ * Print the heaps and the names with the most bytes allocated to the listener.
+ */
+void kmalloc_tracker_print_report() {
+  constexpr auto relaxed = std::memory_order_relaxed;
+  cprintf("kmalloc tracking is %s, %lld allocations were not recorded\n",
+          gKmallocTracking ? "on" : "off", (long long)g_dropped.load(relaxed));
+  cprintf("%-12s %9s %12s %12s %9s %12s %9s %7s\n", "heap", "size KB", "peak bot KB",
+          "peak top KB", "free KB", "min free KB", "allocs", "failed");
+  for (const auto& stats : g_heaps) {
+    u32 heap = stats.heap.load(std::memory_order_acquire);
+    if (!heap) {
+      continue;
+    }
+    cprintf("%-12s %9d %12d %12d %9d %12d %9lld %7lld\n", heap_name(heap).c_str(),
+            stats.size.load(relaxed) / 1024, stats.peak_bottom.load(relaxed) / 1024,
+            stats.peak_top.load(relaxed) / 1024, stats.free.load(relaxed) / 1024,
+            stats.min_free.load(relaxed) / 1024, (long long)stats.count.load(relaxed),
+            (long long)stats.failed.load(relaxed));
+  }
+
+  auto names = names_by_bytes();
+  names.resize(std::min(names.size(), size_t(30)));
+  cprintf("\n%-12s %-32s %9s %9s %11s %7s\n", "heap", "name", "allocs", "KB", "largest KB",
+          "failed");
+  for (const auto* stats : names) {
+    cprintf("%-12s %-32s %9lld %9lld %11d %7lld\n", heap_name(stats->heap).c_str(), stats->name,
+            (long long)stats->count.load(relaxed), (long long)stats->bytes.load(relaxed) / 1024,
+            stats->largest.load(relaxed) / 1024, (long long)stats->failed.load(relaxed));
+  }
+}
+
+std::string kmalloc_tracker_json() {
+  constexpr auto relaxed = std::memory_order_relaxed;
+  json result;
+  result["dropped"] = g_dropped.load(relaxed);
+  result["heaps"] = json::array();
+  for (const auto& stats : g_heaps) {
+    u32 heap = stats.heap.load(std::memory_order_acquire);
+    if (!heap) {
+      continue;
+    }
+    json sizes;
+    for (int i = 0; i < NUM_SIZE_BUCKETS; i++) {
+      if (auto count = stats.size_histogram[i].load(relaxed)) {
+        sizes[std::to_string(1u << i)] = count;
+      }
+    }
+    result["heaps"].push_back({{"heap", heap_name(heap)},
+                               {"size", stats.size.load(relaxed)},
+                               {"peak-bottom", stats.peak_bottom.load(relaxed)},
+                               {"peak-top", stats.peak_top.load(relaxed)},
+                               {"free", stats.free.load(relaxed)},
+                               {"min-free", stats.min_free.load(relaxed)},
+                               {"allocations", stats.count.load(relaxed)},
+                               {"bytes", stats.bytes.load(relaxed)},
+                               {"failed", stats.failed.load(relaxed)},
+                               {"sizes", sizes}});
+  }
+  result["names"] = json::array();
+  for (const auto* stats : names_by_bytes()) {
+    result["names"].push_back({{"heap", heap_name(stats->heap)},
+                               {"name", stats->name},
+                               {"allocations", stats->count.load(relaxed)},
+                               {"bytes", stats->bytes.load(relaxed)},
+                               {"largest", stats->largest.load(relaxed)},
+                               {"failed", stats->failed.load(relaxed)}});
+  }
+  return result.dump();
+}
+
+/*!
+ * Turn on tracking, and append a json snapshot of the tables to a file every interval_seconds,
+ * until kmalloc_tracker_stop_snapshots. Returns the path of the file.
+ */
+std::string kmalloc_tracker_start_snapshots(GameVersion version, int interval_seconds) {
+  kmalloc_tracker_stop_snapshots();
+  auto path = file_util::get_user_misc_dir(version) / "kmalloc" /
+              fmt::format("kmalloc-{}.jsonl", str_util::current_local_timestamp_no_colons());
+  file_util::create_dir_if_needed_for_file(path);
+  gKmallocTracking = true;
+  g_snapshots.stop = false;
+  g_snapshots.thread = std::thread(snapshot_thread, path.string(), std::max(interval_seconds, 1));
+  return path.string();
+}
+
+void kmalloc_tracker_stop_snapshots() {
+  if (!g_snapshots.thread.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(g_snapshots.mutex);
+    g_snapshots.stop = true;
+  }
+  g_snapshots.cv.notify_one();
+  g_snapshots.thread.join();
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+/*!
+ * @file kmalloc_tracker.h
+ * Optional tracking of kmalloc allocations per heap and per allocation name. Not in the original
+ * game. For each heap, this also records the most it ever had in use from the bottom and from the
+ * top, and the least free space it ever had, so heaps can be sized and near-overflows can be
+ * caught before an allocation actually fails.
+ *
+ * Recording doesn't lock, and the tables can be read while allocations are being recorded.
+ */
+
+#include <atomic>
+#include <string>
+
+#include "common/common_types.h"
+#include "common/versions/versions.h"
+
+#include "game/kernel/common/kmalloc.h"
+
+extern std::atomic<bool> gKmallocTracking;
+
+void kmalloc_tracker_reset();
+void kmalloc_track(Ptr<kheapinfo> heap, s32 size, const char* name, bool failed);
+void kmalloc_tracker_print_report();
+std::string kmalloc_tracker_json();
+std::string kmalloc_tracker_start_snapshots(GameVersion version, int interval_seconds);
+void kmalloc_tracker_stop_snapshots();
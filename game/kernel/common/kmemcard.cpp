@@ -9,13 +9,17 @@
 #include "kmemcard.h"
 
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <cstdio>
 #include <cstring>
+#include <thread>
 
 #include "common/util/Assert.h"
 #include "common/util/FileUtil.h"
 #include "common/util/Timer.h"
 
+#include "game/runtime.h"
 #include "game/sce/sif_ee.h"
 #include "game/sce/sif_ee_memcard.h"
 
@@ -51,6 +55,21 @@ static_assert(sizeof(McHeader) == 0x400, "McHeader size");
 
 static McHeader header;
 
+// a save that is being written by the background worker. The EE thread starts it and checks on it
+// from MC_run, the worker thread only sets ok and done.
+struct PendingSave {
+  bool in_progress = false;
+  std::atomic<bool> done = false;
+  std::atomic<bool> ok = false;
+  u32 file = 0;
+  u32 save_count = 0;
+  u32 bank = 0;
+  u8 preview_data[64] = {};
+  Timer timer;
+};
+
+static PendingSave pending_save;
+
 // these are the return value for sceMcGetInfo.
 static s32 p1, p2, p3, p4;
 using namespace ee;
@@ -132,6 +151,13 @@ void kmemcard_init_globals() {
   p4 = 0;
   // memset(&dirent, 0, sizeof(sceMcTblGetDir));
   memset(&header, 0, sizeof(McHeader));
+  // a save started before a restart is still writing its file, and will set done when it's
+  // finished. Let it finish first, so it doesn't complete a save started after this.
+  while (pending_save.in_progress && !pending_save.done) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  pending_save.in_progress = false;
+  pending_save.done = false;
 }
 
 /*!
@@ -179,6 +205,20 @@ bool file_is_present(int id, int bank = 0) {
   */
 }
 
+/*!
+ * PC port function to read the header at the start of a bank file, which is all we need to know
+ * about a save without loading it.
+ */
+bool read_mc_header(const fs::path& path, McHeader* result) {
+  auto fp = file_util::open_file(path, "rb");
+  if (!fp) {
+    return false;
+  }
+  bool ok = fread(result, sizeof(McHeader), 1, fp) == 1;
+  fclose(fp);
+  return ok;
+}
+
 /*!
  * PC port function to set memcard info. We don't use a memory card, instead just the raw savefiles.
  */
@@ -187,14 +227,13 @@ void pc_update_card() {
   mc_last_file = -1;
   for (s32 file = 0; file < 4; file++) {
     auto bankname = mc_get_filename(g_game_version, 4 + file * 2);
-    mc_files[file].present = file_is_present(file);
+    McHeader bank_header1, bank_header2;
+    mc_files[file].present = file_is_present(file) && read_mc_header(bankname, &bank_header1);
     if (mc_files[file].present) {
-      auto bankdata = file_util::read_binary_file(bankname.string());
-      auto header1 = reinterpret_cast<McHeader*>(bankdata.data());
-      if (file_is_present(file, 1)) {
-        auto bankname2 = mc_get_filename(g_game_version, 1 + 4 + file * 2);
-        auto bankdata2 = file_util::read_binary_file(bankname2.string());
-        auto header2 = reinterpret_cast<McHeader*>(bankdata2.data());
+      auto header1 = &bank_header1;
+      if (file_is_present(file, 1) &&
+          read_mc_header(mc_get_filename(g_game_version, 1 + 4 + file * 2), &bank_header2)) {
+        auto header2 = &bank_header2;
 
         if (header2->save_count > header1->save_count) {
           // use most recent bank here.
@@ -223,14 +262,13 @@ void pc_update_card() {
 }
 
 /*!
- * PC port function to save a file. This does the whole saving at once, synchronously.
+ * PC port function to start saving a file. This picks the bank, and copies the header, the save
+ * data and the footer into a buffer that the background worker writes out, so the game doesn't wait
+ * on the disk. The bank file is replaced all at once, so a crash while saving leaves the old save.
  */
-void pc_game_save_synch() {
-  Timer mc_timer;
-  mc_timer.start();
+void pc_game_save_start() {
+  pending_save.timer.start();
   pc_update_card();
-  auto path = mc_get_filename(g_game_version, 0);
-  file_util::create_dir_if_needed_for_file(path.string());
 
   // cd_reprobe_save //
   if (!file_is_present(op.param2)) {
@@ -250,64 +288,61 @@ void pc_game_save_synch() {
 
   // file*2 + p4 is the bank (2 banks per file, p4 is 0 or 1 to select the bank)
   // 4 is the first bank file
-  mc_print("open {} for saving", mc_get_filename_no_dir(g_game_version, op.param2 * 2 + 4 + p4));
-  auto save_path = mc_get_filename(g_game_version, op.param2 * 2 + 4 + p4);
-  file_util::create_dir_if_needed_for_file(save_path.string());
-  auto fd = file_util::open_file(save_path.string().c_str(), "wb");
-  mc_print("synchronous save file open took {:.2f}ms\n", mc_timer.getMs());
-  if (fd) {
-    // cb_openedsave //
-    mc_print("save file opened, writing header...");
-    memset(&header, 0, sizeof(McHeader));
-    header.save_count = p2;
-    header.checksum = mc_checksum(op.data_ptr, BANK_SIZE[g_game_version]);
-    header.magic = MEM_CARD_MAGIC;
-    header.save_count2 = p2;
-    memcpy(header.preview_data, op.data_ptr2.c(), 64);
-    if (fwrite(&header, sizeof(McHeader), 1, fd) == 1) {
-      // cb_savedheader //
-      mc_print("save file writing main data");
-      if (fwrite(op.data_ptr.c(), BANK_SIZE[g_game_version], 1, fd) == 1) {
-        // cb_saveddata //
-        mc_print("save file writing footer");
-        if (fwrite(&header, sizeof(McHeader), 1, fd) == 1) {
-          // cb_savedfooter //
-          if (fclose(fd) == 0) {
-            // cb_closedsave //
-            mc_print("All done with saving!!");
-            op.operation = MemoryCardOperationKind::NO_OP;
-            op.result = McStatusCode::OK;
-            mc_files[op.param2].present = 1;
-            mc_files[op.param2].most_recent_save_count = p2;
-            mc_files[op.param2].last_saved_bank = p4;
-            memcpy(mc_files[op.param2].data, op.data_ptr2.c(), 64);
-            mc_last_file = op.param2;
-          } else {
-            op.operation = MemoryCardOperationKind::NO_OP;
-            op.result = McStatusCode::INTERNAL_ERROR;
-          }
-        } else {
-          fclose(fd);
-          op.operation = MemoryCardOperationKind::NO_OP;
-          op.result = McStatusCode::INTERNAL_ERROR;
-        }
-      } else {
-        fclose(fd);
-        op.operation = MemoryCardOperationKind::NO_OP;
-        op.result = McStatusCode::INTERNAL_ERROR;
-      }
-    } else {
-      fclose(fd);
-      op.operation = MemoryCardOperationKind::NO_OP;
-      op.result = McStatusCode::INTERNAL_ERROR;
-    }
+  mc_print("queue {} for saving", mc_get_filename_no_dir(g_game_version, op.param2 * 2 + 4 + p4));
+  memset(&header, 0, sizeof(McHeader));
+  header.save_count = p2;
+  header.checksum = mc_checksum(op.data_ptr, BANK_SIZE[g_game_version]);
+  header.magic = MEM_CARD_MAGIC;
+  header.save_count2 = p2;
+  memcpy(header.preview_data, op.data_ptr2.c(), 64);
+
+  SaveFileJobPayload job;
+  job.path = mc_get_filename(g_game_version, op.param2 * 2 + 4 + p4).string();
+  job.data.resize(mc_get_total_bank_size(g_game_version));
+  u8* dst = job.data.data();
+  memcpy(dst, &header, sizeof(McHeader));
+  memcpy(dst + sizeof(McHeader), op.data_ptr.c(), BANK_SIZE[g_game_version]);
+  memcpy(dst + sizeof(McHeader) + BANK_SIZE[g_game_version], &header, sizeof(McHeader));
+  job.callback = [](bool ok) {
+    pending_save.ok = ok;
+    pending_save.done = true;
+  };
+
+  pending_save.file = op.param2;
+  pending_save.save_count = p2;
+  pending_save.bank = p4;
+  memcpy(pending_save.preview_data, header.preview_data, 64);
+  pending_save.done = false;
+  pending_save.in_progress = true;
+  g_background_worker.enqueue_save_file(std::move(job));
+  mc_print("save queued after {:.2f}ms\n", pending_save.timer.getMs());
+}
+
+/*!
+ * PC port function to check on the save started by pc_game_save_start. While the file is being
+ * written, the operation stays SAVE and BUSY. After that, this sets the result the same way the
+ * original synchronous save did.
+ */
+void pc_game_save_poll() {
+  if (!pending_save.done) {
+    return;
+  }
+  pending_save.in_progress = false;
+  if (pending_save.ok) {
+    // cb_closedsave //
+    mc_print("All done with saving!!");
+    op.operation = MemoryCardOperationKind::NO_OP;
+    op.result = McStatusCode::OK;
+    mc_files[pending_save.file].present = 1;
+    mc_files[pending_save.file].most_recent_save_count = pending_save.save_count;
+    mc_files[pending_save.file].last_saved_bank = pending_save.bank;
+    memcpy(mc_files[pending_save.file].data, pending_save.preview_data, 64);
+    mc_last_file = pending_save.file;
   } else {
-    fmt::print("[MC] Error opening file, errno - {}", errno);
     op.operation = MemoryCardOperationKind::NO_OP;
     op.result = McStatusCode::INTERNAL_ERROR;
   }
-
-  mc_print("[MC] synchronous save took {:.2f}ms\n", mc_timer.getMs());
+  mc_print("save took {:.2f}ms\n", pending_save.timer.getMs());
 }
 
 void pc_game_load_open_file(FILE* fd) {
@@ -490,6 +525,12 @@ void MC_run() {
     }
   }
 
+  // a save file is being written in the background, wait for it to finish.
+  if (pending_save.in_progress) {
+    pc_game_save_poll();
+    return;
+  }
+
   // if we got here, there is no in-progress sony function. So start the next one, if we should
   if (op.operation == MemoryCardOperationKind::FORMAT) {
     // format memory card. Not used in PC port, so lets move on.
@@ -504,7 +545,7 @@ void MC_run() {
   } else if (op.operation == MemoryCardOperationKind::SAVE) {
     // write game save.
     // there's no cards, keep in mind.
-    pc_game_save_synch();
+    pc_game_save_start();
     // allow some number of errors.
     op.retry_count--;
     if (op.retry_count == 0) {
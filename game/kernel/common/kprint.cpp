@@ -1,9 +1,12 @@
 #include "kprint.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstdarg>
 #include <cstdio>
 #include <cstring>
+#include <deque>
+#include <string>
 
 #include "common/cross_os_debug/xdbg.h"
 #include "common/listener_common.h"
@@ -39,6 +42,48 @@ char ConvertTable[16];
 // buffer for sending an "acknowledge" message to the compiler
 char AckBufArea[40];
 
+// compiled format strings, by the address of the format string.
+bool gFormatCacheEnabled = true;
+
+struct FormatCacheSlot {
+  const char* format = nullptr;
+  FormatProgram program;
+  u64 last_use = 0;  // to pick which slot to replace when all the probes are taken
+  u32 users = 0;     // formats running the program, it can't be replaced until they're done
+};
+
+namespace {
+// open addressing, by the address of the format string. Slots never move and aren't replaced while
+// format runs them, so a program stays valid even if a print method it calls adds more format
+// strings.
+std::vector<FormatCacheSlot> g_format_cache;
+u64 g_format_cache_clock = 0;
+constexpr u32 FORMAT_CACHE_BITS = 14;
+constexpr u32 FORMAT_CACHE_SIZE = 1 << FORMAT_CACHE_BITS;
+constexpr u32 FORMAT_CACHE_MAX_PROBES = 16;
+
+// programs for format strings that aren't in the cache, one for each level of nested format calls.
+// They keep their memory, so compiling into them doesn't allocate once they have grown.
+thread_local std::deque<FormatProgram> t_format_scratch;
+thread_local u32 t_format_depth = 0;
+
+// integer parts below this are printed by cvt_float with integer division, which gives the same
+// digits as its float division. Above 10485761, the float division starts getting digits wrong.
+constexpr float CVT_FLOAT_MAX_EXACT_INTEGER = 10000000.f;
+
+/*!
+ * Same result as std::modf, but without a library call for the positive values that cvt_float
+ * almost always gets. The fraction is exact either way.
+ */
+float split_float(float x, float* integer_part) {
+  if (x > 0.f && x < 8388608.f) {
+    *integer_part = (float)(s32)x;
+    return x - *integer_part;
+  }
+  return std::modf(x, integer_part);
+}
+}  // namespace
+
 /*!
  * Initialize global variables for kprint
  */
@@ -51,6 +96,7 @@ void kprint_init_globals_common() {
   PrintBufArea.offset = 0;
   memcpy(ConvertTable, "0123456789abcdef", 16);
   memset(AckBufArea, 0, sizeof(AckBufArea));
+  format_cache_clear();
 }
 
 /*!
@@ -337,11 +383,23 @@ s32 cvt_float(float x, s32 precision, s32* lead_char, char* buff_start, char* bu
 
   // find fraction and integer parts of absolute value.
   float integer_part;
-  float fraction_part = std::modf(abs_x, &integer_part);
+  float fraction_part = split_float(abs_x, &integer_part);
 
   char* start_ptr = buff_start + 1;  // the null terminator is at buff_start[0].
   char* end_ptr = buff_end - 1;      // the last char we can write to.
 
+  // added: small integer parts get the same digits from integer division, which is much faster.
+  if (integer_part < CVT_FLOAT_MAX_EXACT_INTEGER) {
+    u32 integer = (u32)integer_part;
+    while (start_ptr <= end_ptr && integer) {
+      *end_ptr = '0' + integer % 10;
+      end_ptr--;
+      integer /= 10;
+      forward_count++;
+    }
+    integer_part = 0.f;
+  }
+
   // loop over integer digits (increasing significance)
   while (start_ptr <= end_ptr && (integer_part != 0.0f)) {
     // the fractional part will be the lowest place integer divided by 10
@@ -399,7 +457,7 @@ s32 cvt_float(float x, s32 precision, s32* lead_char, char* buff_start, char* bu
       // same loop as before, but only over the number of digits we actually want to print.
       do {
         float next_int;
-        fraction_part = std::modf(fraction_part * 10.f, &next_int);
+        fraction_part = split_float(fraction_part * 10.f, &next_int);
         u32 ru32 = *(u32*)&next_int;
         s32 value;
         if (((ru32 >> 0x17) & 0xff) < 0x9e) {
@@ -524,12 +582,35 @@ char* kitoa(char* buffer, s64 value, u64 base, s32 length, char pad, u32 flag) {
     value_to_print = -value;
   }
 
-  // write number in reverse
+  // write number in reverse. The common bases are split out so they divide by a constant.
   int count = 0;
-  do {
-    buffer[count++] = ConvertTable[(u64)value_to_print % (u64)base];
-    value_to_print = (u64)value_to_print / (u64)base;
-  } while (value_to_print);
+  u64 digits = value_to_print;
+  switch (base) {
+    case 10:
+      do {
+        buffer[count++] = ConvertTable[digits % 10];
+        digits /= 10;
+      } while (digits);
+      break;
+    case 16:
+      do {
+        buffer[count++] = ConvertTable[digits & 0xf];
+        digits >>= 4;
+      } while (digits);
+      break;
+    case 2:
+      do {
+        buffer[count++] = ConvertTable[digits & 1];
+        digits >>= 1;
+      } while (digits);
+      break;
+    default:
+      do {
+        buffer[count++] = ConvertTable[digits % base];
+        digits /= base;
+      } while (digits);
+      break;
+  }
 
   // append negative if we need to
   if (negativeValue < 0) {
@@ -559,9 +640,10 @@ char* kitoa(char* buffer, s64 value, u64 base, s32 length, char pad, u32 flag) {
     }
   }
 
-  // null terminate, reverse, return!
+  // null terminate, reverse, return! A null pad character ends the string early, and then only
+  // the part before it is reversed.
   buffer[count] = 0;
-  reverse(buffer);
+  std::reverse(buffer, pad ? buffer + count : buffer + strlen(buffer));
   return buffer;
 }
 
@@ -574,3 +656,338 @@ char* kitoa(char* buffer, s64 value, u64 base, s32 length, char pad, u32 flag) {
 void kqtoa() {
   ASSERT(false);
 }
+
+namespace {
+/*!
+ * Is this a ~ code that format knows? Jak 1 doesn't have ~O, but treats it the same way as any
+ * other unknown code, so it's fine to include it here.
+ */
+bool is_format_code(char code) {
+  switch (code) {
+    case '%':
+    case '~':
+    case 'H':
+    case 'J':
+    case 'K':
+    case 'L':
+    case 'N':
+    case 'V':
+    case 'W':
+    case 'Y':
+    case 'Z':
+    case 'h':
+    case 'j':
+    case 'k':
+    case 'l':
+    case 'n':
+    case 'v':
+    case 'w':
+    case 'y':
+    case 'z':
+    case 'O':
+    case 'o':
+    case 'G':
+    case 'g':
+    case 'A':
+    case 'a':
+    case 'S':
+    case 's':
+    case 'C':
+    case 'c':
+    case 'P':
+    case 'p':
+    case 'I':
+    case 'i':
+    case 'Q':
+    case 'q':
+    case 'X':
+    case 'x':
+    case 'D':
+    case 'd':
+    case 'B':
+    case 'b':
+    case 'F':
+    case 'f':
+    case 'R':
+    case 'r':
+    case 'M':
+    case 'm':
+    case 'E':
+    case 'e':
+    case 'T':
+    case 't':
+      return true;
+    default:
+      return false;
+  }
+}
+
+struct FormatBuilder {
+  std::vector<FormatOp> ops;
+  std::string text;
+
+  void clear() {
+    ops.clear();
+    text.clear();
+  }
+
+  void add_text(const char* str, size_t len) {
+    if (!ops.empty()) {
+      auto& last = ops.back();
+      if (last.kind == FormatOp::Kind::TEXT && last.text_start + last.text_len == text.size()) {
+        last.text_len += len;
+        text.append(str, len);
+        return;
+      }
+    }
+    auto& op = ops.emplace_back();
+    op.kind = FormatOp::Kind::TEXT;
+    op.text_start = text.size();
+    op.text_len = len;
+    text.append(str, len);
+  }
+};
+}  // namespace
+
+/*!
+ * Parse a format string into a FormatProgram. The argument parsing is the same as the original
+ * format function. Anything that just outputs text (plain characters, ~~, ~T and the pass-through
+ * codes) becomes text, so only directives that take an argument are left to run.
+ *
+ * The original read past the end of the format string, or past the end of the argument data, on
+ * some malformed strings. These stop at the end of the string instead.
+ */
+void compile_format(const char* format, FormatProgram* out) {
+  // reused, so it doesn't allocate once it has grown.
+  thread_local FormatBuilder builder;
+  builder.clear();
+  format_struct argument_data[8];
+  for (auto& x : argument_data) {
+    x.reset();
+  }
+  // only the arguments the last directive wrote have to be reset for the next one.
+  u32 used_args = 0;
+  const char* format_ptr = format;
+  while (*format_ptr) {
+    if (*format_ptr != '~') {
+      const char* text_end = strchr(format_ptr, '~');
+      if (!text_end) {
+        text_end = format_ptr + strlen(format_ptr);
+      }
+      builder.add_text(format_ptr, text_end - format_ptr);
+      format_ptr = text_end;
+      continue;
+    }
+
+    const char* arg_start = format_ptr;
+    u32 arg_idx = 0;
+    for (u32 i = 0; i < used_args; i++) {
+      argument_data[i].reset();
+    }
+
+    // read arguments, should exit with format_ptr[1] == the command character
+    while ((u8)(format_ptr[1] - '0') < 10 || format_ptr[1] == ',' || format_ptr[1] == '\'' ||
+           format_ptr[1] == '`' ||
+           (argument_data[arg_idx].data[0] == -1 &&
+            (format_ptr[1] == '-' || format_ptr[1] == '+'))) {
+      char arg_char = format_ptr[1];
+      auto& arg = argument_data[arg_idx];
+
+      if (arg_char == ',') {
+        // advance to next argument
+        arg_idx = std::min(arg_idx + 1, 7u);
+        format_ptr++;
+        continue;
+      }
+
+      // character argument
+      if (arg_char == '\'') {
+        arg.data[0] = format_ptr[2];
+        format_ptr += format_ptr[2] ? 2 : 1;
+        continue;
+      }
+
+      // string argument
+      if (arg_char == '`') {
+        u32 i = 0;
+        format_ptr += 2;
+        while (*format_ptr && *format_ptr != '`') {
+          if (i < sizeof(arg.data) - 1) {
+            arg.data[i++] = *format_ptr;
+          }
+          format_ptr++;
+        }
+        arg.data[i] = 0;
+        if (!*format_ptr) {
+          format_ptr--;
+        }
+        continue;
+      }
+
+      if (arg_char == '-') {
+        // negative flag
+        arg.data[1] = 1;
+        format_ptr++;
+        continue;
+      }
+
+      if (arg_char == '+') {
+        // positive flag does nothing
+        format_ptr++;
+        continue;
+      }
+
+      // otherwise it's a number
+      if (arg.data[0] == -1) {
+        arg.data[0] = 0;
+      }
+      arg.data[0] = arg.data[0] * 10 + arg_char - '0';
+      format_ptr++;
+    }
+
+    used_args = arg_idx + 1;
+    char code = format_ptr[1];
+    if (!is_format_code(code)) {
+      // jak 2 and 3 print an error, then output the character before the code and continue from
+      // the code as if it was normal text. (jak 1 asserts)
+      auto& op = builder.ops.emplace_back();
+      op.kind = FormatOp::Kind::BAD_CODE;
+      op.code = code;
+      builder.add_text(format_ptr, 1);
+      format_ptr++;
+      continue;
+    }
+
+    switch (code) {
+      case '%': {
+        auto& op = builder.ops.emplace_back();
+        op.kind = FormatOp::Kind::NEWLINE;
+        op.indent = format_ptr[2] != 0;
+      } break;
+      case '~':
+        builder.add_text(format_ptr + 1, 1);
+        break;
+      case 'H':
+      case 'J':
+      case 'K':
+      case 'L':
+      case 'N':
+      case 'V':
+      case 'W':
+      case 'Y':
+      case 'Z':
+      case 'h':
+      case 'j':
+      case 'k':
+      case 'l':
+      case 'n':
+      case 'v':
+      case 'w':
+      case 'y':
+      case 'z':
+        // pass through, with the arguments
+        builder.add_text(arg_start, format_ptr + 2 - arg_start);
+        break;
+      case 'T':
+      case 't':
+        builder.add_text("\t", 1);
+        break;
+      default: {
+        auto& op = builder.ops.emplace_back();
+        op.kind = FormatOp::Kind::DIRECTIVE;
+        op.code = code;
+        op.arg0 = argument_data[0].data[0];
+        op.arg1 = argument_data[1].data[0];
+        op.arg2 = argument_data[2].data[0];
+        op.arg0_1 = argument_data[0].data[1];
+        op.arg0_2 = argument_data[0].data[2];
+        if (code == 'P' || code == 'p' || code == 'I' || code == 'i') {
+          // the name of the type to print as.
+          const char* name = argument_data[0].data;
+          op.text_start = builder.text.size();
+          op.text_len = strnlen(name, sizeof(argument_data[0].data));
+          builder.text.append(name, op.text_len);
+          builder.text.push_back(0);
+        }
+      } break;
+    }
+    format_ptr += 2;
+  }
+
+  size_t ops_size = builder.ops.size() * sizeof(FormatOp);
+  size_t source_size = strlen(format) + 1;
+  out->num_ops = builder.ops.size();
+  out->text_offset = ops_size + source_size;
+  out->data.resize(out->text_offset + builder.text.size());
+  memcpy(out->data.data(), builder.ops.data(), ops_size);
+  memcpy(out->data.data() + ops_size, format, source_size);
+  memcpy(out->data.data() + out->text_offset, builder.text.data(), builder.text.size());
+}
+
+/*!
+ * Get the compiled version of a format string. Format strings are almost always constants in
+ * object files, so they are cached by address, and checked against the string in case the
+ * address was reused after an unload. When all the slots the string can go in are taken, the
+ * least recently used one that isn't running is replaced. If the cache is disabled, or every slot
+ * is running, the string is compiled into a reused scratch program.
+ */
+FormatProgramRef::FormatProgramRef(const char* format) {
+  u32 depth = t_format_depth++;
+  if (gFormatCacheEnabled) {
+    if (g_format_cache.empty()) {
+      g_format_cache.resize(FORMAT_CACHE_SIZE);
+    }
+    u32 hash = ((uintptr_t)format * 0x9e3779b97f4a7c15ull) >> (64 - FORMAT_CACHE_BITS);
+    FormatCacheSlot* victim = nullptr;
+    for (u32 i = 0; i < FORMAT_CACHE_MAX_PROBES; i++) {
+      auto& slot = g_format_cache[(hash + i) & (FORMAT_CACHE_SIZE - 1)];
+      if (slot.format == format) {
+        if (strcmp(slot.program.source(), format)) {
+          // a different string at this address. If the old one is still running, leave it.
+          victim = slot.users ? nullptr : &slot;
+          break;
+        }
+        use_slot(&slot);
+        return;
+      }
+      if (!slot.format) {
+        victim = &slot;
+        break;
+      }
+      if (!slot.users && (!victim || slot.last_use < victim->last_use)) {
+        victim = &slot;
+      }
+    }
+    if (victim) {
+      victim->format = format;
+      compile_format(format, &victim->program);
+      use_slot(victim);
+      return;
+    }
+  }
+
+  if (t_format_scratch.size() <= depth) {
+    t_format_scratch.emplace_back();
+  }
+  compile_format(format, &t_format_scratch[depth]);
+  m_program = &t_format_scratch[depth];
+}
+
+FormatProgramRef::~FormatProgramRef() {
+  if (m_slot) {
+    m_slot->users--;
+  }
+  t_format_depth--;
+}
+
+void FormatProgramRef::use_slot(FormatCacheSlot* slot) {
+  slot->last_use = ++g_format_cache_clock;
+  slot->users++;
+  m_slot = slot;
+  m_program = &slot->program;
+}
+
+void format_cache_clear() {
+  g_format_cache.clear();
+  g_format_cache_clock = 0;
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include "common/common_types.h"
 
 #include "game/kernel/common/Ptr.h"
@@ -29,6 +31,74 @@ struct format_struct {
   }
 };
 
+/*!
+ * One step of a compiled format string. Not in the original game, which parsed the format string
+ * on every call to format.
+ */
+struct FormatOp {
+  enum class Kind : u8 {
+    TEXT,       // copy text[text_start, text_start + text_len) to the output
+    NEWLINE,    // ~%, indented if there is more of the format string after it
+    DIRECTIVE,  // a ~ code, with its arguments already parsed
+    BAD_CODE,   // a ~ code that format doesn't know
+  };
+  Kind kind;
+  char code = 0;
+  bool indent = false;
+  // argument_data[0..2].data[0], and argument_data[0].data[1..2], which are all the directives use.
+  s8 arg0 = -1, arg1 = -1, arg2 = -1;
+  s8 arg0_1 = -1, arg0_2 = -1;
+  u32 text_start = 0;
+  u32 text_len = 0;
+};
+
+/*!
+ * A format string split into text to copy and directives to run, so it only has to be parsed
+ * once. The ops, a copy of the format string and the text the ops copy are kept in one block, so a
+ * cached format string is only a few cache lines. The type name argument of ~P and ~I is stored
+ * null terminated in the text.
+ */
+struct FormatProgram {
+  std::vector<u8> data;
+  u32 num_ops = 0;
+  u32 text_offset = 0;
+
+  const FormatOp* begin() const { return (const FormatOp*)data.data(); }
+  const FormatOp* end() const { return begin() + num_ops; }
+  size_t size() const { return num_ops; }
+  const FormatOp& operator[](size_t i) const { return begin()[i]; }
+  const char* source() const { return (const char*)data.data() + num_ops * sizeof(FormatOp); }
+  const char* text() const { return (const char*)data.data() + text_offset; }
+  const char* type_name(const FormatOp& op) const { return text() + op.text_start; }
+};
+
+void compile_format(const char* format, FormatProgram* out);
+
+struct FormatCacheSlot;
+
+/*!
+ * The compiled version of a format string, which stays valid while this exists, even if format is
+ * called again before it's done.
+ */
+class FormatProgramRef {
+ public:
+  explicit FormatProgramRef(const char* format);
+  ~FormatProgramRef();
+  FormatProgramRef(const FormatProgramRef&) = delete;
+  FormatProgramRef& operator=(const FormatProgramRef&) = delete;
+
+  const FormatProgram& operator*() const { return *m_program; }
+
+ private:
+  void use_slot(FormatCacheSlot* slot);
+
+  const FormatProgram* m_program = nullptr;
+  FormatCacheSlot* m_slot = nullptr;
+};
+
+void format_cache_clear();
+extern bool gFormatCacheEnabled;
+
 void kprint_init_globals_common();
 
 /*!
@@ -114,6 +114,7 @@ void KernelCheckAndDispatch() {
     if (new_message.offset) {
       ProcessListenerMessage(new_message);
     }
+    ProcessListenerBatch();
 
     // remember the old listener function
     auto old_listener = ListenerFunction->value;
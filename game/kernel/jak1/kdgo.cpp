@@ -2,6 +2,7 @@
 
 #include "common/common_types.h"
 #include "common/log/log.h"
+#include "common/util/Timer.h"
 
 #include "game/common/dgo_rpc_types.h"
 #include "game/kernel/common/Ptr.h"
@@ -136,6 +137,7 @@ void load_and_link_dgo_from_c(const char* name,
                               u32 linkFlag,
                               s32 bufferSize,
                               bool jump_from_c_to_goal) {
+  Timer timer;
   lg::debug("[Load and Link DGO From C] {}", name);
   u32 oldShowStall = sShowStallMsg;
 
@@ -164,6 +166,8 @@ void load_and_link_dgo_from_c(const char* name,
       fileName, buffer1, buffer2,
       Ptr<u8>((heap->current + 0x3f).offset & 0xffffffc0));  // 64-byte aligned for IOP DMA
 
+  // time spent in the linker, not waiting for the IOP
+  double link_seconds = 0;
   u32 lastObjectLoaded = 0;
   while (!lastObjectLoaded) {
     // check to see if next object is loaded (I believe it always is?)
@@ -188,13 +192,17 @@ void load_and_link_dgo_from_c(const char* name,
     lg::debug("[link and exec] {:18s} {} {:6d} heap-use {:8d} {:8d}: 0x{:x}", objName,
               lastObjectLoaded, objSize, kheapused(kglobalheap),
               kdebugheap.offset ? kheapused(kdebugheap) : 0, kglobalheap->current.offset);
+    Timer link_timer;
     link_and_exec(obj, objName, objSize, heap, linkFlag, jump_from_c_to_goal);  // link now!
+    link_seconds += link_timer.getSeconds();
 
     // inform IOP we are done
     if (!lastObjectLoaded) {
       ContinueLoadingDGO(Ptr<u8>((heap->current + 0x3f).offset & 0xffffffc0));
     }
   }
+  lg::info("load_and_link_dgo_from_c took {:.3f} s ({:.3f} s linking)\n", timer.getSeconds(),
+           link_seconds);
   sShowStallMsg = oldShowStall;
 }
 }  // namespace jak1
\ No newline at end of file
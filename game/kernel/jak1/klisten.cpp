@@ -101,4 +101,37 @@ void ProcessListenerMessage(Ptr<char> msg) {
   SendAck();
 }
 
+/*!
+ * Link and run the objects from batch loads, in order, and ack the messages they came in once
+ * they have run. Not in the original game.
+ */
+void ProcessListenerBatch() {
+  ListenerBatchItem item;
+  while (PopListenerBatchItem(&item)) {
+    ListenerStatus = 1;
+    if (item.data.empty()) {
+      // flush the load messages first, so the compiler knows about everything that was acked.
+      ClearPending();
+      SendBatchAck(item.ack_id);
+      continue;
+    }
+
+    // the linker copies each segment of a v3 object into its own allocation, so the object is
+    // only needed while linking. Put it at the top of the heap and free it once it has run.
+    auto old_top = kdebugheap->top;
+    auto buffer = kmalloc(kdebugheap, item.data.size(), KMALLOC_TOP, "listener-link-block");
+    if (!buffer.offset) {
+      MsgErr("dkernel: no memory to load %s of %d bytes\n", item.name.c_str(),
+             (int)item.data.size());
+      continue;
+    }
+    memcpy(buffer.c(), item.data.data(), item.data.size());
+    // unlike a single load, there's no listener function to run after this: the top level runs
+    // right away, so the next object can use what it defines.
+    link_and_exec(buffer, item.name.c_str(), 0, kdebugheap,
+                  LINK_FLAG_FORCE_DEBUG | LINK_FLAG_OUTPUT_LOAD | LINK_FLAG_EXECUTE, true);
+    kdebugheap->top = old_top;
+  }
+}
+
 }  // namespace jak1
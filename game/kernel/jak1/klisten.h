@@ -11,4 +11,5 @@ void klisten_init_globals();
 
 void InitListener();
 void ProcessListenerMessage(Ptr<char> msg);
+void ProcessListenerBatch();
 }  // namespace jak1
\ No newline at end of file
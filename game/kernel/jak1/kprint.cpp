@@ -38,9 +38,6 @@ s32 format_impl_jak1(uint64_t* args) {
   // first two args are dest, format string
   uint64_t* arg_regs = args + 2;
 
-  // data for arguments in a format command
-  format_struct argument_data[8];
-
   u32 arg_reg_idx = 0;
 
   // the gstring
@@ -74,9 +71,6 @@ s32 format_impl_jak1(uint64_t* args) {
     indentation = (*print_column) >> 3;
   }
 
-  // which arg we're on
-  u32 arg_idx = 0;
-
   // if last char was newline and we have tabs, do tabs
   if (indentation && output_ptr[-1] == '\n') {
     for (u32 i = 0; i < indentation; i++) {
@@ -85,137 +79,17 @@ s32 format_impl_jak1(uint64_t* args) {
     }
   }
 
-  // input pointer
-  char* format_ptr = format_cstring;
+  // the format string, parsed into text and directives. (added, the original parsed the format
+  // string here on every call)
+  FormatProgramRef program_ref(format_cstring);
+  const auto& program = *program_ref;
+  u8 justify = 0;
 
-  // loop over the format string
-  while (*format_ptr) {
+  for (const auto& op : program) {
     // got a command?
-    if (*format_ptr == '~') {
-      char* arg_start = format_ptr;
-      // get some arguments
-      arg_idx = 0;
-      u8 justify = 0;
-      for (auto& x : argument_data) {
-        x.reset();
-      }
-
-      // read arguments
-      while ((u8)(format_ptr[1] - '0') < 10 ||  // number 0 to 10
-             format_ptr[1] == ',' ||            // comma
-             format_ptr[1] == '\'' ||           // quote
-             format_ptr[1] == '`' ||            // backtick
-             (argument_data[arg_idx].data[0] == -1 &&
-              (format_ptr[1] == '-' || format_ptr[1] == '+')  // flags1 == -1 && +/-
-              )) {
-        // here format_ptr[1] points to next unread character in argument
-        // format_ptr[0] is originally the ~
-        // should exit loop with format_ptr[1] == the command character
-        char arg_char = format_ptr[1];  // gVar1
-
-        if (arg_char == ',') {
-          // advance to next argument
-          arg_idx++;     // increment which argument we're on
-          format_ptr++;  // increment past comma, and try again
-          continue;
-        }
-
-        // character argument
-        if (arg_char == '\'') {  // 0x27
-          argument_data[arg_idx].data[0] = format_ptr[2];
-          format_ptr += 2;
-          continue;
-        }
-
-        // string argument
-        if (arg_char == '`') {  // 0x60
-          u32 i = 0;
-          format_ptr += 2;
-          // read string
-          while (*format_ptr != '`') {
-            argument_data[arg_idx].data[i] = *format_ptr;
-            i++;
-            format_ptr++;
-          }
-          // null terminate
-          argument_data[arg_idx].data[i] = 0;
-          continue;
-        }
-
-        if (arg_char == '-') {  // 0x2d
-          // negative flag
-          argument_data[arg_idx].data[1] = 1;
-          format_ptr++;
-          continue;
-        }
-
-        if (arg_char == '+') {  // 0x2b
-          // positive flag does nothing
-          format_ptr++;
-          continue;
-        }
-
-        // otherwise:
-
-        // null terminate if we got no args
-        if (argument_data[arg_idx].data[0] == -1) {
-          argument_data[arg_idx].data[0] = 0;
-        }
-
-        // otherwise it's a number
-        argument_data[arg_idx].data[0] = argument_data[arg_idx].data[0] * 10 + arg_char - '0';
-        format_ptr++;
-      }  // end argument while
-
+    if (op.kind == FormatOp::Kind::DIRECTIVE) {
       // switch on command
-      switch (format_ptr[1]) {
-          // offset of 0x25
-
-        case '%':  // newline
-          *output_ptr = '\n';
-          output_ptr++;
-          // indent the next line if there is one
-          if (indentation && format_ptr[2]) {
-            for (u32 i = 0; i < indentation; i++) {
-              *output_ptr = ' ';
-              output_ptr++;
-            }
-          }
-          break;
-
-        case '~':  // tilde escape
-          *output_ptr = '~';
-          output_ptr++;
-          break;
-
-          // pass through arguments
-        case 'H':  // 23 -> 48, H
-        case 'J':  // 25 -> 4A, J
-        case 'K':  // 26 -> 4B, K
-        case 'L':  // 27 -> 4C, L
-        case 'N':  // 29 -> 4E, N
-        case 'V':  // 31 -> 56, V
-        case 'W':  // 32 -> 57, W
-        case 'Y':  // 34 -> 59, Y
-        case 'Z':  // 35 -> 5A, Z
-        case 'h':
-        case 'j':
-        case 'k':
-        case 'l':
-        case 'n':
-        case 'v':
-        case 'w':
-        case 'y':
-        case 'z':
-          while (arg_start < format_ptr + 1) {
-            *output_ptr = *arg_start;
-            arg_start++;
-            output_ptr++;
-          }
-          *output_ptr = format_ptr[1];
-          output_ptr++;
-          break;
-
+      switch (op.code) {
         case 'G':  // like %s, prints a C string
         case 'g': {
           *output_ptr = 0;
@@ -227,7 +101,7 @@ s32 format_impl_jak1(uint64_t* args) {
         case 'A':  // print a boxed object
         case 'a':  // pad,padchar (like ) ~8,'0A
         {
-          s8 arg0 = argument_data[0].data[0];
+          s8 arg0 = op.arg0;
           s32 desired_length = arg0;
           *output_ptr = 0;
           u64 in = arg_regs[arg_reg_idx++];
@@ -244,8 +118,8 @@ s32 format_impl_jak1(uint64_t* args) {
               // too short
               if (justify == 0) {
                 char pad = ' ';
-                if (argument_data[1].data[0] != -1) {
-                  pad = argument_data[1].data[0];
+                if (op.arg1 != -1) {
+                  pad = op.arg1;
                 }
                 kstrinsert(output_ptr, pad, desired_length - print_len);
               } else {
@@ -253,8 +127,8 @@ s32 format_impl_jak1(uint64_t* args) {
                 //                output_ptr = strend(output_ptr);
                 //                while(0 < (desired_length - print_len)) {
                 //                  char pad = ' ';
-                //                  if(argument_data[0].data[1] != -1) {
-                //                    pad = argument_data[0].data[1];
+                //                  if(op.arg0_1 != -1) {
+                //                    pad = op.arg0_1;
                 //                  }
                 //                  output_ptr[0] = pad;
                 //                  output_ptr++;
@@ -270,7 +144,7 @@ s32 format_impl_jak1(uint64_t* args) {
 
         case 'S':  // like A, but strings are printed without quotes
         case 's': {
-          s8 arg0 = argument_data[0].data[0];
+          s8 arg0 = op.arg0;
           s32 desired_length = arg0;
           *output_ptr = 0;
           u64 in = arg_regs[arg_reg_idx++];
@@ -294,8 +168,8 @@ s32 format_impl_jak1(uint64_t* args) {
               // too short
               if (justify == 0) {
                 char pad = ' ';
-                if (argument_data[1].data[0] != -1) {
-                  pad = argument_data[1].data[0];
+                if (op.arg1 != -1) {
+                  pad = op.arg1;
                 }
                 kstrinsert(output_ptr, pad, desired_length - print_len);
 
@@ -307,8 +181,8 @@ s32 format_impl_jak1(uint64_t* args) {
                 //                  char* l108 = output_ptr;
                 //
                 //                  char pad = ' ';
-                //                  if(argument_data[0].data[1] != -1) {
-                //                    pad = argument_data[0].data[1];
+                //                  if(op.arg0_1 != -1) {
+                //                    pad = op.arg0_1;
                 //                  }
                 //                  output_ptr[0] = pad;
                 //                  output_ptr++;
@@ -329,12 +203,12 @@ s32 format_impl_jak1(uint64_t* args) {
         case 'P':  // like ~A, but can specify type explicitly
         case 'p': {
           *output_ptr = 0;
-          s8 arg0 = argument_data[0].data[0];
+          s8 arg0 = op.arg0;
           u64 in = arg_regs[arg_reg_idx++];
           if (arg0 == -1) {
             print_object(in);
           } else {
-            auto sym = find_symbol_from_c(argument_data[0].data);
+            auto sym = find_symbol_from_c(program.type_name(op));
             if (sym.offset) {
               Ptr<Type> type = *sym.cast<Ptr<Type>>();
               if (type.offset) {
@@ -350,12 +224,12 @@ s32 format_impl_jak1(uint64_t* args) {
         case 'I':  // like ~P, but calls inpsect
         case 'i': {
           *output_ptr = 0;
-          s8 arg0 = argument_data[0].data[0];
+          s8 arg0 = op.arg0;
           u64 in = arg_regs[arg_reg_idx++];
           if (arg0 == -1) {
             inspect_object(in);
           } else {
-            auto sym = find_symbol_from_c(argument_data[0].data);
+            auto sym = find_symbol_from_c(program.type_name(op));
             if (sym.offset) {
               Ptr<Type> type = *sym.cast<Ptr<Type>>();
               if (type.offset) {
@@ -376,33 +250,33 @@ s32 format_impl_jak1(uint64_t* args) {
         case 'X':  // hex, 64 bit, pad padchar
         case 'x': {
           char pad = '0';
-          if (argument_data[1].data[0] != -1) {
-            pad = argument_data[1].data[0];
+          if (op.arg1 != -1) {
+            pad = op.arg1;
           }
           u64 in = arg_regs[arg_reg_idx++];
-          kitoa(output_ptr, in, 16, argument_data[0].data[0], pad, 0);
+          kitoa(output_ptr, in, 16, op.arg0, pad, 0);
           output_ptr = strend(output_ptr);
         } break;
 
         case 'D':  // integer 64, pad padchar
         case 'd': {
           char pad = ' ';
-          if (argument_data[1].data[0] != -1) {
-            pad = argument_data[1].data[0];
+          if (op.arg1 != -1) {
+            pad = op.arg1;
           }
           u64 in = arg_regs[arg_reg_idx++];
-          kitoa(output_ptr, in, 10, argument_data[0].data[0], pad, 0);
+          kitoa(output_ptr, in, 10, op.arg0, pad, 0);
           output_ptr = strend(output_ptr);
         } break;
 
         case 'B':  // integer 64, pad padchar
         case 'b': {
           char pad = '0';
-          if (argument_data[1].data[0] != -1) {
-            pad = argument_data[1].data[0];
+          if (op.arg1 != -1) {
+            pad = op.arg1;
           }
           u64 in = arg_regs[arg_reg_idx++];
-          kitoa(output_ptr, in, 2, argument_data[0].data[0], pad, 0);
+          kitoa(output_ptr, in, 2, op.arg0, pad, 0);
           output_ptr = strend(output_ptr);
         } break;
 
@@ -416,11 +290,11 @@ s32 format_impl_jak1(uint64_t* args) {
         case 'f':  // float with args
         {
           float in = *(float*)&arg_regs[arg_reg_idx++];
-          s8 pad_length = argument_data[0].data[0];
-          s8 pad_char = argument_data[1].data[0];
+          s8 pad_length = op.arg0;
+          s8 pad_char = op.arg1;
           if (pad_char == -1)
             pad_char = ' ';
-          s8 precision = argument_data[2].data[0];
+          s8 precision = op.arg2;
           if (precision == -1)
             precision = 4;
           ftoa(output_ptr, in, pad_length, pad_char, precision, 0);
@@ -430,11 +304,11 @@ s32 format_impl_jak1(uint64_t* args) {
         case 'R':  // rotation degrees
         case 'r': {
           float in = *(float*)&arg_regs[arg_reg_idx++];
-          s8 pad_length = argument_data[0].data[0];
-          s8 pad_char = argument_data[1].data[0];
+          s8 pad_length = op.arg0;
+          s8 pad_char = op.arg1;
           if (pad_char == -1)
             pad_char = ' ';
-          s8 precision = argument_data[2].data[0];
+          s8 precision = op.arg2;
           if (precision == -1)
             precision = 4;
           ftoa(output_ptr, in * 360.f / 65536.f, pad_length, pad_char, precision, 0);
@@ -444,11 +318,11 @@ s32 format_impl_jak1(uint64_t* args) {
         case 'M':  // distance meters
         case 'm': {
           float in = *(float*)&arg_regs[arg_reg_idx++];
-          s8 pad_length = argument_data[0].data[0];
-          s8 pad_char = argument_data[1].data[0];
+          s8 pad_length = op.arg0;
+          s8 pad_char = op.arg1;
           if (pad_char == -1)
             pad_char = ' ';
-          s8 precision = argument_data[2].data[0];
+          s8 precision = op.arg2;
           if (precision == -1)
             precision = 4;
           ftoa(output_ptr, in / 4096.f, pad_length, pad_char, precision, 0);
@@ -458,11 +332,11 @@ s32 format_impl_jak1(uint64_t* args) {
         case 'E':  // time seconds
         case 'e': {
           s64 in = arg_regs[arg_reg_idx++];
-          s8 pad_length = argument_data[0].data[0];
-          s8 pad_char = argument_data[0].data[1];
+          s8 pad_length = op.arg0;
+          s8 pad_char = op.arg0_1;
           if (pad_char == -1)
             pad_char = ' ';
-          s8 precision = argument_data[0].data[2];
+          s8 precision = op.arg0_2;
           if (precision == -1)
             precision = 4;
           float value;
@@ -475,25 +349,30 @@ s32 format_impl_jak1(uint64_t* args) {
           output_ptr = strend(output_ptr);
         } break;
 
-        case 'T':
-        case 't': {
-          sprintf(output_ptr, "\t");
-          output_ptr = strend(output_ptr);
-        } break;
-
         default:
-          MsgErr("format: unknown code 0x%02x\n", format_ptr[1]);
+          MsgErr("format: unknown code 0x%02x\n", op.code);
           ASSERT(false);
           break;
       }
-      format_ptr++;
-    } else {
-      // got normal char, just copy it
-      *output_ptr = *format_ptr;
+    } else if (op.kind == FormatOp::Kind::TEXT) {
+      // normal characters, ~~, ~T and pass through codes
+      memcpy(output_ptr, program.text() + op.text_start, op.text_len);
+      output_ptr += op.text_len;
+    } else if (op.kind == FormatOp::Kind::NEWLINE) {
+      *output_ptr = '\n';
       output_ptr++;
+      // indent the next line if there is one
+      if (indentation && op.indent) {
+        for (u32 i = 0; i < indentation; i++) {
+          *output_ptr = ' ';
+          output_ptr++;
+        }
+      }
+    } else {
+      MsgErr("format: unknown code 0x%02x\n", op.code);
+      ASSERT(false);
     }
-    format_ptr++;
-  }  // end format string while
+  }  // end format program loop
 
   // end
   *output_ptr = 0;
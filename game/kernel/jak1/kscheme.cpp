@@ -1,6 +1,7 @@
 #include "kscheme.h"
 
 #include <cstring>
+#include <unordered_map>
 
 #include "common/common_types.h"
 #include "common/log/log.h"
@@ -28,9 +29,15 @@ using namespace jak1_symbols;
 namespace jak1 {
 // where to put a new symbol for the most recently searched for symbol that wasn't found
 u32 symbol_slot;
+// host-side index of symbol name to offset from s7. This is only used to speed up lookups, the
+// symbol table in GOAL memory is the same as it would be without it.
+std::unordered_map<std::string, s32> g_symbol_hash_table;
+// find_symbol_from_c only probes the table when this is off. For benchmarking.
+bool g_symbol_hash_table_enabled = true;
 
 void kscheme_init_globals() {
   symbol_slot = 0;
+  g_symbol_hash_table.clear();
 }
 
 /*!
@@ -611,6 +618,7 @@ Ptr<Symbol> set_fixed_symbol(u32 offset, const char* name, u32 value) {
   // set value of the symbol
   sym->value = value;
 
+  g_symbol_hash_table[name] = sym.offset - s7.offset;
   NumSymbols++;
   return sym;
 }
@@ -663,13 +671,9 @@ Ptr<Symbol> find_symbol_in_area(u32 hash, const char* name, u32 start, u32 end)
 }
 
 /*!
- * Searches the table for a symbol.  If the symbol is found, returns it.
- * If not, returns 0, but symbol_slot will contain the slot for the symbol.
- * If both are 0, the symbol table is full and you are sad.
- * Also allows you to find the empty pair by searching for _empty_
+ * Search the symbol table in GOAL memory for a symbol, like the original find_symbol_from_c.
  */
-Ptr<Symbol> find_symbol_from_c(const char* name) {
-  symbol_slot = 0;  // nowhere to put the symbol yet, clear any old symbol_slot result.
+Ptr<Symbol> find_symbol_in_table(const char* name) {
   u32 hash = crc32((const u8*)name, (int)strlen(name));
 
   // check if we've got the empty pair.
@@ -721,6 +725,38 @@ Ptr<Symbol> find_symbol_from_c(const char* name) {
   }
 }
 
+/*!
+ * Searches the table for a symbol.  If the symbol is found, returns it.
+ * If not, returns 0, but symbol_slot will contain the slot for the symbol.
+ * If both are 0, the symbol table is full and you are sad.
+ * Also allows you to find the empty pair by searching for _empty_
+ *
+ * Symbols that are already known are found in the host-side index instead of probing the table.
+ */
+Ptr<Symbol> find_symbol_from_c(const char* name) {
+  symbol_slot = 0;  // nowhere to put the symbol yet, clear any old symbol_slot result.
+  if (!g_symbol_hash_table_enabled) {
+    return find_symbol_in_table(name);
+  }
+
+  const auto& it = g_symbol_hash_table.find(name);
+  if (it != g_symbol_hash_table.end()) {
+    auto sym = Ptr<Symbol>(s7.offset + it->second);
+    // check the symbol is still there, in case the table was changed behind our back.
+    if (info(sym)->str.offset && !strcmp(info(sym)->str->data(), name)) {
+      return sym;
+    }
+    g_symbol_hash_table.erase(it);
+  }
+
+  // not in the index, so we need to probe, which will also find the slot for a new symbol.
+  auto sym = find_symbol_in_table(name);
+  if (sym.offset && sym.offset != (s7 + FIX_SYM_EMPTY_PAIR).offset) {
+    g_symbol_hash_table[name] = sym.offset - s7.offset;
+  }
+  return sym;
+}
+
 /*!
  * Returns a symbol with the given name.  If this is the first time, make a new symbol, otherwise it
  * returns the old one. Basically a LISP symbol intern
@@ -741,6 +777,7 @@ Ptr<Symbol> intern_from_c(const char* name) {
   auto str = make_string_from_c(name);
   info(symbol)->str = Ptr<String>(str);
   info(symbol)->hash = hash;
+  g_symbol_hash_table[name] = symbol.offset - s7.offset;
 
   NumSymbols++;
   return symbol;
@@ -861,6 +898,7 @@ Ptr<Type> set_fixed_type(u32 offset,
   type_symbol.cast<u32>().c()[-1] = *(s7 + FIX_SYM_SYMBOL_TYPE);
   info(type_symbol)->str = Ptr<String>(make_string_from_c(name));
   info(type_symbol)->hash = crc32((const u8*)name, (int)strlen(name));
+  g_symbol_hash_table[name] = type_symbol.offset - s7.offset;
 
   // increment
   NumSymbols++;
@@ -1463,6 +1501,7 @@ s32 InitHeapAndSymbol() {
   // the last symbol we will ever access.
   LastSymbol = symbol_table + SYM_TABLE_END * 8;
   NumSymbols = 0;
+  g_symbol_hash_table.clear();
   // inform compiler the symbol table is reset, and where it is.
   reset_output();
 
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <string>
+#include <unordered_map>
+
 #include "common/goal_constants.h"
 
 #include "game/kernel/common/kmalloc.h"
@@ -7,6 +10,9 @@
 
 namespace jak1 {
 
+extern std::unordered_map<std::string, s32> g_symbol_hash_table;
+extern bool g_symbol_hash_table_enabled;
+
 struct SymInfo {
   u32 hash;
   Ptr<String> str;
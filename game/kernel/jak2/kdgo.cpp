@@ -238,6 +238,8 @@ void load_and_link_dgo_from_c(const char* name,
       fileName, buffer1, buffer2,
       Ptr<u8>((heap->current + 0x3f).offset & 0xffffffc0));  // 64-byte aligned for IOP DMA
 
+  // time spent in the linker, not waiting for the IOP
+  double link_seconds = 0;
   u32 lastObjectLoaded = 0;
   while (!lastObjectLoaded) {
     // check to see if next object is loaded (I believe it always is?)
@@ -264,7 +266,9 @@ void load_and_link_dgo_from_c(const char* name,
               kdebugheap.offset ? kheapused(kdebugheap) : 0, kglobalheap->current.offset);
     {
       auto p = scoped_prof(fmt::format("link-{}", objName).c_str());
+      Timer link_timer;
       link_and_exec(obj, objName, objSize, heap, linkFlag, jump_from_c_to_goal);  // link now!
+      link_seconds += link_timer.getSeconds();
     }
 
     // inform IOP we are done
@@ -272,7 +276,8 @@ void load_and_link_dgo_from_c(const char* name,
       ContinueLoadingDGO(buffer1, buffer2, Ptr<u8>((heap->current + 0x3f).offset & 0xffffffc0));
     }
   }
-  lg::info("load_and_link_dgo_from_c took {:.3f} s\n", timer.getSeconds());
+  lg::info("load_and_link_dgo_from_c took {:.3f} s ({:.3f} s linking)\n", timer.getSeconds(),
+           link_seconds);
   sShowStallMsg = oldShowStall;
 }
 
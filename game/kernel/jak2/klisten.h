@@ -15,6 +15,7 @@ extern Ptr<Symbol4<u32>> kernel_packages;
 
 void klisten_init_globals();
 void ProcessListenerMessage(Ptr<char> msg);
+void ProcessListenerBatch();
 int sql_query_sync(Ptr<String> string_in);
 void InitListener();
 }  // namespace jak2
\ No newline at end of file
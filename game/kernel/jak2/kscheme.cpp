@@ -3,6 +3,7 @@
 
 #include <cstdio>
 #include <cstring>
+#include <unordered_map>
 
 #include "fileio.h"
 
@@ -33,9 +34,15 @@ Ptr<Symbol4<u32>> LevelTypeList;
 Ptr<Symbol4<u32>> CollapseQuote;
 Ptr<Symbol4<u32>> SqlResult;
 Ptr<u32> KernelDebug;
+// host-side index of symbol name to offset from s7. This is only used to speed up lookups, the
+// symbol table in GOAL memory is the same as it would be without it.
+std::unordered_map<std::string, s32> g_symbol_hash_table;
+// find_symbol_from_c only probes the table when this is off. For benchmarking.
+bool g_symbol_hash_table_enabled = true;
 
 void kscheme_init_globals() {
   symbol_slot = 0;
+  g_symbol_hash_table.clear();
   LevelTypeList.offset = 0;
   CollapseQuote.offset = 0;
   SqlResult.offset = 0;
@@ -601,6 +608,7 @@ Ptr<Symbol4<u32>> set_fixed_symbol(u32 offset, const char* name, u32 value) {
   // set hash of the symbol
   *sym_to_hash(sym).c() = crc32((const u8*)name, strlen(name));
 
+  g_symbol_hash_table[name] = sym.offset - s7.offset;
   NumSymbols++;
   return sym;
 }
@@ -653,13 +661,9 @@ Ptr<Symbol4<u32>> find_symbol_in_area(u32 hash, const char* name, u32 start, u32
 }
 
 /*!
- * Searches the table for a symbol.  If the symbol is found, returns it.
- * If not, returns 0, but symbol_slot will contain the slot for the symbol.
- * If both are 0, the symbol table is full and you are sad.
- * Also allows you to find the empty pair by searching for _empty_
+ * Search the symbol table in GOAL memory for a symbol, like the original find_symbol_from_c.
  */
-Ptr<Symbol4<u32>> find_symbol_from_c(const char* name) {
-  symbol_slot = 0;  // nowhere to put the symbol yet, clear any old symbol_slot result.
+Ptr<Symbol4<u32>> find_symbol_in_table(const char* name) {
   u32 hash = crc32((const u8*)name, (int)strlen(name));
 
   // check if we've got the empty pair.
@@ -710,6 +714,39 @@ Ptr<Symbol4<u32>> find_symbol_from_c(const char* name) {
   }
 }
 
+/*!
+ * Searches the table for a symbol.  If the symbol is found, returns it.
+ * If not, returns 0, but symbol_slot will contain the slot for the symbol.
+ * If both are 0, the symbol table is full and you are sad.
+ * Also allows you to find the empty pair by searching for _empty_
+ *
+ * Symbols that are already known are found in the host-side index instead of probing the table.
+ */
+Ptr<Symbol4<u32>> find_symbol_from_c(const char* name) {
+  symbol_slot = 0;  // nowhere to put the symbol yet, clear any old symbol_slot result.
+  if (!g_symbol_hash_table_enabled) {
+    return find_symbol_in_table(name);
+  }
+
+  const auto& it = g_symbol_hash_table.find(name);
+  if (it != g_symbol_hash_table.end()) {
+    Ptr<Symbol4<u32>> sym(s7.offset + it->second);
+    // check the symbol is still there, in case the table was changed behind our back.
+    auto str = sym_to_string(sym);
+    if (str.offset && !strcmp(str->data(), name)) {
+      return sym;
+    }
+    g_symbol_hash_table.erase(it);
+  }
+
+  // not in the index, so we need to probe, which will also find the slot for a new symbol.
+  auto sym = find_symbol_in_table(name);
+  if (sym.offset && sym.offset != s7.offset + S7_OFF_FIX_SYM_EMPTY_PAIR) {
+    g_symbol_hash_table[name] = sym.offset - s7.offset;
+  }
+  return sym;
+}
+
 /*!
  * Returns a symbol with the given name.  If this is the first time, make a new symbol, otherwise it
  * returns the old one. Basically a LISP symbol intern
@@ -728,6 +765,7 @@ Ptr<Symbol4<u32>> intern_from_c(const char* name) {
   auto str = make_string_from_c(name);
   *sym_to_string_ptr(symbol) = Ptr<String>(str);
   *sym_to_hash(symbol) = hash;
+  g_symbol_hash_table[name] = symbol.offset - s7.offset;
 
   NumSymbols++;
   return symbol;
@@ -880,6 +918,7 @@ Ptr<Type> set_fixed_type(u32 offset,
   // set the symbol's name and hash
   *sym_to_string_ptr(type_symbol) = Ptr<String>(make_string_from_c(name));
   *sym_to_hash(type_symbol) = crc32((const u8*)name, strlen(name));
+  g_symbol_hash_table[name] = type_symbol.offset - s7.offset;
   NumSymbols++;
 
   if (symbol_value.offset == 0) {
@@ -1482,6 +1521,7 @@ int InitHeapAndSymbol() {
   SymbolTable2 = symbol_table + 5;
   s7 = symbol_table + 0x8001;
   NumSymbols = 0;
+  g_symbol_hash_table.clear();
 
   // inform compiler of s7
   reset_output();
@@ -1,4 +1,7 @@
 #pragma once
+#include <string>
+#include <unordered_map>
+
 #include "common/common_types.h"
 
 #include "game/kernel/common/Ptr.h"
@@ -11,6 +14,8 @@ namespace jak2 {
 constexpr s32 SYMBOL_OFFSET = 1;
 
 extern Ptr<Symbol4<u32>> SqlResult;
+extern std::unordered_map<std::string, s32> g_symbol_hash_table;
+extern bool g_symbol_hash_table_enabled;
 
 /*!
  * GOAL Type
@@ -101,6 +101,7 @@ void KernelDispatch(u32 dispatcher_func) {
   if (new_message.offset) {
     ProcessListenerMessage(new_message);
   }
+  ProcessListenerBatch();
 
   // remember the old listener
   auto old_listener_function = ListenerFunction->value();
@@ -16,5 +16,6 @@ extern Ptr<Symbol4<u32>> kernel_packages;
 void InitListener();
 void klisten_init_globals();
 void ProcessListenerMessage(Ptr<char> msg);
+void ProcessListenerBatch();
 int sql_query_sync(Ptr<String> string_in);
 }  // namespace jak3
\ No newline at end of file
@@ -19,6 +19,8 @@
 #include "common/versions/versions.h"
 
 #include "game/common/game_common_types.h"
+#include "game/kernel/common/kmalloc_tracker.h"
+#include "game/mips2c/mips2c_table.h"
 #include "graphics/gfx_test.h"
 
 #include "third-party/CLI11.hpp"
@@ -96,11 +98,15 @@ int main(int argc, char** argv) {
   bool disable_avx2 = false;
   bool disable_display = false;
   bool enable_profiling = false;
+  bool stream_profile = false;
   bool enable_portable = false;
   bool disable_save_location_override = false;
   std::string profile_until_event = "";
   std::string gpu_test = "";
   std::string gpu_test_out_path = "";
+  std::string mips2c_capture = "";
+  int mips2c_capture_calls = 100;
+  int kmalloc_snapshot_seconds = 0;
   int port_number = -1;
   fs::path project_path_override;
   fs::path user_config_dir_override;
@@ -115,6 +121,8 @@ int main(int argc, char** argv) {
   app.add_flag("--no-avx2", disable_avx2, "Disable AVX2 for testing");
   app.add_flag("--no-display", disable_display, "Disable video display");
   app.add_flag("--profile", enable_profiling, "Enables profiling immediately from startup");
+  app.add_flag("--profile-stream", stream_profile,
+               "Enables profiling from startup, writing all events to a file as they happen");
   app.add_flag("--portable", enable_portable,
                "Save settings and saves relative to the game's executable, takes precedence over "
                "--config-path");
@@ -127,6 +135,13 @@ int main(int argc, char** argv) {
                  "Tests for minimum graphics requirements.  Valid Options are: [opengl]");
   app.add_option("--gpu-test-out-path", gpu_test_out_path,
                  "Where to store the gpu test result file");
+  app.add_option("--mips2c-capture", mips2c_capture,
+                 "Record calls to this mips2c function, for the mips2c_replay tool");
+  app.add_option("--mips2c-capture-calls", mips2c_capture_calls,
+                 "Number of calls to record with --mips2c-capture, defaults to 100");
+  app.add_option("--kmalloc-track", kmalloc_snapshot_seconds,
+                 "Track kmalloc allocations from startup, writing a snapshot every this many "
+                 "seconds");
   app.add_option("--proj-path", project_path_override,
                  "Specify the location of the 'data/' folder");
   app.add_option("--config-path", user_config_dir_override,
@@ -167,6 +182,7 @@ int main(int argc, char** argv) {
 
   prof().set_enable(enable_profiling);
   prof().set_waiting_for_event(profile_until_event);
+  prof().set_thread_name("main");
 
   // Create struct with all non-kmachine handled args to pass to the runtime
   GameLaunchOptions game_options;
@@ -222,6 +238,20 @@ int main(int argc, char** argv) {
     return 1;
   }
 
+  if (stream_profile) {
+    lg::info("Streaming profile events to {}", prof().start_streaming());
+  }
+
+  if (!mips2c_capture.empty()) {
+    lg::info("Capturing {} calls of mips2c function {}", mips2c_capture_calls, mips2c_capture);
+    Mips2C::arm_capture(mips2c_capture, mips2c_capture_calls);
+  }
+
+  if (kmalloc_snapshot_seconds > 0) {
+    lg::info("Writing kmalloc snapshots to {}",
+             kmalloc_tracker_start_snapshots(game_options.game_version, kmalloc_snapshot_seconds));
+  }
+
   bool force_debug_next_time = false;
   // always start with an empty arg, as internally kmachine starts at `1` not `0`
   std::vector<const char*> arg_ptrs = {""};
@@ -250,6 +280,8 @@ int main(int argc, char** argv) {
       auto exit_status = exec_runtime(game_options, arg_ptrs.size(), arg_ptrs.data());
       switch (exit_status) {
         case RuntimeExitStatus::EXIT:
+          prof().stop_streaming();
+          kmalloc_tracker_stop_snapshots();
           return 0;
         case RuntimeExitStatus::RESTART_RUNTIME:
         case RuntimeExitStatus::RUNNING:
@@ -0,0 +1,245 @@
+#include "mips2c_capture.h"
+
+#include <cstring>
+#include <sstream>
+
+#include "common/goal_constants.h"
+#include "common/log/log.h"
+#include "common/util/Assert.h"
+#include "common/util/Serializer.h"
+#include "common/util/Timer.h"
+#include "common/util/compress.h"
+#include "common/util/string_util.h"
+
+#include "game/kernel/common/kscheme.h"
+#include "game/kernel/jak1/kscheme.h"
+#include "game/kernel/jak2/kscheme.h"
+#include "game/kernel/jak3/kscheme.h"
+#include "game/runtime.h"
+
+#include "fmt/core.h"
+
+namespace Mips2C {
+namespace {
+constexpr u32 MIPS2C_CAPTURE_MAGIC = 0x4332504d;  // "MP2C"
+// change this if the layout of the capture changes.
+constexpr u32 MIPS2C_CAPTURE_VERSION = 1;
+
+struct CaptureState {
+  std::string function_name;
+  int remaining_calls = 0;
+  u64 (*exec)(void*) = nullptr;
+  Mips2CCapture capture;
+  std::vector<u8> shadow;  // EE memory, as of the end of the last captured call
+};
+
+CaptureState g_capture;
+
+/*!
+ * Find the pages of memory that differ from the shadow copy, store them, and update the shadow.
+ */
+void diff_pages(const u8* memory, std::vector<u8>& shadow, std::vector<u32>& pages,
+                std::vector<u8>& data) {
+  constexpr u32 PAGE_SIZE = Mips2CCapture::PAGE_SIZE;
+  for (u32 i = 0; i < shadow.size() / PAGE_SIZE; i++) {
+    const u8* page = memory + i * PAGE_SIZE;
+    u8* shadow_page = shadow.data() + i * PAGE_SIZE;
+    if (memcmp(page, shadow_page, PAGE_SIZE)) {
+      memcpy(shadow_page, page, PAGE_SIZE);
+      pages.push_back(i);
+      data.insert(data.end(), page, page + PAGE_SIZE);
+    }
+  }
+}
+
+template <typename T>
+void save_symbol_table(Mips2CCapture& capture, const T& table) {
+  for (const auto& [name, value] : table) {
+    capture.symbol_names.push_back(name);
+    capture.symbol_values.push_back(value);
+  }
+}
+
+void start_capture(Mips2CCapture& capture) {
+  capture.version = g_game_version;
+  capture.function_name = g_capture.function_name;
+  capture.memory_size = EE_MAIN_MEM_SIZE;
+  capture.s7_offset = ::s7.offset;
+  capture.symbol_table2_offset = SymbolTable2.offset;
+  capture.last_symbol_offset = LastSymbol.offset;
+  switch (g_game_version) {
+    case GameVersion::Jak1:
+      save_symbol_table(capture, jak1::g_symbol_hash_table);
+      break;
+    case GameVersion::Jak2:
+      save_symbol_table(capture, jak2::g_symbol_hash_table);
+      break;
+    case GameVersion::Jak3:
+      capture.symbol_string_offset = jak3::SymbolString.offset;
+      save_symbol_table(capture, jak3::g_symbol_hash_table);
+      break;
+    default:
+      ASSERT_NOT_REACHED();
+  }
+  // starting from zeroes means the first call stores all of the memory that's in use.
+  g_capture.shadow.assign(EE_MAIN_MEM_SIZE, 0);
+}
+
+void finish_capture() {
+  auto path = file_util::get_user_misc_dir(g_game_version) / "mips2c_captures" /
+              fmt::format("{}-{}.m2ccap", g_capture.function_name,
+                          str_util::current_local_timestamp_no_colons());
+  lg::info("Writing {} captured calls of {}", g_capture.capture.calls.size(),
+           g_capture.function_name);
+  write_mips2c_capture(path, g_capture.capture);
+  lg::info("Saved mips2c capture to {}", path.string());
+  g_capture.capture = {};
+  g_capture.shadow = {};
+  g_capture.shadow.shrink_to_fit();
+}
+
+/*!
+ * Stands in for the captured function in the linked function table.
+ */
+u64 capture_call(void* ctx) {
+  if (g_capture.remaining_calls <= 0) {
+    return g_capture.exec(ctx);
+  }
+
+  auto& capture = g_capture.capture;
+  if (capture.calls.empty()) {
+    start_capture(capture);
+  }
+  auto* c = (ExecutionContext*)ctx;
+  auto& call = capture.calls.emplace_back();
+  diff_pages(g_ee_main_mem, g_capture.shadow, call.changed_pages, call.changed_data);
+  call.before = *c;
+  call.rng_before = save_rng_state();
+
+  u64 goal_calls = gGoalCallCount;
+  Timer timer;
+  call.result = g_capture.exec(ctx);
+  call.duration_ns = timer.getNs();
+  call.called_goal = gGoalCallCount != goal_calls;
+
+  call.after = *c;
+  call.rng_after = save_rng_state();
+  diff_pages(g_ee_main_mem, g_capture.shadow, call.written_pages, call.written_data);
+
+  if (--g_capture.remaining_calls == 0) {
+    finish_capture();
+  }
+  return call.result;
+}
+
+void serialize_call(Serializer& ser, CapturedCall& call) {
+  ser.from_ptr(&call.before);
+  ser.from_ptr(&call.after);
+  ser.from_ptr(&call.result);
+  ser.from_ptr(&call.duration_ns);
+  ser.from_ptr(&call.called_goal);
+  ser.from_str(&call.rng_before);
+  ser.from_str(&call.rng_after);
+  ser.from_pod_vector(&call.changed_pages);
+  ser.from_pod_vector(&call.changed_data);
+  ser.from_pod_vector(&call.written_pages);
+  ser.from_pod_vector(&call.written_data);
+}
+
+void serialize_capture(Serializer& ser, Mips2CCapture& capture) {
+  ser.from_ptr(&capture.version);
+  ser.from_str(&capture.function_name);
+  ser.from_ptr(&capture.memory_size);
+  ser.from_ptr(&capture.s7_offset);
+  ser.from_ptr(&capture.symbol_table2_offset);
+  ser.from_ptr(&capture.last_symbol_offset);
+  ser.from_ptr(&capture.symbol_string_offset);
+  ser.from_string_vector(&capture.symbol_names);
+  ser.from_pod_vector(&capture.symbol_values);
+  if (ser.is_saving()) {
+    ser.save<size_t>(capture.calls.size());
+  } else {
+    capture.calls.resize(ser.load<size_t>());
+  }
+  for (auto& call : capture.calls) {
+    serialize_call(ser, call);
+  }
+}
+}  // namespace
+
+/*!
+ * Capture the next num_calls calls to the named function, then write them to the user's misc
+ * folder. This has to be done before the function is linked.
+ */
+void arm_capture(const std::string& function_name, int num_calls) {
+  g_capture.function_name = function_name;
+  g_capture.remaining_calls = num_calls;
+}
+
+/*!
+ * Get the function that should be registered for name: exec itself, or the capturing wrapper if
+ * this is the function being captured.
+ */
+u64 (*exec_for_capture(const std::string& name, u64 (*exec)(void*)))(void*) {
+  if (g_capture.remaining_calls > 0 && name == g_capture.function_name) {
+    g_capture.exec = exec;
+    return capture_call;
+  }
+  return exec;
+}
+
+std::string save_rng_state() {
+  std::ostringstream ss;
+  ss << gRng.R_u32() << ' ' << gRng.extra_random_generator;
+  return ss.str();
+}
+
+void load_rng_state(const std::string& state) {
+  std::istringstream ss(state);
+  u32 r;
+  ss >> r >> gRng.extra_random_generator;
+  memcpy(&gRng.R, &r, 4);
+}
+
+/*!
+ * Copy captured pages into memory.
+ */
+void apply_pages(u8* memory, const std::vector<u32>& pages, const std::vector<u8>& data) {
+  ASSERT(data.size() == pages.size() * Mips2CCapture::PAGE_SIZE);
+  for (size_t i = 0; i < pages.size(); i++) {
+    memcpy(memory + pages[i] * Mips2CCapture::PAGE_SIZE,
+           data.data() + i * Mips2CCapture::PAGE_SIZE, Mips2CCapture::PAGE_SIZE);
+  }
+}
+
+void write_mips2c_capture(const fs::path& path, Mips2CCapture& capture) {
+  Serializer ser;
+  u32 magic = MIPS2C_CAPTURE_MAGIC;
+  u32 version = MIPS2C_CAPTURE_VERSION;
+  ser.from_ptr(&magic);
+  ser.from_ptr(&version);
+  serialize_capture(ser, capture);
+  auto [data, size] = ser.get_save_result();
+  auto compressed = compression::compress_zstd(data, size);
+  file_util::create_dir_if_needed_for_file(path);
+  file_util::write_binary_file(path, compressed.data(), compressed.size());
+}
+
+Mips2CCapture read_mips2c_capture(const fs::path& path) {
+  auto compressed = file_util::read_binary_file(path);
+  auto data = compression::decompress_zstd(compressed.data(), compressed.size());
+  Serializer ser(data.data(), data.size());
+  u32 magic, version;
+  ser.from_ptr(&magic);
+  ser.from_ptr(&version);
+  ASSERT_MSG(magic == MIPS2C_CAPTURE_MAGIC,
+             fmt::format("{} is not a mips2c capture", path.string()));
+  ASSERT_MSG(version == MIPS2C_CAPTURE_VERSION,
+             fmt::format("mips2c capture {} has version {}, but {} is required", path.string(),
+                         version, MIPS2C_CAPTURE_VERSION));
+  Mips2CCapture capture;
+  serialize_capture(ser, capture);
+  ASSERT(ser.get_load_finished());
+  return capture;
+}
+}  // namespace Mips2C
@@ -0,0 +1,66 @@
+#pragma once
+
+/*!
+ * @file mips2c_capture.h
+ * Recording calls to a single mips2c function, so they can be replayed and timed by the
+ * mips2c_replay tool without running the game.
+ *
+ * A mips2c function's inputs are its ExecutionContext and EE memory. Before each call, the pages of
+ * EE memory that changed since the previous captured call are stored (for the first call, this is
+ * all non-zero memory), so replaying the calls in order rebuilds the memory each call saw. After
+ * each call, the pages the call wrote and the context are stored, so a replay can check that it
+ * produced exactly the same thing.
+ */
+
+#include <string>
+#include <vector>
+
+#include "common/common_types.h"
+#include "common/util/FileUtil.h"
+#include "common/versions/versions.h"
+
+#include "game/mips2c/mips2c_private.h"
+
+namespace Mips2C {
+
+struct CapturedCall {
+  ExecutionContext before;
+  ExecutionContext after;
+  u64 result = 0;
+  u64 duration_ns = 0;
+  // calls that jump back into GOAL code can't be replayed on their own.
+  bool called_goal = false;
+  std::string rng_before;  // gRng, which some functions use.
+  std::string rng_after;
+
+  std::vector<u32> changed_pages;  // pages that changed since the previous call, before this call
+  std::vector<u8> changed_data;
+  std::vector<u32> written_pages;  // pages this call wrote, and their contents after the call
+  std::vector<u8> written_data;
+};
+
+struct Mips2CCapture {
+  static constexpr u32 PAGE_SIZE = 0x1000;
+
+  GameVersion version = GameVersion::Jak1;
+  std::string function_name;
+  u32 memory_size = 0;
+
+  // enough of the kernel's symbol table state to run the function's link callback again.
+  u32 s7_offset = 0;
+  u32 symbol_table2_offset = 0;
+  u32 last_symbol_offset = 0;
+  u32 symbol_string_offset = 0;  // jak 3 only
+  std::vector<std::string> symbol_names;
+  std::vector<s32> symbol_values;
+
+  std::vector<CapturedCall> calls;
+};
+
+std::string save_rng_state();
+void load_rng_state(const std::string& state);
+void apply_pages(u8* memory, const std::vector<u32>& pages, const std::vector<u8>& data);
+
+void write_mips2c_capture(const fs::path& path, Mips2CCapture& capture);
+Mips2CCapture read_mips2c_capture(const fs::path& path);
+}  // namespace Mips2C
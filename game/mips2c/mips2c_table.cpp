@@ -398,6 +398,7 @@ namespace shadow_execute { extern void link(); }
 // clang-format on
 
 LinkedFunctionTable gLinkedFunctionTable;
+u64 gGoalCallCount = 0;
 Rng gRng;
 PerGameVersion<std::unordered_map<std::string, std::vector<void (*)()>>> gMips2CLinkCallbacks = {
     //////// JAK 1
@@ -657,7 +658,9 @@ PerGameVersion<std::unordered_map<std::string, std::vector<void (*)()>>> gMips2C
        jak3::shadow_add_single_tris::link, jak3::shadow_add_double_tris::link}}}};
 
 void LinkedFunctionTable::reg(const std::string& name, u64 (*exec)(void*), u32 stack_size) {
-  const auto& it = m_executes.insert({name, {exec, Ptr<u8>()}});
+  // if this function is being captured, GOAL calls the capture instead.
+  exec = exec_for_capture(name, exec);
+  const auto& it = m_executes.insert({name, {exec, Ptr<u8>(), stack_size}});
   if (!it.second) {
     lg::error("MIPS2C Function {} is registered multiple times, ignoring later registrations.",
               name);
@@ -744,4 +747,26 @@ u32 LinkedFunctionTable::get(const std::string& name) {
   }
   return it->second.goal_trampoline.offset;
 }
+
+/*!
+ * Get the C++ function registered for name, or nullptr if it hasn't been linked.
+ */
+u64 (*LinkedFunctionTable::get_exec(const std::string& name))(void*) {
+  auto it = m_executes.find(name);
+  if (it == m_executes.end()) {
+    return nullptr;
+  }
+  return it->second.c_func;
+}
+
+/*!
+ * Get the size of the MIPS stack given to the function registered for name.
+ */
+u32 LinkedFunctionTable::get_stack_size(const std::string& name) {
+  auto it = m_executes.find(name);
+  if (it == m_executes.end()) {
+    ASSERT_NOT_REACHED_MSG(fmt::format("mips2c function {} is unknown", name));
+  }
+  return it->second.stack_size;
+}
 }  // namespace Mips2C
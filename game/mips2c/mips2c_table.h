@@ -17,11 +17,14 @@ class LinkedFunctionTable {
  public:
   void reg(const std::string& name, u64 (*exec)(void*), u32 goal_stack_size);
   u32 get(const std::string& name);
+  u64 (*get_exec(const std::string& name))(void*);
+  u32 get_stack_size(const std::string& name);
 
  private:
   struct Func {
     u64 (*c_func)(void*);
     Ptr<u8> goal_trampoline;
+    u32 stack_size = 0;
   };
   std::unordered_map<std::string, Func> m_executes;
 };
@@ -29,6 +32,12 @@ class LinkedFunctionTable {
 extern PerGameVersion<std::unordered_map<std::string, std::vector<void (*)()>>>
     gMips2CLinkCallbacks;
 extern LinkedFunctionTable gLinkedFunctionTable;
+// counts calls from mips2c code back to GOAL code, so a capture can tell which calls used them.
+extern u64 gGoalCallCount;
+
+// recording calls for the mips2c_replay tool, see mips2c_capture.h
+void arm_capture(const std::string& function_name, int num_calls);
+u64 (*exec_for_capture(const std::string& name, u64 (*exec)(void*)))(void*);
 
 struct Rng {
   Rng() { init(); }
@@ -18,6 +18,7 @@
 #include "common/util/FileUtil.h"
 
 #include "game/common/overlord_common.h"
+#include "game/overlord/common/iso_file_reader.h"
 #include "game/overlord/common/isocommon.h"
 #include "game/overlord/common/overlord.h"
 #include "game/overlord/common/sbank.h"
@@ -49,6 +50,7 @@ void fake_iso_init_globals() {
   memset(sFiles, 0, sizeof(sFiles));
 
   fake_iso_entry_count = 0;
+  iso_file_reader.close_all();
 }
 
 /*!
@@ -122,18 +124,13 @@ const char* get_file_path(FileRecord* fr) {
 }
 
 /*!
- * Determine the length of a file. This isn't very fast, but nobody checks file sizes extremely
- * quickly. This is an ISO FS API Function
+ * Determine the length of a file. This is an ISO FS API Function
  */
 uint32_t FS_GetLength(FileRecord* fr) {
   const char* path = get_file_path(fr);
   file_util::assert_file_exists(path, "fake_iso FS_GetLength");
-  FILE* fp = file_util::open_file(path, "rb");
-  ASSERT(fp);
-  fseek(fp, 0, SEEK_END);
-  uint32_t len = ftell(fp);
-  rewind(fp);
-  fclose(fp);
+  s64 len = iso_file_reader.size(path);
+  ASSERT(len >= 0);
   return len;
 }
 
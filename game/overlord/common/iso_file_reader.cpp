@@ -0,0 +1,372 @@
+#include "iso_file_reader.h"
+
+#include <algorithm>
+
+#include "common/log/log.h"
+#include "common/util/Assert.h"
+#include "common/util/FileUtil.h"
+
+#include "game/overlord/common/fake_iso.h"
+#include "game/sce/iop.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+IsoFileReader iso_file_reader;
+
+struct IsoFileReader::File {
+  ~File() {
+    if (fd >= 0) {
+#ifdef _WIN32
+      _close(fd);
+#else
+      close(fd);
+#endif
+    }
+  }
+
+  int fd = -1;
+  u64 size = 0;
+  s64 mtime = 0;
+  // where the last read of this file ended, to detect sequential reads.
+  u64 sequential_end = 0;
+#ifdef _WIN32
+  // there's no pread, and seeking and reading must not be interleaved with another thread.
+  std::mutex mutex;
+#endif
+};
+
+namespace {
+size_t read_at(int fd, u64 offset, void* dst, size_t size) {
+  size_t done = 0;
+  while (done < size) {
+#ifdef _WIN32
+    if (_lseeki64(fd, offset + done, SEEK_SET) < 0) {
+      break;
+    }
+    auto result = _read(fd, (u8*)dst + done, std::min(size - done, (size_t)INT32_MAX));
+#else
+    auto result = pread(fd, (u8*)dst + done, size - done, offset + done);
+#endif
+    if (result <= 0) {
+      break;
+    }
+    done += result;
+  }
+  return done;
+}
+}  // namespace
+
+IsoFileReader::IsoFileReader() : m_blocks(PREFETCH_BLOCK_COUNT) {}
+
+IsoFileReader::~IsoFileReader() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_shutdown = true;
+  }
+  m_cv.notify_all();
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
+
+/*!
+ * Get the open file for a path, opening it if needed. If check_changed is set, the file is opened
+ * again if it has been modified since it was opened (for example, when a DGO is rebuilt while the
+ * game is running). Must be called with m_mutex held.
+ */
+std::shared_ptr<IsoFileReader::File> IsoFileReader::get_file(const std::string& path,
+                                                             bool check_changed) {
+  auto it = m_files.find(path);
+  if (it != m_files.end() && !check_changed) {
+    return it->second;
+  }
+
+  std::error_code ec;
+  u64 size = fs::file_size(path, ec);
+  if (ec) {
+    lg::error("[OVERLORD] fake iso could not open the file \"{}\"", path);
+    return nullptr;
+  }
+  s64 mtime = fs::last_write_time(path, ec).time_since_epoch().count();
+  if (it != m_files.end() && it->second->size == size && it->second->mtime == mtime) {
+    return it->second;
+  }
+
+  auto file = std::make_shared<File>();
+#ifdef _WIN32
+  file->fd = _wopen(fs::path(path).wstring().c_str(), _O_RDONLY | _O_BINARY);
+#else
+  file->fd = ::open(path.c_str(), O_RDONLY);
+#endif
+  if (file->fd < 0) {
+    lg::error("[OVERLORD] fake iso could not open the file \"{}\"", path);
+    return nullptr;
+  }
+  file->size = size;
+  file->mtime = mtime;
+  // any prefetched data for an older version of the file won't be used, because it refers to the
+  // old File.
+  m_files[path] = file;
+  return file;
+}
+
+size_t IsoFileReader::read_file(File& file, u64 offset, void* dst, size_t size) {
+#ifdef _WIN32
+  std::lock_guard<std::mutex> lock(file.mutex);
+#endif
+  return read_at(file.fd, offset, dst, size);
+}
+
+/*!
+ * Open a file, or check that an already open file hasn't changed. Returns false if it doesn't
+ * exist.
+ */
+bool IsoFileReader::open(const std::string& path) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return get_file(path, true) != nullptr;
+}
+
+/*!
+ * Get the size of a file, or -1 if it doesn't exist.
+ */
+s64 IsoFileReader::size(const std::string& path) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto file = get_file(path, true);
+  return file ? (s64)file->size : -1;
+}
+
+/*!
+ * Copy data from prefetched blocks. This only copies if all the data is ready. If it isn't, pending
+ * is set if the missing data is currently being prefetched. Must be called with m_mutex held.
+ */
+bool IsoFileReader::copy_from_blocks(const File* file,
+                                     u64 offset,
+                                     void* dst,
+                                     size_t size,
+                                     bool* pending) {
+  Block* pieces[PREFETCH_BLOCK_COUNT];
+  int num_pieces = 0;
+  *pending = false;
+
+  for (u64 at = offset; at < offset + size;) {
+    Block* found = nullptr;
+    for (auto& block : m_blocks) {
+      if (block.state != Block::State::EMPTY && block.file.get() == file && block.offset <= at &&
+          at < block.offset + PREFETCH_BLOCK_SIZE) {
+        found = &block;
+        break;
+      }
+    }
+    if (!found) {
+      return false;
+    }
+    if (found->state != Block::State::READY) {
+      *pending = true;
+      return false;
+    }
+    if (at >= found->offset + found->size || num_pieces == PREFETCH_BLOCK_COUNT) {
+      return false;  // the block was cut short by the end of the file
+    }
+    pieces[num_pieces++] = found;
+    at = found->offset + found->size;
+  }
+
+  for (int i = 0; i < num_pieces; i++) {
+    auto* block = pieces[i];
+    u64 start = std::max(offset, block->offset);
+    u64 end = std::min(offset + size, block->offset + block->size);
+    memcpy((u8*)dst + (start - offset), block->data.get() + (start - block->offset), end - start);
+    block->last_use = ++m_use_counter;
+  }
+  return true;
+}
+
+/*!
+ * Record a read of a file. If it continues from where the last read ended, queue the following
+ * blocks to be prefetched. Must be called with m_mutex held.
+ */
+void IsoFileReader::note_access(const std::shared_ptr<File>& file, u64 offset, size_t size) {
+  bool sequential = offset == file->sequential_end;
+  file->sequential_end = offset + size;
+  if (!sequential) {
+    return;
+  }
+
+  bool queued = false;
+  u64 first = (offset + size) / PREFETCH_BLOCK_SIZE * PREFETCH_BLOCK_SIZE;
+  for (int i = 0; i < PREFETCH_AHEAD; i++) {
+    u64 block_offset = first + i * PREFETCH_BLOCK_SIZE;
+    if (block_offset >= file->size) {
+      break;
+    }
+
+    // skip blocks that we already have, and find the least recently used block to replace.
+    bool have = false;
+    Block* replace = nullptr;
+    for (auto& block : m_blocks) {
+      if (block.state != Block::State::EMPTY && block.file == file &&
+          block.offset == block_offset) {
+        have = true;
+        break;
+      }
+      if (block.state == Block::State::EMPTY) {
+        if (!replace || replace->state != Block::State::EMPTY) {
+          replace = &block;
+        }
+      } else if (block.state == Block::State::READY &&
+                 (!replace ||
+                  (replace->state == Block::State::READY && block.last_use < replace->last_use))) {
+        replace = &block;
+      }
+    }
+    if (have) {
+      continue;
+    }
+    if (!replace) {
+      break;  // everything is being loaded already.
+    }
+
+    if (!replace->data) {
+      replace->data = std::make_unique<u8[]>(PREFETCH_BLOCK_SIZE);
+    }
+    replace->state = Block::State::QUEUED;
+    replace->file = file;
+    replace->offset = block_offset;
+    replace->size = 0;
+    replace->last_use = ++m_use_counter;
+    m_queue.push_back(replace);
+    queued = true;
+  }
+
+  if (queued) {
+    if (!m_thread.joinable()) {
+      m_thread = std::thread(&IsoFileReader::prefetch_thread, this);
+    }
+    m_cv.notify_all();
+  }
+}
+
+void IsoFileReader::prefetch_thread() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    m_cv.wait(lock, [&] { return m_shutdown || !m_queue.empty(); });
+    if (m_shutdown) {
+      return;
+    }
+
+    Block* block = m_queue.front();
+    m_queue.pop_front();
+    block->state = Block::State::LOADING;
+    auto file = block->file;
+    size_t size = std::min((u64)PREFETCH_BLOCK_SIZE, file->size - block->offset);
+
+    lock.unlock();
+    size = read_file(*file, block->offset, block->data.get(), size);
+    lock.lock();
+
+    block->size = size;
+    block->state = Block::State::READY;
+    m_cv.notify_all();
+  }
+}
+
+/*!
+ * Read from a file, if all the data has already been prefetched. Doesn't wait for the disk.
+ * Reads past the end of the file are truncated.
+ */
+bool IsoFileReader::read_prefetched(const std::string& path,
+                                    u64 offset,
+                                    void* dst,
+                                    size_t size,
+                                    size_t* bytes_read) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  *bytes_read = 0;
+  auto file = get_file(path, false);
+  if (!file || offset >= file->size) {
+    return true;
+  }
+  size = std::min(size, (size_t)(file->size - offset));
+
+  bool pending;
+  if (!copy_from_blocks(file.get(), offset, dst, size, &pending)) {
+    return false;
+  }
+  note_access(file, offset, size);
+  *bytes_read = size;
+  return true;
+}
+
+/*!
+ * Read from a file, waiting for the disk if needed. Reads past the end of the file are truncated.
+ */
+size_t IsoFileReader::read(const std::string& path, u64 offset, void* dst, size_t size) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  auto file = get_file(path, false);
+  if (!file || offset >= file->size) {
+    return 0;
+  }
+  size = std::min(size, (size_t)(file->size - offset));
+
+  while (true) {
+    bool pending;
+    if (copy_from_blocks(file.get(), offset, dst, size, &pending)) {
+      note_access(file, offset, size);
+      return size;
+    }
+    if (!pending) {
+      break;
+    }
+    // the data is already on its way, so waiting for it is faster than reading it again.
+    m_cv.wait(lock);
+  }
+
+  lock.unlock();
+  size = read_file(*file, offset, dst, size);
+  lock.lock();
+  note_access(file, offset, size);
+  return size;
+}
+
+/*!
+ * Close all files and drop prefetched data.
+ */
+void IsoFileReader::close_all() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_files.clear();
+  m_queue.clear();
+  for (auto& block : m_blocks) {
+    // blocks that are being loaded are left alone, their File is kept alive until they finish.
+    if (block.state != Block::State::LOADING) {
+      block.state = Block::State::EMPTY;
+      block.file.reset();
+    }
+  }
+}
+
+/*!
+ * Read from a file on an IOP thread. Prefetched data is copied immediately. Otherwise, the read is
+ * done on the thread pool and the IOP thread sleeps, so other IOP threads can run while waiting for
+ * the disk.
+ */
+size_t iso_read_from_iop(const std::string& path, u64 offset, void* dst, size_t size) {
+  size_t bytes_read = 0;
+  if (iso_file_reader.read_prefetched(path, offset, dst, size, &bytes_read)) {
+    return bytes_read;
+  }
+
+  auto future = thpool.submit(
+      [&](s32 thread_to_wake) {
+        bytes_read = iso_file_reader.read(path, offset, dst, size);
+        iop::iWakeupThread(thread_to_wake);
+      },
+      iop::GetThreadId());
+  iop::SleepThread();
+  future.get();
+  return bytes_read;
+}
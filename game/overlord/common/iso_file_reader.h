@@ -0,0 +1,75 @@
+#pragma once
+
+/*!
+ * @file iso_file_reader.h
+ * Reads files for the fake iso implementations (jak1 fake_iso and jak2 iso_cd).
+ *
+ * Files are kept open, and their sizes are cached, so a read is a single pread. When a file is read
+ * sequentially (like a DGO or a stream), the following blocks of the file are prefetched into a
+ * small pool of buffers on a background thread, so the next read doesn't have to wait for the disk.
+ */
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "common/common_types.h"
+
+class IsoFileReader {
+ public:
+  static constexpr size_t PREFETCH_BLOCK_SIZE = 128 * 1024;
+  static constexpr int PREFETCH_BLOCK_COUNT = 16;
+  // how many blocks past the end of a sequential read to prefetch
+  static constexpr int PREFETCH_AHEAD = 4;
+
+  IsoFileReader();
+  ~IsoFileReader();
+  IsoFileReader(const IsoFileReader&) = delete;
+  IsoFileReader& operator=(const IsoFileReader&) = delete;
+
+  bool open(const std::string& path);
+  s64 size(const std::string& path);
+  bool read_prefetched(const std::string& path,
+                       u64 offset,
+                       void* dst,
+                       size_t size,
+                       size_t* bytes_read);
+  size_t read(const std::string& path, u64 offset, void* dst, size_t size);
+  void close_all();
+
+ private:
+  struct File;
+  struct Block {
+    enum class State { EMPTY, QUEUED, LOADING, READY };
+    State state = State::EMPTY;
+    std::shared_ptr<File> file;
+    u64 offset = 0;
+    size_t size = 0;
+    u64 last_use = 0;
+    std::unique_ptr<u8[]> data;
+  };
+
+  std::shared_ptr<File> get_file(const std::string& path, bool check_changed);
+  static size_t read_file(File& file, u64 offset, void* dst, size_t size);
+  bool copy_from_blocks(const File* file, u64 offset, void* dst, size_t size, bool* pending);
+  void note_access(const std::shared_ptr<File>& file, u64 offset, size_t size);
+  void prefetch_thread();
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::unordered_map<std::string, std::shared_ptr<File>> m_files;
+  std::vector<Block> m_blocks;
+  std::deque<Block*> m_queue;
+  u64 m_use_counter = 0;
+  bool m_shutdown = false;
+  std::thread m_thread;
+};
+
+extern IsoFileReader iso_file_reader;
+
+size_t iso_read_from_iop(const std::string& path, u64 offset, void* dst, size_t size);
@@ -6,6 +6,7 @@
 #include "common/util/FileUtil.h"
 
 #include "game/overlord/common/fake_iso.h"
+#include "game/overlord/common/iso_file_reader.h"
 #include "game/overlord/common/overlord.h"
 #include "game/overlord/common/soundcommon.h"
 #include "game/overlord/jak1/isocommon.h"
@@ -43,16 +44,10 @@ void fake_iso_init_globals() {
   sReadInfo = nullptr;
 }
 
-static FILE* open_fr(FileRecord* fr, s32 thread_to_wake) {
-  const char* path = get_file_path(fr);
-  FILE* fp = file_util::open_file(path, "rb");
-  if (!fp) {
-    lg::error("[OVERLORD] fake iso could not open the file \"{}\"", path);
-  }
-
+static void open_fr(FileRecord* fr, s32 thread_to_wake) {
+  // this logs an error if the file doesn't exist.
+  iso_file_reader.open(get_file_path(fr));
   iop::iWakeupThread(thread_to_wake);
-
-  return fp;
 }
 
 /*!
@@ -76,7 +71,7 @@ LoadStackEntry* FS_Open(FileRecord* fr, int32_t offset) {
 
       auto future = thpool.submit(open_fr, fr, iop::GetThreadId());
       iop::SleepThread();
-      selected->fp = future.get();
+      future.get();
 
       return selected;
     }
@@ -102,7 +97,7 @@ LoadStackEntry* FS_OpenWad(FileRecord* fr, int32_t offset) {
 
       auto future = thpool.submit(open_fr, fr, iop::GetThreadId());
       iop::SleepThread();
-      selected->fp = future.get();
+      future.get();
 
       return selected;
     }
@@ -119,15 +114,14 @@ LoadStackEntry* FS_OpenWad(FileRecord* fr, int32_t offset) {
 void FS_Close(LoadStackEntry* fd) {
   lg::debug("[OVERLORD] FS_Close {} @ {}/{}", fd->fr->name, fd->fr->location, fd->location);
 
-  // close the FD
+  // the file itself is kept open by the iso_file_reader.
   fd->fr = nullptr;
-  fclose(fd->fp);
   if (fd == sReadInfo) {
     sReadInfo = nullptr;
   }
 }
 
-void fs_read(LoadStackEntry* fd, void* buffer, int32_t len, s32 thread_to_wake) {
+void fs_read(LoadStackEntry* fd, void* buffer, int32_t len) {
   int32_t real_size = len;
   if (len < 0) {
     // not sure what this is about...
@@ -138,24 +132,8 @@ void fs_read(LoadStackEntry* fd, void* buffer, int32_t len, s32 thread_to_wake)
   real_size = sectors * SECTOR_SIZE;
   u32 offset_into_file = SECTOR_SIZE * fd->location;
 
-  ASSERT(fd->fp);
-  fseek(fd->fp, 0, SEEK_END);
-  uint32_t file_len = ftell(fd->fp);
-  rewind(fd->fp);
-
-  if (offset_into_file < file_len) {
-    if (offset_into_file) {
-      fseek(fd->fp, offset_into_file, SEEK_SET);
-    }
-
-    if (offset_into_file + real_size > file_len) {
-      real_size = (file_len - offset_into_file);
-    }
-
-    if (fread(buffer, real_size, 1, fd->fp) != 1) {
-      ASSERT(false);
-    }
-  }
+  // reads past the end of the file are truncated.
+  iso_read_from_iop(get_file_path(fd->fr), offset_into_file, buffer, real_size);
 
   if (len < 0) {
     len = len + 0x7ff;
@@ -163,23 +141,15 @@ void fs_read(LoadStackEntry* fd, void* buffer, int32_t len, s32 thread_to_wake)
 
   fd->location += (len / SECTOR_SIZE);
   sReadInfo = fd;
-
-  iop::iWakeupThread(thread_to_wake);
 }
 
 /*!
  * Begin reading!  Returns FS_READ_OK on success (always)
  * This is an ISO FS API Function
- *
- * Idea: do the fopen in FS_Open and keep the file open?  It would be faster.
  */
 uint32_t FS_BeginRead(LoadStackEntry* fd, void* buffer, int32_t len) {
   ASSERT(fd->fr->location < fake_iso_entry_count);
-
-  auto future = thpool.submit(fs_read, fd, buffer, len, iop::GetThreadId());
-  iop::SleepThread();
-  future.get();
-
+  fs_read(fd, buffer, len);
   return CMD_STATUS_IN_PROGRESS;
 }
 
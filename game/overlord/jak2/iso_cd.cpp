@@ -9,6 +9,7 @@
 
 #include "game/common/overlord_common.h"
 #include "game/overlord/common/fake_iso.h"
+#include "game/overlord/common/iso_file_reader.h"
 #include "game/overlord/common/isocommon.h"
 #include "game/overlord/common/sbank.h"
 #include "game/overlord/jak2/iso_queue.h"
@@ -82,7 +83,6 @@ u32 FS_SyncRead();
 
 struct FakeCd {
   int offset_into_file = 0;
-  FILE* fp = nullptr;
   void (*callback)(int) = nullptr;
   FileRecord* last_fr = nullptr;
 } gFakeCd;
@@ -120,12 +120,11 @@ void iso_cd_init_globals() {
   gFakeCd.last_fr = nullptr;
 }
 
-static FILE* open_fr(FileRecord* fr, s32 thread_to_wake) {
-  const char* path = get_file_path(fr);
-  FILE* fp = file_util::open_file(path, "rb");
+static bool open_fr(FileRecord* fr, s32 thread_to_wake) {
+  bool ok = iso_file_reader.open(get_file_path(fr));
   iop::iWakeupThread(thread_to_wake);
 
-  return fp;
+  return ok;
 }
 
 ///////////////////////////
@@ -140,25 +139,12 @@ auto sceCdCallback(void (*callback)(int)) {
 
 int sceCdRead(int lsn, int num_sectors, void* dest, void* mode) {
   (void)mode;
-  auto do_read = [lsn, num_sectors, dest](s32 thid) {
-    // printf("sceCdRead %d, %d -> %p\n", lsn, num_sectors, dest);
-    ASSERT(gFakeCd.fp);
-    if (fseek(gFakeCd.fp, lsn * SECTOR_SIZE, SEEK_SET)) {
-      ASSERT_MSG(false, "Failed to fseek");
-    }
-    if (fread(dest, num_sectors * SECTOR_SIZE, 1, gFakeCd.fp) < 0) {
-      printf("dest is %p, num_sectors %d, lsn %d\n", dest, num_sectors, lsn);
-      printf("err: %s\n", strerror(errno));
-      ASSERT_MSG(false, "Failed to fread");
-    }
-    ASSERT(gFakeCd.callback);
-
-    iWakeupThread(thid);
-  };
-
-  auto future = thpool.submit(do_read, GetThreadId());
-  SleepThread();
-  future.get();
+  // printf("sceCdRead %d, %d -> %p\n", lsn, num_sectors, dest);
+  ASSERT(gFakeCd.last_fr);
+  // reads past the end of the file are truncated.
+  iso_read_from_iop(get_file_path(gFakeCd.last_fr), (u64)lsn * SECTOR_SIZE, dest,
+                    num_sectors * SECTOR_SIZE);
+  ASSERT(gFakeCd.callback);
 
   return 1;
 }
@@ -613,19 +599,8 @@ int FS_PageBeginRead(LoadStackEntry* lse, Buffer* buffer) {
     if (gFakeCd.last_fr != lse->fr) {
       auto future = thpool.submit(open_fr, lse->fr, GetThreadId());
       SleepThread();
-      FILE* fp = future.get();
-      if (!fp) {
-        lg::error("[OVERLORD] fake iso could not open the file \"{}\"", get_file_path(lse->fr));
-      } else {
-        // printf("PAGE READING %s\n", path);
-      }
-
-      ASSERT(fp);
-
-      if (gFakeCd.fp) {
-        fclose(gFakeCd.fp);
-      }
-      gFakeCd.fp = fp;
+      bool ok = future.get();
+      ASSERT(ok);
       gFakeCd.last_fr = lse->fr;
     }
 
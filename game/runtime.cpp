@@ -254,6 +254,8 @@ void ee_worker_runner(SystemThreadInterface& iface) {
       std::this_thread::sleep_for(std::chrono::milliseconds(50));
     }
   }
+  // finish anything queued right before exit, like a save file.
+  g_background_worker.process_queues();
 }
 
 /*!
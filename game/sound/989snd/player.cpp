@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: ISC
 #include "player.h"
 
+#include <algorithm>
 #include <fstream>
 
 #include "sfxblock.h"
@@ -98,7 +99,7 @@ void Player::Tick(s16Output* stream, int samples) {
   std::scoped_lock lock(mTickLock);
   static int htick = 200;
   static int stick = 48000;
-  for (int i = 0; i < samples; i++) {
+  while (samples > 0) {
     // The handlers expect to tick at 240hz
     // 48000/240 = 200
     if (htick == 200) {
@@ -123,9 +124,14 @@ void Player::Tick(s16Output* stream, int samples) {
       stick = 0;
     }
 
-    stick++;
-    htick++;
-    *stream++ = mSynth.Tick();
+    // voices only change when the handlers tick, so everything up to the next handler tick can
+    // be mixed at once.
+    int block = std::min(samples, 200 - htick);
+    mSynth.Tick(stream, block);
+    stream += block;
+    samples -= block;
+    stick += block;
+    htick += block;
   }
 }
 
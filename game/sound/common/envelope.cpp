@@ -118,17 +118,6 @@ void ADSR::Stop() {
   m_Level = 0;
 }
 
-s16 ADSR::Level() const {
-  return static_cast<u16>(m_Level);
-}
-
-void Volume::Run() {
-  if (!m_Sweep.EnableSweep.get())
-    return;
-
-  Step();
-}
-
 void Volume::Set(u16 volume) {
   m_Sweep.bits = volume;
 
@@ -154,12 +143,4 @@ void Volume::Set(u16 volume) {
   // Console.WriteLn(Color_Red, "start sweep, e:%d d:%d sh:%d st:%d inv:%d", m_Exp, m_Decrease,
   // m_Shift, m_Step, m_Inv); Console.WriteLn(Color_Red, "Current level %08x", m_Level);
 }
-
-u16 Volume::Get() const {
-  return m_Sweep.bits;
-}
-
-s16 Volume::GetCurrent() const {
-  return static_cast<s16>(m_Level);
-}
 }  // namespace snd
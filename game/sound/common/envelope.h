@@ -68,7 +68,7 @@ class ADSR : Envelope {
   void Attack();
   void Release();
   void Stop();
-  [[nodiscard]] s16 Level() const;
+  [[nodiscard]] s16 Level() const { return static_cast<u16>(m_Level); }
   void SetLevel(s16 value) { m_Level = value; }
   void UpdateSettings();
   ADSRReg m_Reg{0};
@@ -93,10 +93,15 @@ class ADSR : Envelope {
 
 class Volume : Envelope {
  public:
-  void Run();
+  void Run() {
+    if (!m_Sweep.EnableSweep.get())
+      return;
+
+    Step();
+  }
   void Set(u16 volume);
-  [[nodiscard]] u16 Get() const;
-  [[nodiscard]] s16 GetCurrent() const;
+  [[nodiscard]] u16 Get() const { return m_Sweep.bits; }
+  [[nodiscard]] s16 GetCurrent() const { return static_cast<s16>(m_Level); }
 
   void Reset() {
     m_Sweep.bits = 0;
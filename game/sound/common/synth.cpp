@@ -2,20 +2,33 @@
 // SPDX-License-Identifier: ISC
 #include "synth.h"
 
+#include <algorithm>
 #include <stdexcept>
 
+#ifdef __aarch64__
+#include "third-party/sse2neon/sse2neon.h"
+#else
+#include <immintrin.h>
+#endif
+
 namespace snd {
 
 static s16 ApplyVolume(s16 sample, s32 volume) {
   return (sample * volume) >> 15;
 }
 
+void Synth::RemoveDeadVoices() {
+  mVoices.erase(std::remove_if(mVoices.begin(), mVoices.end(),
+                               [](std::shared_ptr<Voice>& v) { return v->Dead(); }),
+                mVoices.end());
+}
+
 s16Output Synth::Tick() {
   s16Output out{};
 
-  mVoices.remove_if([](std::shared_ptr<Voice>& v) { return v->Dead(); });
-  for (auto& v : mVoices) {
-    out += v->Run();
+  RemoveDeadVoices();
+  for (auto it = mVoices.rbegin(); it != mVoices.rend(); ++it) {
+    out += (*it)->Run();
   }
 
   out.left = ApplyVolume(out.left, mVolume.left.Get());
@@ -26,8 +39,65 @@ s16Output Synth::Tick() {
   return out;
 }
 
+/*!
+ * Produce a block of samples, with the same result as calling Tick() for each sample.
+ */
+void Synth::Tick(s16Output* out, int samples) {
+  while (samples > 0) {
+    int block = std::min(samples, Voice::MAX_BLOCK_SIZE);
+    MixBlock(out, block);
+    out += block;
+    samples -= block;
+  }
+}
+
+void Synth::MixBlock(s16Output* out, int samples) {
+  std::fill(out, out + samples, s16Output{});
+
+  RemoveDeadVoices();
+  for (auto it = mVoices.rbegin(); it != mVoices.rend(); ++it) {
+    (*it)->Run(mVoiceOutput.data(), samples);
+    // saturating add, like s16Output's +=
+    int i = 0;
+    for (; i + 4 <= samples; i += 4) {
+      __m128i mix = _mm_loadu_si128((const __m128i*)(out + i));
+      __m128i voice = _mm_loadu_si128((const __m128i*)(mVoiceOutput.data() + i));
+      _mm_storeu_si128((__m128i*)(out + i), _mm_adds_epi16(mix, voice));
+    }
+    for (; i < samples; i++) {
+      out[i] += mVoiceOutput[i];
+    }
+  }
+  // a voice that died during the block would have been removed before the next sample
+  RemoveDeadVoices();
+
+  // the master volume only changes with SetMasterVol, the sweep doesn't affect Get().
+  s32 left_vol = mVolume.left.Get();
+  s32 right_vol = mVolume.right.Get();
+  __m128i vol = _mm_setr_epi32(left_vol, right_vol, left_vol, right_vol);
+  int i = 0;
+  for (; i + 4 <= samples; i += 4) {
+    __m128i mix = _mm_loadu_si128((const __m128i*)(out + i));
+    __m128i lo = _mm_srai_epi32(_mm_mullo_epi32(_mm_cvtepi16_epi32(mix), vol), 15);
+    __m128i hi = _mm_srai_epi32(
+        _mm_mullo_epi32(_mm_cvtepi16_epi32(_mm_srli_si128(mix, 8)), vol), 15);
+    // truncate to 16 bits, like ApplyVolume.
+    lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+    hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+    _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(lo, hi));
+  }
+  for (; i < samples; i++) {
+    out[i].left = ApplyVolume(out[i].left, left_vol);
+    out[i].right = ApplyVolume(out[i].right, right_vol);
+  }
+
+  for (i = 0; i < samples; i++) {
+    mVolume.Run();
+  }
+}
+
 void Synth::AddVoice(std::shared_ptr<Voice> voice) {
-  mVoices.emplace_front(voice);
+  mVoices.emplace_back(voice);
 }
 
 void Synth::SetMasterVol(u32 volume) {
@@ -1,7 +1,7 @@
 // Copyright: 2021 - 2024, Ziemas
 // SPDX-License-Identifier: ISC
 #pragma once
-#include <forward_list>
+#include <array>
 #include <memory>
 #include <unordered_map>
 #include <vector>
@@ -26,11 +26,17 @@ class Synth {
   }
 
   s16Output Tick();
+  void Tick(s16Output* out, int samples);
   void AddVoice(std::shared_ptr<Voice> voice);
   void SetMasterVol(u32 volume);
 
  private:
-  std::forward_list<std::shared_ptr<Voice>> mVoices;
+  void RemoveDeadVoices();
+  void MixBlock(s16Output* out, int samples);
+
+  // in the order they were added. They are mixed newest first.
+  std::vector<std::shared_ptr<Voice>> mVoices;
+  std::array<s16Output, Voice::MAX_BLOCK_SIZE> mVoiceOutput{};
 
   VolumePair mVolume{};
 };
@@ -0,0 +1,161 @@
+// Offline benchmark for the synth. Renders random voices with both the per-sample and the block
+// mixer, reports how long each took, and checks that their output is identical.
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "synth.h"
+
+#include "common/log/log.h"
+#include "common/util/Timer.h"
+
+#include "fmt/core.h"
+#include "third-party/CLI11.hpp"
+
+namespace {
+constexpr int SAMPLE_RATE = 48000;
+// the 989snd handlers change voices at 240hz
+constexpr int TICK_SAMPLES = 200;
+
+struct SampleInfo {
+  u32 start;  // in u16's
+};
+
+/*!
+ * Make random ADPCM samples. Each 16 byte block is a header and 28 samples. Some of the samples
+ * loop until they are keyed off, the others stop their voice when they end.
+ */
+std::vector<SampleInfo> make_samples(std::mt19937& rng, std::vector<u16>& memory, int count) {
+  std::vector<SampleInfo> samples;
+  for (int i = 0; i < count; i++) {
+    auto& info = samples.emplace_back();
+    info.start = memory.size();
+    int num_blocks = 4 + rng() % 60;
+    bool repeat = rng() % 2;
+    for (int block = 0; block < num_blocks; block++) {
+      u16 header = (rng() % 13) | ((rng() % 5) << 4);
+      if (block == 0) {
+        header |= 1 << 10;  // loop start
+      }
+      if (block == num_blocks - 1) {
+        header |= 1 << 8;  // loop end
+        if (repeat) {
+          header |= 1 << 9;
+        }
+      }
+      memory.push_back(header);
+      for (int j = 0; j < 7; j++) {
+        memory.push_back(rng());
+      }
+    }
+  }
+  return samples;
+}
+
+// the same voice, in the synth for each mixer.
+struct VoicePair {
+  std::shared_ptr<snd::Voice> reference;
+  std::shared_ptr<snd::Voice> block;
+
+  template <typename F>
+  void apply(F&& f) {
+    f(*reference);
+    f(*block);
+  }
+};
+}  // namespace
+
+int main(int argc, char** argv) {
+  int num_voices = 48;
+  double seconds = 60;
+  u32 seed = 1;
+
+  CLI::App app{"989snd synth benchmark"};
+  app.add_option("-n,--voices", num_voices, "Number of voices playing at once, defaults to 48");
+  app.add_option("-s,--seconds", seconds, "Seconds of audio to render, defaults to 60");
+  app.add_option("--seed", seed, "Random seed");
+  CLI11_PARSE(app, argc, argv);
+
+  lg::initialize();
+
+  std::mt19937 rng(seed);
+  std::vector<u16> memory;
+  auto samples = make_samples(rng, memory, 64);
+
+  snd::Synth reference_synth, block_synth;
+  reference_synth.SetMasterVol(0x3ffff * 0x300 / 0x400);
+  block_synth.SetMasterVol(0x3ffff * 0x300 / 0x400);
+
+  int total_samples = (int)(seconds * SAMPLE_RATE);
+  std::vector<snd::s16Output> reference_out(total_samples);
+  std::vector<snd::s16Output> block_out(total_samples);
+  std::vector<VoicePair> voices;
+  double reference_time = 0, block_time = 0;
+
+  for (int pos = 0; pos < total_samples; pos += TICK_SAMPLES) {
+    // like a handler tick: start, stop and change voices.
+    voices.erase(std::remove_if(voices.begin(), voices.end(),
+                                [](VoicePair& v) { return v.reference->Dead(); }),
+                 voices.end());
+    for (auto& voice : voices) {
+      if (rng() % 50 == 0) {
+        voice.apply([](snd::Voice& v) { v.KeyOff(); });
+      } else if (rng() % 20 == 0) {
+        u16 pitch = 0x400 + rng() % 0x3c00;
+        voice.apply([&](snd::Voice& v) { v.SetPitch(pitch); });
+      }
+    }
+    while ((int)voices.size() < num_voices) {
+      auto& voice = voices.emplace_back();
+      voice.reference = std::make_shared<snd::Voice>();
+      voice.block = std::make_shared<snd::Voice>();
+      u32 start = samples[rng() % samples.size()].start;
+      u16 pitch = 0x400 + rng() % 0x3c00;
+      u16 adsr1 = rng(), adsr2 = rng();
+      // most volumes are fixed, some sweep.
+      u16 left = rng() % 4 ? rng() % 0x4000 : rng() | 0x8000;
+      u16 right = rng() % 4 ? rng() % 0x4000 : rng() | 0x8000;
+      voice.apply([&](snd::Voice& v) {
+        v.SetSample(memory.data());
+        v.SetSsa(start);
+        v.SetPitch(pitch);
+        v.SetAsdr1(adsr1);
+        v.SetAsdr2(adsr2);
+        v.SetVolume(left, right);
+        v.KeyOn();
+      });
+      reference_synth.AddVoice(voice.reference);
+      block_synth.AddVoice(voice.block);
+    }
+
+    int count = std::min(TICK_SAMPLES, total_samples - pos);
+    Timer reference_timer;
+    for (int i = 0; i < count; i++) {
+      reference_out[pos + i] = reference_synth.Tick();
+    }
+    reference_time += reference_timer.getSeconds();
+
+    Timer block_timer;
+    block_synth.Tick(block_out.data() + pos, count);
+    block_time += block_timer.getSeconds();
+  }
+
+  fmt::print("{:.1f} s of audio with {} voices\n", seconds, num_voices);
+  fmt::print("  per-sample: {:8.2f} ms ({:.0f}x realtime)\n", reference_time * 1000,
+             seconds / reference_time);
+  fmt::print("  block:      {:8.2f} ms ({:.0f}x realtime)\n", block_time * 1000,
+             seconds / block_time);
+
+  for (int i = 0; i < total_samples; i++) {
+    if (reference_out[i].left != block_out[i].left ||
+        reference_out[i].right != block_out[i].right) {
+      fmt::print("output differs at sample {}: {} {} vs {} {}\n", i, reference_out[i].left,
+                 reference_out[i].right, block_out[i].left, block_out[i].right);
+      return 1;
+    }
+  }
+  fmt::print("output is identical\n");
+  return 0;
+}
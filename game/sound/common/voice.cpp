@@ -4,6 +4,14 @@
 
 #include <array>
 
+#ifdef __aarch64__
+#include "third-party/sse2neon/sse2neon.h"
+#else
+#include <immintrin.h>
+#endif
+
+#include "common/util/Assert.h"
+
 namespace snd {
 #include "interp_table.inc"
 
@@ -102,9 +110,7 @@ void Voice::KeyOff() {
   // fmt::print("Key Off\n");
 }
 
-s16Output Voice::Run() {
-  DecodeSamples();
-
+s16 Voice::Interpolate() {
   u32 index = (mCounter & 0x0FF0) >> 4;
 
   s16 sample = 0;
@@ -112,7 +118,10 @@ s16Output Voice::Run() {
   sample = static_cast<s16>(sample + ((mDecodeBuf.Peek(1) * interp_table[index][1]) >> 15));
   sample = static_cast<s16>(sample + ((mDecodeBuf.Peek(2) * interp_table[index][2]) >> 15));
   sample = static_cast<s16>(sample + ((mDecodeBuf.Peek(3) * interp_table[index][3]) >> 15));
+  return sample;
+}
 
+void Voice::AdvancePitch() {
   s32 step = mPitch;
   step = std::min(step, 0x3FFF);
   mCounter += step;
@@ -124,6 +133,12 @@ s16Output Voice::Run() {
     steps--;
     mDecodeBuf.Pop();
   }
+}
+
+s16Output Voice::Run() {
+  DecodeSamples();
+  s16 sample = Interpolate();
+  AdvancePitch();
 
   sample = ApplyVolume(sample, mADSR.Level());
   s16 left = ApplyVolume(sample, mVolume.left.GetCurrent());
@@ -134,4 +149,59 @@ s16Output Voice::Run() {
 
   return s16Output{left, right};
 }
+
+// ApplyVolume for 8 samples: the 32-bit product shifted right by 15, truncated to 16 bits.
+static __m128i ApplyVolume8(__m128i sample, __m128i volume) {
+  __m128i lo = _mm_mullo_epi16(sample, volume);
+  __m128i hi = _mm_mulhi_epi16(sample, volume);
+  return _mm_or_si128(_mm_slli_epi16(hi, 1), _mm_srli_epi16(lo, 15));
+}
+
+/*!
+ * Render a block of samples, with the same result as calling Run() for each sample. If the voice
+ * dies, the rest of the block is silent and the voice isn't advanced, like the synth would have
+ * removed it.
+ *
+ * Decoding, interpolation and the envelopes depend on the previous sample, so they are done one
+ * sample at a time first. The volumes are then applied to the whole block with SIMD.
+ */
+void Voice::Run(s16Output* out, int samples) {
+  ASSERT(samples <= MAX_BLOCK_SIZE);
+  alignas(16) s16 raw[MAX_BLOCK_SIZE];
+  alignas(16) s16 env[MAX_BLOCK_SIZE];
+  alignas(16) s16 vol_left[MAX_BLOCK_SIZE];
+  alignas(16) s16 vol_right[MAX_BLOCK_SIZE];
+
+  int count = 0;
+  while (count < samples && !Dead()) {
+    DecodeSamples();
+    raw[count] = Interpolate();
+    AdvancePitch();
+
+    env[count] = mADSR.Level();
+    vol_left[count] = mVolume.left.GetCurrent();
+    vol_right[count] = mVolume.right.GetCurrent();
+    count++;
+
+    mADSR.Run();
+    mVolume.Run();
+  }
+
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m128i sample = ApplyVolume8(_mm_load_si128((const __m128i*)(raw + i)),
+                                  _mm_load_si128((const __m128i*)(env + i)));
+    __m128i left = ApplyVolume8(sample, _mm_load_si128((const __m128i*)(vol_left + i)));
+    __m128i right = ApplyVolume8(sample, _mm_load_si128((const __m128i*)(vol_right + i)));
+    _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi16(left, right));
+    _mm_storeu_si128((__m128i*)(out + i + 4), _mm_unpackhi_epi16(left, right));
+  }
+  for (; i < count; i++) {
+    s16 sample = ApplyVolume(raw[i], env[i]);
+    out[i] = s16Output{ApplyVolume(sample, vol_left[i]), ApplyVolume(sample, vol_right[i])};
+  }
+  for (; i < samples; i++) {
+    out[i] = s16Output{};
+  }
+}
 }  // namespace snd
@@ -17,8 +17,12 @@ class Voice {
     Permanent,
   };
 
+  // the largest number of samples rendered by a single call to Run(out, samples)
+  static constexpr int MAX_BLOCK_SIZE = 256;
+
   Voice(AllocationType alloc = AllocationType::Managed) : mAlloc(alloc) {}
   s16Output Run();
+  void Run(s16Output* out, int samples);
 
   void KeyOn();
 
@@ -89,6 +93,8 @@ class Voice {
 
   void DecodeSamples();
   void UpdateBlockHeader();
+  s16 Interpolate();
+  void AdvancePitch();
 
   fifo<s16, 0x20> mDecodeBuf{};
   s16 mDecodeHist1{0};
@@ -1,6 +1,7 @@
 #include "SystemThread.h"
 
 #include "common/common_types.h"
+#include "common/global_profiler/GlobalProfiler.h"
 #include "common/log/log.h"
 #include "common/util/unicode_util.h"
 
@@ -104,6 +105,7 @@ void* bootstrap_thread_func(void* x) {
 #else
   SetThreadDescription(GetCurrentThread(), (LPCWSTR)utf8_string_to_wide_string(thd->name).c_str());
 #endif
+  prof().set_thread_name(thd->name);
 
   thd->function(iface);
   lg::debug("[SYSTEM] Thread {} is returning", thd->name.c_str());
@@ -1,43 +1,52 @@
 #include "background_worker.h"
 
 #include "common/log/log.h"
+#include "common/util/FileUtil.h"
 
 #include "curl/curl.h"
 
 bool BackgroundWorker::process_queues() {
   std::lock_guard<std::mutex> job_lock(job_queue_lock);
-  // Copy over anything in the inbox into the main job queue
-  // - this is a very fast operation
-  {
-    std::lock_guard<std::mutex> inbox_lock(inbox_queue_lock);
-    // Return early if there is nothing to process
-    if (inbox_queue.empty() && job_queue.empty()) {
-      return false;
+  bool processed = false;
+  // Process the queues until they're empty, one job at a time
+  while (true) {
+    // Copy over anything in the inbox into the job queues
+    // - this is a very fast operation
+    // This is done before every job, so a save queued while a slow job runs goes next.
+    {
+      std::lock_guard<std::mutex> inbox_lock(inbox_queue_lock);
+      while (!inbox_queue.empty()) {
+        auto& job = inbox_queue.front();
+        auto& queue = job.type == JobType::SAVE_FILE ? save_queue : job_queue;
+        queue.push(std::move(job));
+        inbox_queue.pop();
+      }
     }
-    while (!inbox_queue.empty()) {
-      const auto& job = inbox_queue.front();
-      job_queue.push(job);
-      inbox_queue.pop();
-    }
-  }
 
-  // Process actual job queue now
-  // - this is potentially a very slow operation!
-  // Process the queue until it's empty
-  while (!job_queue.empty()) {
-    const auto& job = job_queue.front();
-    switch (job.type) {
-      case JobType::WEB_REQUEST:
-        job_web_request(std::get<WebRequestJobPayload>(job.payload));
-        break;
-      default:
-        lg::error("[Job] Unsupported job type!");
-        break;
+    auto& queue = save_queue.empty() ? job_queue : save_queue;
+    // Return if there is nothing to process
+    if (queue.empty()) {
+      return processed;
     }
+    // - this is potentially a very slow operation!
+    run_job(queue.front());
+    queue.pop();
+    processed = true;
+  }
+}
 
-    job_queue.pop();
+void BackgroundWorker::run_job(BackgroundJob& job) {
+  switch (job.type) {
+    case JobType::WEB_REQUEST:
+      job_web_request(std::get<WebRequestJobPayload>(job.payload));
+      break;
+    case JobType::SAVE_FILE:
+      job_save_file(std::move(std::get<SaveFileJobPayload>(job.payload)));
+      break;
+    default:
+      lg::error("[Job] Unsupported job type!");
+      break;
   }
-  return true;
 }
 
 void BackgroundWorker::enqueue_webrequest(WebRequestJobPayload payload) {
@@ -45,6 +54,11 @@ void BackgroundWorker::enqueue_webrequest(WebRequestJobPayload payload) {
   inbox_queue.push({JobType::WEB_REQUEST, payload});
 }
 
+void BackgroundWorker::enqueue_save_file(SaveFileJobPayload payload) {
+  std::lock_guard<std::mutex> inbox_lock(inbox_queue_lock);
+  inbox_queue.push({JobType::SAVE_FILE, std::move(payload)});
+}
+
 static size_t WriteCallback(void* contents, size_t size, size_t nmemb, void* userp) {
   ((std::string*)userp)->append((char*)contents, size * nmemb);
   return size * nmemb;
@@ -81,3 +95,15 @@ void BackgroundWorker::job_web_request(WebRequestJobPayload payload) {
     }
   }
 }
+
+void BackgroundWorker::job_save_file(SaveFileJobPayload payload) {
+  bool ok = false;
+  try {
+    file_util::create_dir_if_needed_for_file(payload.path);
+    ok = file_util::write_binary_file_atomic(payload.path, payload.data.data(),
+                                             payload.data.size());
+  } catch (const std::exception& e) {
+    lg::error("[Job:SaveFile]: Error: {}", e.what());
+  }
+  payload.callback(ok);
+}
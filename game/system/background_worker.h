@@ -5,6 +5,9 @@
 #include <queue>
 #include <string>
 #include <variant>
+#include <vector>
+
+#include "common/common_types.h"
 
 // This is intended to be a general purpose worker which is processed by a separate thread
 //
@@ -12,7 +15,7 @@
 // but since you cannot spawn new threads directly in the EE without causing problems
 // you can delegate to this worker, managed by a separate worker thread `ee_worker_thread`.
 
-enum class JobType { WEB_REQUEST };
+enum class JobType { WEB_REQUEST, SAVE_FILE };
 
 struct WebRequestJobPayload {
   JobType type = JobType::WEB_REQUEST;
@@ -21,9 +24,18 @@ struct WebRequestJobPayload {
   std::function<void(bool, std::string cache_id, std::optional<std::string>)> callback;
 };
 
+// Writes data to a file with file_util::write_binary_file_atomic, then calls the callback with
+// whether it worked. The callback runs on the worker thread.
+struct SaveFileJobPayload {
+  JobType type = JobType::SAVE_FILE;
+  std::string path;
+  std::vector<u8> data;
+  std::function<void(bool)> callback;
+};
+
 struct BackgroundJob {
   JobType type;
-  std::variant<WebRequestJobPayload> payload;
+  std::variant<WebRequestJobPayload, SaveFileJobPayload> payload;
 };
 
 // TODO - consider adding some sort of job tracking / polling if required
@@ -36,6 +48,8 @@ class BackgroundWorker {
   // queue while it's being quickly copied over to the main queue
   std::queue<BackgroundJob> inbox_queue;
   std::queue<BackgroundJob> job_queue;
+  // saves run before everything else, so the game isn't stuck waiting on web requests to save.
+  std::queue<BackgroundJob> save_queue;
   std::mutex inbox_queue_lock;
   std::mutex job_queue_lock;
 
@@ -43,7 +57,10 @@ class BackgroundWorker {
   bool process_queues();
 
   void enqueue_webrequest(WebRequestJobPayload payload);
+  void enqueue_save_file(SaveFileJobPayload payload);
 
  private:
+  void run_job(BackgroundJob& job);
   void job_web_request(WebRequestJobPayload payload);
+  void job_save_file(SaveFileJobPayload payload);
 };
@@ -0,0 +1,141 @@
+#include "gl_stub.h"
+
+#include <cstring>
+#include <type_traits>
+
+#include "third-party/glad/include/glad/glad.h"
+
+namespace {
+
+GLuint g_next_object_id = 1;
+
+/*!
+ * Used for every function that doesn't need a specific stub. There's one for each signature, so
+ * it's always called through the right function type.
+ */
+template <typename R, typename... Args>
+R APIENTRY stub_default(Args...) {
+  if constexpr (!std::is_void_v<R>) {
+    return R();
+  }
+}
+
+template <typename R, typename... Args>
+void set_default_stub(R(APIENTRYP& func)(Args...)) {
+  if (!func) {
+    func = stub_default<R, Args...>;
+  }
+}
+
+const GLubyte* APIENTRY stub_get_string(GLenum name) {
+  return (const GLubyte*)(name == GL_VERSION ? "4.3.0 stub" : "stub");
+}
+
+const GLubyte* APIENTRY stub_get_stringi(GLenum /*name*/, GLuint /*index*/) {
+  return (const GLubyte*)"GL_stub";
+}
+
+void APIENTRY stub_get_integerv(GLenum pname, GLint* data) {
+  switch (pname) {
+    case GL_VIEWPORT:
+      data[0] = 0;
+      data[1] = 0;
+      data[2] = 640;
+      data[3] = 480;
+      break;
+    case GL_MAX_SAMPLES:
+      data[0] = 8;
+      break;
+    case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT:
+      data[0] = 256;
+      break;
+    case GL_NUM_EXTENSIONS:
+      data[0] = 1;
+      break;
+    default:
+      data[0] = 0;
+      break;
+  }
+}
+
+void APIENTRY stub_get_floatv(GLenum pname, GLfloat* data) {
+  data[0] = pname == GL_MAX_TEXTURE_MAX_ANISOTROPY ? 16.f : 0.f;
+}
+
+// glGetShaderiv and glGetProgramiv, only used to check compile and link status.
+void APIENTRY stub_get_object_iv(GLuint /*object*/, GLenum /*pname*/, GLint* params) {
+  params[0] = GL_TRUE;
+}
+
+void APIENTRY stub_get_tex_level_parameteriv(GLenum /*target*/,
+                                             GLint /*level*/,
+                                             GLenum /*pname*/,
+                                             GLint* params) {
+  params[0] = 0;
+}
+
+GLenum APIENTRY stub_check_framebuffer_status(GLenum /*target*/) {
+  return GL_FRAMEBUFFER_COMPLETE;
+}
+
+GLuint APIENTRY stub_create_shader(GLenum /*type*/) {
+  return g_next_object_id++;
+}
+
+GLuint APIENTRY stub_create_program() {
+  return g_next_object_id++;
+}
+
+void APIENTRY stub_gen(GLsizei n, GLuint* ids) {
+  for (GLsizei i = 0; i < n; i++) {
+    ids[i] = g_next_object_id++;
+  }
+}
+
+void* stub_loader(const char* name) {
+  struct Stub {
+    const char* name;
+    void* func;
+  };
+  static const Stub stubs[] = {
+      {"glGetString", (void*)stub_get_string},
+      {"glGetStringi", (void*)stub_get_stringi},
+      {"glGetIntegerv", (void*)stub_get_integerv},
+      {"glGetFloatv", (void*)stub_get_floatv},
+      {"glGetShaderiv", (void*)stub_get_object_iv},
+      {"glGetProgramiv", (void*)stub_get_object_iv},
+      {"glGetTexLevelParameteriv", (void*)stub_get_tex_level_parameteriv},
+      {"glCheckFramebufferStatus", (void*)stub_check_framebuffer_status},
+      {"glCreateShader", (void*)stub_create_shader},
+      {"glCreateProgram", (void*)stub_create_program},
+      {"glGenBuffers", (void*)stub_gen},
+      {"glGenTextures", (void*)stub_gen},
+      {"glGenVertexArrays", (void*)stub_gen},
+      {"glGenFramebuffers", (void*)stub_gen},
+      {"glGenRenderbuffers", (void*)stub_gen},
+      {"glGenQueries", (void*)stub_gen},
+      {"glGenSamplers", (void*)stub_gen},
+  };
+  for (const auto& stub : stubs) {
+    if (!strcmp(stub.name, name)) {
+      return stub.func;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+/*!
+ * Point all OpenGL functions at stubs. Objects get unique ids, queries return plausible values,
+ * and everything else does nothing.
+ */
+bool load_gl_stubs() {
+  if (!gladLoadGLLoader(stub_loader) || GLVersion.major != 4) {
+    return false;
+  }
+#define GL_STUB(name) set_default_stub(glad_##name);
+#include "gl_stub_functions.inc"
+#undef GL_STUB
+  return true;
+}
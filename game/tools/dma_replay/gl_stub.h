@@ -0,0 +1,9 @@
+#pragma once
+
+/*!
+ * @file gl_stub.h
+ * Fill in the OpenGL function pointers with functions that do nothing, so the renderer can run
+ * without a GPU or a window.
+ */
+
+bool load_gl_stubs();
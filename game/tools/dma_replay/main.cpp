@@ -0,0 +1,163 @@
+/*!
+ * @file main.cpp
+ * Replay a frame captured with "Capture DMA Next Frame" through the renderer, with OpenGL stubbed
+ * out, and report how much CPU time each bucket takes. This runs without a GPU or a window, so
+ * renderer changes can be measured on any machine.
+ */
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "common/dma/dma_capture.h"
+#include "common/dma/dma_chain_read.h"
+#include "common/goal_constants.h"
+#include "common/log/log.h"
+#include "common/util/FileUtil.h"
+#include "common/util/unicode_util.h"
+
+#include "game/graphics/opengl_renderer/OpenGLRenderer.h"
+#include "game/graphics/opengl_renderer/loader/Loader.h"
+#include "game/graphics/texture/TexturePool.h"
+#include "game/kernel/common/kscheme.h"
+#include "game/runtime.h"
+#include "game/tools/dma_replay/gl_stub.h"
+
+#include "fmt/core.h"
+#include "third-party/CLI11.hpp"
+#include "third-party/imgui/imgui.h"
+
+namespace {
+constexpr PerGameVersion<int> fr3_level_count(jak1::LEVEL_TOTAL,
+                                              jak2::LEVEL_TOTAL,
+                                              jak3::LEVEL_TOTAL);
+
+struct BucketTime {
+  std::string name;
+  double total_ms = 0;
+  double max_ms = 0;
+};
+
+void add_times(const ProfilerNode& node, std::vector<BucketTime>& times) {
+  for (const auto& child : node.children()) {
+    auto it = std::find_if(times.begin(), times.end(),
+                           [&](const BucketTime& t) { return t.name == child.name(); });
+    if (it == times.end()) {
+      it = times.insert(times.end(), BucketTime{child.name()});
+    }
+    double ms = child.stats().duration * 1000;
+    it->total_ms += ms;
+    it->max_ms = std::max(it->max_ms, ms);
+  }
+}
+
+const ProfilerNode* find_child(const ProfilerNode& node, const std::string& name) {
+  for (const auto& child : node.children()) {
+    if (child.name() == name) {
+      return &child;
+    }
+  }
+  return nullptr;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  ArgumentGuard u8_guard(argc, argv);
+
+  fs::path capture_path;
+  int num_frames = 100;
+  bool skip_levels = false;
+  bool show_empty = false;
+
+  lg::initialize();
+
+  CLI::App app{"OpenGOAL DMA Replay"};
+  app.add_option("capture-path", capture_path, "The path to the .dmacap file to replay")
+      ->required();
+  app.add_option("-n,--frames", num_frames, "Number of times to render the frame, defaults to 100");
+  app.add_flag("--no-levels", skip_levels, "Don't load the levels that were loaded in the capture");
+  app.add_flag("--show-empty", show_empty, "Also report buckets that took no time");
+  app.validate_positionals();
+  CLI11_PARSE(app, argc, argv);
+
+  auto ok = file_util::setup_project_path({});
+  if (!ok) {
+    lg::error("couldn't setup project path, exiting");
+    return 1;
+  }
+
+  lg::info("Loading capture from '{}'", capture_path.string());
+  auto capture = read_dma_capture(capture_path);
+  std::vector<u8> memory(capture.memory_size);
+  capture.restore_memory(memory.data());
+
+  // the renderer reads these from the runtime.
+  g_game_version = capture.version;
+  g_ee_main_mem = memory.data();
+  s7.offset = capture.s7_offset;
+
+  if (!load_gl_stubs()) {
+    lg::error("couldn't load OpenGL stubs, exiting");
+    return 1;
+  }
+  // a few renderers draw debug windows, so give them a context.
+  ImGui::CreateContext();
+  ImGui::GetIO().DisplaySize = ImVec2(640, 480);
+  ImGui::GetIO().Fonts->Build();
+
+  auto texture_pool = std::make_shared<TexturePool>(capture.version);
+  auto loader = std::make_shared<Loader>(
+      file_util::get_jak_project_dir() / "out" / game_version_names[capture.version] / "fr3",
+      fr3_level_count[capture.version]);
+  OpenGLRenderer renderer(texture_pool, loader, capture.version);
+
+  if (!skip_levels && !capture.levels.empty()) {
+    lg::info("Loading levels: {}", fmt::join(capture.levels, ", "));
+    loader->set_want_levels(capture.levels);
+    loader->update_blocking(*texture_pool);
+  }
+  loader->set_active_levels(capture.active_levels);
+
+  RenderOptions options;
+  options.window_framebuffer_width = options.game_res_w;
+  options.window_framebuffer_height = options.game_res_h;
+  options.draw_region_width = options.game_res_w;
+  options.draw_region_height = options.game_res_h;
+  options.pmode_alp_register = capture.pmode_alp;
+
+  std::vector<BucketTime> steps;
+  std::vector<BucketTime> buckets;
+  double total_ms = 0;
+  // the first frame does one-time setup, so it isn't counted.
+  for (int i = 0; i < num_frames + 1; i++) {
+    ImGui::NewFrame();
+    renderer.render(DmaFollower(memory.data(), capture.chain_offset), options);
+    ImGui::EndFrame();
+    if (i == 0) {
+      continue;
+    }
+
+    const auto* root = renderer.profiler().root();
+    total_ms += root->stats().duration * 1000;
+    add_times(*root, steps);
+    if (const auto* bucket_node = find_child(*root, "buckets")) {
+      add_times(*bucket_node, buckets);
+    }
+  }
+
+  fmt::print("{} frames, {:.3f} ms per frame\n\n", num_frames, total_ms / num_frames);
+  fmt::print("{:40s} {:>10s} {:>10s}\n", "step", "avg ms", "max ms");
+  for (const auto& step : steps) {
+    fmt::print("{:40s} {:10.3f} {:10.3f}\n", step.name, step.total_ms / num_frames, step.max_ms);
+  }
+  fmt::print("\n{:40s} {:>10s} {:>10s}\n", "bucket", "avg ms", "max ms");
+  for (const auto& bucket : buckets) {
+    if (show_empty || bucket.max_ms >= 0.001) {
+      fmt::print("{:40s} {:10.3f} {:10.3f}\n", bucket.name, bucket.total_ms / num_frames,
+                 bucket.max_ms);
+    }
+  }
+
+  ImGui::DestroyContext();
+  return 0;
+}
@@ -0,0 +1,279 @@
+/*!
+ * @file main.cpp
+ * Benchmark the kernel's format function on the format strings in the Jak 1 GOAL source, against
+ * the old format that parsed the string on every call, with the format cache on and off, and the
+ * integer and float printing it uses. Arguments are made up from
+ * the directives in each string: small integers, floats in +/-1000 and bintegers for objects.
+ * This runs the kernel format code without the rest of the game.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "common/goal_constants.h"
+#include "common/listener_common.h"
+#include "common/log/log.h"
+#include "common/symbols.h"
+#include "common/util/FileUtil.h"
+#include "common/util/Timer.h"
+#include "common/util/unicode_util.h"
+
+#include "game/kernel/common/kboot.h"
+#include "game/kernel/common/klisten.h"
+#include "game/kernel/common/kmalloc.h"
+#include "game/kernel/common/kprint.h"
+#include "game/kernel/common/kscheme.h"
+#include "game/kernel/common/memory_layout.h"
+#include "game/kernel/jak1/kprint.h"
+#include "game/tools/format_bench/old_format.h"
+
+#include "fmt/core.h"
+#include "third-party/CLI11.hpp"
+
+namespace {
+constexpr u32 MEMORY_SIZE = 64 * 1024 * 1024;
+constexpr int MAX_FORMAT_ARGS = 8;
+
+struct FormatCall {
+  u32 format;  // GOAL string
+  u64 args[MAX_FORMAT_ARGS] = {};
+};
+
+/*!
+ * Find the string literals passed to format in GOAL source.
+ */
+std::vector<std::string> find_format_strings(const fs::path& source_dir) {
+  const std::regex format_call(R"re(\(format\s+[^\s()"]+\s+"((?:[^"\\]|\\.)*)\")re");
+  std::vector<std::string> result;
+  for (const auto& path : file_util::find_files_recursively(source_dir, std::regex(".*\\.gc"))) {
+    auto text = file_util::read_text_file(path);
+    for (auto it = std::sregex_iterator(text.begin(), text.end(), format_call);
+         it != std::sregex_iterator(); ++it) {
+      std::string str;
+      const std::string escaped = (*it)[1];
+      for (size_t i = 0; i < escaped.size(); i++) {
+        if (escaped[i] == '\\' && i + 1 < escaped.size()) {
+          i++;
+          str.push_back(escaped[i] == 'n' ? '\n' : escaped[i] == 't' ? '\t' : escaped[i]);
+        } else {
+          str.push_back(escaped[i]);
+        }
+      }
+      result.push_back(str);
+    }
+  }
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+  return result;
+}
+
+/*!
+ * Set up just enough of the kernel for format: a heap, the print buffer, and an empty symbol table.
+ */
+void setup_kernel() {
+  MasterDebug = 1;
+  g_game_version = GameVersion::Jak1;
+  kmalloc_init_globals_common();
+  kprint_init_globals_common();
+  kinitheap(kdebugheap, Ptr<u8>(HEAP_START), MEMORY_SIZE - HEAP_START);
+  init_output();
+  s7 = kmalloc(kdebugheap, 0x1000, KMALLOC_MEMSET, "symbol-table").cast<u32>() + BASIC_OFFSET;
+  print_column = kmalloc(kdebugheap, 16, KMALLOC_MEMSET, "print-column").cast<u32>();
+}
+
+/*!
+ * Make a GOAL string. The type isn't set, format doesn't check it.
+ */
+u32 make_goal_string(const std::string& str) {
+  auto mem = kmalloc(kdebugheap, str.size() + 9, KMALLOC_MEMSET, "format-string");
+  *(mem + 4).cast<u32>() = str.size();
+  memcpy((mem + 8).c(), str.c_str(), str.size() + 1);
+  return mem.offset + BASIC_OFFSET;
+}
+
+/*!
+ * Make arguments for the directives in a format string. Returns false for strings that can't be
+ * run without the rest of the game: types by name, unknown codes, or too many arguments.
+ */
+bool make_call(const char* str, u32 c_string, std::mt19937& rng, FormatCall* call) {
+  FormatProgram program;
+  compile_format(str, &program);
+  int arg = 0;
+  for (const auto& op : program) {
+    if (op.kind == FormatOp::Kind::BAD_CODE) {
+      return false;
+    }
+    if (op.kind != FormatOp::Kind::DIRECTIVE) {
+      continue;
+    }
+    if (arg == MAX_FORMAT_ARGS) {
+      return false;
+    }
+    switch (op.code) {
+      case 'D':
+      case 'd':
+      case 'X':
+      case 'x':
+      case 'B':
+      case 'b':
+        call->args[arg++] = (s64)(rng() % 2000) - 1000;
+        break;
+      case 'E':
+      case 'e':
+        call->args[arg++] = rng() % 100000;
+        break;
+      case 'F':
+      case 'f':
+      case 'R':
+      case 'r':
+      case 'M':
+      case 'm': {
+        float f = std::uniform_real_distribution<float>(-1000.f, 1000.f)(rng);
+        u32 bits;
+        memcpy(&bits, &f, sizeof(float));
+        call->args[arg++] = bits;
+      } break;
+      case 'C':
+      case 'c':
+        call->args[arg++] = 'a' + rng() % 26;
+        break;
+      case 'G':
+      case 'g':
+        call->args[arg++] = c_string;
+        break;
+      case 'A':
+      case 'a':
+      case 'S':
+      case 's':
+        call->args[arg++] = (rng() % 1000) << 3;  // binteger
+        break;
+      case 'P':
+      case 'p':
+      case 'I':
+      case 'i':
+        if (op.arg0 != -1) {
+          return false;
+        }
+        call->args[arg++] = (rng() % 1000) << 3;
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+using FormatFunction = s32 (*)(u64*);
+
+std::string run_call(const FormatCall& call, FormatFunction format) {
+  u64 regs[2 + MAX_FORMAT_ARGS];
+  regs[0] = s7.offset + jak1_symbols::FIX_SYM_TRUE;
+  regs[1] = call.format;
+  memcpy(regs + 2, call.args, sizeof(call.args));
+  clear_print();
+  format(regs);
+  return PrintBufArea.cast<char>().c() + sizeof(ListenerMessageHeader);
+}
+
+double run_calls(const std::vector<FormatCall>& calls, int runs, FormatFunction format) {
+  u64 regs[2 + MAX_FORMAT_ARGS];
+  regs[0] = s7.offset + jak1_symbols::FIX_SYM_TRUE;
+  Timer timer;
+  for (int run = 0; run < runs; run++) {
+    for (const auto& call : calls) {
+      regs[1] = call.format;
+      memcpy(regs + 2, call.args, sizeof(call.args));
+      clear_print();
+      format(regs);
+    }
+  }
+  return (double)timer.getNs() / (runs * calls.size());
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  ArgumentGuard u8_guard(argc, argv);
+
+  int num_runs = 100;
+
+  lg::initialize();
+
+  CLI::App app{"OpenGOAL format Benchmark"};
+  app.add_option("-n,--runs", num_runs, "Number of times to format each string, defaults to 100");
+  app.validate_positionals();
+  CLI11_PARSE(app, argc, argv);
+  num_runs = std::max(num_runs, 1);
+
+  auto ok = file_util::setup_project_path({});
+  if (!ok) {
+    lg::error("couldn't setup project path, exiting");
+    return 1;
+  }
+
+  auto strings = find_format_strings(file_util::get_jak_project_dir() / "goal_src" / "jak1");
+  std::vector<u8> memory(MEMORY_SIZE);
+  g_ee_main_mem = memory.data();
+  setup_kernel();
+
+  u32 c_string = kmalloc(kdebugheap, 16, 0, "c-string").offset;
+  strcpy(Ptr<char>(c_string).c(), "c-string");
+
+  std::mt19937 rng(0);
+  std::vector<FormatCall> calls;
+  for (const auto& str : strings) {
+    FormatCall call;
+    if (!make_call(str.c_str(), c_string, rng, &call)) {
+      continue;
+    }
+    call.format = make_goal_string(str);
+    calls.push_back(call);
+  }
+  fmt::print("{} format strings, running {}\n", strings.size(), calls.size());
+  if (calls.empty()) {
+    return 1;
+  }
+
+  int mismatches = 0;
+  for (const auto& call : calls) {
+    if (run_call(call, old_format_impl_jak1) != run_call(call, format_impl_jak1)) {
+      mismatches++;
+    }
+  }
+  if (mismatches) {
+    fmt::print("{} format strings give different output than the old format\n", mismatches);
+  }
+
+  double old_ns = run_calls(calls, num_runs, old_format_impl_jak1);
+  gFormatCacheEnabled = false;
+  double uncached_ns = run_calls(calls, num_runs, format_impl_jak1);
+  gFormatCacheEnabled = true;
+  double cached_ns = run_calls(calls, num_runs, format_impl_jak1);
+  fmt::print("format: {:.1f} ns per call with the old format, {:.1f} ns with the cache on, {:.1f} "
+             "ns with it off\n",
+             old_ns, cached_ns, uncached_ns);
+
+  // the numbers alone, with the same kind of values.
+  char buffer[128];
+  std::vector<s64> ints;
+  std::vector<float> floats;
+  for (int i = 0; i < 100000; i++) {
+    ints.push_back((s64)(rng() % 2000) - 1000);
+    floats.push_back(std::uniform_real_distribution<float>(-1000.f, 1000.f)(rng));
+  }
+  Timer timer;
+  for (auto x : ints) {
+    kitoa(buffer, x, 10, -1, ' ', 0);
+  }
+  double kitoa_ns = (double)timer.getNs() / ints.size();
+  timer.start();
+  for (auto x : floats) {
+    ftoa(buffer, x, 12, ' ', 4, 0);
+  }
+  double ftoa_ns = (double)timer.getNs() / floats.size();
+  fmt::print("kitoa: {:.1f} ns per call, ftoa: {:.1f} ns per call\n", kitoa_ns, ftoa_ns);
+  return 0;
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "common/common_types.h"
+
+s32 old_format_impl_jak1(u64* args);
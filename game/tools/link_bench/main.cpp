@@ -0,0 +1,158 @@
+/*!
+ * @file main.cpp
+ * Benchmark the Jak 1 kernel's linker on the objects in DGO files, with the host-side symbol index
+ * that find_symbol_from_c uses on and off. The DGOs are linked in order into an empty symbol
+ * table, like the game loads them, but top-level code isn't run, so this works without the rest
+ * of the game.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/goal_constants.h"
+#include "common/log/log.h"
+#include "common/symbols.h"
+#include "common/util/DgoReader.h"
+#include "common/util/FileUtil.h"
+#include "common/util/Timer.h"
+#include "common/util/unicode_util.h"
+
+#include "game/kernel/common/kboot.h"
+#include "game/kernel/common/kmalloc.h"
+#include "game/kernel/common/kprint.h"
+#include "game/kernel/common/kscheme.h"
+#include "game/kernel/common/memory_layout.h"
+#include "game/kernel/jak1/klink.h"
+#include "game/kernel/jak1/kscheme.h"
+#include "game/mips2c/mips2c_table.h"
+
+#include "fmt/core.h"
+#include "third-party/CLI11.hpp"
+
+using namespace jak1_symbols;
+
+namespace {
+/*!
+ * Set up just enough of the kernel for the linker: the heaps, and a symbol table with the types
+ * and symbols that are needed to make new types and symbols.
+ */
+void setup_kernel() {
+  MasterDebug = 1;
+  g_game_version = GameVersion::Jak1;
+  kmalloc_init_globals_common();
+  kprint_init_globals_common();
+  jak1::kscheme_init_globals();
+  Mips2C::gLinkedFunctionTable = {};
+
+  const u32 heap_size = (EE_MAIN_MEM_SIZE - HEAP_START) / 2;
+  kinitheap(kglobalheap, Ptr<u8>(HEAP_START), heap_size);
+  kinitheap(kdebugheap, Ptr<u8>(HEAP_START + heap_size), heap_size);
+  init_output();
+  init_crc();
+
+  auto symbol_table =
+      kmalloc(kglobalheap, jak1::SYM_TABLE_MEM_SIZE, KMALLOC_MEMSET, "symbol-table").cast<u32>();
+  s7 = symbol_table + (jak1::GOAL_MAX_SYMBOLS / 2) * 8 + BASIC_OFFSET;
+  SymbolTable2 = symbol_table + BASIC_OFFSET;
+  LastSymbol = symbol_table + jak1::SYM_TABLE_END * 8;
+  NumSymbols = 0;
+
+  *(s7 + FIX_SYM_EMPTY_CAR) = (s7 + FIX_SYM_EMPTY_PAIR).offset;
+  *(s7 + FIX_SYM_EMPTY_CDR) = (s7 + FIX_SYM_EMPTY_PAIR).offset;
+  *(s7 + FIX_SYM_GLOBAL_HEAP) = kglobalheap.offset;
+  jak1::alloc_and_init_type((s7 + FIX_SYM_TYPE_TYPE).cast<jak1::Symbol>(), 9);
+  jak1::alloc_and_init_type((s7 + FIX_SYM_SYMBOL_TYPE).cast<jak1::Symbol>(), 9);
+  jak1::alloc_and_init_type((s7 + FIX_SYM_STRING_TYPE).cast<jak1::Symbol>(), 9);
+  jak1::alloc_and_init_type((s7 + FIX_SYM_FUNCTION_TYPE).cast<jak1::Symbol>(), 9);
+  jak1::set_fixed_symbol(FIX_SYM_FALSE, "#f", s7.offset + FIX_SYM_FALSE);
+  jak1::set_fixed_symbol(FIX_SYM_TRUE, "#t", s7.offset + FIX_SYM_TRUE);
+  jak1::set_fixed_symbol(FIX_SYM_GLOBAL_HEAP, "global", kglobalheap.offset);
+  // the linker changes this when it keeps debug segments.
+  EnableMethodSet = jak1::intern_from_c("*enable-method-set*").cast<u32>();
+}
+
+/*!
+ * Link all objects of the DGOs in order, on a new symbol table. Returns the seconds spent in the
+ * linker for each DGO.
+ */
+std::vector<double> link_dgos(const std::vector<std::unique_ptr<DgoReader>>& dgos,
+                              bool use_index) {
+  setup_kernel();
+  jak1::g_symbol_hash_table_enabled = use_index;
+  std::vector<double> result;
+  for (const auto& dgo : dgos) {
+    double seconds = 0;
+    for (const auto& entry : dgo->entries()) {
+      // the object is loaded to the top of the heap, like load_and_link_dgo_from_c does.
+      Ptr<u8> obj((kglobalheap->current + 0x3f).offset & 0xffffffc0);
+      memcpy(obj.c(), entry.data.data(), entry.data.size());
+      Timer timer;
+      jak1::link_and_exec(obj, entry.internal_name.c_str(), entry.data.size(), kglobalheap, 0,
+                          false);
+      seconds += timer.getSeconds();
+    }
+    result.push_back(seconds);
+  }
+  jak1::g_symbol_hash_table_enabled = true;
+  return result;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  ArgumentGuard u8_guard(argc, argv);
+
+  std::vector<fs::path> dgo_paths;
+  int num_runs = 10;
+
+  // the linker logs each object at debug level.
+  lg::set_stdout_level(lg::level::info);
+  lg::initialize();
+
+  CLI::App app{"OpenGOAL Link Benchmark"};
+  app.add_option("dgos", dgo_paths, "Jak 1 DGO files to link, in load order")->required();
+  app.add_option("-n,--runs", num_runs, "Number of times to link the DGOs, defaults to 10");
+  app.validate_positionals();
+  CLI11_PARSE(app, argc, argv);
+  num_runs = std::max(num_runs, 1);
+
+  std::vector<std::unique_ptr<DgoReader>> dgos;
+  for (const auto& path : dgo_paths) {
+    if (!fs::exists(path)) {
+      lg::error("DGO file {} doesn't exist", path.string());
+      return 1;
+    }
+    dgos.push_back(std::make_unique<DgoReader>(path.filename().string(),
+                                               file_util::read_binary_file(path)));
+  }
+
+  std::vector<u8> memory(EE_MAIN_MEM_SIZE);
+  g_ee_main_mem = memory.data();
+
+  // the index must not change what the linker writes.
+  link_dgos(dgos, false);
+  std::vector<u8> memory_without_index = memory;
+  link_dgos(dgos, true);
+  if (memory != memory_without_index) {
+    fmt::print("linking with the symbol index gives different memory than without it\n");
+  }
+
+  std::vector<double> with_index(dgos.size()), without_index(dgos.size());
+  for (int run = 0; run < num_runs; run++) {
+    auto with = link_dgos(dgos, true);
+    auto without = link_dgos(dgos, false);
+    for (size_t i = 0; i < dgos.size(); i++) {
+      with_index[i] += with[i] / num_runs;
+      without_index[i] += without[i] / num_runs;
+    }
+  }
+
+  for (size_t i = 0; i < dgos.size(); i++) {
+    fmt::print("{}: {} objects, {:.3f} ms linking with the symbol index, {:.3f} ms without\n",
+               dgo_paths[i].filename().string(), dgos[i]->entries().size(), with_index[i] * 1000,
+               without_index[i] * 1000);
+  }
+  return 0;
+}
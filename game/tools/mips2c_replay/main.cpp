@@ -0,0 +1,288 @@
+/*!
+ * @file main.cpp
+ * Replay calls to a mips2c function recorded with the runtime's --mips2c-capture flag. Each call
+ * is run from the captured context and memory, checked against what the game got, bit for bit, and
+ * then timed. This runs without the rest of the game, so a mips2c function can be optimized and
+ * checked on its own.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "common/log/log.h"
+#include "common/util/Timer.h"
+#include "common/util/unicode_util.h"
+
+#include "game/kernel/common/kscheme.h"
+#include "game/kernel/common/memory_layout.h"
+#include "game/kernel/jak1/kscheme.h"
+#include "game/kernel/jak2/kscheme.h"
+#include "game/kernel/jak3/kscheme.h"
+#include "game/mips2c/mips2c_capture.h"
+#include "game/runtime.h"
+
+#include "fmt/core.h"
+#include "third-party/CLI11.hpp"
+
+using namespace Mips2C;
+
+namespace {
+// the function's MIPS stack goes after EE memory.
+constexpr u32 REPLAY_STACK_SIZE = 1024 * 1024;
+
+template <typename T>
+void restore_symbol_table(const Mips2CCapture& capture, T& table) {
+  table.clear();
+  for (size_t i = 0; i < capture.symbol_names.size(); i++) {
+    table[capture.symbol_names[i]] = capture.symbol_values[i];
+  }
+}
+
+/*!
+ * Set up the kernel's symbol table state from the capture, so link callbacks can find symbols.
+ */
+void restore_kernel(const Mips2CCapture& capture) {
+  ::s7.offset = capture.s7_offset;
+  SymbolTable2.offset = capture.symbol_table2_offset;
+  LastSymbol.offset = capture.last_symbol_offset;
+  init_crc();
+  switch (capture.version) {
+    case GameVersion::Jak1:
+      restore_symbol_table(capture, jak1::g_symbol_hash_table);
+      break;
+    case GameVersion::Jak2:
+      restore_symbol_table(capture, jak2::g_symbol_hash_table);
+      break;
+    case GameVersion::Jak3:
+      jak3::SymbolString.offset = capture.symbol_string_offset;
+      restore_symbol_table(capture, jak3::g_symbol_hash_table);
+      break;
+    default:
+      ASSERT_NOT_REACHED();
+  }
+}
+
+/*!
+ * Compare the context after a replayed call with the captured one. The stack is in a different
+ * place than it was in the game, so registers that point into the stack are compared relative to
+ * sp.
+ */
+std::vector<std::string> compare_context(const CapturedCall& call,
+                                         const ExecutionContext& actual,
+                                         u64 actual_sp) {
+  std::vector<std::string> diffs;
+  const auto& expected = call.after;
+  u64 expected_sp = call.before.gprs[sp].du64[0];
+  for (int i = 0; i < 32; i++) {
+    const auto& e = expected.gprs[i];
+    const auto& a = actual.gprs[i];
+    if (e.du64[1] != a.du64[1] ||
+        (e.du64[0] != a.du64[0] && e.du64[0] - expected_sp != a.du64[0] - actual_sp)) {
+      diffs.push_back(fmt::format("gpr {}", i));
+    }
+  }
+  for (int i = 0; i < 32; i++) {
+    if (memcmp(&expected.fprs[i], &actual.fprs[i], sizeof(float))) {
+      diffs.push_back(fmt::format("fpr {}", i));
+    }
+  }
+  for (int i = 0; i < 32; i++) {
+    if (memcmp(&expected.vfs[i], &actual.vfs[i], sizeof(Mips2c_vf))) {
+      diffs.push_back(fmt::format("vf {}", i));
+    }
+  }
+  if (memcmp(&expected.acc, &actual.acc, sizeof(Mips2c_acc))) {
+    diffs.push_back("acc");
+  }
+  if (memcmp(&expected.Q, &actual.Q, sizeof(float))) {
+    diffs.push_back("Q");
+  }
+  if (memcmp(&expected.I, &actual.I, sizeof(float))) {
+    diffs.push_back("I");
+  }
+  if (memcmp(&expected.hi, &actual.hi, sizeof(u128)) ||
+      memcmp(&expected.lo, &actual.lo, sizeof(u128))) {
+    diffs.push_back("hi/lo");
+  }
+  return diffs;
+}
+
+/*!
+ * Find the pages below end where memory differs from the expected memory.
+ */
+std::vector<u32> compare_memory(const u8* actual, const std::vector<u8>& expected, u32 end) {
+  std::vector<u32> pages;
+  for (u32 i = 0; i < end / Mips2CCapture::PAGE_SIZE; i++) {
+    u32 offset = i * Mips2CCapture::PAGE_SIZE;
+    if (memcmp(actual + offset, expected.data() + offset, Mips2CCapture::PAGE_SIZE)) {
+      pages.push_back(i);
+    }
+  }
+  return pages;
+}
+
+void print_histogram(std::vector<u64>& times_ns) {
+  std::sort(times_ns.begin(), times_ns.end());
+  auto percentile = [&](double p) {
+    return times_ns[std::min(times_ns.size() - 1, size_t(p * times_ns.size()))] / 1000.;
+  };
+  fmt::print("min {:.3f} us, p50 {:.3f} us, p90 {:.3f} us, p99 {:.3f} us, max {:.3f} us\n\n",
+             times_ns.front() / 1000., percentile(0.5), percentile(0.9), percentile(0.99),
+             times_ns.back() / 1000.);
+
+  // power of two buckets, in ns.
+  std::vector<size_t> buckets;
+  for (auto t : times_ns) {
+    size_t bucket = 0;
+    while ((2ull << bucket) <= t) {
+      bucket++;
+    }
+    if (bucket >= buckets.size()) {
+      buckets.resize(bucket + 1);
+    }
+    buckets[bucket]++;
+  }
+  size_t most = *std::max_element(buckets.begin(), buckets.end());
+  for (size_t i = 0; i < buckets.size(); i++) {
+    if (!buckets[i]) {
+      continue;
+    }
+    fmt::print("{:>10.3f} us {:>8} {}\n", (1ull << i) / 1000., buckets[i],
+               std::string((buckets[i] * 50 + most - 1) / most, '#'));
+  }
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  ArgumentGuard u8_guard(argc, argv);
+
+  fs::path capture_path;
+  int num_runs = 100;
+
+  lg::initialize();
+
+  CLI::App app{"OpenGOAL mips2c Replay"};
+  app.add_option("capture-path", capture_path, "The path to the .m2ccap file to replay")
+      ->required();
+  app.add_option("-n,--runs", num_runs, "Number of times to run each call, defaults to 100");
+  app.validate_positionals();
+  CLI11_PARSE(app, argc, argv);
+  num_runs = std::max(num_runs, 1);
+
+  lg::info("Loading capture from '{}'", capture_path.string());
+  auto capture = read_mips2c_capture(capture_path);
+  if (capture.calls.empty()) {
+    lg::error("capture has no calls, exiting");
+    return 1;
+  }
+
+  g_game_version = capture.version;
+  std::vector<u8> memory(capture.memory_size + REPLAY_STACK_SIZE);
+  g_ee_main_mem = memory.data();
+  const u64 stack_top = capture.memory_size + REPLAY_STACK_SIZE - 16;
+
+  // the memory the game had, which replayed calls should exactly reproduce.
+  std::vector<u8> expected(capture.memory_size);
+  apply_pages(expected.data(), capture.calls[0].changed_pages, capture.calls[0].changed_data);
+  memcpy(memory.data(), expected.data(), expected.size());
+
+  // run the link callbacks to find the function and fill in the symbols it uses. This allocates on
+  // the GOAL heap, so memory is put back afterward.
+  restore_kernel(capture);
+  for (const auto& [object_name, callbacks] : gMips2CLinkCallbacks[capture.version]) {
+    for (auto& callback : callbacks) {
+      callback();
+    }
+  }
+  auto* exec = gLinkedFunctionTable.get_exec(capture.function_name);
+  if (!exec) {
+    lg::error("mips2c function {} is unknown in {}", capture.function_name,
+              game_version_names[capture.version]);
+    return 1;
+  }
+  memcpy(memory.data(), expected.data(), expected.size());
+
+  // in the game, the context, the MIPS stack and the C++ frames of the call were on the GOAL stack
+  // at the top of EE memory, so the game wrote pages there that the replay doesn't. Only memory
+  // below the stack is compared.
+  const u32 stack_size = gLinkedFunctionTable.get_stack_size(capture.function_name);
+  auto stack_bottom = [&](const CapturedCall& call) {
+    u64 bottom = std::min<u64>(call.before.gprs[sp].du64[0] - stack_size,
+                               capture.memory_size - DEBUG_HEAP_SPACE_FOR_STACK);
+    return u32(bottom & ~u64(Mips2CCapture::PAGE_SIZE - 1));
+  };
+
+  std::vector<u64> times_ns;
+  u64 game_ns = 0;
+  int replayed = 0, skipped = 0, mismatches = 0;
+  for (size_t call_idx = 0; call_idx < capture.calls.size(); call_idx++) {
+    const auto& call = capture.calls[call_idx];
+    if (call_idx > 0) {
+      apply_pages(memory.data(), call.changed_pages, call.changed_data);
+      apply_pages(expected.data(), call.changed_pages, call.changed_data);
+    }
+    if (call.called_goal) {
+      // GOAL code isn't loaded here, so just take what the game did.
+      skipped++;
+      apply_pages(memory.data(), call.written_pages, call.written_data);
+      apply_pages(expected.data(), call.written_pages, call.written_data);
+      continue;
+    }
+
+    // the pages the call writes are put back before each run.
+    std::vector<u8> undo;
+    for (auto page : call.written_pages) {
+      const u8* src = memory.data() + page * Mips2CCapture::PAGE_SIZE;
+      undo.insert(undo.end(), src, src + Mips2CCapture::PAGE_SIZE);
+    }
+    apply_pages(expected.data(), call.written_pages, call.written_data);
+
+    for (int run = 0; run < num_runs; run++) {
+      if (run > 0) {
+        apply_pages(memory.data(), call.written_pages, undo);
+      }
+      ExecutionContext ctx = call.before;
+      ctx.gprs[sp].du64[0] = stack_top;
+      load_rng_state(call.rng_before);
+
+      Timer timer;
+      u64 result = exec(&ctx);
+      times_ns.push_back(timer.getNs());
+
+      if (run > 0) {
+        continue;
+      }
+      auto diffs = compare_context(call, ctx, stack_top);
+      if (result != call.result) {
+        diffs.push_back("result");
+      }
+      if (save_rng_state() != call.rng_after) {
+        diffs.push_back("rng");
+      }
+      auto bad_pages = compare_memory(memory.data(), expected, stack_bottom(call));
+      if (!bad_pages.empty()) {
+        diffs.push_back(fmt::format("{} pages of memory, starting at #x{:x}", bad_pages.size(),
+                                    bad_pages.front() * Mips2CCapture::PAGE_SIZE));
+      }
+      if (!diffs.empty()) {
+        mismatches++;
+        lg::error("call {} does not match the capture: {}", call_idx, fmt::join(diffs, ", "));
+      }
+    }
+
+    // continue from what the game did, even if the replay didn't match it.
+    memcpy(memory.data(), expected.data(), expected.size());
+    game_ns += call.duration_ns;
+    replayed++;
+  }
+
+  fmt::print("{}: replayed {} calls {} times each, skipped {} that call GOAL code, {} mismatched\n",
+             capture.function_name, replayed, num_runs, skipped, mismatches);
+  if (replayed) {
+    fmt::print("{:.3f} us per call in the game\n", game_ns / 1000. / replayed);
+    print_histogram(times_ns);
+  }
+  return mismatches ? 1 : 0;
+}
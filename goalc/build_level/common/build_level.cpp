@@ -3,16 +3,13 @@
 void save_pc_data(const std::string& nickname,
                   tfrag3::Level& data,
                   const fs::path& fr3_output_dir) {
-  Serializer ser;
-  data.serialize(ser);
-  auto compressed =
-      compression::compress_zstd(ser.get_save_result().first, ser.get_save_result().second);
+  auto fr3 = tfrag3::write_fr3(data);
   lg::print("stats for {}\n", data.level_name);
-  print_memory_usage(data, ser.get_save_result().second);
-  lg::print("compressed: {} -> {} ({:.2f}%)\n", ser.get_save_result().second, compressed.size(),
-            100.f * compressed.size() / ser.get_save_result().second);
-  file_util::write_binary_file(fr3_output_dir / fmt::format("{}.fr3", nickname), compressed.data(),
-                               compressed.size());
+  print_memory_usage(data, fr3.uncompressed_size);
+  lg::print("compressed: {} -> {} ({:.2f}%)\n", fr3.uncompressed_size, fr3.data.size(),
+            100.f * fr3.data.size() / fr3.uncompressed_size);
+  file_util::write_binary_file(fr3_output_dir / fmt::format("{}.fr3", nickname), fr3.data.data(),
+                               fr3.data.size());
 }
 
 std::vector<std::string> get_build_level_deps(const std::string& input_file) {
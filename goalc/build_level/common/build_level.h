@@ -3,8 +3,8 @@
 #include <string>
 #include <vector>
 
+#include "common/custom_data/Fr3File.h"
 #include "common/log/log.h"
-#include "common/util/compress.h"
 #include "common/util/json_util.h"
 #include "common/util/string_util.h"
 
@@ -1,9 +1,9 @@
 #include "LevelFile.h"
 
 namespace jak1 {
-static size_t ambient_arr_slot;
 
-size_t DrawableTreeArray::add_to_object_file(DataObjectGenerator& gen) const {
+size_t DrawableTreeArray::add_to_object_file(DataObjectGenerator& gen,
+                                             size_t ambient_arr_slot) const {
   /*
    (deftype drawable-tree-array (drawable-group)
     ((trees drawable-tree 1 :offset 32 :score 100))
@@ -84,13 +84,13 @@ std::vector<u8> LevelFile::save_object_file() const {
   auto file_info_slot = info.add_to_object_file(gen);
   gen.link_word_to_byte(1, file_info_slot);
 
-  ambient_arr_slot = jak1::generate_inline_array_ambients(gen, ambients);
+  size_t ambient_arr_slot = jak1::generate_inline_array_ambients(gen, ambients);
 
   //(bsphere                vector :inline                   :offset-assert  16)
   //(all-visible-list       (pointer uint16)                 :offset-assert  32)
   //(visible-list-length    int32                            :offset-assert  36)
   //(drawable-trees         drawable-tree-array              :offset-assert  40)
-  gen.link_word_to_byte(40 / 4, drawable_trees.add_to_object_file(gen));
+  gen.link_word_to_byte(40 / 4, drawable_trees.add_to_object_file(gen, ambient_arr_slot));
   //(pat                    pointer                          :offset-assert  44)
   //(pat-length             int32                            :offset-assert  48)
   //(texture-remap-table    (pointer uint64)                 :offset-assert  52)
@@ -34,7 +34,7 @@ struct DrawableTreeArray {
   std::vector<DrawableTreeCollideFragment> collides;
   std::vector<DrawableTreeAmbient> ambients;
   std::vector<DrawableTreeInstanceShrub> shrubs;
-  size_t add_to_object_file(DataObjectGenerator& gen) const;
+  size_t add_to_object_file(DataObjectGenerator& gen, size_t ambient_arr_slot) const;
 };
 
 struct TextureRemap {};
@@ -7,10 +7,15 @@
 
 #include "CodeGenerator.h"
 
+#include <atomic>
+#include <exception>
+#include <thread>
 #include <unordered_set>
 
 #include "IR.h"
 
+#include "common/util/SimpleThreadGroup.h"
+
 #include "goalc/debugger/DebugInfo.h"
 #include "goalc/emitter/IGen.h"
 
@@ -21,10 +26,54 @@ using namespace emitter;
 CodeGenerator::CodeGenerator(FileEnv* env, DebugInfo* debug_info, GameVersion version)
     : m_gen(version), m_fe(env), m_debug_info(debug_info) {}
 
+namespace {
+// below this, starting the threads costs more than they save.
+constexpr int MIN_FUNCTIONS_PER_THREAD = 4;
+}  // namespace
+
+void run_per_function(int count, bool parallel, const std::function<void(int)>& f) {
+  int num_threads = 1;
+  if (parallel) {
+    num_threads = std::min((int)std::thread::hardware_concurrency(),
+                           count / MIN_FUNCTIONS_PER_THREAD);
+  }
+
+  if (num_threads <= 1) {
+    for (int i = 0; i < count; i++) {
+      f(i);
+    }
+    return;
+  }
+
+  // functions vary a lot in size, so threads grab the next function instead of a fixed range.
+  std::atomic<int> next_function = 0;
+  std::vector<std::exception_ptr> errors(count);
+  SimpleThreadGroup threads;
+  threads.run(
+      [&](int) {
+        for (int i = next_function++; i < count; i = next_function++) {
+          try {
+            f(i);
+          } catch (...) {
+            errors[i] = std::current_exception();
+          }
+        }
+      },
+      num_threads, num_threads);
+  threads.join();
+
+  for (auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+}
+
 /*!
- * Generate an object file.
+ * Generate an object file. With the parallel-backend setting, the instructions for different
+ * functions are generated at the same time. The result is the same either way.
  */
-std::vector<u8> CodeGenerator::run(const TypeSystem* ts) {
+std::vector<u8> CodeGenerator::run(const TypeSystem* ts, const CompilerSettings& settings) {
   std::unordered_set<std::string> function_names;
 
   // first, add each function to the ObjectGenerator (but don't add any data)
@@ -51,10 +100,13 @@ std::vector<u8> CodeGenerator::run(const TypeSystem* ts) {
     static_obj->generate(&m_gen);
   }
 
-  // next, add instructions to functions
-  for (size_t i = 0; i < m_fe->functions().size(); i++) {
+  // next, add instructions to functions, then clean them up with the peephole optimizer.
+  run_per_function(m_fe->functions().size(), settings.parallel_backend, [&](int i) {
     do_function(m_fe->functions().at(i).get(), i);
-  }
+    if (settings.peephole) {
+      m_gen.optimize_function(m_gen.get_existing_function_record(i));
+    }
+  });
 
   // generate a v3 object.
   return m_gen.generate_data_v3(ts).to_vector();
@@ -178,21 +230,19 @@ void CodeGenerator::do_goal_function(FunctionEnv* env, int f_idx) {
     auto& bonus = allocs.stack_ops.at(ir_idx);
     for (auto& op : bonus.ops) {
       if (op.load) {
+        int offset = allocs.get_slot_for_spill(op.slot) * GPR_SIZE;
         if (op.reg.is_gpr() && op.reg_class == RegClass::GPR_64) {
           // todo, s8 or 0 offset if possible?
-          m_gen.add_instr(IGen::load64_gpr64_plus_s32(
-                              op.reg, allocs.get_slot_for_spill(op.slot) * GPR_SIZE, RSP),
-                          i_rec);
+          m_gen.add_instr(IGen::load64_gpr64_plus_s32(op.reg, offset, RSP), i_rec,
+                          MoveInfo::load(MoveInfo::Width::GPR64, op.reg, offset));
         } else if (op.reg.is_xmm() && op.reg_class == RegClass::FLOAT) {
           // load xmm32 off of the stack
-          m_gen.add_instr(IGen::load_reg_offset_xmm32(
-                              op.reg, RSP, allocs.get_slot_for_spill(op.slot) * GPR_SIZE),
-                          i_rec);
+          m_gen.add_instr(IGen::load_reg_offset_xmm32(op.reg, RSP, offset), i_rec,
+                          MoveInfo::load(MoveInfo::Width::XMM32, op.reg, offset));
         } else if (op.reg.is_xmm() &&
                    (op.reg_class == RegClass::VECTOR_FLOAT || op.reg_class == RegClass::INT_128)) {
-          m_gen.add_instr(IGen::load128_xmm128_reg_offset(
-                              op.reg, RSP, allocs.get_slot_for_spill(op.slot) * GPR_SIZE),
-                          i_rec);
+          m_gen.add_instr(IGen::load128_xmm128_reg_offset(op.reg, RSP, offset), i_rec,
+                          MoveInfo::load(MoveInfo::Width::XMM128, op.reg, offset));
         } else {
           ASSERT(false);
         }
@@ -205,21 +255,19 @@ void CodeGenerator::do_goal_function(FunctionEnv* env, int f_idx) {
     // store things back on the stack if needed.
     for (auto& op : bonus.ops) {
       if (op.store) {
+        int offset = allocs.get_slot_for_spill(op.slot) * GPR_SIZE;
         if (op.reg.is_gpr() && op.reg_class == RegClass::GPR_64) {
           // todo, s8 or 0 offset if possible?
-          m_gen.add_instr(IGen::store64_gpr64_plus_s32(
-                              RSP, allocs.get_slot_for_spill(op.slot) * GPR_SIZE, op.reg),
-                          i_rec);
+          m_gen.add_instr(IGen::store64_gpr64_plus_s32(RSP, offset, op.reg), i_rec,
+                          MoveInfo::store(MoveInfo::Width::GPR64, op.reg, offset));
         } else if (op.reg.is_xmm() && op.reg_class == RegClass::FLOAT) {
           // store xmm32 on the stack
-          m_gen.add_instr(IGen::store_reg_offset_xmm32(
-                              RSP, op.reg, allocs.get_slot_for_spill(op.slot) * GPR_SIZE),
-                          i_rec);
+          m_gen.add_instr(IGen::store_reg_offset_xmm32(RSP, op.reg, offset), i_rec,
+                          MoveInfo::store(MoveInfo::Width::XMM32, op.reg, offset));
         } else if (op.reg.is_xmm() &&
                    (op.reg_class == RegClass::VECTOR_FLOAT || op.reg_class == RegClass::INT_128)) {
-          m_gen.add_instr(IGen::store128_xmm128_reg_offset(
-                              RSP, op.reg, allocs.get_slot_for_spill(op.slot) * GPR_SIZE),
-                          i_rec);
+          m_gen.add_instr(IGen::store128_xmm128_reg_offset(RSP, op.reg, offset), i_rec,
+                          MoveInfo::store(MoveInfo::Width::XMM128, op.reg, offset));
         } else {
           ASSERT(false);
         }
@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <functional>
+
+#include "CompilerSettings.h"
 #include "Env.h"
 
 #include "common/versions/versions.h"
@@ -19,7 +22,7 @@ class TypeSystem;
 class CodeGenerator {
  public:
   CodeGenerator(FileEnv* env, DebugInfo* debug_info, GameVersion version);
-  std::vector<u8> run(const TypeSystem* ts);
+  std::vector<u8> run(const TypeSystem* ts, const CompilerSettings& settings);
   emitter::ObjectGeneratorStats get_obj_stats() const { return m_gen.get_stats(); }
 
  private:
@@ -30,3 +33,10 @@ class CodeGenerator {
   FileEnv* m_fe = nullptr;
   DebugInfo* m_debug_info = nullptr;
 };
+
+/*!
+ * Call f(i) for each function index in [0, count). If parallel is set and there are enough
+ * functions, the calls are spread across threads. Any exception is rethrown after all calls are
+ * done, and if several calls threw, the one with the lowest index wins, like running in order.
+ */
+void run_per_function(int count, bool parallel, const std::function<void(int)>& f);
@@ -9,6 +9,7 @@
 #include "common/goos/PrettyPrinter.h"
 #include "common/link_types.h"
 #include "common/util/FileUtil.h"
+#include "common/util/Timer.h"
 
 #include "goalc/make/Tools.h"
 #include "goalc/regalloc/Allocator.h"
@@ -27,12 +28,14 @@ Compiler::Compiler(GameVersion version,
       m_debugger(&m_listener, &m_goos.reader, version),
       m_make(repl_config, user_profile),
       m_repl(std::move(repl)),
-      m_symbol_info(&m_goos.reader.db) {
+      m_symbol_info(&m_goos.reader.db),
+      m_object_cache(m_ts) {
   m_listener.add_debugger(&m_debugger);
   m_listener.set_default_port(version);
   m_ts.add_builtin_types(m_version);
   m_global_env = std::make_unique<GlobalEnv>();
   m_none = std::make_unique<None>(m_ts.make_typespec("none"));
+  setup_object_cache();
 
   // let the build system run us
   m_make.add_tool(std::make_shared<CompilerTool>(this));
@@ -249,9 +252,16 @@ Val* Compiler::compile_error_guard(const goos::Object& code, Env* env) {
 }
 
 void Compiler::color_object_file(FileEnv* env) {
-  int num_spills_in_file = 0;
-  for (auto& f : env->functions()) {
-    AllocationInput input;
+  const auto& functions = env->functions();
+  std::vector<AllocationInput> inputs(functions.size());
+  std::vector<AllocationResult> results(functions.size());
+
+  // functions are allocated independently, so do them at the same time. The debug prints aren't
+  // safe to interleave, so those are done in order.
+  bool parallel = m_settings.parallel_backend && !m_settings.debug_print_regalloc;
+  run_per_function(functions.size(), parallel, [&](int idx) {
+    auto& f = functions.at(idx);
+    auto& input = inputs.at(idx);
     input.is_asm_function = f->is_asm_func;
     for (auto& i : f->code()) {
       input.instructions.push_back(i->to_rai());
@@ -276,9 +286,15 @@ void Compiler::color_object_file(FileEnv* env) {
       input.debug_settings.allocate_log_level = 2;
     }
 
-    m_debug_stats.total_funcs++;
+    results.at(idx) = allocate_registers_v2(input);
+  });
 
-    auto regalloc_result_2 = allocate_registers_v2(input);
+  // handle the results in order, so the output doesn't depend on which function finished first.
+  int num_spills_in_file = 0;
+  for (size_t idx = 0; idx < functions.size(); idx++) {
+    auto& f = functions.at(idx);
+    auto& regalloc_result_2 = results.at(idx);
+    m_debug_stats.total_funcs++;
 
     if (regalloc_result_2.ok) {
       if (regalloc_result_2.num_spilled_vars > 0) {
@@ -293,7 +309,7 @@ void Compiler::color_object_file(FileEnv* env) {
           "the v1 allocator.\n",
           f->name());
       m_debug_stats.funcs_requiring_v1_allocator++;
-      auto regalloc_result = allocate_registers(input);
+      auto regalloc_result = allocate_registers(inputs.at(idx));
       m_debug_stats.num_spills_v1 += regalloc_result.num_spills;
       num_spills_in_file += regalloc_result.num_spills;
       f->set_allocations(std::move(regalloc_result));
@@ -309,14 +325,14 @@ std::vector<u8> Compiler::codegen_object_file(FileEnv* env) {
     debug_info->clear();
     CodeGenerator gen(env, debug_info, m_version);
     bool ok = true;
-    auto result = gen.run(&m_ts);
+    auto result = gen.run(&m_ts, m_settings);
     for (auto& f : env->functions()) {
       if (f->settings.print_asm) {
         lg::print("{}\n", debug_info->disassemble_function_by_name(f->name(), &ok, &m_goos.reader));
       }
     }
-    auto stats = gen.get_obj_stats();
-    m_debug_stats.num_moves_eliminated += stats.moves_eliminated;
+    m_debug_stats.last_object = gen.get_obj_stats();
+    m_debug_stats.objects += m_debug_stats.last_object;
     env->cleanup_after_codegen();
     return result;
   } catch (std::exception& e) {
@@ -332,7 +348,7 @@ bool Compiler::codegen_and_disassemble_object_file(FileEnv* env,
   auto debug_info = &m_debugger.get_debug_info_for_object(env->name());
   debug_info->clear();
   CodeGenerator gen(env, debug_info, m_version);
-  *data_out = gen.run(&m_ts);
+  *data_out = gen.run(&m_ts, m_settings);
   bool ok = true;
   *asm_out = debug_info->disassemble_all_functions(&ok, &m_goos.reader, omit_ir);
   return ok;
@@ -415,6 +431,69 @@ void Compiler::setup_goos_forms() {
   });
 }
 
+/*!
+ * Send a generated object file to the target and/or write it to out/obj.
+ */
+void Compiler::load_and_write_object_file(const CompilationOptions& options,
+                                          const std::string& obj_file_name,
+                                          const std::vector<u8>& data) {
+  // send to target
+  if (options.load) {
+    if (m_batch_load) {
+      m_batch_load->push_back({obj_file_name, data});
+    } else if (m_listener.is_connected()) {
+      m_listener.send_code(data, obj_file_name);
+    } else {
+      lg::print("WARNING - couldn't load because listener isn't connected\n");  // todo log warn
+    }
+  }
+
+  // save file
+  if (options.write) {
+    auto path = file_util::get_jak_project_dir() / "out" / m_make.compiler_output_prefix() /
+                "obj" / (obj_file_name + ".o");
+    file_util::create_dir_if_needed_for_file(path);
+    file_util::write_binary_file(path, (void*)data.data(), data.size());
+  }
+}
+
+/*!
+ * Record accesses to the global tables, and tell the object cache how to check them.
+ */
+void Compiler::setup_object_cache() {
+  for (auto* env : {m_goos.goal_env.as_env(), m_goos.global_environment.as_env()}) {
+    env->vars.set_recorded(true);
+    m_object_cache.add_goos_table(&env->vars);
+  }
+
+  m_symbol_types.set_recorded(true);
+  m_object_cache.add_table(&m_symbol_types, [this](goos::InternedSymbolPtr sym) {
+    auto* type = m_symbol_types.lookup(sym);
+    return type ? type->print() : "-";
+  });
+
+  m_global_constants.set_recorded(true);
+  m_object_cache.add_table(&m_global_constants, [this](goos::InternedSymbolPtr sym) {
+    auto* constant = m_global_constants.lookup(sym);
+    return constant ? constant->print() : "-";
+  });
+
+  // not an InternedPtrMap, so accesses are recorded where it's used.
+  m_object_cache.add_table(&m_inlineable_functions, [this](goos::InternedSymbolPtr sym) {
+    auto it = m_inlineable_functions.find(sym);
+    if (it == m_inlineable_functions.end()) {
+      return std::string("-");
+    }
+    const auto& func = it->second;
+    std::string result = fmt::format("{} {} {}", func.type.print(), func.inline_by_default,
+                                      func.lambda.body.print());
+    for (const auto& param : func.lambda.params) {
+      result += fmt::format(" {} {}", param.name, param.type.print());
+    }
+    return result;
+  });
+}
+
 void Compiler::asm_file(const CompilationOptions& options) {
   // If the filename provided is not a valid path but it's a name (with or without an extension)
   // attempt to find it in the defined `asmFileSearchDirs`
@@ -462,12 +541,6 @@ void Compiler::asm_file(const CompilationOptions& options) {
     file_path = candidate_paths.at(0).string();
   }
 
-  // Evict any symbols we have indexed for this file, this is what
-  // helps to ensure we have an up to date and accurate symbol index
-  m_symbol_info.evict_symbols_using_file_index(file_path);
-
-  auto code = m_goos.reader.read_from_file({file_path});
-
   std::string obj_file_name = file_path;
 
   // Extract object name from file name.
@@ -479,15 +552,51 @@ void Compiler::asm_file(const CompilationOptions& options) {
   }
   obj_file_name = obj_file_name.substr(0, obj_file_name.find_last_of('.'));
 
+  // Only normal builds are cached. Files compiled while compiling another file (by a macro) are
+  // not, as their definitions are recorded as part of the outer file.
+  bool use_cache = m_settings.object_cache && options.color && !options.disassemble &&
+                   !goos::AccessRecorder::active();
+  u64 cache_key = 0;
+  if (use_cache) {
+    cache_key = m_object_cache.compute_key(
+        file_path, file_util::read_text_file(file_path),
+        fmt::format("{} {} {}", game_version_names[m_version], options.no_code,
+                    m_settings.describe_codegen_settings()));
+    if (const auto* cached = m_object_cache.lookup(obj_file_name, cache_key)) {
+      // the definitions and symbol info from the last time this was compiled are still valid.
+      m_debugger.get_debug_info_for_object(obj_file_name) = cached->debug_info;
+      m_debug_stats.last_object = cached->stats;
+      load_and_write_object_file(options, obj_file_name, cached->data);
+      return;
+    }
+  }
+
+  // Evict any symbols we have indexed for this file, this is what
+  // helps to ensure we have an up to date and accurate symbol index
+  m_symbol_info.evict_symbols_using_file_index(file_path);
+
+  Timer compile_timer;
+  std::optional<TypeLookupRecorder> type_recorder;
+  std::optional<goos::AccessRecorder> global_recorder;
+  size_t first_fragment = m_goos.reader.db.fragments().size();
+  if (use_cache) {
+    // if this fails to compile, the old entry shouldn't be used next time.
+    m_object_cache.remove(obj_file_name);
+    type_recorder.emplace();
+    global_recorder.emplace();
+  }
+
+  auto code = m_goos.reader.read_from_file({file_path});
+
   // COMPILE
   auto obj_file = compile_object_file(obj_file_name, code, !options.no_code);
 
+  std::vector<u8> data;
   if (options.color) {
     // register allocation
     color_object_file(obj_file);
 
     // code/object file generation
-    std::vector<u8> data;
     std::string disasm;
     if (options.disassemble) {
       codegen_and_disassemble_object_file(obj_file, &data, &disasm, options.disasm_code_only);
@@ -499,23 +608,34 @@ void Compiler::asm_file(const CompilationOptions& options) {
     } else {
       data = codegen_object_file(obj_file);
     }
+  }
 
-    // send to target
-    if (options.load) {
-      if (m_listener.is_connected()) {
-        m_listener.send_code(data, obj_file_name);
-      } else {
-        lg::print("WARNING - couldn't load because listener isn't connected\n");  // todo log warn
+  if (use_cache) {
+    // stop recording before the cache looks at what was used.
+    ObjectCache::Dependencies deps;
+    deps.types = std::move(type_recorder->names);
+    deps.symbols = std::move(global_recorder->symbols);
+    deps.hash_table_keys = std::move(global_recorder->hash_table_keys);
+    type_recorder.reset();
+    global_recorder.reset();
+
+    const auto& fragments = m_goos.reader.db.fragments();
+    for (size_t i = first_fragment; i < fragments.size(); i++) {
+      if (auto* file = dynamic_cast<goos::FileText*>(fragments[i].get())) {
+        deps.files.push_back(file->get_path());
       }
     }
 
-    // save file
-    if (options.write) {
-      auto path = file_util::get_jak_project_dir() / "out" / m_make.compiler_output_prefix() /
-                  "obj" / (obj_file_name + ".o");
-      file_util::create_dir_if_needed_for_file(path);
-      file_util::write_binary_file(path, (void*)data.data(), data.size());
-    }
+    ObjectCache::Result result;
+    result.data = data;
+    result.debug_info = m_debugger.get_debug_info_for_object(obj_file_name);
+    result.stats = m_debug_stats.last_object;
+    m_object_cache.store(obj_file_name, cache_key, deps, std::move(result),
+                         compile_timer.getMs());
+  }
+
+  if (options.color) {
+    load_and_write_object_file(options, obj_file_name, data);
   } else {
     if (options.load) {
       lg::print("WARNING - couldn't load because coloring is not enabled\n");
@@ -12,10 +12,12 @@
 #include "goalc/compiler/CompilerSettings.h"
 #include "goalc/compiler/Env.h"
 #include "goalc/compiler/IR.h"
+#include "goalc/compiler/ObjectCache.h"
 #include "goalc/compiler/docs/DocTypes.h"
 #include "goalc/compiler/symbol_info.h"
 #include "goalc/data_compiler/game_text_common.h"
 #include "goalc/debugger/Debugger.h"
+#include "goalc/emitter/ObjectGenerator.h"
 #include "goalc/emitter/Register.h"
 #include "goalc/listener/Listener.h"
 #include "goalc/make/MakeSystem.h"
@@ -100,6 +102,10 @@ class Compiler {
                      replxx::Replxx::colors_t& colors,
                      std::vector<std::pair<std::string, replxx::Replxx::Color>> const& user_data);
   bool knows_object_file(const std::string& name);
+  // code size and peephole stats for the most recently generated object file.
+  const emitter::ObjectGeneratorStats& last_object_stats() const {
+    return m_debug_stats.last_object;
+  }
   MakeSystem& make_system() { return m_make; }
   std::vector<symbol_info::SymbolInfo*> lookup_symbol_info_by_file(
       const std::string& file_path) const;
@@ -130,6 +136,8 @@ class Compiler {
   std::unique_ptr<REPL::Wrapper> m_repl;
   CompilerSettings m_settings;
   bool m_throw_on_define_extern_redefinition = false;  // TODO - move to settings
+  // objects to load, collected while compiling a batch-load form.
+  std::optional<std::vector<listener::BatchObject>> m_batch_load;
 
   // State Tracking
   symbol_info::SymbolInfoMap m_symbol_info;
@@ -137,6 +145,7 @@ class Compiler {
   goos::InternedPtrMap<goos::Object> m_global_constants;
   std::unordered_map<goos::InternedSymbolPtr, InlineableFunction, goos::InternedSymbolPtr::hash>
       m_inlineable_functions;
+  ObjectCache m_object_cache;
 
   // Overrides
   std::unordered_set<std::string> m_allow_inconsistent_definition_symbols;
@@ -144,12 +153,17 @@ class Compiler {
   struct DebugStats {
     int num_spills = 0;
     int num_spills_v1 = 0;
-    int num_moves_eliminated = 0;
     int total_funcs = 0;
     int funcs_requiring_v1_allocator = 0;
+    emitter::ObjectGeneratorStats objects;
+    emitter::ObjectGeneratorStats last_object;
   } m_debug_stats;
 
   void setup_goos_forms();
+  void load_and_write_object_file(const CompilationOptions& options,
+                                  const std::string& obj_file_name,
+                                  const std::vector<u8>& data);
+  void setup_object_cache();
   bool get_true_or_false(const goos::Object& form, const goos::Object& boolean);
   bool try_getting_macro_from_goos(const goos::Object& macro_name, goos::Object* dest);
   bool expand_macro_once(const goos::Object& src, goos::Object* out, Env* env);
@@ -621,6 +635,7 @@ class Compiler {
   Val* compile_seval(const goos::Object& form, const goos::Object& rest, Env* env);
   Val* compile_exit(const goos::Object& form, const goos::Object& rest, Env* env);
   Val* compile_asm_file(const goos::Object& form, const goos::Object& rest, Env* env);
+  Val* compile_batch_load(const goos::Object& form, const goos::Object& rest, Env* env);
   Val* compile_repl_clear_screen(const goos::Object& form, const goos::Object& rest, Env* env);
   Val* compile_asm_data_file(const goos::Object& form, const goos::Object& rest, Env* env);
   Val* compile_asm_text_file(const goos::Object& form, const goos::Object& rest, Env* env);
@@ -1,5 +1,7 @@
 #include "CompilerSettings.h"
 
+#include "fmt/core.h"
+
 CompilerSettings::CompilerSettings() {
   m_settings["print-ir"].kind = SettingKind::BOOL;
   m_settings["print-ir"].boolp = &debug_print_ir;
@@ -9,6 +11,18 @@ CompilerSettings::CompilerSettings() {
 
   m_settings["disable-math-const-prop"].kind = SettingKind::BOOL;
   m_settings["disable-math-const-prop"].boolp = &disable_math_const_prop;
+
+  m_settings["parallel-backend"].kind = SettingKind::BOOL;
+  m_settings["parallel-backend"].boolp = &parallel_backend;
+
+  m_settings["peephole"].kind = SettingKind::BOOL;
+  m_settings["peephole"].boolp = &peephole;
+
+  m_settings["object-cache"].kind = SettingKind::BOOL;
+  m_settings["object-cache"].boolp = &object_cache;
+
+  m_settings["listener-compression"].kind = SettingKind::BOOL;
+  m_settings["listener-compression"].boolp = &listener_compression;
 }
 
 void CompilerSettings::set(const std::string& name, const goos::Object& value) {
@@ -23,6 +37,17 @@ void CompilerSettings::set(const std::string& name, const goos::Object& value) {
   }
 }
 
+/*!
+ * The settings that change the output of compiling a file. Settings that only change how fast it
+ * is compiled are left out.
+ */
+std::string CompilerSettings::describe_codegen_settings() const {
+  return fmt::format("print-ir {} print-regalloc {} disable-math-const-prop {} "
+                     "emit-move-after-return {} peephole {} check-for-requires {}",
+                     debug_print_ir, debug_print_regalloc, disable_math_const_prop,
+                     emit_move_after_return, peephole, check_for_requires);
+}
+
 void CompilerSettings::link(bool& val, const std::string& name) {
   m_settings[name].kind = SettingKind::BOOL;
   m_settings[name].boolp = &val;
@@ -12,10 +12,19 @@ class CompilerSettings {
   bool debug_print_regalloc = false;
   bool disable_math_const_prop = false;
   bool emit_move_after_return = true;
+  // do register allocation and code generation for the functions in a file at the same time.
+  bool parallel_backend = true;
+  // remove and shorten jumps and remove redundant moves after code generation.
+  bool peephole = true;
+  // reuse the object file from the last time a file was compiled if nothing it used has changed.
+  bool object_cache = true;
+  // compress objects sent to the target by batch-load.
+  bool listener_compression = true;
   bool check_for_requires = false;  // check for missing 'require' statements (TODO - does not work
                                     // for virtual state usages or macro usages)
 
   void set(const std::string& name, const goos::Object& value);
+  std::string describe_codegen_settings() const;
 
  private:
   void link(bool& val, const std::string& name);
@@ -103,30 +103,35 @@ void regset_common(emitter::ObjectGenerator* gen,
 
   bool src_is_xmm128 = (src_class == RegClass::VECTOR_FLOAT || src_class == RegClass::INT_128);
   bool dst_is_xmm128 = (dst_class == RegClass::VECTOR_FLOAT || dst_class == RegClass::INT_128);
+  // tag moves between registers of the same kind for the peephole optimizer.
+  using Width = emitter::MoveInfo::Width;
 
   if (src_class == RegClass::GPR_64 && dst_class == RegClass::GPR_64) {
     if (src_reg == dst_reg) {
       // eliminate move
-      gen->count_eliminated_move();
+      gen->count_eliminated_move(irec);
       gen->add_instr(IGen::null(), irec);
     } else {
-      gen->add_instr(IGen::mov_gpr64_gpr64(dst_reg, src_reg), irec);
+      gen->add_instr(IGen::mov_gpr64_gpr64(dst_reg, src_reg), irec,
+                     emitter::MoveInfo::reg_to_reg(Width::GPR64, dst_reg, src_reg));
     }
   } else if (src_class == RegClass::FLOAT && dst_class == RegClass::FLOAT) {
     if (src_reg == dst_reg) {
       // eliminate move
-      gen->count_eliminated_move();
+      gen->count_eliminated_move(irec);
       gen->add_instr(IGen::null(), irec);
     } else {
-      gen->add_instr(IGen::mov_xmm32_xmm32(dst_reg, src_reg), irec);
+      gen->add_instr(IGen::mov_xmm32_xmm32(dst_reg, src_reg), irec,
+                     emitter::MoveInfo::reg_to_reg(Width::XMM32, dst_reg, src_reg));
     }
   } else if (src_is_xmm128 && dst_is_xmm128) {
     if (src_reg == dst_reg) {
       // eliminate move
-      gen->count_eliminated_move();
+      gen->count_eliminated_move(irec);
       gen->add_instr(IGen::null(), irec);
     } else {
-      gen->add_instr(IGen::mov_vf_vf(dst_reg, src_reg), irec);
+      gen->add_instr(IGen::mov_vf_vf(dst_reg, src_reg), irec,
+                     emitter::MoveInfo::reg_to_reg(Width::XMM128, dst_reg, src_reg));
     }
   } else if (src_class == RegClass::FLOAT && dst_class == RegClass::GPR_64) {
     // xmm 1x -> gpr
@@ -0,0 +1,192 @@
+#include "ObjectCache.h"
+
+#include "common/type_system/TypeSystem.h"
+#include "common/util/FileUtil.h"
+#include "common/versions/versions.h"
+
+#include "fmt/core.h"
+#include "third-party/zstd/lib/common/xxhash.h"
+
+namespace {
+// change this if what's kept in an entry changes, or to force everything to be compiled again.
+constexpr int OBJECT_CACHE_VERSION = 1;
+
+u64 hash_string(const std::string& str) {
+  return XXH64(str.data(), str.size(), 0);
+}
+
+std::string describe_goos_value(const goos::Object* value) {
+  if (!value) {
+    return "-";
+  }
+  switch (value->type) {
+    case goos::ObjectType::MACRO: {
+      // these print as just their name.
+      auto* macro = value->as_macro();
+      return fmt::format("macro {} {} {}", macro->name, macro->args.print(), macro->body.print());
+    }
+    case goos::ObjectType::LAMBDA: {
+      auto* lambda = value->as_lambda();
+      return fmt::format("lambda {} {} {}", lambda->name, lambda->args.print(),
+                         lambda->body.print());
+    }
+    case goos::ObjectType::STRING_HASH_TABLE:
+      // the entries that are used are checked on their own.
+      return fmt::format("hash table {}", (const void*)value->heap_obj.get());
+    default:
+      return value->print();
+  }
+}
+
+const goos::Object* find_key(const goos::StringHashTableObject& table, const std::string& key) {
+  auto it = table.data.find(key);
+  return it == table.data.end() ? nullptr : &it->second;
+}
+}  // namespace
+
+ObjectCache::ObjectCache(const TypeSystem& ts) : m_ts(ts) {}
+
+/*!
+ * Add a global table that files can depend on. The cache checks the symbols used by a file with
+ * describe, and recognizes the table by the pointer given to the AccessRecorder.
+ */
+void ObjectCache::add_table(const void* table, Describer describe) {
+  m_tables[table].describe = std::move(describe);
+}
+
+/*!
+ * Add a table of GOOS globals.
+ */
+void ObjectCache::add_goos_table(goos::EnvironmentMap* table) {
+  auto& entry = m_tables[table];
+  entry.goos_values = table;
+  entry.describe = [table](goos::InternedSymbolPtr sym) {
+    return describe_goos_value(table->lookup(sym));
+  };
+}
+
+u64 ObjectCache::type_hash(const std::string& type_name) const {
+  // this is empty for types that aren't defined, so defining one later invalidates its users.
+  return hash_string(m_ts.type_definition_text(type_name));
+}
+
+u64 ObjectCache::file_hash(const std::string& path) const {
+  return file_util::file_exists(path) ? hash_string(file_util::read_text_file(path)) : 0;
+}
+
+/*!
+ * The part of the key that is known before compiling: the file and how it is compiled.
+ */
+u64 ObjectCache::compute_key(const std::string& source_path,
+                             const std::string& source,
+                             const std::string& settings) const {
+  auto header = fmt::format("{} {} {} {}\n", OBJECT_CACHE_VERSION, build_revision(), source_path,
+                            settings);
+  return hash_string(header + source);
+}
+
+bool ObjectCache::up_to_date(const Entry& entry) const {
+  for (const auto& [type, hash] : entry.types) {
+    if (type_hash(type) != hash) {
+      return false;
+    }
+  }
+  for (const auto& check : entry.symbols) {
+    if (hash_string(check.table->describe(check.sym)) != check.hash) {
+      return false;
+    }
+  }
+  for (const auto& check : entry.keys) {
+    if (hash_string(describe_goos_value(find_key(*check.table, check.key))) != check.hash) {
+      return false;
+    }
+  }
+  for (const auto& [path, hash] : entry.files) {
+    if (file_hash(path) != hash) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+ * Get the result of compiling a file, if the file and everything it used are unchanged since it
+ * was stored. If so, the GOOS globals it set are set again.
+ */
+const ObjectCache::Result* ObjectCache::lookup(const std::string& name, u64 key) {
+  auto it = m_entries.find(name);
+  if (it == m_entries.end() || it->second.key != key || !up_to_date(it->second)) {
+    m_stats.misses++;
+    return nullptr;
+  }
+
+  const auto& entry = it->second;
+  for (const auto& output : entry.symbol_outputs) {
+    output.table->set(output.sym, output.value);
+  }
+  for (const auto& output : entry.key_outputs) {
+    output.table->data[output.key] = output.value;
+  }
+
+  m_stats.hits++;
+  m_stats.saved_ms += entry.compile_ms;
+  return &entry.result;
+}
+
+/*!
+ * Store the result of compiling a file. This must be called right after compiling it, so the
+ * state it used is hashed as the compiler left it.
+ */
+void ObjectCache::store(const std::string& name,
+                        u64 key,
+                        const Dependencies& deps,
+                        Result result,
+                        double compile_ms) {
+  Entry entry;
+  entry.key = key;
+  entry.result = std::move(result);
+  entry.compile_ms = compile_ms;
+
+  for (const auto& type : deps.types) {
+    entry.types.emplace_back(type, type_hash(type));
+  }
+  for (const auto& path : deps.files) {
+    entry.files.emplace_back(path, file_hash(path));
+  }
+
+  for (const auto& access : deps.symbols) {
+    auto table_it = m_tables.find(access.table);
+    if (table_it == m_tables.end()) {
+      continue;
+    }
+    const auto& table = table_it->second;
+    if (access.set_first && table.goos_values) {
+      entry.symbol_outputs.push_back({table.goos_values, access.sym,
+                                      *table.goos_values->lookup(access.sym)});
+    } else {
+      entry.symbols.push_back({&table, access.sym, hash_string(table.describe(access.sym))});
+    }
+  }
+
+  for (const auto& access : deps.hash_table_keys) {
+    const auto* value = find_key(*access.table, access.key);
+    if (access.set_first) {
+      entry.key_outputs.push_back({access.table, access.key, *value});
+    } else {
+      entry.keys.push_back({access.table, access.key, hash_string(describe_goos_value(value))});
+    }
+  }
+
+  m_entries[name] = std::move(entry);
+}
+
+void ObjectCache::remove(const std::string& name) {
+  m_entries.erase(name);
+}
+
+std::string ObjectCache::print_stats() const {
+  int total = m_stats.hits + m_stats.misses;
+  return fmt::format("Object cache: {} hits, {} misses ({:.1f}% hit rate), saved {:.2f} s",
+                     m_stats.hits, m_stats.misses, total ? 100. * m_stats.hits / total : 0.,
+                     m_stats.saved_ms / 1000.);
+}
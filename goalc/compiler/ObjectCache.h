@@ -0,0 +1,128 @@
+#pragma once
+
+/*!
+ * @file ObjectCache.h
+ * Remembers the object file generated for each source file compiled in this session, so a file
+ * that gets built again can be skipped when nothing it depends on has changed. An entry is reused
+ * if:
+ * - the source, the compiler settings and the compiler build are the same
+ * - every other file that was read while compiling it is the same
+ * - every type definition that was looked up while compiling it is the same
+ * - every global (macros, GOOS variables and hash table entries, constants, symbol types and
+ *   inline functions) that it used is the same as it was after it was compiled.
+ *
+ * Skipping a file also skips the definitions it makes, so this relies on them still being in the
+ * compiler from the last time the file was compiled. This is why the cache is only kept in memory,
+ * and goes away with the compiler. GOOS variables and hash table entries that a file set before
+ * using them are outputs only: they aren't compared, and are set again when the file is skipped.
+ */
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "common/common_types.h"
+#include "common/goos/Object.h"
+
+#include "goalc/debugger/DebugInfo.h"
+#include "goalc/emitter/ObjectGenerator.h"
+
+class TypeSystem;
+
+class ObjectCache {
+ public:
+  /*!
+   * Everything compiling a file produces that isn't kept in the compiler's state.
+   */
+  struct Result {
+    std::vector<u8> data;
+    DebugInfo debug_info{""};
+    emitter::ObjectGeneratorStats stats;
+  };
+
+  /*!
+   * What was used while compiling a file.
+   */
+  struct Dependencies {
+    std::unordered_set<std::string> types;
+    std::vector<std::string> files;
+    std::vector<goos::AccessRecorder::SymbolAccess> symbols;
+    std::vector<goos::AccessRecorder::HashTableAccess> hash_table_keys;
+  };
+
+  // everything about a symbol in a table that code using it could depend on.
+  using Describer = std::function<std::string(goos::InternedSymbolPtr)>;
+
+  explicit ObjectCache(const TypeSystem& ts);
+  void add_table(const void* table, Describer describe);
+  void add_goos_table(goos::EnvironmentMap* table);
+  u64 compute_key(const std::string& source_path,
+                  const std::string& source,
+                  const std::string& settings) const;
+  const Result* lookup(const std::string& name, u64 key);
+  void store(const std::string& name,
+             u64 key,
+             const Dependencies& deps,
+             Result result,
+             double compile_ms);
+  void remove(const std::string& name);
+  std::string print_stats() const;
+
+ private:
+  struct Table {
+    Describer describe;
+    goos::EnvironmentMap* goos_values = nullptr;
+  };
+
+  struct SymbolCheck {
+    const Table* table = nullptr;
+    goos::InternedSymbolPtr sym{nullptr};
+    u64 hash = 0;
+  };
+
+  struct SymbolRestore {
+    goos::EnvironmentMap* table = nullptr;
+    goos::InternedSymbolPtr sym{nullptr};
+    goos::Object value;
+  };
+
+  struct KeyCheck {
+    std::shared_ptr<goos::StringHashTableObject> table;
+    std::string key;
+    u64 hash = 0;
+  };
+
+  struct KeyRestore {
+    std::shared_ptr<goos::StringHashTableObject> table;
+    std::string key;
+    goos::Object value;
+  };
+
+  struct Entry {
+    u64 key = 0;
+    std::vector<std::pair<std::string, u64>> types;
+    std::vector<std::pair<std::string, u64>> files;
+    std::vector<SymbolCheck> symbols;
+    std::vector<KeyCheck> keys;
+    std::vector<SymbolRestore> symbol_outputs;
+    std::vector<KeyRestore> key_outputs;
+    Result result;
+    double compile_ms = 0;
+  };
+
+  bool up_to_date(const Entry& entry) const;
+  u64 type_hash(const std::string& type_name) const;
+  u64 file_hash(const std::string& path) const;
+
+  const TypeSystem& m_ts;
+  std::unordered_map<const void*, Table> m_tables;
+  std::unordered_map<std::string, Entry> m_entries;
+
+  struct {
+    int hits = 0;
+    int misses = 0;
+    double saved_ms = 0;
+  } m_stats;
+};
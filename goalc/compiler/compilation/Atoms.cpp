@@ -149,6 +149,7 @@ const std::unordered_map<
         {"gs", {"", &Compiler::compile_gs}},
         {":exit", {"", &Compiler::compile_exit}},
         {"asm-file", {"", &Compiler::compile_asm_file}},
+        {"batch-load", {"", &Compiler::compile_batch_load}},
         {"asm-data-file", {"", &Compiler::compile_asm_data_file}},
         {"asm-text-file", {"", &Compiler::compile_asm_text_file}},
         {"listen-to-target", {"", &Compiler::compile_listen_to_target}},
@@ -181,6 +181,34 @@ Val* Compiler::compile_asm_file(const goos::Object& form, const goos::Object& re
   return get_none();
 }
 
+/*!
+ * Compile the forms in the body, and load all the files they load through the listener at the end,
+ * together. This is much faster than loading them one by one.
+ */
+Val* Compiler::compile_batch_load(const goos::Object& form, const goos::Object& rest, Env* env) {
+  if (m_batch_load) {
+    throw_compiler_error(form, "batch-load can't be nested");
+  }
+
+  m_batch_load.emplace();
+  Val* result = get_none();
+  try {
+    result = compile_begin(form, rest, env);
+  } catch (...) {
+    m_batch_load.reset();
+    throw;
+  }
+
+  auto objects = std::move(*m_batch_load);
+  m_batch_load.reset();
+  if (m_listener.is_connected()) {
+    m_listener.send_code_batch(objects, m_settings.listener_compression);
+  } else if (!objects.empty()) {
+    lg::print("WARNING - couldn't load because listener isn't connected\n");
+  }
+  return result;
+}
+
 /*!
  * Simple help / documentation command
  */
@@ -825,7 +853,8 @@ Val* Compiler::compile_make(const goos::Object& form, const goos::Object& rest,
   va_check(form, args, {goos::ObjectType::STRING},
            {{"force", {false, {goos::ObjectType::SYMBOL}}},
             {"verbose", {false, {goos::ObjectType::SYMBOL}}},
-            {"report", {false, {goos::ObjectType::SYMBOL}}}});
+            {"report", {false, {goos::ObjectType::SYMBOL}}},
+            {"jobs", {false, {}}}});
   bool force = false;
   if (args.has_named("force")) {
     force = get_true_or_false(form, args.get_named("force"));
@@ -841,7 +870,18 @@ Val* Compiler::compile_make(const goos::Object& form, const goos::Object& rest,
     report = get_true_or_false(form, args.get_named("report"));
   }
 
-  m_make.make(args.unnamed.at(0).as_string()->data, force, verbose, report);
+  // #f (or no argument) means use the default from the command line.
+  std::optional<int> jobs;
+  if (args.has_named("jobs")) {
+    const auto& jobs_arg = args.get_named("jobs");
+    if (jobs_arg.is_int()) {
+      jobs = jobs_arg.as_int();
+    } else if (get_true_or_false(form, jobs_arg)) {
+      throw_compiler_error(form, "make :jobs must be an integer or #f");
+    }
+  }
+
+  m_make.make(args.unnamed.at(0).as_string()->data, force, verbose, report, jobs);
   return get_none();
 }
 
@@ -853,10 +893,18 @@ Val* Compiler::compile_print_debug_compiler_stats(const goos::Object& form,
 
   lg::print("Spill operations (total): {}\n", m_debug_stats.num_spills);
   lg::print("Spill operations (v1 only): {}\n", m_debug_stats.num_spills_v1);
-  lg::print("Eliminated moves: {}\n", m_debug_stats.num_moves_eliminated);
+  const auto& objs = m_debug_stats.objects;
+  lg::print("Eliminated moves: {}\n", objs.moves_eliminated);
+  lg::print("Code bytes: {} -> {}\n", objs.code_bytes_before, objs.code_bytes);
+  lg::print("Instructions: {} -> {}\n", objs.instructions_before, objs.instructions);
+  lg::print("Peephole: {} jumps shortened, {} threaded, {} removed, {} branches fused, {} moves "
+            "removed\n",
+            objs.jumps_shortened, objs.jumps_threaded, objs.jumps_removed, objs.branches_fused,
+            objs.moves_removed);
   lg::print("Total functions: {}\n", m_debug_stats.total_funcs);
   lg::print("Functions requiring v1: {}\n", m_debug_stats.funcs_requiring_v1_allocator);
   lg::print("Size of autocomplete prefix tree: {}\n", m_symbol_info.symbol_count());
+  lg::print("{}\n", m_object_cache.print_stats());
 
   return get_none();
 }
@@ -42,6 +42,7 @@ Val* Compiler::compile_inline(const goos::Object& form, const goos::Object& rest
   auto args = get_va(form, rest);
   va_check(form, args, {goos::ObjectType::SYMBOL}, {});
 
+  goos::AccessRecorder::record(&m_inlineable_functions, args.unnamed.at(0).as_symbol(), false);
   auto kv = m_inlineable_functions.find(args.unnamed.at(0).as_symbol());
   if (kv == m_inlineable_functions.end()) {
     throw_compiler_error(form, "Cannot inline {} because the function's code could not be found.",
@@ -345,6 +346,7 @@ Val* Compiler::compile_function_or_method_call(const goos::Object& form, Env* en
   if (uneval_head.is_symbol()) {
     // we can only auto-inline the function if its name is explicitly given.
     // look it up:
+    goos::AccessRecorder::record(&m_inlineable_functions, uneval_head.as_symbol(), false);
     auto kv = m_inlineable_functions.find(uneval_head.as_symbol());
     if (kv != m_inlineable_functions.end()) {
       // it's inlinable.  However, we do not always inline an inlinable function by default
@@ -3,7 +3,8 @@
  * Tool to build GOAL object files. Will eventually support v3 and v4.
  *
  * There are 5 steps:
- * 1. The user adds static data / instructions and specifies links.
+ * 1. The user adds static data / instructions and specifies links. Each function can then be run
+ *    through the peephole optimizer, which shortens and simplifies jumps and removes useless moves.
  * 2. The functions and static data are laid out in memory
  * 3. The user specified links are updated according to the memory layout, and jumps are patched
  * 4. The link table is generated for each segment
@@ -15,6 +16,8 @@
 
 #include "ObjectGenerator.h"
 
+#include "IGen.h"
+
 #include "common/goal_constants.h"
 #include "common/type_system/TypeSystem.h"
 #include "common/versions/versions.h"
@@ -25,6 +28,123 @@
 
 namespace emitter {
 
+namespace {
+// how many jumps to jumps are followed when threading a jump
+constexpr int MAX_JUMP_THREAD_HOPS = 8;
+
+bool is_null(const Instruction& instr) {
+  return instr.m_flags & Instruction::kIsNull;
+}
+
+bool is_unconditional_jump(const Instruction& instr) {
+  return !is_null(instr) && (instr.op == 0xe9 || instr.op == 0xeb);
+}
+
+bool is_long_conditional_jump(const Instruction& instr) {
+  return !is_null(instr) && instr.op == 0x0f && (instr.m_flags & Instruction::kOp2Set) &&
+         (instr.op2 & 0xf0) == 0x80;
+}
+
+/*!
+ * Flip the condition of a jcc. The x86 condition codes come in pairs that differ in the low bit.
+ */
+Instruction invert_condition(const Instruction& instr) {
+  ASSERT(is_long_conditional_jump(instr));
+  Instruction result = instr;
+  result.op2 ^= 1;
+  return result;
+}
+
+/*!
+ * Convert a jmp or jcc with a 32-bit offset to the 8-bit offset version.
+ */
+Instruction to_short_jump(const Instruction& instr) {
+  ASSERT(instr.get_imm_size() == 4);
+  if (is_unconditional_jump(instr)) {
+    Instruction result(0xeb);
+    result.set(Imm(1, 0));
+    return result;
+  }
+  ASSERT(is_long_conditional_jump(instr));
+  Instruction result(0x70 | (instr.op2 & 0xf));
+  result.set(Imm(1, 0));
+  return result;
+}
+
+/*!
+ * Does the second move have no effect when it runs right after the first one?
+ */
+bool is_redundant_move(const MoveInfo& first, const MoveInfo& second) {
+  using Kind = MoveInfo::Kind;
+  if (first.kind == Kind::NONE || second.kind == Kind::NONE || first.width != second.width) {
+    return false;
+  }
+  switch (second.kind) {
+    case Kind::REG_TO_REG:
+      // the same move again, or the same move backward.
+      return first.kind == Kind::REG_TO_REG &&
+             ((first.dst == second.dst && first.src == second.src) ||
+              (first.dst == second.src && first.src == second.dst));
+    case Kind::STACK_TO_REG:
+      if (first.kind == Kind::STACK_TO_REG) {
+        return first.dst == second.dst && first.stack_offset == second.stack_offset;
+      }
+      // a 32-bit load also clears the upper part of the xmm register, so it isn't redundant.
+      return first.kind == Kind::REG_TO_STACK && first.width != MoveInfo::Width::XMM32 &&
+             first.src == second.dst && first.stack_offset == second.stack_offset;
+    case Kind::REG_TO_STACK:
+      if (first.kind == Kind::REG_TO_STACK) {
+        return first.src == second.src && first.stack_offset == second.stack_offset;
+      }
+      return first.kind == Kind::STACK_TO_REG && first.dst == second.src &&
+             first.stack_offset == second.stack_offset;
+    default:
+      return false;
+  }
+}
+}  // namespace
+
+MoveInfo MoveInfo::reg_to_reg(Width width, Register dst, Register src) {
+  MoveInfo result;
+  result.kind = Kind::REG_TO_REG;
+  result.width = width;
+  result.dst = dst;
+  result.src = src;
+  return result;
+}
+
+MoveInfo MoveInfo::load(Width width, Register dst, int stack_offset) {
+  MoveInfo result;
+  result.kind = Kind::STACK_TO_REG;
+  result.width = width;
+  result.dst = dst;
+  result.stack_offset = stack_offset;
+  return result;
+}
+
+MoveInfo MoveInfo::store(Width width, Register src, int stack_offset) {
+  MoveInfo result;
+  result.kind = Kind::REG_TO_STACK;
+  result.width = width;
+  result.src = src;
+  result.stack_offset = stack_offset;
+  return result;
+}
+
+ObjectGeneratorStats& ObjectGeneratorStats::operator+=(const ObjectGeneratorStats& other) {
+  moves_eliminated += other.moves_eliminated;
+  code_bytes_before += other.code_bytes_before;
+  code_bytes += other.code_bytes;
+  instructions_before += other.instructions_before;
+  instructions += other.instructions;
+  jumps_shortened += other.jumps_shortened;
+  jumps_threaded += other.jumps_threaded;
+  jumps_removed += other.jumps_removed;
+  branches_fused += other.branches_fused;
+  moves_removed += other.moves_removed;
+  return *this;
+}
+
 ObjectGenerator::ObjectGenerator(GameVersion version) : m_version(version) {}
 
 /*!
@@ -183,6 +303,13 @@ IR_Record ObjectGenerator::get_future_ir_record_in_same_func(const IR_Record& ir
  * Add a new Instruction for the given IR instruction.
  */
 InstructionRecord ObjectGenerator::add_instr(Instruction inst, IR_Record ir) {
+  return add_instr(inst, ir, MoveInfo());
+}
+
+/*!
+ * Add a new Instruction for the given IR instruction, which is the given move.
+ */
+InstructionRecord ObjectGenerator::add_instr(Instruction inst, IR_Record ir, const MoveInfo& move) {
   // only this second condition is an actual error.
   ASSERT(ir.ir_id ==
          int(m_function_data_by_seg.at(ir.seg).at(ir.func_id).ir_to_instruction.size()) - 1);
@@ -194,8 +321,8 @@ InstructionRecord ObjectGenerator::add_instr(Instruction inst, IR_Record ir) {
   auto& func_data = m_function_data_by_seg.at(rec.seg).at(rec.func_id);
   rec.instr_id = int(func_data.instructions.size());
   func_data.instructions.emplace_back(inst);
-  auto debug = m_function_data_by_seg.at(ir.seg).at(ir.func_id).debug;
-  debug->instructions.emplace_back(inst, InstructionInfo::Kind::IR, ir.ir_id);
+  func_data.moves.push_back(move);
+  func_data.debug->instructions.emplace_back(inst, InstructionInfo::Kind::IR, ir.ir_id);
   return rec;
 }
 
@@ -203,7 +330,9 @@ void ObjectGenerator::add_instr_no_ir(FunctionRecord func,
                                       Instruction inst,
                                       InstructionInfo::Kind kind) {
   auto info = InstructionInfo(inst, kind);
-  m_function_data_by_seg.at(func.seg).at(func.func_id).instructions.emplace_back(inst);
+  auto& func_data = m_function_data_by_seg.at(func.seg).at(func.func_id);
+  func_data.instructions.emplace_back(inst);
+  func_data.moves.emplace_back();
   func.debug->instructions.push_back(info);
 }
 
@@ -246,7 +375,7 @@ void ObjectGenerator::link_instruction_jump(InstructionRecord jump_instr, IR_Rec
   // must jump within our own function.
   ASSERT(jump_instr.seg == destination.seg);
   ASSERT(jump_instr.func_id == destination.func_id);
-  m_jump_temp_links_by_seg.at(jump_instr.seg).push_back({jump_instr, destination});
+  get_function_data(jump_instr).jump_links.push_back({jump_instr, destination});
 }
 
 /*!
@@ -256,7 +385,7 @@ void ObjectGenerator::link_instruction_jump(InstructionRecord jump_instr, IR_Rec
  */
 void ObjectGenerator::link_instruction_symbol_mem(const InstructionRecord& rec,
                                                   const std::string& name) {
-  m_symbol_instr_temp_links_by_seg.at(rec.seg)[name].push_back({rec, true});
+  get_function_data(rec).symbol_instr_links.push_back({rec, name, true});
 }
 
 /*!
@@ -265,7 +394,7 @@ void ObjectGenerator::link_instruction_symbol_mem(const InstructionRecord& rec,
  */
 void ObjectGenerator::link_instruction_symbol_ptr(const InstructionRecord& rec,
                                                   const std::string& name) {
-  m_symbol_instr_temp_links_by_seg.at(rec.seg)[name].push_back({rec, false});
+  get_function_data(rec).symbol_instr_links.push_back({rec, name, false});
 }
 
 /*!
@@ -313,12 +442,184 @@ void ObjectGenerator::link_static_pointer_to_function(const StaticRecord& source
 void ObjectGenerator::link_instruction_static(const InstructionRecord& instr,
                                               const StaticRecord& target_static,
                                               int offset) {
-  m_rip_data_temp_links_by_seg.at(instr.seg).push_back({instr, target_static, offset});
+  get_function_data(instr).rip_data_links.push_back({instr, target_static, offset});
 }
 
 void ObjectGenerator::link_instruction_to_function(const InstructionRecord& instr,
                                                    const FunctionRecord& target_func) {
-  m_rip_func_temp_links_by_seg.at(instr.seg).push_back({instr, target_func});
+  get_function_data(instr).rip_func_links.push_back({instr, target_func});
+}
+
+/*!
+ * Run the peephole optimizer on a function once all of its instructions have been added.
+ * Instructions are replaced or turned into null instructions, but never added or removed, so all
+ * records stay valid. Like adding instructions, this can be done for different functions at the
+ * same time. It:
+ * - retargets jumps to unconditional jumps to go to the final destination
+ * - turns a jcc over a jmp into one inverted jcc
+ * - removes jumps to the next instruction
+ * - removes moves and spill loads/stores that undo or repeat the one right before them
+ * - uses 8-bit offsets for the jumps that are close enough
+ * Instructions that a jump goes to are never removed, so the instruction before them always runs
+ * first.
+ *
+ * This only looks at neighboring instructions. There's no liveness analysis, so a spill load or
+ * store is only removed when it repeats or undoes the one right before it, not when its value is
+ * never used. The only sequence that gets fused is the jcc over a jmp, other IGen sequences are
+ * left as they are.
+ */
+void ObjectGenerator::optimize_function(const FunctionRecord& func) {
+  auto& f = m_function_data_by_seg.at(func.seg).at(func.func_id);
+  ASSERT(!f.optimized);
+  f.optimized = true;
+  auto& stats = f.stats;
+  const int n = f.instructions.size();
+  for (const auto& instr : f.instructions) {
+    if (!is_null(instr)) {
+      stats.code_bytes_before += instr.length();
+      stats.instructions_before++;
+    }
+  }
+
+  auto set_instr = [&](int idx, const Instruction& instr) {
+    f.instructions.at(idx) = instr;
+    f.debug->instructions.at(idx).instruction = instr;
+  };
+  // the first instruction at or after idx that isn't null, or n if there isn't one.
+  auto next_real = [&](int idx) {
+    while (idx < n && is_null(f.instructions.at(idx))) {
+      idx++;
+    }
+    return idx;
+  };
+  // the first instruction that runs after the jump is taken.
+  auto jump_dest = [&](const JumpLink& link) {
+    return next_real(f.ir_to_instruction.at(link.dest.ir_id));
+  };
+
+  std::vector<int> link_at(n, -1);
+  for (size_t i = 0; i < f.jump_links.size(); i++) {
+    link_at.at(f.jump_links[i].jump_instr.instr_id) = i;
+  }
+
+  // jump threading. This stops at a loop of jumps because of the hop limit.
+  for (auto& link : f.jump_links) {
+    for (int hop = 0; hop < MAX_JUMP_THREAD_HOPS; hop++) {
+      int dest = jump_dest(link);
+      if (dest >= n || link_at.at(dest) == -1 || !is_unconditional_jump(f.instructions.at(dest))) {
+        break;
+      }
+      const auto& next_dest = f.jump_links.at(link_at.at(dest)).dest;
+      if (next_real(f.ir_to_instruction.at(next_dest.ir_id)) == dest) {
+        break;  // jumps to itself
+      }
+      link.dest = next_dest;
+      if (hop == 0) {
+        stats.jumps_threaded++;
+      }
+    }
+  }
+
+  // how many jumps go to each instruction.
+  std::vector<int> jumps_to(n + 1);
+  for (const auto& link : f.jump_links) {
+    jumps_to.at(jump_dest(link))++;
+  }
+
+  std::vector<bool> link_removed(f.jump_links.size());
+  auto remove_jump = [&](int link_idx) {
+    const auto& link = f.jump_links.at(link_idx);
+    int instr_idx = link.jump_instr.instr_id;
+    jumps_to.at(jump_dest(link))--;
+    set_instr(instr_idx, IGen::null());
+    // jumps to the removed jump now go to the instruction after it.
+    jumps_to.at(next_real(instr_idx)) += jumps_to.at(instr_idx);
+    jumps_to.at(instr_idx) = 0;
+    link_removed.at(link_idx) = true;
+  };
+
+  for (size_t link_idx = 0; link_idx < f.jump_links.size(); link_idx++) {
+    if (link_removed.at(link_idx)) {
+      continue;
+    }
+    auto& link = f.jump_links.at(link_idx);
+    int instr_idx = link.jump_instr.instr_id;
+    int after = next_real(instr_idx + 1);
+    if (jump_dest(link) == after) {
+      remove_jump(link_idx);
+      stats.jumps_removed++;
+      continue;
+    }
+
+    // jcc a; jmp b; a: -> jncc b; a:
+    if (!is_long_conditional_jump(f.instructions.at(instr_idx)) || after >= n ||
+        link_at.at(after) == -1 || !is_unconditional_jump(f.instructions.at(after)) ||
+        jumps_to.at(after) != 0 || jump_dest(link) != next_real(after + 1)) {
+      continue;
+    }
+    int other_idx = link_at.at(after);
+    jumps_to.at(jump_dest(link))--;
+    link.dest = f.jump_links.at(other_idx).dest;
+    jumps_to.at(jump_dest(link))++;
+    set_instr(instr_idx, invert_condition(f.instructions.at(instr_idx)));
+    remove_jump(other_idx);
+    stats.branches_fused++;
+
+    // jcc a; jmp a; a: leaves a jcc to the next instruction.
+    if (jump_dest(link) == next_real(instr_idx + 1)) {
+      remove_jump(link_idx);
+      stats.jumps_removed++;
+    }
+  }
+
+  std::vector<JumpLink> kept_links;
+  for (size_t link_idx = 0; link_idx < f.jump_links.size(); link_idx++) {
+    if (!link_removed.at(link_idx)) {
+      kept_links.push_back(f.jump_links.at(link_idx));
+    }
+  }
+  f.jump_links = std::move(kept_links);
+
+  // moves that do nothing
+  int prev = -1;
+  for (int i = 0; i < n; i++) {
+    if (is_null(f.instructions.at(i))) {
+      continue;
+    }
+    if (prev != -1 && jumps_to.at(i) == 0 && is_redundant_move(f.moves.at(prev), f.moves.at(i))) {
+      set_instr(i, IGen::null());
+      stats.moves_removed++;
+      continue;
+    }
+    prev = i;
+  }
+
+  // branch relaxation. Shortening a jump only brings others closer to their destinations, so
+  // repeat until nothing changes.
+  std::vector<int> offsets(n + 1);
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (int i = 0; i < n; i++) {
+      offsets.at(i + 1) = offsets.at(i) + f.instructions.at(i).length();
+    }
+    for (const auto& link : f.jump_links) {
+      int instr_idx = link.jump_instr.instr_id;
+      const auto& instr = f.instructions.at(instr_idx);
+      if (instr.get_imm_size() != 4) {
+        continue;
+      }
+      // the offset is from the end of the jump, and only the size of the jump itself changes.
+      int dest = offsets.at(f.ir_to_instruction.at(link.dest.ir_id));
+      int short_offset = dest > offsets.at(instr_idx) ? dest - offsets.at(instr_idx + 1)
+                                                      : dest - (offsets.at(instr_idx) + 2);
+      if (short_offset >= INT8_MIN && short_offset <= INT8_MAX) {
+        set_instr(instr_idx, to_short_jump(instr));
+        stats.jumps_shortened++;
+        changed = true;
+      }
+    }
+  }
 }
 
 /*!
@@ -383,47 +684,52 @@ void ObjectGenerator::handle_temp_static_ptr_links(int seg) {
 }
 
 /*!
- * m_jump_temp_links_by_seg patching after memory layout is done
+ * Jump link patching after memory layout is done
  */
 void ObjectGenerator::handle_temp_jump_links(int seg) {
-  for (const auto& link : m_jump_temp_links_by_seg.at(seg)) {
-    // we need to compute three offsets, all relative to the start of data.
-    // 1). the location of the patch (the immediate of the opcode)
-    // 2). the value of RIP at the jump (the instruction after the jump, on x86)
-    // 3). the value of RIP we want
-    const auto& function = m_function_data_by_seg.at(seg).at(link.jump_instr.func_id);
-    ASSERT(link.jump_instr.func_id == link.dest.func_id);
-    ASSERT(link.jump_instr.seg == seg);
-    ASSERT(link.dest.seg == seg);
-    const auto& jump_instr = function.instructions.at(link.jump_instr.instr_id);
-    ASSERT(jump_instr.get_imm_size() == 4);
-
-    // 1). patch = instruction location + location of imm in instruction.
-    int patch_location = function.instruction_to_byte_in_data.at(link.jump_instr.instr_id) +
-                         jump_instr.offset_of_imm();
-
-    // 2). source rip = jump instr + 1 location
-    int source_rip = function.instruction_to_byte_in_data.at(link.jump_instr.instr_id + 1);
-
-    // 3). dest rip = first instruction of dest IR
-    int dest_rip =
-        function.instruction_to_byte_in_data.at(function.ir_to_instruction.at(link.dest.ir_id));
-
-    patch_data<s32>(seg, patch_location, dest_rip - source_rip);
+  for (const auto& function : m_function_data_by_seg.at(seg)) {
+    for (const auto& link : function.jump_links) {
+      // we need to compute three offsets, all relative to the start of data.
+      // 1). the location of the patch (the immediate of the opcode)
+      // 2). the value of RIP at the jump (the instruction after the jump, on x86)
+      // 3). the value of RIP we want
+      ASSERT(link.jump_instr.func_id == link.dest.func_id);
+      ASSERT(link.jump_instr.seg == seg);
+      ASSERT(link.dest.seg == seg);
+      const auto& jump_instr = function.instructions.at(link.jump_instr.instr_id);
+      ASSERT(jump_instr.get_imm_size() == 4 || jump_instr.get_imm_size() == 1);
+
+      // 1). patch = instruction location + location of imm in instruction.
+      int patch_location = function.instruction_to_byte_in_data.at(link.jump_instr.instr_id) +
+                           jump_instr.offset_of_imm();
+
+      // 2). source rip = jump instr + 1 location
+      int source_rip = function.instruction_to_byte_in_data.at(link.jump_instr.instr_id + 1);
+
+      // 3). dest rip = first instruction of dest IR
+      int dest_rip =
+          function.instruction_to_byte_in_data.at(function.ir_to_instruction.at(link.dest.ir_id));
+
+      if (jump_instr.get_imm_size() == 1) {
+        // shortened by the peephole optimizer, which checked that it fits.
+        ASSERT(dest_rip - source_rip >= INT8_MIN && dest_rip - source_rip <= INT8_MAX);
+        patch_data<s8>(seg, patch_location, dest_rip - source_rip);
+      } else {
+        patch_data<s32>(seg, patch_location, dest_rip - source_rip);
+      }
+    }
   }
 }
 
 /*!
  * Convert:
- * m_symbol_instr_temp_links_by_seg -> m_sym_links_by_seg
+ * the symbol links of each function -> m_sym_links_by_seg
  * after memory layout is done and before link tables are generated
  */
 void ObjectGenerator::handle_temp_instr_sym_links(int seg) {
-  for (const auto& links : m_symbol_instr_temp_links_by_seg.at(seg)) {
-    const auto& sym_name = links.first;
-    for (const auto& link : links.second) {
+  for (const auto& function : m_function_data_by_seg.at(seg)) {
+    for (const auto& link : function.symbol_instr_links) {
       ASSERT(seg == link.rec.seg);
-      const auto& function = m_function_data_by_seg.at(seg).at(link.rec.func_id);
       const auto& instruction = function.instructions.at(link.rec.instr_id);
       int offset_of_instruction = function.instruction_to_byte_in_data.at(link.rec.instr_id);
       int offset_in_instruction =
@@ -433,30 +739,35 @@ void ObjectGenerator::handle_temp_instr_sym_links(int seg) {
       } else {
         ASSERT(instruction.get_imm_size() == 4);
       }
-      m_sym_links_by_seg.at(seg)[sym_name].push_back(offset_of_instruction + offset_in_instruction);
+      m_sym_links_by_seg.at(seg)[link.name].push_back(offset_of_instruction +
+                                                      offset_in_instruction);
     }
   }
 }
 
 void ObjectGenerator::handle_temp_rip_func_links(int seg) {
-  for (const auto& link : m_rip_func_temp_links_by_seg.at(seg)) {
-    RipLink result;
-    result.instr = link.instr;
-    result.target_segment = link.target.seg;
-    const auto& target_func = m_function_data_by_seg.at(link.target.seg).at(link.target.func_id);
-    result.offset_in_segment = target_func.instruction_to_byte_in_data.at(0);
-    m_rip_links_by_seg.at(seg).push_back(result);
+  for (const auto& function : m_function_data_by_seg.at(seg)) {
+    for (const auto& link : function.rip_func_links) {
+      RipLink result;
+      result.instr = link.instr;
+      result.target_segment = link.target.seg;
+      const auto& target_func = m_function_data_by_seg.at(link.target.seg).at(link.target.func_id);
+      result.offset_in_segment = target_func.instruction_to_byte_in_data.at(0);
+      m_rip_links_by_seg.at(seg).push_back(result);
+    }
   }
 }
 
 void ObjectGenerator::handle_temp_rip_data_links(int seg) {
-  for (const auto& link : m_rip_data_temp_links_by_seg.at(seg)) {
-    RipLink result;
-    result.instr = link.instr;
-    result.target_segment = link.data.seg;
-    const auto& target = m_static_data_by_seg.at(link.data.seg).at(link.data.static_id);
-    result.offset_in_segment = target.location + link.offset;
-    m_rip_links_by_seg.at(seg).push_back(result);
+  for (const auto& function : m_function_data_by_seg.at(seg)) {
+    for (const auto& link : function.rip_data_links) {
+      RipLink result;
+      result.instr = link.instr;
+      result.target_segment = link.data.seg;
+      const auto& target = m_static_data_by_seg.at(link.data.seg).at(link.data.static_id);
+      result.offset_in_segment = target.location + link.offset;
+      m_rip_links_by_seg.at(seg).push_back(result);
+    }
   }
 }
 
@@ -631,10 +942,31 @@ std::vector<u8> ObjectGenerator::generate_header_v3() {
 }
 
 ObjectGeneratorStats ObjectGenerator::get_stats() const {
-  return m_stats;
+  ObjectGeneratorStats stats;
+  for (const auto& seg : m_function_data_by_seg) {
+    for (const auto& function : seg) {
+      ObjectGeneratorStats function_stats = function.stats;
+      for (const auto& instr : function.instructions) {
+        if (!is_null(instr)) {
+          function_stats.code_bytes += instr.length();
+          function_stats.instructions++;
+        }
+      }
+      if (!function.optimized) {
+        function_stats.code_bytes_before = function_stats.code_bytes;
+        function_stats.instructions_before = function_stats.instructions;
+      }
+      stats += function_stats;
+    }
+  }
+  return stats;
+}
+
+void ObjectGenerator::count_eliminated_move(const IR_Record& ir) {
+  m_function_data_by_seg.at(ir.seg).at(ir.func_id).stats.moves_eliminated++;
 }
 
-void ObjectGenerator::count_eliminated_move() {
-  m_stats.moves_eliminated++;
+ObjectGenerator::FunctionData& ObjectGenerator::get_function_data(const InstructionRecord& rec) {
+  return m_function_data_by_seg.at(rec.seg).at(rec.func_id);
 }
 }  // namespace emitter
@@ -11,6 +11,7 @@
 
 #include "Instruction.h"
 #include "ObjectFileData.h"
+#include "Register.h"
 
 #include "common/versions/versions.h"
 
@@ -57,10 +58,49 @@ struct StaticRecord {
   int static_id = -1;
 };
 
+/*!
+ * A move between two registers, or between a register and the stack. The peephole optimizer uses
+ * these to find moves that have no effect because they undo or repeat the move before them.
+ */
+struct MoveInfo {
+  enum class Kind : u8 { NONE, REG_TO_REG, STACK_TO_REG, REG_TO_STACK };
+  // how much of the register is moved. Moves of a different width are never combined.
+  enum class Width : u8 { GPR64, XMM32, XMM128 };
+
+  Kind kind = Kind::NONE;
+  Width width = Width::GPR64;
+  Register dst;           // unused for REG_TO_STACK
+  Register src;           // unused for STACK_TO_REG
+  int stack_offset = -1;  // offset from rsp, for loads and stores
+
+  static MoveInfo reg_to_reg(Width width, Register dst, Register src);
+  static MoveInfo load(Width width, Register dst, int stack_offset);
+  static MoveInfo store(Width width, Register src, int stack_offset);
+};
+
 struct ObjectGeneratorStats {
   int moves_eliminated = 0;
+
+  // size of the functions, before and after the peephole optimizer
+  int code_bytes_before = 0;
+  int code_bytes = 0;
+  int instructions_before = 0;
+  int instructions = 0;
+
+  // peephole optimizer changes
+  int jumps_shortened = 0;
+  int jumps_threaded = 0;
+  int jumps_removed = 0;
+  int branches_fused = 0;
+  int moves_removed = 0;
+
+  ObjectGeneratorStats& operator+=(const ObjectGeneratorStats& other);
 };
 
+/*!
+ * Once all functions have been added, instructions and instruction links can be added to different
+ * functions from different threads at the same time. Everything else must be done from one thread.
+ */
 class ObjectGenerator {
  public:
   ObjectGenerator(GameVersion version);
@@ -73,6 +113,7 @@ class ObjectGenerator {
   IR_Record get_future_ir_record(const FunctionRecord& func, int ir_id);
   IR_Record get_future_ir_record_in_same_func(const IR_Record& irec, int ir_id);
   InstructionRecord add_instr(Instruction inst, IR_Record ir);
+  InstructionRecord add_instr(Instruction inst, IR_Record ir, const MoveInfo& move);
   void add_instr_no_ir(FunctionRecord func, Instruction inst, InstructionInfo::Kind kind);
   StaticRecord add_static_to_seg(int seg, int min_align = 16);
   std::vector<u8>& get_static_data(const StaticRecord& rec);
@@ -94,8 +135,9 @@ class ObjectGenerator {
                                int offset);
   void link_instruction_to_function(const InstructionRecord& instr,
                                     const FunctionRecord& target_func);
+  void optimize_function(const FunctionRecord& func);
   ObjectGeneratorStats get_stats() const;
-  void count_eliminated_move();
+  void count_eliminated_move(const IR_Record& ir);
 
   GameVersion version() const { return m_version; }
 
@@ -132,14 +174,6 @@ class ObjectGenerator {
     memcpy(data.data() + offset, &x, sizeof(T));
   }
 
-  struct FunctionData {
-    std::vector<Instruction> instructions;
-    std::vector<int> ir_to_instruction;
-    std::vector<int> instruction_to_byte_in_data;
-    int min_align = 16;
-    FunctionDebugInfo* debug = nullptr;
-  };
-
   struct StaticData {
     std::vector<u8> data;
     int min_align = 16;
@@ -171,6 +205,7 @@ class ObjectGenerator {
 
   struct SymbolInstrLink {
     InstructionRecord rec;
+    std::string name;
     bool is_mem_access = false;
   };
 
@@ -203,6 +238,31 @@ class ObjectGenerator {
     int dest = -1;
   };
 
+  /*!
+   * Everything added while generating a function's instructions is stored here, not shared between
+   * functions, so different functions can be generated at the same time. The links are merged in
+   * function order once the memory layout is done.
+   */
+  struct FunctionData {
+    std::vector<Instruction> instructions;
+    std::vector<int> ir_to_instruction;
+    std::vector<int> instruction_to_byte_in_data;
+    int min_align = 16;
+    FunctionDebugInfo* debug = nullptr;
+
+    std::vector<JumpLink> jump_links;
+    std::vector<SymbolInstrLink> symbol_instr_links;
+    std::vector<RipFuncLink> rip_func_links;
+    std::vector<RipDataLink> rip_data_links;
+
+    // one per instruction, for the peephole optimizer
+    std::vector<MoveInfo> moves;
+    ObjectGeneratorStats stats;
+    bool optimized = false;
+  };
+
+  FunctionData& get_function_data(const InstructionRecord& rec);
+
   template <typename T>
   using seg_vector = std::array<std::vector<T>, N_SEG>;
 
@@ -220,13 +280,9 @@ class ObjectGenerator {
 
   // temp link stuff
   seg_map<StaticTypeLink> m_static_type_temp_links_by_seg;
-  seg_vector<JumpLink> m_jump_temp_links_by_seg;
-  seg_map<SymbolInstrLink> m_symbol_instr_temp_links_by_seg;
   seg_map<StaticSymbolLink> m_static_sym_temp_links_by_seg;
   seg_vector<StaticDataPointerLink> m_static_data_temp_ptr_links_by_seg;
   seg_vector<StaticFunctionPointerLink> m_static_function_temp_ptr_links_by_seg;
-  seg_vector<RipFuncLink> m_rip_func_temp_links_by_seg;
-  seg_vector<RipDataLink> m_rip_data_temp_links_by_seg;
 
   // final link stuff
   seg_map<int> m_type_ptr_links_by_seg;
@@ -235,7 +291,5 @@ class ObjectGenerator {
   seg_vector<PointerLink> m_pointer_links_by_seg;
 
   std::vector<FunctionRecord> m_all_function_records;
-
-  ObjectGeneratorStats m_stats;
 };
 }  // namespace emitter
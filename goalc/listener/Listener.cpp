@@ -28,6 +28,8 @@
 
 #include "common/cross_sockets/XSocket.h"
 #include "common/util/Assert.h"
+#include "common/util/Timer.h"
+#include "common/util/compress.h"
 #include "common/versions/versions.h"
 #include "common/log/log.h"
 
@@ -233,7 +235,7 @@ void Listener::receive_func() {
               lg::print(
                   "[Listener] WARNING: message ID jumped from {} to {}. Some messages may have "
                   "been lost. You must wait for an ACK before sending the next message.\n",
-                  last_recvd_id, hdr->msg_id);
+                  last_recvd_id.load(), hdr->msg_id);
             }
           } else {
             printf("[Listener] Got an unexpcted ACK message.");
@@ -260,7 +262,7 @@ void Listener::receive_func() {
             lg::print(
                 "[Listener] ERROR: Got an ack message with id of {}, but the last message sent "
                 "had an ID of {}.\n",
-                last_recvd_id, last_sent_id);
+                last_recvd_id.load(), last_sent_id.load());
           }
         } else {
           printf("[Listener] got invalid ack!\n");
@@ -350,7 +352,8 @@ int Listener::get_received_message_count() {
  * The load name is not actually sent to the target.  Instead, if the target loads successfully
  * and outputs a *listener* load message, this will be remapped to a load of the given name.
  */
-void Listener::send_code(std::vector<uint8_t>& code, const std::optional<std::string>& load_name) {
+void Listener::send_code(const std::vector<uint8_t>& code,
+                         const std::optional<std::string>& load_name) {
   got_ack = false;
   int total_size = code.size() + sizeof(ListenerMessageHeader);
   if (total_size > BUFFER_SIZE) {
@@ -378,6 +381,80 @@ void Listener::send_code(std::vector<uint8_t>& code, const std::optional<std::st
   send_buffer(total_size);
 }
 
+/*!
+ * Send many objects for the target to link and run, in order. This is much faster than sending them
+ * one at a time with send_code: the objects are packed into large messages, optionally compressed,
+ * and sent without waiting for each one to be acked. There's no limit on the size of an object.
+ */
+void Listener::send_code_batch(const std::vector<BatchObject>& objects, bool compress) {
+  got_ack = false;
+  if (objects.empty()) {
+    got_ack = true;
+    return;
+  }
+
+  Timer timer;
+  std::vector<u8> stream;
+  size_t total_size = 0;
+  for (const auto& object : objects) {
+    std::vector<u8> compressed;
+    if (compress) {
+      compressed = compression::compress_zstd(object.data.data(), object.data.size());
+    }
+    bool use_compressed = compress && compressed.size() < object.data.size();
+    ListenerBatchRecord record;
+    record.name_size = object.name.size();
+    record.size = object.data.size();
+    record.compressed_size = use_compressed ? compressed.size() : 0;
+    const auto& data = use_compressed ? compressed : object.data;
+
+    const u8* record_bytes = (const u8*)&record;
+    stream.insert(stream.end(), record_bytes, record_bytes + sizeof(ListenerBatchRecord));
+    stream.insert(stream.end(), object.name.begin(), object.name.end());
+    stream.insert(stream.end(), data.begin(), data.end());
+    total_size += object.data.size();
+  }
+
+  waiting_for_ack = true;
+  size_t offset = 0;
+  while (offset < stream.size()) {
+    // don't get too far ahead of the target.
+    if (last_sent_id - last_recvd_id >= LISTENER_BATCH_WINDOW &&
+        !wait_for_ack_id(last_sent_id - LISTENER_BATCH_WINDOW + 1)) {
+      printf("[Listener] Timed out waiting for ack during batch load.\n");
+      return;
+    }
+
+    u32 chunk_size = std::min(LISTENER_BATCH_CHUNK_SIZE, u32(stream.size() - offset));
+    auto* header = (ListenerMessageHeader*)m_buffer;
+    header->deci2_header.rsvd = 0;
+    header->deci2_header.len = chunk_size + sizeof(ListenerMessageHeader);
+    header->deci2_header.proto = DECI2_PROTOCOL;
+    header->deci2_header.src = 'H';
+    header->deci2_header.dst = 'E';
+    header->msg_size = chunk_size;
+    header->ltt_msg_kind = LTT_MSG_CODE_BATCH;
+    header->u6 = offset == 0 ? LISTENER_BATCH_FIRST_CHUNK : 0;
+    last_sent_id++;
+    header->msg_id = last_sent_id;
+    memcpy(header + 1, stream.data() + offset, chunk_size);
+    write_buffer(chunk_size + sizeof(ListenerMessageHeader), chunk_size);
+    offset += chunk_size;
+  }
+
+  if (!wait_for_ack_id(last_sent_id)) {
+    printf("[Listener] Timed out waiting for ack during batch load.\n");
+    return;
+  }
+  got_ack = true;
+
+  double seconds = timer.getSeconds();
+  double mb = total_size / (1024. * 1024.);
+  lg::print("[Listener] Loaded {} objects, {:.2f} MB ({:.2f} MB sent) in {:.3f} s\n",
+            objects.size(), mb, stream.size() / (1024. * 1024.), seconds);
+  lg::print("[Listener] {:.2f} MB/s, {:.1f} objects/s\n", mb / seconds, objects.size() / seconds);
+}
+
 /*!
  * Send a message to tell the target to reset. The shutdown parameter tells the target to shutdown.
  * Waits for the target to ack the shutdown message.
@@ -438,19 +515,9 @@ void Listener::send_poke() {
  * Waits for the target to respond or times out and prints an error.
  */
 void Listener::send_buffer(int sz) {
-  int wrote = 0;
-
-  if (debug_listener) {
-    fprintf(stderr, "[L -> T] sending %d bytes...\n", sz);
-  }
-
   got_ack = false;
   waiting_for_ack = true;
-  while (wrote < sz) {
-    auto to_send = std::min(512, sz - wrote);
-    auto x = write_to_socket(listen_socket, m_buffer + wrote, to_send);
-    wrote += x > 0 ? x : 0;
-  }
+  write_buffer(sz);
 
   if (debug_listener) {
     printf("  waiting for ack...\n");
@@ -467,6 +534,50 @@ void Listener::send_buffer(int sz) {
   }
 }
 
+/*!
+ * Low level write of the m_buffer, without waiting for an ack.
+ */
+void Listener::write_buffer(int sz, int max_write) {
+  int wrote = 0;
+
+  if (debug_listener) {
+    fprintf(stderr, "[L -> T] sending %d bytes...\n", sz);
+  }
+
+  while (wrote < sz) {
+    auto to_send = std::min(max_write, sz - wrote);
+    auto x = write_to_socket(listen_socket, m_buffer + wrote, to_send);
+    wrote += x > 0 ? x : 0;
+  }
+}
+
+/*!
+ * Wait for the target to ack the message with the given id, or a later one. Times out if the
+ * target takes too long between acks.
+ */
+bool Listener::wait_for_ack_id(u64 id) {
+  if (!m_connected) {
+    printf("wait_for_ack_id called when not connected!\n");
+    return false;
+  }
+
+  u64 last_id = last_recvd_id;
+  for (int i = 0; i < 2000; i++) {
+    if (last_recvd_id >= id) {
+      return true;
+    }
+    if (last_recvd_id != last_id) {
+      // the target is making progress, keep waiting.
+      last_id = last_recvd_id;
+      i = 0;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(1000));
+  }
+
+  waiting_for_ack = false;
+  return false;
+}
+
 /*!
  * Wait for the target to send an ack.
  */
@@ -9,7 +9,9 @@
 #ifndef JAK1_LISTENER_H
 #define JAK1_LISTENER_H
 
+#include <atomic>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
 #include <unordered_map>
@@ -26,6 +28,11 @@
 
 namespace listener {
 
+struct BatchObject {
+  std::string name;
+  std::vector<u8> data;
+};
+
 class Listener {
  public:
   static constexpr int BUFFER_SIZE = 32 * 1024 * 1024;
@@ -39,7 +46,9 @@ class Listener {
   void send_reset(bool shutdown);
   void send_poke();
   void disconnect();
-  void send_code(std::vector<uint8_t>& code, const std::optional<std::string>& load_name = {});
+  void send_code(const std::vector<uint8_t>& code,
+                 const std::optional<std::string>& load_name = {});
+  void send_code_batch(const std::vector<BatchObject>& objects, bool compress);
   void add_debugger(Debugger* debugger);
   bool most_recent_send_was_acked() const { return got_ack; }
   void set_default_port(GameVersion v) { m_default_port = DECI2_PORT - 1 + (int)v; }
@@ -50,7 +59,9 @@ class Listener {
   void do_unload(const std::string& name);
 
   void send_buffer(int sz);
+  void write_buffer(int sz, int max_write = 512);
   bool wait_for_ack();
+  bool wait_for_ack_id(u64 id);
   void handle_output_message(const char* msg);
 
   int m_default_port = DECI2_PORT;
@@ -72,8 +83,8 @@ class Listener {
 
   std::optional<std::string> m_pending_listener_load_object_name;
   char ack_recv_buff[512];
-  uint64_t last_sent_id = 0;
-  uint64_t last_recvd_id = 0;
+  std::atomic<uint64_t> last_sent_id = 0;
+  std::atomic<uint64_t> last_recvd_id = 0;
 };
 }  // namespace listener
 
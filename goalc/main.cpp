@@ -36,6 +36,9 @@ int main(int argc, char** argv) {
   std::string username = "#f";
   std::string game = "jak1";
   int nrepl_port = -1;
+  int make_jobs = 1;
+  fs::path build_cache_dir;
+  bool build_cache_hash_tools = false;
   fs::path project_path_override;
 
   // TODO - a lot of these flags could be deprecated and moved into `repl-config.json`
@@ -49,6 +52,12 @@ int main(int argc, char** argv) {
   app.add_option("-g,--game", game, "The game name: 'jak1' or 'jak2'");
   app.add_option("--proj-path", project_path_override,
                  "Specify the location of the 'data/' folder");
+  app.add_option("-j,--jobs", make_jobs,
+                 "Number of build steps that (make) runs at once. 0 uses one per hardware thread");
+  app.add_option("--build-cache", build_cache_dir,
+                 "Specify a folder to share build outputs through, between checkouts or CI runs");
+  app.add_flag("--build-cache-hash-tools", build_cache_hash_tools,
+               "Only share build outputs with the exact same build of goalc, for local changes");
   define_common_cli_arguments(app);
   app.validate_positionals();
   CLI11_PARSE(app, argc, argv);
@@ -91,6 +100,10 @@ int main(int argc, char** argv) {
   try {
     if (!cmd.empty()) {
       compiler = std::make_unique<Compiler>(game_version);
+      compiler->make_system().set_default_jobs(make_jobs);
+      if (!build_cache_dir.empty()) {
+        compiler->make_system().set_shared_cache_dir(build_cache_dir, build_cache_hash_tools);
+      }
       compiler->run_front_end_on_string(cmd);
       return 0;
     }
@@ -119,6 +132,10 @@ int main(int argc, char** argv) {
     compiler = std::make_unique<Compiler>(
         game_version, std::make_optional(repl_config), username,
         std::make_unique<REPL::Wrapper>(username, repl_config, startup_file, nrepl_server_ok));
+    compiler->make_system().set_default_jobs(make_jobs);
+    if (!build_cache_dir.empty()) {
+      compiler->make_system().set_shared_cache_dir(build_cache_dir, build_cache_hash_tools);
+    }
     // Start nREPL Server if it spun up successfully
     if (nrepl_server_ok) {
       nrepl_thread = std::thread([&]() {
@@ -147,6 +164,10 @@ int main(int argc, char** argv) {
         compiler = std::make_unique<Compiler>(
             game_version, std::make_optional(repl_config), username,
             std::make_unique<REPL::Wrapper>(username, repl_config, startup_file, nrepl_server_ok));
+        compiler->make_system().set_default_jobs(make_jobs);
+        if (!build_cache_dir.empty()) {
+          compiler->make_system().set_shared_cache_dir(build_cache_dir, build_cache_hash_tools);
+        }
         status = ReplStatus::OK;
       }
       // process user input
@@ -0,0 +1,319 @@
+#include "BuildDatabase.h"
+
+#include <chrono>
+#include <thread>
+
+#include "common/log/log.h"
+#include "common/versions/versions.h"
+
+#include "goalc/make/Tool.h"
+
+#include "fmt/core.h"
+#include "third-party/json.hpp"
+#include "third-party/zstd/lib/common/xxhash.h"
+
+namespace {
+// change this if the database format changes.
+constexpr int BUILD_DATABASE_VERSION = 1;
+
+std::string step_key(const std::vector<std::string>& outputs) {
+  std::string result;
+  for (auto& out : outputs) {
+    result += out;
+    result += '\n';
+  }
+  return result;
+}
+}  // namespace
+
+void BuildDatabase::load(const fs::path& db_path) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_db_path = db_path;
+  m_files.clear();
+  m_steps.clear();
+  m_pending.clear();
+  if (!fs::exists(db_path)) {
+    return;
+  }
+
+  try {
+    auto json = nlohmann::json::parse(file_util::read_text_file(db_path));
+    if (json.at("version").get<int>() != BUILD_DATABASE_VERSION) {
+      return;
+    }
+    for (const auto& [path, file] : json.at("files").items()) {
+      m_files[path] = {file.at(0).get<u64>(), file.at(1).get<s64>(), file.at(2).get<u64>()};
+    }
+    for (const auto& [key, step] : json.at("steps").items()) {
+      m_steps[key] = {step.at("deps").get<u64>(), step.at("outputs").get<std::vector<u64>>()};
+    }
+  } catch (const std::exception& e) {
+    lg::warn("Ignoring bad build database {}: {}", db_path.string(), e.what());
+    m_files.clear();
+    m_steps.clear();
+  }
+}
+
+void BuildDatabase::save() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (m_db_path.empty()) {
+    return;
+  }
+
+  nlohmann::json json;
+  json["version"] = BUILD_DATABASE_VERSION;
+  auto& files = json["files"] = nlohmann::json::object();
+  for (const auto& [path, file] : m_files) {
+    files[path] = {file.size, file.mtime, file.hash};
+  }
+  auto& steps = json["steps"] = nlohmann::json::object();
+  for (const auto& [key, step] : m_steps) {
+    steps[key] = {{"deps", step.deps_hash}, {"outputs", step.output_hashes}};
+  }
+
+  // write to a temporary file first, so an interrupted build can't leave a truncated database.
+  file_util::create_dir_if_needed_for_file(m_db_path);
+  auto temp_path = m_db_path;
+  temp_path += ".tmp";
+  file_util::write_text_file(temp_path, json.dump());
+  fs::rename(temp_path, m_db_path);
+}
+
+/*!
+ * Get the hash of a file's contents. This is only recomputed when the file's size or modification
+ * time changes. Directories all have the same hash, and missing files have none.
+ */
+std::optional<u64> BuildDatabase::file_hash(const std::string& path) {
+  auto full_path = fs::path(file_util::get_file_path({path}));
+  std::error_code ec;
+  if (fs::is_directory(full_path, ec)) {
+    return 0;
+  }
+  if (!fs::is_regular_file(full_path, ec)) {
+    return std::nullopt;
+  }
+
+  FileHash result;
+  result.size = fs::file_size(full_path);
+  result.mtime = fs::last_write_time(full_path).time_since_epoch().count();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto& it = m_files.find(path);
+    if (it != m_files.end() && it->second.size == result.size &&
+        it->second.mtime == result.mtime) {
+      return it->second.hash;
+    }
+  }
+
+  auto data = file_util::read_binary_file(full_path);
+  result.hash = XXH64(data.data(), data.size(), 0);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_files[path] = result;
+  return result.hash;
+}
+
+/*!
+ * Hash everything that goes into a step. Returns nothing if one of its files is missing.
+ */
+std::optional<u64> BuildDatabase::deps_hash(const PendingStep& step) {
+  std::string key = fmt::format("{}\n{}\n", step.tool_name, step.arg);
+  for (auto& file : step.files) {
+    auto hash = file_hash(file);
+    if (!hash) {
+      return std::nullopt;
+    }
+    key += fmt::format("{} {:x}\n", file, *hash);
+  }
+  return XXH64(key.data(), key.size(), 0);
+}
+
+bool BuildDatabase::outputs_match(const std::vector<std::string>& outputs,
+                                  const StepEntry& entry) {
+  if (outputs.size() != entry.output_hashes.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < outputs.size(); i++) {
+    if (file_hash(outputs[i]) != entry.output_hashes[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*!
+ * Check if a step needs to run. The files it uses are remembered, so they can be recorded with
+ * record once it has run.
+ */
+BuildDatabase::Status BuildDatabase::check(const std::string& tool_name,
+                                           const ToolInput& task,
+                                           const std::vector<std::string>& additional_deps) {
+  for (auto& in : task.input) {
+    if (!fs::exists(file_util::get_file_path({in}))) {
+      throw std::runtime_error(fmt::format("Input file {} does not exist.", in));
+    }
+  }
+
+  PendingStep step;
+  step.tool_name = tool_name;
+  // steps without an :arg have an invalid object, which can't be printed.
+  if (task.arg.type != goos::ObjectType::INVALID) {
+    step.arg = task.arg.print();
+  }
+  step.files = task.input;
+  step.files.insert(step.files.end(), task.deps.begin(), task.deps.end());
+  step.files.insert(step.files.end(), additional_deps.begin(), additional_deps.end());
+  auto hash = deps_hash(step);
+
+  auto key = step_key(task.output);
+  std::optional<StepEntry> entry;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending[key] = step;
+    const auto& it = m_steps.find(key);
+    if (it != m_steps.end()) {
+      entry = it->second;
+    }
+  }
+
+  if (!hash) {
+    return Status::STALE;  // don't have a dep.
+  }
+
+  if (entry && entry->deps_hash == *hash && outputs_match(task.output, *entry)) {
+    return Status::UP_TO_DATE;
+  }
+
+  if (!m_shared_cache_dir.empty()) {
+    auto restored = restore_from_shared_cache(task.output, *hash);
+    if (restored) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_steps[key] = *restored;
+      m_pending.erase(key);
+      return Status::UP_TO_DATE;
+    }
+  }
+
+  return entry ? Status::STALE : Status::UNKNOWN;
+}
+
+/*!
+ * Record the current state of a step's files, after it has run. Returns false if the step wasn't
+ * checked first.
+ */
+bool BuildDatabase::record(const std::vector<std::string>& outputs) {
+  auto key = step_key(outputs);
+  PendingStep step;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto& it = m_pending.find(key);
+    if (it == m_pending.end()) {
+      return false;
+    }
+    step = std::move(it->second);
+    m_pending.erase(it);
+  }
+
+  StepEntry entry;
+  auto hash = deps_hash(step);
+  bool valid = hash.has_value();
+  if (valid) {
+    entry.deps_hash = *hash;
+    for (auto& out : outputs) {
+      auto out_hash = file_hash(out);
+      if (!out_hash) {
+        // steps that don't produce files (like groups) always run.
+        valid = false;
+        break;
+      }
+      entry.output_hashes.push_back(*out_hash);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (valid) {
+      m_steps[key] = entry;
+    } else {
+      m_steps.erase(key);
+    }
+  }
+
+  if (valid && !m_shared_cache_dir.empty()) {
+    store_in_shared_cache(outputs, entry);
+  }
+  return true;
+}
+
+fs::path BuildDatabase::shared_cache_path(u64 deps_hash) const {
+  // outputs can be shared between builds of the same revision. Changes to the tools that change
+  // their output must increase BUILD_OUTPUT_VERSION.
+  auto key =
+      fmt::format("{} {} {:x}", build_revision(), versions::BUILD_OUTPUT_VERSION, deps_hash);
+  if (m_shared_cache_hash_tools) {
+    // build_revision only changes when cmake runs, so local builds with uncommitted changes can
+    // opt in to also checking the tools themselves. They and the common code can be in different
+    // shared libraries, so check both.
+    key += fmt::format(" {:x} {:x}", code_module_hash(reinterpret_cast<const void*>(&step_key)),
+                       code_module_hash(reinterpret_cast<const void*>(&code_module_hash)));
+  }
+  return m_shared_cache_dir / fmt::format("{:016x}", XXH64(key.data(), key.size(), 0));
+}
+
+std::optional<BuildDatabase::StepEntry> BuildDatabase::restore_from_shared_cache(
+    const std::vector<std::string>& outputs,
+    u64 deps_hash) {
+  auto dir = shared_cache_path(deps_hash);
+  if (!fs::exists(dir / "manifest.json")) {
+    return std::nullopt;
+  }
+
+  try {
+    auto manifest = nlohmann::json::parse(file_util::read_text_file(dir / "manifest.json"));
+    StepEntry entry;
+    entry.deps_hash = deps_hash;
+    entry.output_hashes = manifest.at("hashes").get<std::vector<u64>>();
+    if (entry.output_hashes.size() != outputs.size()) {
+      return std::nullopt;
+    }
+    for (size_t i = 0; i < outputs.size(); i++) {
+      file_util::copy_file(dir / std::to_string(i), file_util::get_file_path({outputs[i]}));
+    }
+    lg::info("Restored {} from the build cache", outputs.at(0));
+    return entry;
+  } catch (const std::exception& e) {
+    lg::warn("Failed to restore {} from the build cache: {}", outputs.at(0), e.what());
+    return std::nullopt;
+  }
+}
+
+void BuildDatabase::store_in_shared_cache(const std::vector<std::string>& outputs,
+                                          const StepEntry& entry) {
+  auto dir = shared_cache_path(entry.deps_hash);
+  if (fs::exists(dir)) {
+    return;
+  }
+
+  // the cache may be shared with other processes, so build the entry in a unique temporary
+  // folder, and only rename it into place once it's complete.
+  auto temp_dir = dir;
+  temp_dir += fmt::format(".{:x}.{}.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()),
+                          std::chrono::steady_clock::now().time_since_epoch().count());
+  try {
+    fs::create_directories(temp_dir);
+    for (size_t i = 0; i < outputs.size(); i++) {
+      fs::copy_file(file_util::get_file_path({outputs[i]}), temp_dir / std::to_string(i));
+    }
+    nlohmann::json manifest = {{"outputs", outputs}, {"hashes", entry.output_hashes}};
+    file_util::write_text_file(temp_dir / "manifest.json", manifest.dump());
+    std::error_code ec;
+    fs::rename(temp_dir, dir, ec);
+    if (ec) {
+      // somebody else stored the same outputs first.
+      fs::remove_all(temp_dir, ec);
+    }
+  } catch (const std::exception& e) {
+    lg::warn("Failed to store {} in the build cache: {}", outputs.at(0), e.what());
+    std::error_code ec;
+    fs::remove_all(temp_dir, ec);
+  }
+}
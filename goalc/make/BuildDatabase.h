@@ -0,0 +1,83 @@
+#pragma once
+
+/*!
+ * @file BuildDatabase.h
+ * Content hashes of the files used and produced by each make step, saved between runs.
+ * A step is up to date if its tool, argument and the contents of all its inputs and dependencies
+ * are the same as the last time it ran, and its outputs haven't been changed or removed since.
+ * Unlike comparing modification times, this isn't fooled by switching branches or touching files.
+ *
+ * Optionally, outputs can be stored in a shared cache directory (which can be used by multiple
+ * checkouts or CI runs), and restored from there when a step with the same inputs has already
+ * been built by tools of the same revision and BUILD_OUTPUT_VERSION. For local builds, where the
+ * revision doesn't change with every edit to the tools, the tool binaries can be checked too.
+ */
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/common_types.h"
+#include "common/util/FileUtil.h"
+
+struct ToolInput;
+
+class BuildDatabase {
+ public:
+  enum class Status {
+    UP_TO_DATE,  // all hashes match and the outputs exist (possibly restored from the cache)
+    STALE,       // something has changed since the step last ran
+    UNKNOWN      // the step hasn't been recorded yet
+  };
+
+  void load(const fs::path& db_path);
+  void save();
+  bool loaded() const { return !m_db_path.empty(); }
+  void set_shared_cache_dir(const fs::path& dir, bool hash_tools = false) {
+    m_shared_cache_dir = dir;
+    m_shared_cache_hash_tools = hash_tools;
+  }
+
+  Status check(const std::string& tool_name,
+               const ToolInput& task,
+               const std::vector<std::string>& additional_deps);
+  bool record(const std::vector<std::string>& outputs);
+
+ private:
+  struct FileHash {
+    u64 size = 0;
+    s64 mtime = 0;
+    u64 hash = 0;
+  };
+
+  struct StepEntry {
+    u64 deps_hash = 0;
+    std::vector<u64> output_hashes;
+  };
+
+  // the files a step uses, from the last time it was checked.
+  struct PendingStep {
+    std::string tool_name;
+    std::string arg;
+    std::vector<std::string> files;
+  };
+
+  std::optional<u64> file_hash(const std::string& path);
+  std::optional<u64> deps_hash(const PendingStep& step);
+  bool outputs_match(const std::vector<std::string>& outputs, const StepEntry& entry);
+  fs::path shared_cache_path(u64 deps_hash) const;
+  std::optional<StepEntry> restore_from_shared_cache(const std::vector<std::string>& outputs,
+                                                     u64 deps_hash);
+  void store_in_shared_cache(const std::vector<std::string>& outputs, const StepEntry& entry);
+
+  fs::path m_db_path;
+  fs::path m_shared_cache_dir;
+  bool m_shared_cache_hash_tools = false;
+
+  std::mutex m_mutex;
+  std::unordered_map<std::string, FileHash> m_files;
+  std::unordered_map<std::string, StepEntry> m_steps;
+  std::unordered_map<std::string, PendingStep> m_pending;
+};
@@ -11,11 +11,18 @@ const std::string compiler_report_base =
     "th{background-color:#4caf50;color:#fff;text-align:left;padding:12px "
     "15px;font-weight:700}tbody tr{border-bottom:1px solid #ddd}tbody td{padding:12px 15px}tbody "
     "tr:nth-child(even){background-color:#f2f2f2}tbody "
-    "tr:hover{background-color:#f1f1f1}table{margin:20px 0}</style><canvas height=75vh "
+    "tr:hover{background-color:#f1f1f1}table{margin:20px 0}#timeline{margin-left:80px}"
+    ".lane{position:relative;height:18px;margin:2px 0;background-color:#f2f2f2}.lane "
+    "span{position:absolute;left:-"
+    "80px}.step{position:absolute;top:1px;height:16px;background-color:#4caf50;"
+    "box-shadow:inset -1px 0 #fff}.crit{background-color:#e53935}</style><canvas height=75vh "
     "id=chart></canvas><br>Compare Against: <select id=compare></select> Accepted Margin of Error "
     "%: <input id=margin type=number value=15>File Regex: <input id=regex><button "
     "onclick=renderData()>Apply</button><table id=table><thead><tr "
-    "id=table-head-row><th>File<tbody id=table-body></table><script "
+    "id=table-head-row><th>File<tbody id=table-body></table>Timeline: <select id=timeline-run "
+    "onchange=renderTimeline()></select><div id=timeline></div>Code size: <select id=code-run "
+    "onchange=renderCode()></select><table><thead><tr><th>File<th>Bytes "
+    "before<th>Bytes<th>Instructions before<th>Instructions<tbody id=code-body></table><script "
     "src=https://cdn.jsdelivr.net/npm/chart.js></script><script>\n// DATA BEGINS\nconst tests = "
     "[]\n// DATA ENDS\nlet testOrder=[],tableData={};for(const test of "
     "tests)for(const[fileName,fileTime]of(testOrder.push(test.name),document.getElementById("
@@ -38,4 +45,24 @@ const std::string compiler_report_base =
     "ctx=document.getElementById(\"chart\");new "
     "Chart(ctx,{type:\"bar\",data:{labels:tests.map(e=>e.name),datasets:[{label:\"Total "
     "Time\",data:tests.map(e=>e.total),borderWidth:1}]},options:{scales:{y:{beginAtZero:!0,type:"
-    "\"logarithmic\",title:{display:!0,text:\"Seconds\"}}}}});</script>";
+    "\"logarithmic\",title:{display:!0,text:\"Seconds\"}}}}});function renderTimeline(){let "
+    "e=document.getElementById(\"timeline\"),t=tests.find(e=>e.name===document.getElementById("
+    "\"timeline-run\").value);if(e.innerHTML=\"\",!t||!t.timeline)return;let "
+    "a=Math.max(t.total,1e-9),l=\"\";for(let n=0;n<t.jobs;n++){l+=`<div class=lane><span>worker "
+    "${n}</span>`;for(let o of t.timeline.filter(e=>e.worker===n))l+=`<div "
+    "class=\"step${o.critical?\" crit\":\"\"}\" "
+    "style=\"left:${100*o.start/a}%;width:${Math.max(100*(o.end-o.start)/a,.1)}%\" "
+    "title=\"${o.file} [${o.tool}] ${(o.end-o.start).toFixed(3)}s\"></div>`;l+=\"</div>\"}"
+    "e.innerHTML=l+`<p>Critical path: ${t.critical_path.length} steps, "
+    "${t.critical_total.toFixed(3)}s of "
+    "${t.total.toFixed(3)}s</p>`}for(const e of "
+    "tests)e.timeline&&(document.getElementById(\"timeline-run\").innerHTML+=`<option>${e.name}"
+    "</option>`,document.getElementById(\"timeline-run\").value=e.name);renderTimeline();"
+    "function renderCode(){let e=document.getElementById(\"code-body\"),t=tests.find(e=>e.name===do"
+    "cument.getElementById(\"code-run\").value);if(e.innerHTML=\"\",!t||!t.code)return;let "
+    "a={bytes_before:0,bytes:0,instructions_before:0,instructions:0},l=\"\";for(let[n,o]of "
+    "Object.entries(t.code)){l+=`<tr><td>${n}</td>`;for(let r in a)a[r]+=o[r],l+=`<td>${o[r]}</td>`"
+    ";l+=\"</tr>\"}l+=\"<tr><td>total</td>\";for(let r in a)l+=`<td>${a[r]}</td>`;e.innerHTML=l+\"<"
+    "/tr>\"}for(const e of tests)e.code&&(document.getElementById(\"code-run\").innerHTML+=`<option"
+    ">${e.name}</option>`,document.getElementById(\"code-run\").value=e.name);renderCode();</script"
+    ">";
@@ -1,8 +1,15 @@
 #include "MakeSystem.h"
 
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <thread>
+
 #include "common/goos/ParseHelpers.h"
 #include "common/log/log.h"
 #include "common/util/FileUtil.h"
+#include "common/util/SimpleThreadGroup.h"
 #include "common/util/Timer.h"
 #include "common/util/string_util.h"
 
@@ -106,6 +113,11 @@ MakeSystem::MakeSystem(const std::optional<REPL::Config> repl_config, const std:
   add_tool<BuildLevel2Tool>();
   add_tool<BuildLevel3Tool>();
   add_tool<BuildActorTool>();
+
+  if (m_repl_config && !m_repl_config->build_cache_dir.empty()) {
+    m_build_db.set_shared_cache_dir(m_repl_config->build_cache_dir,
+                                    m_repl_config->build_cache_hash_tools);
+  }
 }
 
 /*!
@@ -372,9 +384,21 @@ std::vector<std::string> MakeSystem::get_dependencies(const std::string& target)
 void MakeSystem::add_tool(std::shared_ptr<Tool> tool) {
   auto& name = tool->name();
   ASSERT(m_tools.find(name) == m_tools.end());
+  tool->set_build_database(&m_build_db);
   m_tools[name] = tool;
 }
 
+/*!
+ * Save the hashes of a step's files in the build database after it has run.
+ */
+void MakeSystem::record_step(MakeStep& rule, Tool& tool) {
+  // the tool's needs_run finds the files the step uses. With :force it hasn't been called yet.
+  if (!m_build_db.record(rule.outputs)) {
+    tool.needs_run({rule.input, rule.deps, rule.outputs, rule.arg}, m_path_map);
+    m_build_db.record(rule.outputs);
+  }
+}
+
 std::vector<std::string> MakeSystem::filter_dependencies(const std::vector<std::string>& all_deps) {
   Timer timer;
   std::vector<std::string> result;
@@ -443,8 +467,52 @@ void print_input(const std::vector<std::string>& in, char end) {
 }
 }  // namespace
 
-bool MakeSystem::make(const std::string& target_in, bool force, bool verbose, bool gen_report) {
+/*!
+ * For each step in steps (given by one of its outputs), get the indices of the steps in steps that
+ * must finish before it can run. steps is in dependency order, so these always come first.
+ */
+std::vector<std::vector<int>> MakeSystem::get_step_graph(
+    const std::vector<std::string>& steps) const {
+  std::unordered_map<std::string, int> output_to_idx;
+  for (int i = 0; i < (int)steps.size(); i++) {
+    for (auto& out : m_output_to_step.at(steps[i])->outputs) {
+      output_to_idx[out] = i;
+    }
+  }
+
+  std::vector<std::vector<int>> result(steps.size());
+  for (int i = 0; i < (int)steps.size(); i++) {
+    auto& rule = m_output_to_step.at(steps[i]);
+    auto add_dep = [&](const std::string& dep) {
+      // steps that don't need to run again aren't in the list, and don't need to be waited for.
+      const auto& it = output_to_idx.find(dep);
+      if (it != output_to_idx.end() && it->second != i &&
+          std::find(result[i].begin(), result[i].end(), it->second) == result[i].end()) {
+        ASSERT(it->second < i);
+        result[i].push_back(it->second);
+      }
+    };
+    for (auto& dep : rule->deps) {
+      add_dep(dep);
+    }
+    for (auto& dep :
+         m_tools.at(rule->tool)
+             ->get_additional_dependencies({rule->input, rule->deps, rule->outputs, rule->arg},
+                                           m_path_map)) {
+      add_dep(dep);
+    }
+  }
+  return result;
+}
+
+bool MakeSystem::make(const std::string& target_in,
+                      bool force,
+                      bool verbose,
+                      bool gen_report,
+                      std::optional<int> jobs_in) {
   std::string target = m_path_map.apply_remaps(target_in);
+  m_build_db.load(file_util::get_jak_project_dir() / "out" / m_path_map.output_prefix /
+                  "build-db.json");
   auto deps = get_dependencies(target);
   //  lg::print("All deps:\n");
   //  for (auto& dep : deps) {
@@ -475,63 +543,248 @@ bool MakeSystem::make(const std::string& target_in, bool force, bool verbose, bo
                                    str_util::current_isotimestamp());
   }
 
-  Timer make_timer;
-  lg::print("Building {} targets...\n", deps.size());
-  int i = 0;
-  for (auto& to_make : deps) {
-    Timer step_timer;
-    auto& rule = m_output_to_step.at(to_make);
-    auto& tool = m_tools.at(rule->tool);
-    int percent = (100.0 * (1 + (i++)) / (deps.size())) + 0.5;
-    if (verbose) {
-      lg::print("[{:3d}%] [{:8s}] {}{}\n", percent, tool->name(), rule->input.at(0),
-                rule->input.size() > 1 ? ", ..." : "");
-    } else {
-      lg::print("[{:3d}%] [{:8s}]       ", percent, tool->name());
-      print_input(rule->input, '\r');
+  int jobs = jobs_in.value_or(m_default_jobs);
+  if (jobs <= 0) {
+    jobs = std::max(1, (int)std::thread::hardware_concurrency());
+  }
+  const int num_steps = deps.size();
+  jobs = std::max(1, std::min(jobs, num_steps));
+
+  // build a graph of the steps, and start with the ones that don't depend on anything.
+  const auto step_deps = get_step_graph(deps);
+  std::vector<int> num_waiting_on(num_steps);
+  std::vector<std::vector<int>> dependents(num_steps);
+  // ready steps are started in the same order as the serial build, so -j 1 builds in that order.
+  std::set<int> ready_parallel, ready_serial;
+  auto add_ready = [&](int idx) {
+    auto& tool = m_tools.at(m_output_to_step.at(deps[idx])->tool);
+    (tool->can_run_in_parallel() ? ready_parallel : ready_serial).insert(idx);
+  };
+  for (int i = 0; i < num_steps; i++) {
+    num_waiting_on[i] = step_deps[i].size();
+    for (int dep : step_deps[i]) {
+      dependents[dep].push_back(i);
     }
-
-    bool success = false;
-    try {
-      success = tool->run({rule->input, rule->deps, rule->outputs, rule->arg}, m_path_map);
-    } catch (std::exception& e) {
-      lg::print("\n");
-      lg::print("Error: {}\n", e.what());
+    if (num_waiting_on[i] == 0) {
+      add_ready(i);
     }
-    if (!success) {
-      lg::print("Build failed on {}{}\n", rule->input.at(0), rule->input.size() > 1 ? ", ..." : "");
-      throw std::runtime_error("Build failed.");
-      return false;
+  }
+
+  struct StepTiming {
+    int worker = -1;
+    double start = 0;
+    double end = 0;
+  };
+  std::vector<StepTiming> timings(num_steps);
+  std::vector<std::string> report_data(num_steps);
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  int num_started = 0;
+  int num_done = 0;
+  bool failed = false;
+
+  Timer make_timer;
+  if (jobs > 1) {
+    lg::print("Building {} targets with {} jobs...\n", num_steps, jobs);
+  } else {
+    lg::print("Building {} targets...\n", num_steps);
+  }
+
+  auto print_prefix = [&](int percent, const std::string& tool, int worker) {
+    lg::print("[{:3d}%] [{:8s}] ", percent, tool);
+    if (jobs > 1) {
+      lg::print("#{:<2d} ", worker);
     }
+  };
+
+  // worker 0 is this thread, and is the only one that runs steps that can't run in parallel.
+  auto run_worker = [&](int worker) {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!failed && num_done < num_steps) {
+      std::set<int>* queue = ready_parallel.empty() ? nullptr : &ready_parallel;
+      if (worker == 0 && !ready_serial.empty() &&
+          (!queue || *ready_serial.begin() < *queue->begin())) {
+        queue = &ready_serial;
+      }
+      if (!queue) {
+        cv.wait(lock);
+        continue;
+      }
 
-    const auto seconds = step_timer.getSeconds();
-    if (verbose) {
-      if (seconds > 0.05) {
-        lg::print(fg(fmt::color::yellow), " {:.3f}\n", seconds);
-      } else {
-        lg::print(" {:.3f}\n", seconds);
+      int idx = *queue->begin();
+      queue->erase(queue->begin());
+      auto& rule = m_output_to_step.at(deps[idx]);
+      auto& tool = m_tools.at(rule->tool);
+      int percent = (100.0 * (1 + (num_started++)) / (num_steps)) + 0.5;
+      timings[idx].worker = worker;
+      timings[idx].start = make_timer.getSeconds();
+
+      if (verbose) {
+        if (jobs > 1) {
+          print_prefix(percent, tool->name(), worker);
+          lg::print("{}{}\n", rule->input.at(0), rule->input.size() > 1 ? ", ..." : "");
+        } else {
+          lg::print("[{:3d}%] [{:8s}] {}{}\n", percent, tool->name(), rule->input.at(0),
+                    rule->input.size() > 1 ? ", ..." : "");
+        }
+      } else if (jobs == 1) {
+        lg::print("[{:3d}%] [{:8s}]       ", percent, tool->name());
+        print_input(rule->input, '\r');
       }
-    } else {
-      if (seconds > 0.05) {
-        lg::print("[{:3d}%] [{:8s}] ", percent, tool->name());
-        lg::print(fg(fmt::color::yellow), "{:.3f} ", seconds);
-        print_input(rule->input, '\n');
+
+      lock.unlock();
+      bool success = false;
+      try {
+        const ToolInput task = {rule->input, rule->deps, rule->outputs, rule->arg};
+        success = tool->run(task, m_path_map);
+        if (success) {
+          record_step(*rule, *tool);
+          if (gen_report) {
+            report_data[idx] = tool->get_report_data(task);
+          }
+        }
+      } catch (std::exception& e) {
+        lg::print("\n");
+        lg::print("Error: {}\n", e.what());
+      }
+      lock.lock();
+
+      timings[idx].end = make_timer.getSeconds();
+      num_done++;
+      if (!success) {
+        lg::print("Build failed on {}{}\n", rule->input.at(0),
+                  rule->input.size() > 1 ? ", ..." : "");
+        failed = true;
+        cv.notify_all();
+        break;
+      }
+
+      for (int dependent : dependents[idx]) {
+        if (--num_waiting_on[dependent] == 0) {
+          add_ready(dependent);
+        }
+      }
+      cv.notify_all();
+
+      const auto seconds = timings[idx].end - timings[idx].start;
+      if (verbose && jobs == 1) {
+        if (seconds > 0.05) {
+          lg::print(fg(fmt::color::yellow), " {:.3f}\n", seconds);
+        } else {
+          lg::print(" {:.3f}\n", seconds);
+        }
       } else {
-        lg::print("[{:3d}%] [{:8s}] {:.3f} ", percent, tool->name(), seconds);
+        print_prefix(percent, tool->name(), worker);
+        if (seconds > 0.05) {
+          lg::print(fg(fmt::color::yellow), "{:.3f} ", seconds);
+        } else {
+          lg::print("{:.3f} ", seconds);
+        }
         print_input(rule->input, '\n');
       }
     }
+  };
 
-    if (gen_report) {
-      report_contents +=
-          fmt::format("\"{}\": {}{}", str_util::split_string(rule->input.at(0), "/").back(),
-                      seconds, i == deps.size() ? "" : ",");
+  SimpleThreadGroup threads;
+  if (jobs > 1) {
+    threads.run([&](int i) { run_worker(i + 1); }, jobs - 1, jobs - 1);
+  }
+  run_worker(0);
+  if (jobs > 1) {
+    threads.join();
+  }
+  m_build_db.save();
+  if (failed) {
+    throw std::runtime_error("Build failed.");
+    return false;
+  }
+
+  const double total_seconds = make_timer.getSeconds();
+  lg::print("\nSuccessfully built all {} targets in {:.3f}s\n", num_steps, total_seconds);
+
+  // the critical path is the longest chain of steps that depend on each other. Building can't
+  // finish faster than this, no matter how many jobs are used.
+  std::vector<double> path_end(num_steps);
+  std::vector<int> path_prev(num_steps, -1);
+  int critical_end = -1;
+  for (int i = 0; i < num_steps; i++) {
+    for (int dep : step_deps[i]) {
+      if (path_end[dep] > path_end[i]) {
+        path_end[i] = path_end[dep];
+        path_prev[i] = dep;
+      }
+    }
+    path_end[i] += timings[i].end - timings[i].start;
+    if (critical_end == -1 || path_end[i] > path_end[critical_end]) {
+      critical_end = i;
+    }
+  }
+  std::vector<int> critical_path;
+  for (int i = critical_end; i != -1; i = path_prev[i]) {
+    critical_path.push_back(i);
+  }
+  std::reverse(critical_path.begin(), critical_path.end());
+  std::vector<bool> on_critical_path(num_steps, false);
+  for (int i : critical_path) {
+    on_critical_path[i] = true;
+  }
+
+  if (!critical_path.empty()) {
+    lg::print("Critical path: {} steps, {:.3f}s\n", critical_path.size(),
+              path_end[critical_end]);
+    if (verbose) {
+      for (int i : critical_path) {
+        lg::print("  {:.3f} ", timings[i].end - timings[i].start);
+        print_input(m_output_to_step.at(deps[i])->input, '\n');
+      }
     }
   }
-  lg::print("\nSuccessfully built all {} targets in {:.3f}s\n", deps.size(),
-            make_timer.getSeconds());
+  if (jobs > 1) {
+    for (int worker = 0; worker < jobs; worker++) {
+      int count = 0;
+      double busy = 0;
+      for (auto& timing : timings) {
+        if (timing.worker == worker) {
+          count++;
+          busy += timing.end - timing.start;
+        }
+      }
+      lg::print("  worker {:2d}: {:4d} steps, busy {:.3f}s ({:.0f}%)\n", worker, count, busy,
+                total_seconds > 0 ? 100. * busy / total_seconds : 0.);
+    }
+  }
+
   if (gen_report) {
-    report_contents += fmt::format("}}, 'total': {}}});", make_timer.getSeconds());
+    std::string timeline;
+    std::string code;
+    for (int i = 0; i < num_steps; i++) {
+      auto& rule = m_output_to_step.at(deps[i]);
+      auto file_name = str_util::split_string(rule->input.at(0), "/").back();
+      const char* sep = i + 1 == num_steps ? "" : ",";
+      report_contents +=
+          fmt::format("\"{}\": {}{}", file_name, timings[i].end - timings[i].start, sep);
+      timeline += fmt::format(
+          "{{'file': \"{}\", 'tool': \"{}\", 'worker': {}, 'start': {}, 'end': {}, 'critical': "
+          "{}}}{}",
+          file_name, rule->tool, timings[i].worker, timings[i].start, timings[i].end,
+          (bool)on_critical_path[i], sep);
+      if (!report_data[i].empty()) {
+        code += fmt::format("{}\"{}\": {}", code.empty() ? "" : ",", file_name, report_data[i]);
+      }
+    }
+    std::string critical_names;
+    for (size_t i = 0; i < critical_path.size(); i++) {
+      auto& rule = m_output_to_step.at(deps[critical_path[i]]);
+      critical_names +=
+          fmt::format("\"{}\"{}", str_util::split_string(rule->input.at(0), "/").back(),
+                      i + 1 == critical_path.size() ? "" : ",");
+    }
+    report_contents += fmt::format(
+        "}}, 'total': {}, 'jobs': {}, 'timeline': [{}], 'critical_path': [{}], 'critical_total': "
+        "{}, 'code': {{{}}}}});",
+        total_seconds, jobs, timeline, critical_names,
+        critical_path.empty() ? 0. : path_end[critical_end], code);
     str_util::replace(report_output, "// DATA ENDS\n",
                       fmt::format("{}\n// DATA ENDS\n", report_contents));
     file_util::write_text_file(report_path, report_output);
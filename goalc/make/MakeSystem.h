@@ -2,6 +2,7 @@
 
 #include "common/goos/Interpreter.h"
 
+#include "goalc/make/BuildDatabase.h"
 #include "goalc/make/Tool.h"
 
 struct MakeStep {
@@ -57,7 +58,11 @@ class MakeSystem {
   std::vector<std::string> get_dependencies(const std::string& target) const;
   std::vector<std::string> filter_dependencies(const std::vector<std::string>& all_deps);
 
-  bool make(const std::string& target, bool force, bool verbose, bool gen_report);
+  bool make(const std::string& target,
+            bool force,
+            bool verbose,
+            bool gen_report,
+            std::optional<int> jobs = {});
 
   void add_tool(std::shared_ptr<Tool> tool);
   void set_constant(const std::string& name, const std::string& value);
@@ -77,6 +82,20 @@ class MakeSystem {
    */
   const std::string& compiler_output_prefix() const { return m_path_map.output_prefix; }
 
+  /*!
+   * Set the number of steps that make runs at once, if it isn't given one. 0 is one per hardware
+   * thread.
+   */
+  void set_default_jobs(int jobs) { m_default_jobs = jobs; }
+
+  /*!
+   * Set a folder to share build outputs through, see BuildDatabase.h. With hash_tools, outputs are
+   * only shared with the exact same build of the tools.
+   */
+  void set_shared_cache_dir(const fs::path& dir, bool hash_tools = false) {
+    m_build_db.set_shared_cache_dir(dir, hash_tools);
+  }
+
  private:
   void va_check(const goos::Object& form,
                 const goos::Arguments& args,
@@ -89,6 +108,9 @@ class MakeSystem {
                         std::vector<std::string>* result_order,
                         std::unordered_set<std::string>* result_set) const;
 
+  std::vector<std::vector<int>> get_step_graph(const std::vector<std::string>& steps) const;
+  void record_step(MakeStep& rule, Tool& tool);
+
   goos::Interpreter m_goos;
 
   std::optional<REPL::Config> m_repl_config;
@@ -99,4 +121,6 @@ class MakeSystem {
   PathMap m_path_map;
   std::vector<std::string> m_gsrc_folder;
   std::map<std::string, std::string> m_gsrc_files = {};
+  int m_default_jobs = 1;
+  BuildDatabase m_build_db;
 };
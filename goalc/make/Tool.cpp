@@ -5,11 +5,37 @@
 
 #include "common/util/FileUtil.h"
 
+#include "goalc/make/BuildDatabase.h"
+
 #include "fmt/core.h"
 
 Tool::Tool(const std::string& name) : m_name(name) {}
 
 bool Tool::needs_run(const ToolInput& task, const PathMap& path_map) {
+  auto additional_deps = get_additional_dependencies(task, path_map);
+  if (!m_build_db || !m_build_db->loaded()) {
+    return needs_run_by_timestamp(task, additional_deps);
+  }
+
+  switch (m_build_db->check(name(), task, additional_deps)) {
+    case BuildDatabase::Status::UP_TO_DATE:
+      return false;
+    case BuildDatabase::Status::STALE:
+      return true;
+    case BuildDatabase::Status::UNKNOWN:
+    default:
+      // the step has never been recorded, so fall back to timestamps. If those say it's up to
+      // date, record it now so it doesn't have to be rebuilt just to get into the database.
+      if (needs_run_by_timestamp(task, additional_deps)) {
+        return true;
+      }
+      m_build_db->record(task.output);
+      return false;
+  }
+}
+
+bool Tool::needs_run_by_timestamp(const ToolInput& task,
+                                  const std::vector<std::string>& additional_deps) const {
   // for this to return false, all outputs need to be newer than all inputs.
 
   for (auto& in : task.input) {
@@ -32,7 +58,7 @@ bool Tool::needs_run(const ToolInput& task, const PathMap& path_map) {
       }
     }
 
-    for (auto& dep : get_additional_dependencies(task, path_map)) {
+    for (auto& dep : additional_deps) {
       auto dep_path = fs::path(file_util::get_file_path({dep}));
       if (fs::exists(dep_path)) {
         auto dep_time = fs::last_write_time(dep_path);
@@ -6,6 +6,8 @@
 
 #include "common/goos/Object.h"
 
+class BuildDatabase;
+
 struct PathMap {
   std::string output_prefix;
   std::unordered_map<std::string, std::string> path_remap;
@@ -28,10 +30,25 @@ class Tool {
     return {};
   }
   virtual bool needs_run(const ToolInput& task, const PathMap& path_map);
+  /*!
+   * If false, steps using this tool are only run on the thread that called make, one at a time.
+   * Tools that return true must be safe to run at the same time as any other step.
+   */
+  virtual bool can_run_in_parallel() const { return true; }
+  /*!
+   * Extra data about the last run of this tool for the make report, as a JavaScript object, or
+   * empty if there is none. Called right after run, on the same thread.
+   */
+  virtual std::string get_report_data(const ToolInput&) { return ""; }
   virtual ~Tool() = default;
 
   const std::string& name() const { return m_name; }
+  void set_build_database(BuildDatabase* db) { m_build_db = db; }
 
  private:
+  bool needs_run_by_timestamp(const ToolInput& task,
+                              const std::vector<std::string>& additional_deps) const;
+
   std::string m_name;
+  BuildDatabase* m_build_db = nullptr;
 };
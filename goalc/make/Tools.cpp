@@ -43,6 +43,13 @@ bool CompilerTool::run(const ToolInput& task, const PathMap& /*path_map*/) {
   return true;
 }
 
+std::string CompilerTool::get_report_data(const ToolInput& /*task*/) {
+  const auto& stats = m_compiler->last_object_stats();
+  return fmt::format(
+      "{{'bytes_before': {}, 'bytes': {}, 'instructions_before': {}, 'instructions': {}}}",
+      stats.code_bytes_before, stats.code_bytes, stats.instructions_before, stats.instructions);
+}
+
 namespace {
 DgoDescription parse_desc_file(const std::string& filename, goos::Reader& reader) {
   auto& dgo_desc = reader.read_from_file({filename}).as_pair()->cdr;
@@ -88,7 +95,11 @@ bool DgoTool::run(const ToolInput& task, const PathMap& path_map) {
   if (task.input.size() != 1) {
     throw std::runtime_error(fmt::format("Invalid amount of inputs to {} tool", name()));
   }
-  auto desc = parse_desc_file(task.input.at(0), m_reader);
+  DgoDescription desc;
+  {
+    std::lock_guard<std::mutex> lock(m_reader_mutex);
+    desc = parse_desc_file(task.input.at(0), m_reader);
+  }
   build_dgo(desc, path_map.output_prefix);
   return true;
 }
@@ -96,6 +107,7 @@ bool DgoTool::run(const ToolInput& task, const PathMap& path_map) {
 std::vector<std::string> DgoTool::get_additional_dependencies(const ToolInput& task,
                                                               const PathMap& path_map) {
   std::vector<std::string> result;
+  std::lock_guard<std::mutex> lock(m_reader_mutex);
   auto desc = parse_desc_file(task.input.at(0), m_reader);
   for (auto& x : desc.entries) {
     // todo out
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <mutex>
+
 #include "common/goos/Reader.h"
 
 #include "goalc/make/Tool.h"
@@ -11,6 +13,9 @@ class CompilerTool : public Tool {
   CompilerTool(Compiler* compiler);
   bool run(const ToolInput& task, const PathMap& path_map) override;
   bool needs_run(const ToolInput& task, const PathMap& path_map) override;
+  // the compiler isn't thread safe, and has to run on the same thread as the REPL.
+  bool can_run_in_parallel() const override { return false; }
+  std::string get_report_data(const ToolInput& task) override;
 
  private:
   Compiler* m_compiler = nullptr;
@@ -24,6 +29,7 @@ class DgoTool : public Tool {
                                                        const PathMap& path_map) override;
 
  private:
+  std::mutex m_reader_mutex;
   goos::Reader m_reader;
 };
 
@@ -0,0 +1,48 @@
+#include "decompiler/IR2/Form.h"
+#include "gtest/gtest.h"
+
+using namespace decompiler;
+
+TEST(DecompilerFormPool, AllocatesFormsAndElements) {
+  FormPool pool;
+  auto* elt = pool.alloc_element<ConstantTokenElement>("foo");
+  auto* form = pool.alloc_single_form(nullptr, elt);
+  auto* seq = pool.alloc_sequence_form(nullptr, {pool.alloc_element<ConstantTokenElement>("a"),
+                                                 pool.alloc_element<ConstantTokenElement>("b")});
+  auto* empty = pool.alloc_empty_form();
+
+  EXPECT_EQ(form->try_as_single_element(), elt);
+  EXPECT_EQ(elt->parent_form, form);
+  EXPECT_EQ(seq->size(), 2);
+  EXPECT_EQ(seq->at(1)->parent_form, seq);
+  EXPECT_EQ(empty->size(), 0);
+  EXPECT_EQ(dynamic_cast<ConstantTokenElement*>(elt)->value(), "foo");
+
+  EXPECT_EQ(pool.stats().forms, 3);
+  EXPECT_EQ(pool.stats().elements, 3);
+  EXPECT_EQ(pool.stats().blocks, 1);
+  EXPECT_EQ(pool.stats().bytes, 3 * sizeof(Form) + 3 * sizeof(ConstantTokenElement));
+}
+
+TEST(DecompilerFormPool, GrowsBlocks) {
+  FormPool pool;
+  std::vector<Form*> forms;
+  for (int i = 0; i < 100000; i++) {
+    forms.push_back(pool.form<ConstantTokenElement>(std::to_string(i)));
+  }
+
+  // everything is still there after allocating new blocks.
+  for (int i = 0; i < (int)forms.size(); i++) {
+    auto* elt = dynamic_cast<ConstantTokenElement*>(forms[i]->try_as_single_element());
+    ASSERT_TRUE(elt);
+    EXPECT_EQ(elt->value(), std::to_string(i));
+    EXPECT_EQ((uintptr_t)forms[i] % alignof(Form), 0);
+  }
+
+  const auto& stats = pool.stats();
+  EXPECT_EQ(stats.forms, forms.size());
+  EXPECT_GT(stats.blocks, 1);
+  EXPECT_LE(stats.bytes, stats.block_bytes);
+  // blocks grow, so this doesn't take thousands of small blocks.
+  EXPECT_LT(stats.blocks, 100);
+}
@@ -0,0 +1,59 @@
+#include "common/type_system/Type.h"
+
+#include "decompiler/ObjectFile/Ir2Cache.h"
+#include "decompiler/ObjectFile/ObjectFileDB.h"
+#include "decompiler/config.h"
+#include "decompiler/util/DecompilerTypeSystem.h"
+#include "gtest/gtest.h"
+
+using namespace decompiler;
+
+namespace {
+void add_enum(DecompilerTypeSystem& dts, const std::unordered_map<std::string, s64>& entries) {
+  auto* parent = dynamic_cast<ValueType*>(dts.ts.lookup_type("uint32"));
+  dts.ts.add_type("test-enum", std::make_unique<EnumType>(parent, "test-enum", false, entries));
+}
+}  // namespace
+
+TEST(Ir2Cache, EnumChangeMisses) {
+  auto dir = fs::temp_directory_path() / "test_ir2_cache";
+  fs::remove_all(dir);
+  Config config;
+  ObjectFileData data(GameVersion::Jak1);
+  data.name_from_map = "test-object";
+  data.data = {1, 2, 3, 4};
+
+  // decompile with the first version of the enum.
+  u64 key = 0;
+  {
+    DecompilerTypeSystem dts(GameVersion::Jak1);
+    add_enum(dts, {{"a", 1}, {"b", 2}});
+    Ir2Cache cache(dir, config, dts);
+    key = cache.compute_key(data, config);
+    EXPECT_FALSE(cache.lookup(data, key));
+    cache.store(data, key, {"test-enum"}, {{{"test-object_ir2.asm", "text"}}, {}, ""}, 1.0);
+    EXPECT_TRUE(cache.lookup(data, key));
+  }
+
+  // same enum: the entry is used.
+  {
+    DecompilerTypeSystem dts(GameVersion::Jak1);
+    add_enum(dts, {{"b", 2}, {"a", 1}});
+    Ir2Cache cache(dir, config, dts);
+    EXPECT_EQ(key, cache.compute_key(data, config));
+    auto result = cache.lookup(data, key);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(result->files.at(0).second, "text");
+  }
+
+  // a changed value, or a new entry, makes the entry stale.
+  for (const auto& entries : std::vector<std::unordered_map<std::string, s64>>{
+           {{"a", 1}, {"b", 3}}, {{"a", 1}, {"b", 2}, {"c", 4}}}) {
+    DecompilerTypeSystem dts(GameVersion::Jak1);
+    add_enum(dts, entries);
+    Ir2Cache cache(dir, config, dts);
+    EXPECT_EQ(key, cache.compute_key(data, config));
+    EXPECT_FALSE(cache.lookup(data, key));
+  }
+  fs::remove_all(dir);
+}
@@ -0,0 +1,61 @@
+#include "FormRegressionTest.h"
+
+#include "decompiler/types2/types2.h"
+
+#include "gtest/gtest.h"
+
+using namespace decompiler;
+
+TEST_F(FormRegressionTestJak1, Types2Loop) {
+  std::string func =
+      "    sll r0, r0, 0\n"
+      "L285:\n"
+      "    lwu v1, -4(a0)\n"
+      "    lw a0, object(s7)\n"
+
+      "L286:\n"
+      "    bne v1, a1, L287\n"
+      "    or a2, s7, r0\n"
+
+      "    daddiu v1, s7, #t\n"
+      "    or v0, v1, r0\n"
+      "    beq r0, r0, L288\n"
+      "    sll r0, r0, 0\n"
+
+      "    or v1, r0, r0\n"
+      "L287:\n"
+      "    lwu v1, 4(v1)\n"
+      "    bne v1, a0, L286\n"
+      "    sll r0, r0, 0\n"
+      "    or v0, s7, r0\n"
+      "L288:\n"
+      "    jr ra\n"
+      "    daddu sp, sp, r0";
+  auto type = dts->parse_type_spec("(function basic type symbol)");
+  auto test = make_function(func, type, TestSettings());
+  ASSERT_TRUE(test);
+
+  types2::Input in;
+  types2::Output out;
+  in.func = &test->func;
+  in.function_type = type;
+  in.dts = dts.get();
+  types2::run(out, in);
+  ASSERT_TRUE(out.succeeded);
+
+  // the original type pass gets the same types for every op of this function.
+  const auto& env = test->func.ir2.env;
+  ASSERT_EQ(out.op_end_types.size(), test->func.ir2.atomic_ops->ops.size());
+  for (size_t i = 0; i < out.op_end_types.size(); i++) {
+    EXPECT_EQ(out.op_end_types[i].print_gpr_masked(0xffffffff),
+              env.get_types_after_op(i).print_gpr_masked(0xffffffff));
+  }
+
+  // the loop needs more than one sweep, but blocks only run again when their inputs change.
+  EXPECT_EQ(out.stats.functions, 1u);
+  EXPECT_EQ(out.stats.blocks, 6u);  // the block with the "or v1, r0, r0" is unreachable
+  EXPECT_GT(out.stats.sweeps, 1u);
+  EXPECT_GE(out.stats.block_runs, out.stats.blocks);
+  EXPECT_LT(out.stats.block_runs, out.stats.blocks * out.stats.sweeps);
+  EXPECT_GT(out.stats.joins_changed, 0u);
+}
@@ -0,0 +1,116 @@
+#include "common/util/FileUtil.h"
+
+#include "goalc/make/BuildDatabase.h"
+#include "goalc/make/Tool.h"
+#include "gtest/gtest.h"
+
+namespace {
+class BuildDatabaseTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    m_dir = file_util::get_file_path({"test/goalc/source_generated/build_db"});
+    fs::remove_all(m_dir);
+    fs::create_directories(m_dir / "cache");
+    write("in.txt", "input");
+    write("dep.txt", "dep");
+    write("out.txt", "output");
+  }
+
+  void TearDown() override { fs::remove_all(m_dir); }
+
+  void write(const std::string& name, const std::string& text) {
+    file_util::write_text_file(m_dir / name, text);
+  }
+
+  std::string path(const std::string& name) {
+    return "test/goalc/source_generated/build_db/" + name;
+  }
+
+  BuildDatabase::Status check(BuildDatabase& db) {
+    return db.check("test", {m_input, m_deps, m_output, {}}, {});
+  }
+
+  fs::path m_dir;
+  std::vector<std::string> m_input = {path("in.txt")};
+  std::vector<std::string> m_deps = {path("dep.txt")};
+  std::vector<std::string> m_output = {path("out.txt")};
+};
+}  // namespace
+
+TEST_F(BuildDatabaseTest, SkipsUnchangedSteps) {
+  BuildDatabase db;
+  db.load(m_dir / "build-db.json");
+  EXPECT_EQ(check(db), BuildDatabase::Status::UNKNOWN);
+  EXPECT_TRUE(db.record(m_output));
+  db.save();
+
+  // rewriting files with the same contents doesn't matter, and the database is kept between runs.
+  BuildDatabase db2;
+  db2.load(m_dir / "build-db.json");
+  write("dep.txt", "dep");
+  EXPECT_EQ(check(db2), BuildDatabase::Status::UP_TO_DATE);
+
+  write("dep.txt", "changed");
+  EXPECT_EQ(check(db2), BuildDatabase::Status::STALE);
+  EXPECT_TRUE(db2.record(m_output));
+  EXPECT_EQ(check(db2), BuildDatabase::Status::UP_TO_DATE);
+
+  // changed or missing outputs have to be built again.
+  write("out.txt", "modified");
+  EXPECT_EQ(check(db2), BuildDatabase::Status::STALE);
+  fs::remove(m_dir / "out.txt");
+  EXPECT_EQ(check(db2), BuildDatabase::Status::STALE);
+}
+
+TEST_F(BuildDatabaseTest, RecordNeedsCheck) {
+  BuildDatabase db;
+  db.load(m_dir / "build-db.json");
+  EXPECT_FALSE(db.record(m_output));
+  check(db);
+  EXPECT_TRUE(db.record(m_output));
+  EXPECT_FALSE(db.record(m_output));
+}
+
+TEST_F(BuildDatabaseTest, SharedCache) {
+  BuildDatabase db;
+  db.set_shared_cache_dir(m_dir / "cache");
+  db.load(m_dir / "build-db.json");
+  check(db);
+  db.record(m_output);
+
+  // a different checkout, with the same inputs but no outputs.
+  auto output = file_util::read_text_file(m_dir / "out.txt");
+  fs::remove(m_dir / "out.txt");
+  BuildDatabase db2;
+  db2.set_shared_cache_dir(m_dir / "cache");
+  db2.load(m_dir / "other-db.json");
+  EXPECT_EQ(check(db2), BuildDatabase::Status::UP_TO_DATE);
+  EXPECT_EQ(file_util::read_text_file(m_dir / "out.txt"), output);
+
+  write("in.txt", "different input");
+  fs::remove(m_dir / "out.txt");
+  EXPECT_EQ(check(db2), BuildDatabase::Status::STALE);
+  EXPECT_FALSE(fs::exists(m_dir / "out.txt"));
+}
+
+TEST_F(BuildDatabaseTest, SharedCacheHashTools) {
+  BuildDatabase db;
+  db.set_shared_cache_dir(m_dir / "cache", true);
+  db.load(m_dir / "build-db.json");
+  check(db);
+  db.record(m_output);
+  fs::remove(m_dir / "out.txt");
+
+  // outputs stored by an exact build of the tools are only restored by one that asks for it.
+  BuildDatabase db2;
+  db2.set_shared_cache_dir(m_dir / "cache");
+  db2.load(m_dir / "other-db.json");
+  EXPECT_EQ(check(db2), BuildDatabase::Status::UNKNOWN);
+  EXPECT_FALSE(fs::exists(m_dir / "out.txt"));
+
+  BuildDatabase db3;
+  db3.set_shared_cache_dir(m_dir / "cache", true);
+  db3.load(m_dir / "third-db.json");
+  EXPECT_EQ(check(db3), BuildDatabase::Status::UP_TO_DATE);
+  EXPECT_TRUE(fs::exists(m_dir / "out.txt"));
+}
@@ -0,0 +1,36 @@
+#include "common/type_system/TypeSystem.h"
+
+#include "goalc/compiler/ObjectCache.h"
+#include "gtest/gtest.h"
+
+namespace {
+void define_enum(TypeSystem& ts, const std::unordered_map<std::string, s64>& entries) {
+  auto* parent = ts.get_type_of_type<ValueType>("uint32");
+  ts.add_type("test-enum", std::make_unique<EnumType>(parent, "test-enum", false, entries));
+}
+}  // namespace
+
+TEST(ObjectCache, RedefinedEnumIsStale) {
+  TypeSystem ts;
+  ts.add_builtin_types(GameVersion::Jak1);
+  ts.add_type_to_allowed_redefinition_list("test-enum");
+  define_enum(ts, {{"a", 1}, {"b", 2}});
+
+  ObjectCache cache(ts);
+  u64 key = cache.compute_key("test.gc", "(test-enum b)", "");
+  ObjectCache::Dependencies deps;
+  deps.types.insert("test-enum");
+  ObjectCache::Result result;
+  result.data = {1, 2, 3};
+  cache.store("test", key, deps, std::move(result), 1.0);
+  ASSERT_TRUE(cache.lookup("test", key));
+  EXPECT_EQ(cache.lookup("test", key)->data, std::vector<u8>({1, 2, 3}));
+
+  // the same definition again is fine.
+  define_enum(ts, {{"b", 2}, {"a", 1}});
+  EXPECT_TRUE(cache.lookup("test", key));
+
+  // a different value means the object was compiled with the old one.
+  define_enum(ts, {{"a", 1}, {"b", 3}});
+  EXPECT_FALSE(cache.lookup("test", key));
+}
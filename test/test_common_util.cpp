@@ -3,9 +3,11 @@
 #include <unordered_set>
 #include <vector>
 
+#include "common/link_types.h"
 #include "common/util/Assert.h"
 #include "common/util/BitUtils.h"
 #include "common/util/CopyOnWrite.h"
+#include "common/util/DgoReader.h"
 #include "common/util/FileUtil.h"
 #include "common/util/Range.h"
 #include "common/util/SmallVector.h"
@@ -19,6 +21,7 @@
 #include "test/all_jak1_symbols.h"
 
 #include "fmt/core.h"
+#include "third-party/lzokay/lzokay.hpp"
 
 TEST(CommonUtil, CpuInfo) {
   setup_cpu_info();
@@ -154,6 +157,84 @@ TEST(CommonUtil, PowerOfTwo) {
   EXPECT_EQ(get_power_of_two(u64(1) << 63), 63);
 }
 
+TEST(CommonUtil, DecompressDgo) {
+  constexpr size_t kChunkSize = 0x8000;
+  // enough data for many chunks (so it's done in parallel), with a partial chunk at the end.
+  std::vector<u8> original(kChunkSize * 40 + 1234);
+  for (size_t i = 0; i < original.size(); i++) {
+    original[i] = (i / 7) % 13;
+  }
+  // this chunk doesn't compress, so it's stored as is.
+  for (size_t i = 0; i < kChunkSize; i++) {
+    original[kChunkSize * 3 + i] = (i * 2654435761u) >> 24;
+  }
+
+  std::vector<u8> compressed = {'o', 'Z', 'l', 'B'};
+  auto add_u32 = [&](u32 x) {
+    compressed.insert(compressed.end(), (u8*)&x, (u8*)&x + 4);
+  };
+  add_u32(original.size());
+  for (size_t offset = 0; offset < original.size(); offset += kChunkSize) {
+    size_t size = std::min(kChunkSize, original.size() - offset);
+    std::vector<u8> chunk(lzokay::compress_worst_size(size));
+    size_t chunk_size = 0;
+    ASSERT_EQ(lzokay::compress(original.data() + offset, size, chunk.data(), chunk.size(),
+                               chunk_size),
+              lzokay::EResult::Success);
+    if (chunk_size >= kChunkSize) {
+      chunk.assign(original.begin() + offset, original.begin() + offset + kChunkSize);
+    }
+    chunk.resize(std::min(chunk_size, kChunkSize));
+    add_u32(chunk.size());
+    compressed.insert(compressed.end(), chunk.begin(), chunk.end());
+    while (compressed.size() % 4) {
+      compressed.push_back(0);
+    }
+  }
+
+  EXPECT_EQ(file_util::decompress_dgo(compressed), original);
+}
+
+TEST(CommonUtil, WriteBinaryFileAtomic) {
+  auto path = fs::temp_directory_path() / "test_write_atomic.bin";
+  auto temp_path = path;
+  temp_path += ".tmp";
+  std::vector<u8> old_data(100, 1), new_data(5000, 2);
+  file_util::write_binary_file(path, old_data.data(), old_data.size());
+
+  EXPECT_TRUE(file_util::write_binary_file_atomic(path, new_data.data(), new_data.size()));
+  EXPECT_EQ(file_util::read_binary_file(path), new_data);
+  EXPECT_FALSE(fs::exists(temp_path));
+
+  // writing into a directory that does not exist fails, and leaves nothing behind.
+  auto bad_path = fs::temp_directory_path() / "test_write_atomic_missing" / "file.bin";
+  EXPECT_FALSE(file_util::write_binary_file_atomic(bad_path, new_data.data(), new_data.size()));
+  EXPECT_FALSE(fs::exists(bad_path));
+  fs::remove(path);
+}
+
+TEST(CommonUtil, DgoReader) {
+  std::vector<u8> dgo(sizeof(DgoHeader));
+  DgoHeader header = {2, "test.dgo"};
+  memcpy(dgo.data(), &header, sizeof(DgoHeader));
+  for (u32 size : {20u, 64u}) {
+    ObjectHeader obj = {size, "obj"};
+    obj.name[3] = '0' + (size % 10);
+    dgo.insert(dgo.end(), (u8*)&obj, (u8*)&obj + sizeof(ObjectHeader));
+    for (u32 i = 0; i < align16(size); i++) {
+      dgo.push_back(i < size ? size + i : 0);
+    }
+  }
+
+  DgoReader reader("test.dgo", dgo);
+  const auto& entries = reader.entries();
+  ASSERT_EQ(entries.size(), 2u);
+  EXPECT_EQ(entries[0].internal_name, "obj0");
+  ASSERT_EQ(entries[1].data.size(), 64u);
+  EXPECT_EQ(entries[1].data[0], 64);
+  EXPECT_EQ(entries[1].data[63], 64 + 63);
+}
+
 TEST(CommonUtil, CopyOnWrite) {
   CopyOnWrite<int> x(2);
 
@@ -0,0 +1,38 @@
+#include "common/dma/dma_capture.h"
+
+#include "gtest/gtest.h"
+
+TEST(DmaCapture, RoundTrip) {
+  constexpr u32 size = DmaCapture::CHUNK_SIZE * 4;
+  std::vector<u8> memory(size);
+  // chunks 1 and 3 have data, 0 and 2 are all zero.
+  memory[DmaCapture::CHUNK_SIZE + 12] = 0x12;
+  memory[DmaCapture::CHUNK_SIZE * 4 - 1] = 0x34;
+
+  DmaCapture capture;
+  capture.version = GameVersion::Jak2;
+  capture.chain_offset = 0x1230;
+  capture.s7_offset = 0x4560;
+  capture.pmode_alp = 0.5f;
+  capture.levels = {"ctysluma", "ctywide"};
+  capture.active_levels = {"ctywide"};
+  capture.capture_memory(memory.data(), size);
+  EXPECT_EQ(capture.chunk_indices, std::vector<u32>({1, 3}));
+
+  auto path = fs::temp_directory_path() / "test_dma_capture.dmacap";
+  write_dma_capture(path, capture);
+  auto loaded = read_dma_capture(path);
+  fs::remove(path);
+
+  EXPECT_EQ(loaded.version, GameVersion::Jak2);
+  EXPECT_EQ(loaded.chain_offset, 0x1230u);
+  EXPECT_EQ(loaded.s7_offset, 0x4560u);
+  EXPECT_EQ(loaded.pmode_alp, 0.5f);
+  EXPECT_EQ(loaded.levels, capture.levels);
+  EXPECT_EQ(loaded.active_levels, capture.active_levels);
+  ASSERT_EQ(loaded.memory_size, size);
+
+  std::vector<u8> restored(size, 0xff);
+  loaded.restore_memory(restored.data());
+  EXPECT_EQ(restored, memory);
+}
@@ -0,0 +1,92 @@
+#include "common/custom_data/Fr3File.h"
+#include "common/util/compress.h"
+
+#include "gtest/gtest.h"
+
+namespace {
+std::unique_ptr<tfrag3::Level> make_level() {
+  auto level = std::make_unique<tfrag3::Level>();
+  level->level_name = "test-level";
+  // enough texture data to be split into multiple chunks.
+  for (int i = 0; i < 20; i++) {
+    auto& tex = level->textures.emplace_back();
+    tex.w = 256;
+    tex.h = 256;
+    tex.combo_id = i;
+    tex.data.resize(tex.w * tex.h);
+    for (size_t j = 0; j < tex.data.size(); j++) {
+      tex.data[j] = (j * 7919 + i) ^ (j >> 3);
+    }
+    tex.debug_name = fmt::format("tex-{}", i);
+  }
+  level->index_textures.resize(2);
+  level->index_textures[1].name = "itex";
+  level->tfrag_trees[1].resize(2);
+  level->tfrag_trees[1][1].draws.resize(3);
+  level->tie_trees[2].resize(3);
+  level->tie_trees[2][0].static_draws.resize(5);
+  level->shrub_trees.resize(1);
+  level->shrub_trees[0].indices = {1, 2, 3};
+  level->hfrag.indices = {4, 5};
+  level->collision.vertices.resize(10);
+  level->merc_data.models.resize(1);
+  level->merc_data.models[0].name = "merc";
+  return level;
+}
+
+std::vector<u8> serialize(tfrag3::Level& level) {
+  Serializer ser;
+  level.serialize(ser);
+  auto [data, size] = ser.get_save_result();
+  return {data, data + size};
+}
+
+fs::path write_temp_file(const std::vector<u8>& data) {
+  auto path = fs::temp_directory_path() / "test_fr3.fr3";
+  file_util::write_binary_file(path, data.data(), data.size());
+  return path;
+}
+}  // namespace
+
+TEST(Fr3File, RoundTrip) {
+  auto level = make_level();
+  auto fr3 = tfrag3::write_fr3(*level);
+  EXPECT_LT(fr3.data.size(), fr3.uncompressed_size);
+  auto path = write_temp_file(fr3.data);
+
+  for (int threads : {1, 4}) {
+    auto loaded = std::make_unique<tfrag3::Level>();
+    tfrag3::Fr3Reader(path).read(loaded.get(), tfrag3::FR3_ALL_CHUNKS, threads);
+    EXPECT_EQ(serialize(*loaded), serialize(*level));
+  }
+  fs::remove(path);
+}
+
+TEST(Fr3File, ChunkMask) {
+  auto level = make_level();
+  auto path = write_temp_file(tfrag3::write_fr3(*level).data);
+
+  auto loaded = std::make_unique<tfrag3::Level>();
+  u32 mask = tfrag3::fr3_chunk_bit(tfrag3::Fr3ChunkKind::MERC);
+  tfrag3::Fr3Reader(path).read(loaded.get(), mask, 4);
+  EXPECT_EQ(loaded->level_name, "test-level");
+  EXPECT_EQ(loaded->merc_data.models.at(0).name, "merc");
+  // skipped parts have the right size, but no data.
+  ASSERT_EQ(loaded->textures.size(), level->textures.size());
+  EXPECT_TRUE(loaded->textures[0].data.empty());
+  ASSERT_EQ(loaded->tie_trees[2].size(), 3u);
+  EXPECT_TRUE(loaded->tie_trees[2][0].static_draws.empty());
+  EXPECT_TRUE(loaded->collision.vertices.empty());
+  fs::remove(path);
+}
+
+TEST(Fr3File, LegacyFormat) {
+  auto level = make_level();
+  auto data = serialize(*level);
+  auto path = write_temp_file(compression::compress_zstd(data.data(), data.size()));
+
+  auto loaded = std::make_unique<tfrag3::Level>();
+  tfrag3::Fr3Reader(path).read(loaded.get());
+  EXPECT_EQ(serialize(*loaded), data);
+  fs::remove(path);
+}
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/global_profiler/GlobalProfiler.h"
+#include "common/util/FileUtil.h"
+
+#include "fmt/core.h"
+#include "gtest/gtest.h"
+
+#include "third-party/json.hpp"
+#include "third-party/zstd/lib/zstd.h"
+
+namespace {
+std::string decompress_stream(const std::vector<u8>& data) {
+  std::string result;
+  std::vector<char> buffer(ZSTD_DStreamOutSize());
+  ZSTD_DCtx* ctx = ZSTD_createDCtx();
+  ZSTD_inBuffer in = {data.data(), data.size(), 0};
+  while (in.pos < in.size) {
+    ZSTD_outBuffer out = {buffer.data(), buffer.size(), 0};
+    auto ret = ZSTD_decompressStream(ctx, &out, &in);
+    EXPECT_FALSE(ZSTD_isError(ret));
+    if (ZSTD_isError(ret)) {
+      break;
+    }
+    result.append(buffer.data(), out.pos);
+  }
+  ZSTD_freeDCtx(ctx);
+  return result;
+}
+}  // namespace
+
+TEST(GlobalProfiler, Intern) {
+  std::string a = "some-event";
+  std::string b = "some-event";
+  EXPECT_EQ(GlobalProfiler::intern(a.c_str()), GlobalProfiler::intern(b.c_str()));
+  EXPECT_NE(GlobalProfiler::intern("some-event"), GlobalProfiler::intern("other-event"));
+
+  u32 id = 0;
+  std::thread t([&]() { id = GlobalProfiler::intern("some-event"); });
+  t.join();
+  EXPECT_EQ(id, GlobalProfiler::intern(a.c_str()));
+}
+
+TEST(GlobalProfiler, EventCount) {
+  GlobalProfiler p;
+  p.update_event_buffer_size(8);
+  p.begin_event("disabled");
+  EXPECT_EQ(p.get_event_count(), 0u);
+
+  p.set_enable(true);
+  for (int i = 0; i < 5; i++) {
+    p.instant_event("event");
+  }
+  EXPECT_EQ(p.get_event_count(), 5u);
+
+  // only the newest events are kept.
+  for (int i = 0; i < 20; i++) {
+    p.instant_event("event");
+  }
+  EXPECT_EQ(p.get_event_count(), 8u);
+
+  p.clear();
+  EXPECT_EQ(p.get_event_count(), 0u);
+}
+
+TEST(GlobalProfiler, Stream) {
+  constexpr int kThreads = 2;
+  constexpr int kEvents = 1000;
+  GlobalProfiler p;
+  auto path = p.start_streaming();
+  EXPECT_TRUE(p.is_streaming());
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; t++) {
+    threads.emplace_back([&, t]() {
+      p.set_thread_name(fmt::format("worker-{}", t));
+      for (int i = 0; i < kEvents; i++) {
+        p.begin_event("work");
+        p.counter("progress", i);
+        if (t == 0) {
+          p.flow_start("handoff", i);
+        } else {
+          p.flow_end("handoff", i);
+        }
+        p.end_event();
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  p.stop_streaming();
+  EXPECT_FALSE(p.is_streaming());
+  EXPECT_EQ(p.get_dropped_events(), 0u);
+
+  auto trace = nlohmann::json::parse(decompress_stream(file_util::read_binary_file(path)));
+  fs::remove(path);
+  ASSERT_TRUE(trace.is_array());
+
+  int begins = 0, ends = 0, counters = 0, flow_starts = 0, flow_ends = 0;
+  std::map<int, std::string> thread_names;  // the last name given to each thread
+  for (auto& event : trace) {
+    auto phase = event.at("ph").get<std::string>();
+    if (phase == "B") {
+      EXPECT_EQ(event.at("name"), "work");
+      begins++;
+    } else if (phase == "E") {
+      ends++;
+    } else if (phase == "C") {
+      EXPECT_EQ(event.at("name"), "progress");
+      counters++;
+    } else if (phase == "s") {
+      flow_starts++;
+    } else if (phase == "f") {
+      EXPECT_EQ(event.at("bp"), "e");
+      flow_ends++;
+    } else if (phase == "M" && event.at("name") == "thread_name") {
+      thread_names[event.at("tid")] = event.at("args").at("name");
+    }
+  }
+  EXPECT_EQ(begins, kThreads * kEvents);
+  EXPECT_EQ(ends, kThreads * kEvents);
+  EXPECT_EQ(counters, kThreads * kEvents);
+  EXPECT_EQ(flow_starts, kEvents);
+  EXPECT_EQ(flow_ends, kEvents);
+  std::vector<std::string> names;
+  for (auto& [tid, name] : thread_names) {
+    names.push_back(name);
+  }
+  std::sort(names.begin(), names.end());
+  EXPECT_EQ(names, (std::vector<std::string>{"worker-0", "worker-1"}));
+}
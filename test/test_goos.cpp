@@ -1304,4 +1304,37 @@ TEST(GoosBuiltins, HashTable) {
   EXPECT_EQ(e(i, "(cdr (hash-table-try-ref ht \"foo\"))"), "123");
   e(i, "(hash-table-set! ht \"foo\" 456)");
   EXPECT_EQ(e(i, "(cdr (hash-table-try-ref ht \"foo\"))"), "456");
-}
\ No newline at end of file
+}
+
+TEST(GoosBuiltins, AccessRecorder) {
+  Interpreter i;
+  auto& globals = i.global_environment.as_env()->vars;
+  globals.set_recorded(true);
+  e(i, "(define x 1)");
+  e(i, "(define ht (make-string-hash-table))");
+
+  AccessRecorder recorder;
+  // x is read before it's set, y is set before it's read.
+  e(i, "(define y (+ x 1))");
+  e(i, "(set! x y)");
+  // set! doesn't count as a read.
+  e(i, "(set! y 3)");
+  e(i, "(hash-table-set! ht \"foo\" 123)");
+  e(i, "(hash-table-try-ref ht \"foo\")");
+  e(i, "(hash-table-try-ref ht \"bar\")");
+
+  std::unordered_map<std::string, bool> symbols;
+  for (const auto& access : recorder.symbols) {
+    EXPECT_EQ(access.table, &globals);
+    symbols[access.sym.name_ptr] = access.set_first;
+  }
+  EXPECT_FALSE(symbols.at("x"));
+  EXPECT_TRUE(symbols.at("y"));
+  EXPECT_FALSE(symbols.at("ht"));
+
+  ASSERT_EQ(recorder.hash_table_keys.size(), 2u);
+  EXPECT_EQ(recorder.hash_table_keys.at(0).key, "foo");
+  EXPECT_TRUE(recorder.hash_table_keys.at(0).set_first);
+  EXPECT_EQ(recorder.hash_table_keys.at(1).key, "bar");
+  EXPECT_FALSE(recorder.hash_table_keys.at(1).set_first);
+}
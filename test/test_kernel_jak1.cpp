@@ -1,3 +1,6 @@
+#include <cmath>
+#include <cstring>
+#include <random>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -5,14 +8,18 @@
 #include "common/goal_constants.h"
 #include "common/listener_common.h"
 #include "common/symbols.h"
+#include "common/util/json_util.h"
 
 #include "all_jak1_symbols.h"
 #include "game/kernel/common/fileio.h"
 #include "game/kernel/common/kboot.h"
+#include "game/kernel/common/klisten.h"
+#include "game/kernel/common/kmalloc_tracker.h"
 #include "game/kernel/common/kprint.h"
 #include "game/kernel/common/kscheme.h"
 #include "game/kernel/common/memory_layout.h"
 #include "game/kernel/jak1/fileio.h"
+#include "game/kernel/jak1/kprint.h"
 #include "game/kernel/jak1/kscheme.h"
 #include "gtest/gtest.h"
 
@@ -293,6 +300,195 @@ TEST(Kernel, itoa_base_16) {
   EXPECT_EQ("8000000000000000", std::string(buffer));
 }
 
+namespace {
+// kitoa and ftoa as they were before they were sped up, to check that the output didn't change.
+char* reference_kitoa(char* buffer, s64 value, u64 base, s32 length, char pad, u32 flag) {
+  s64 negativeValue = 0;
+  s64 value_to_print = value;
+  if ((value < 0) && base == 10) {
+    negativeValue = value;
+    value_to_print = -value;
+  }
+  int count = 0;
+  do {
+    buffer[count++] = ConvertTable[(u64)value_to_print % (u64)base];
+    value_to_print = (u64)value_to_print / (u64)base;
+  } while (value_to_print);
+  if (negativeValue < 0) {
+    buffer[count++] = '-';
+  }
+  s32 rLen = length;
+  if (0 < length - count) {
+    rLen = length - count;
+    while (0 < rLen) {
+      buffer[count++] = pad;
+      rLen--;
+    }
+  }
+  if (rLen > 0 && value < 0 && (base == 2 || base == 16) && rLen < count) {
+    char c = (base == 16) ? 'f' : '1';
+    while (rLen < count && (buffer[count - 1] == c)) {
+      count--;
+    }
+    if (!(flag & 2)) {
+      buffer[count++] = '-';
+    }
+  }
+  buffer[count] = 0;
+  reverse(buffer);
+  return buffer;
+}
+
+s32 reference_cvt_float(float x, s32 precision, s32* lead_char, char* buff_start, char* buff_end) {
+  *buff_start = 0;
+  s32 forward_count = 0;
+  float abs_x;
+  if (x < 0.0f) {
+    abs_x = -x;
+    *lead_char = '-';
+  } else {
+    *lead_char = 0;
+    abs_x = x;
+  }
+  u32 abs_x_u32;
+  memcpy(&abs_x_u32, &abs_x, 4);
+  if ((abs_x_u32 & 0x7fffffff) == 0x7fffffff) {
+    kstrcpy(buff_start, "NaN");
+    return 3;
+  }
+  float integer_part;
+  float fraction_part = std::modf(abs_x, &integer_part);
+  char* start_ptr = buff_start + 1;
+  char* end_ptr = buff_end - 1;
+  auto digit = [](float f) {
+    u32 u;
+    memcpy(&u, &f, 4);
+    if (((u >> 0x17) & 0xff) < 0x9e) {
+      return (s32)(char)f;
+    }
+    return (u >> 31) ? -1 : 0;
+  };
+  while (start_ptr <= end_ptr && (integer_part != 0.0f)) {
+    float next_int = std::modf(integer_part / 10.f, &integer_part);
+    *end_ptr = '0' + digit(next_int * 10.f + 0.5f);
+    end_ptr--;
+    forward_count++;
+  }
+  char* count_chrp = start_ptr;
+  if (forward_count == 0) {
+    *start_ptr = '0';
+    count_chrp = buff_start + 2;
+  } else {
+    while (end_ptr = end_ptr + 1, end_ptr < buff_end) {
+      *count_chrp = *end_ptr;
+      count_chrp++;
+    }
+  }
+  if (precision) {
+    *count_chrp = '.';
+    count_chrp++;
+  }
+  s32 prec = precision;
+  if (fraction_part != 0.0f && precision) {
+    do {
+      float next_int;
+      fraction_part = std::modf(fraction_part * 10.f, &next_int);
+      *count_chrp = digit(next_int) + '0';
+      count_chrp++;
+      prec--;
+    } while ((prec) && (fraction_part != 0.f));
+  }
+  while (prec = prec - 1, prec != -1) {
+    *count_chrp = '0';
+    count_chrp++;
+  }
+  return count_chrp - start_ptr;
+}
+
+void reference_ftoa(char* out_str, float x, s32 desired_len, char pad_char, s32 precision) {
+  char buff[0x100];
+  char* current_buff = buff;
+  s32 lead_char;
+  s32 count = reference_cvt_float(x, precision, &lead_char, current_buff, buff + 0x7f);
+  if (count > 0x3f) {
+    kstrcpy(current_buff, "NaN");
+    count = 3;
+    lead_char = 0;
+  }
+  if (buff[0] == 0) {
+    current_buff = buff + 1;
+  }
+  s32 real_count = (lead_char != 0) + count;
+  char* out_ptr = out_str;
+  if ((desired_len > 0) && (desired_len > real_count)) {
+    for (s32 i = 0; i < (desired_len - real_count); i++) {
+      *out_ptr++ = pad_char;
+    }
+  }
+  if (lead_char) {
+    *out_ptr++ = lead_char;
+  }
+  for (s32 i = 0; i < count; i++) {
+    *out_ptr++ = *current_buff++;
+  }
+  *out_ptr = 0;
+}
+}  // namespace
+
+TEST(Kernel, itoa_matches_reference) {
+  char buffer[128];
+  char expected[128];
+  kprint_init_globals_common();
+
+  std::mt19937_64 rng(12345);
+  std::vector<s64> values = {0, 1, -1, 9, 10, -10, 99, 100, 255, 256, INT64_MAX, INT64_MIN};
+  for (int i = 0; i < 2000; i++) {
+    s64 value = rng();
+    values.push_back(value >> (i % 64));
+  }
+  for (u64 base : {2, 8, 10, 16}) {
+    for (s32 length : {-1, 0, 1, 4, 17, 40}) {
+      for (char pad : {' ', '0', '\0'}) {
+        for (u32 flag : {0, 2}) {
+          for (auto value : values) {
+            kitoa(buffer, value, base, length, pad, flag);
+            reference_kitoa(expected, value, base, length, pad, flag);
+            ASSERT_STREQ(expected, buffer) << value << " base " << base << " length " << length;
+          }
+        }
+      }
+    }
+  }
+}
+
+TEST(Kernel, ftoa_matches_reference) {
+  char buffer[128];
+  char expected[128];
+
+  std::mt19937 rng(12345);
+  std::vector<float> values = {0.f,          -0.f,          1.f,         -1.f,         0.1f,
+                               1234.5678f,   9999999.f,     10000000.f,  10485761.f,   10485762.f,
+                               16777217.f,   1e20f,         3.4e38f,     -3.4e38f,     1e-40f,
+                               INFINITY,     -INFINITY,     NAN,         -NAN};
+  for (int i = 0; i < 20000; i++) {
+    u32 bits = rng();
+    float f;
+    memcpy(&f, &bits, 4);
+    values.push_back(f);
+    values.push_back(std::uniform_real_distribution<float>(-100000.f, 100000.f)(rng));
+    values.push_back((s32)(rng() % 20000000));
+  }
+  for (s32 precision : {0, 1, 2, 4, 8}) {
+    for (s32 length : {-1, 12}) {
+      for (auto value : values) {
+        ftoa(buffer, value, length, ' ', precision, 0);
+        reference_ftoa(expected, value, length, ' ', precision);
+        ASSERT_STREQ(expected, buffer) << value << " precision " << precision;
+      }
+    }
+  }
+}
+
 namespace {
 void setup_hack_heaps(void* mem, int size) {
   g_ee_main_mem = (u8*)mem;
@@ -351,6 +547,156 @@ TEST(Kernel, PrintBuffer) {
   // more complicated tests for format will be done from within GOAL.
 }
 
+TEST(Kernel, KmallocTracker) {
+  constexpr int size = 32 * 1024 * 1024;
+  auto mem = new u8[size];
+  setup_hack_heaps(mem, size);
+
+  gKmallocTracking = true;
+  kmalloc(kdebugheap, 100, 0, "test-a");
+  kmalloc(kdebugheap, 100, KMALLOC_TOP, "test-a");
+  kmalloc(kdebugheap, 5000, 0, "test-b");
+  EXPECT_EQ(0, kmalloc(kdebugheap, size, 0, "test-b").offset);
+  gKmallocTracking = false;
+
+  auto result = json::parse(kmalloc_tracker_json());
+  for (const auto& heap : result["heaps"]) {
+    if (heap["heap"] == "debug") {
+      EXPECT_EQ(1, heap["failed"].get<int>());
+      EXPECT_EQ(2, heap["sizes"]["64"].get<int>());
+      EXPECT_EQ(1, heap["sizes"]["4096"].get<int>());
+      EXPECT_LE(5100, heap["peak-bottom"].get<int>());
+      EXPECT_LE(100, heap["peak-top"].get<int>());
+      EXPECT_EQ(heap["free"], heap["min-free"]);
+    } else {
+      EXPECT_EQ("global", heap["heap"]);
+    }
+  }
+
+  int names_found = 0;
+  for (const auto& name : result["names"]) {
+    if (name["name"] == "test-a") {
+      EXPECT_EQ(2, name["allocations"].get<int>());
+      EXPECT_EQ(200, name["bytes"].get<int>());
+      names_found++;
+    } else if (name["name"] == "test-b") {
+      EXPECT_EQ(1, name["allocations"].get<int>());
+      EXPECT_EQ(1, name["failed"].get<int>());
+      EXPECT_EQ(5000, name["largest"].get<int>());
+      names_found++;
+    }
+  }
+  EXPECT_EQ(2, names_found);
+
+  delete[] mem;
+}
+
+TEST(Kernel, CompileFormat) {
+  FormatProgram program;
+  auto text = [&](int i) {
+    return std::string(program.text() + program[i].text_start, program[i].text_len);
+  };
+
+  compile_format("abc~~def~T~3,'0H~%", &program);
+  ASSERT_EQ(2, program.size());
+  EXPECT_EQ(FormatOp::Kind::TEXT, program[0].kind);
+  EXPECT_EQ("abc~def\t~3,'0H", text(0));
+  EXPECT_EQ(FormatOp::Kind::NEWLINE, program[1].kind);
+  EXPECT_FALSE(program[1].indent);
+  EXPECT_EQ(std::string("abc~~def~T~3,'0H~%"), program.source());
+
+  compile_format("~8,'x,2f ~`vector`P~%x~?", &program);
+  ASSERT_EQ(7, program.size());
+  EXPECT_EQ(FormatOp::Kind::DIRECTIVE, program[0].kind);
+  EXPECT_EQ('f', program[0].code);
+  EXPECT_EQ(8, program[0].arg0);
+  EXPECT_EQ('x', program[0].arg1);
+  EXPECT_EQ(2, program[0].arg2);
+  EXPECT_EQ('P', program[2].code);
+  EXPECT_EQ(std::string("vector"), program.type_name(program[2]));
+  EXPECT_TRUE(program[3].indent);
+  // unknown code: the ~ is output, then the rest is normal text.
+  EXPECT_EQ(FormatOp::Kind::BAD_CODE, program[5].kind);
+  EXPECT_EQ('?', program[5].code);
+  EXPECT_EQ("~?", text(6));
+}
+
+TEST(Kernel, FormatCache) {
+  constexpr int size = 32 * 1024 * 1024;
+  auto mem = new u8[size];
+  setup_hack_heaps(mem, size);
+  print_column.offset = 0;
+
+  auto float_arg = [](float f) {
+    u32 bits;
+    memcpy(&bits, &f, 4);
+    return (u64)bits;
+  };
+  auto format = [&](u32 str, std::vector<u64> args) {
+    clear_print();
+    u64 regs[10] = {s7.offset + FIX_SYM_TRUE, str};
+    for (size_t i = 0; i < args.size(); i++) {
+      regs[2 + i] = args[i];
+    }
+    format_impl_jak1(regs);
+    return std::string(PrintBufArea.cast<char>().c() + sizeof(ListenerMessageHeader));
+  };
+
+  for (bool cache : {false, true}) {
+    gFormatCacheEnabled = cache;
+    u32 str = make_string_from_c("~D ~X ~B~%~4,'0D|~3,'xX|~~ ~T~3H");
+    for (int i = 0; i < 2; i++) {
+      EXPECT_EQ("12 ff 101\n0007|xx1|~ \t~3H", format(str, {12, 255, 5, 7, 1}));
+    }
+    str = make_string_from_c("~F ~f ~,,2f ~8,'*,1f");
+    for (int i = 0; i < 2; i++) {
+      EXPECT_EQ("      1.0000 1.5000 2.25 ****-3.5",
+                format(str, {float_arg(1.f), float_arg(1.5f), float_arg(2.25f),
+                             float_arg(-3.5f)}));
+    }
+    // the same address with a different format string.
+    strcpy(Ptr<char>(str + 4).c(), "~D!");
+    EXPECT_EQ("3!", format(str, {3}));
+  }
+
+  delete[] mem;
+}
+
+TEST(Kernel, FormatCacheReplacement) {
+  gFormatCacheEnabled = true;
+  format_cache_clear();
+
+  // more strings than the cache has slots, so slots have to be replaced.
+  constexpr int count = 100000;
+  std::vector<std::string> strings;
+  for (int i = 0; i < count; i++) {
+    strings.push_back("~D " + std::to_string(i) + "~%");
+  }
+  FormatProgramRef first(strings[0].c_str());
+  int wrong = 0;
+  for (int pass = 0; pass < 2; pass++) {
+    for (int i = 1; i < count; i++) {
+      FormatProgramRef ref(strings[i].c_str());
+      if (strings[i] != (*ref).source() || (*ref).size() != 3) {
+        wrong++;
+      }
+    }
+  }
+  EXPECT_EQ(0, wrong);
+  // a program that is still running isn't replaced.
+  EXPECT_EQ(strings[0], (*first).source());
+
+  // without the cache, nested calls each get their own program.
+  gFormatCacheEnabled = false;
+  FormatProgramRef outer("~D outer");
+  {
+    FormatProgramRef inner("~X inner");
+    EXPECT_EQ(std::string("~X inner"), (*inner).source());
+  }
+  EXPECT_EQ(std::string("~D outer"), (*outer).source());
+  gFormatCacheEnabled = true;
+}
+
 TEST(Kernel, HashTable) {
   constexpr int size = 32 * 1024 * 1024;
   auto mem = new u8[size];
@@ -0,0 +1,72 @@
+#include "game/mips2c/mips2c_capture.h"
+
+#include "gtest/gtest.h"
+
+using namespace Mips2C;
+
+TEST(Mips2CCapture, RoundTrip) {
+  Mips2CCapture capture;
+  capture.version = GameVersion::Jak2;
+  capture.function_name = "draw-inline-array-tfrag";
+  capture.memory_size = Mips2CCapture::PAGE_SIZE * 4;
+  capture.s7_offset = 0x1230;
+  capture.symbol_table2_offset = 0x4560;
+  capture.last_symbol_offset = 0x7890;
+  capture.symbol_names = {"*display*", "vector"};
+  capture.symbol_values = {0x100, -0x200};
+
+  capture.calls.resize(2);
+  auto& call = capture.calls.at(0);
+  call.before.gprs[sp].du64[0] = 0x3ff0;
+  call.before.vfs[3].f[2] = 1.5f;
+  call.after = call.before;
+  call.after.gprs[v0].du64[0] = 12;
+  call.result = 12;
+  call.duration_ns = 3456;
+  call.rng_before = "1 2";
+  call.rng_after = "3 4";
+  call.changed_pages = {1, 3};
+  call.changed_data.resize(Mips2CCapture::PAGE_SIZE * 2, 0x12);
+  call.written_pages = {3};
+  call.written_data.resize(Mips2CCapture::PAGE_SIZE, 0x34);
+  capture.calls.at(1).called_goal = true;
+
+  auto path = fs::temp_directory_path() / "test_mips2c_capture.m2ccap";
+  write_mips2c_capture(path, capture);
+  auto loaded = read_mips2c_capture(path);
+  fs::remove(path);
+
+  EXPECT_EQ(loaded.version, GameVersion::Jak2);
+  EXPECT_EQ(loaded.function_name, capture.function_name);
+  EXPECT_EQ(loaded.memory_size, capture.memory_size);
+  EXPECT_EQ(loaded.s7_offset, 0x1230u);
+  EXPECT_EQ(loaded.symbol_table2_offset, 0x4560u);
+  EXPECT_EQ(loaded.last_symbol_offset, 0x7890u);
+  EXPECT_EQ(loaded.symbol_names, capture.symbol_names);
+  EXPECT_EQ(loaded.symbol_values, capture.symbol_values);
+  ASSERT_EQ(loaded.calls.size(), 2u);
+
+  const auto& loaded_call = loaded.calls.at(0);
+  EXPECT_EQ(loaded_call.before.gprs[sp].du64[0], 0x3ff0u);
+  EXPECT_EQ(loaded_call.before.vfs[3].f[2], 1.5f);
+  EXPECT_EQ(loaded_call.after.gprs[v0].du64[0], 12u);
+  EXPECT_EQ(loaded_call.result, 12u);
+  EXPECT_EQ(loaded_call.duration_ns, 3456u);
+  EXPECT_FALSE(loaded_call.called_goal);
+  EXPECT_EQ(loaded_call.rng_before, "1 2");
+  EXPECT_EQ(loaded_call.rng_after, "3 4");
+  EXPECT_EQ(loaded_call.changed_pages, call.changed_pages);
+  EXPECT_EQ(loaded_call.changed_data, call.changed_data);
+  EXPECT_EQ(loaded_call.written_pages, call.written_pages);
+  EXPECT_EQ(loaded_call.written_data, call.written_data);
+  EXPECT_TRUE(loaded.calls.at(1).called_goal);
+
+  // replaying the pages rebuilds the memory the call saw.
+  std::vector<u8> memory(capture.memory_size);
+  apply_pages(memory.data(), loaded_call.changed_pages, loaded_call.changed_data);
+  EXPECT_EQ(memory.at(0), 0);
+  EXPECT_EQ(memory.at(Mips2CCapture::PAGE_SIZE), 0x12);
+  EXPECT_EQ(memory.at(Mips2CCapture::PAGE_SIZE * 3 + 5), 0x12);
+  apply_pages(memory.data(), loaded_call.written_pages, loaded_call.written_data);
+  EXPECT_EQ(memory.at(Mips2CCapture::PAGE_SIZE * 3 + 5), 0x34);
+}
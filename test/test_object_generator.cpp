@@ -0,0 +1,143 @@
+/*!
+ * @file test_object_generator.cpp
+ * Tests for the ObjectGenerator's peephole optimizer. The same function is generated with and
+ * without the optimizer, and both versions are run with the CodeTester.
+ */
+
+#include "common/type_system/TypeSystem.h"
+
+#include "goalc/debugger/DebugInfo.h"
+#include "goalc/emitter/CodeTester.h"
+#include "goalc/emitter/IGen.h"
+#include "goalc/emitter/ObjectGenerator.h"
+#include "gtest/gtest.h"
+
+using namespace emitter;
+
+namespace {
+
+struct GeneratedFunction {
+  std::vector<u8> code;
+  ObjectGeneratorStats stats;
+};
+
+/*!
+ * Generate a function of two arguments:
+ *   result = arg0 * arg1
+ *   if (result <= 100) result += 1000;
+ *   if (arg1 != 0) result += 0;  (many times, so the jump over it stays long)
+ * with jumps to jumps, a jcc over a jmp and redundant moves and spills.
+ */
+GeneratedFunction generate(bool optimize, Register arg0, Register arg1) {
+  TypeSystem ts;
+  ts.add_builtin_types(GameVersion::Jak1);
+  DebugInfo debug_info("test");
+  ObjectGenerator gen(GameVersion::Jak1);
+  auto func = gen.add_function_to_seg(0, &debug_info.add_function("test-func", "test"));
+  auto ir = [&](int id) { return gen.get_future_ir_record(func, id); };
+
+  gen.add_instr_no_ir(func, IGen::sub_gpr64_imm8s(RSP, 16), InstructionInfo::Kind::PROLOGUE);
+
+  // 0: result = 0, counter = arg0
+  auto i0 = gen.add_ir(func);
+  gen.add_instr(IGen::xor_gpr64_gpr64(RAX, RAX), i0);
+  gen.add_instr(IGen::mov_gpr64_gpr64(R8, arg0), i0,
+                MoveInfo::reg_to_reg(MoveInfo::Width::GPR64, R8, arg0));
+
+  // 1: loop top, jump to a jump when done.
+  auto i1 = gen.add_ir(func);
+  gen.add_instr(IGen::xor_gpr64_gpr64(R9, R9), i1);
+  gen.add_instr(IGen::cmp_gpr64_gpr64(R8, R9), i1);
+  gen.link_instruction_jump(gen.add_instr(IGen::je_32(), i1), ir(4));
+
+  // 2: loop body, with a move that's undone and a spill that's reloaded.
+  auto i2 = gen.add_ir(func);
+  gen.add_instr(IGen::add_gpr64_gpr64(RAX, arg1), i2);
+  gen.add_instr(IGen::mov_gpr64_gpr64(R10, RAX), i2,
+                MoveInfo::reg_to_reg(MoveInfo::Width::GPR64, R10, RAX));
+  gen.add_instr(IGen::mov_gpr64_gpr64(RAX, R10), i2,
+                MoveInfo::reg_to_reg(MoveInfo::Width::GPR64, RAX, R10));
+  gen.add_instr(IGen::store64_gpr64_plus_s32(RSP, 8, R10), i2,
+                MoveInfo::store(MoveInfo::Width::GPR64, R10, 8));
+  gen.add_instr(IGen::load64_gpr64_plus_s32(R10, 8, RSP), i2,
+                MoveInfo::load(MoveInfo::Width::GPR64, R10, 8));
+
+  // 3: loop bottom
+  auto i3 = gen.add_ir(func);
+  gen.add_instr(IGen::sub_gpr64_imm8s(R8, 1), i3);
+  gen.link_instruction_jump(gen.add_instr(IGen::jmp_32(), i3), ir(1));
+
+  // 4: a jump to the next instruction.
+  auto i4 = gen.add_ir(func);
+  gen.link_instruction_jump(gen.add_instr(IGen::jmp_32(), i4), ir(5));
+
+  // 5: jcc over a jmp
+  auto i5 = gen.add_ir(func);
+  gen.add_instr(IGen::mov_gpr64_s32(R9, 100), i5);
+  gen.add_instr(IGen::cmp_gpr64_gpr64(RAX, R9), i5);
+  gen.link_instruction_jump(gen.add_instr(IGen::jle_32(), i5), ir(7));
+  auto i6 = gen.add_ir(func);
+  gen.link_instruction_jump(gen.add_instr(IGen::jmp_32(), i6), ir(8));
+  auto i7 = gen.add_ir(func);
+  gen.add_instr(IGen::add_gpr64_imm(RAX, 1000), i7);
+
+  // 8: a jump that's too far to shorten.
+  auto i8 = gen.add_ir(func);
+  gen.add_instr(IGen::xor_gpr64_gpr64(R9, R9), i8);
+  gen.add_instr(IGen::cmp_gpr64_gpr64(arg1, R9), i8);
+  gen.link_instruction_jump(gen.add_instr(IGen::je_32(), i8), ir(10));
+  auto i9 = gen.add_ir(func);
+  for (int i = 0; i < 50; i++) {
+    gen.add_instr(IGen::add_gpr64_imm32s(RAX, 0), i9);
+  }
+
+  auto i10 = gen.add_ir(func);
+  gen.add_instr(IGen::add_gpr64_imm8s(RSP, 16), i10);
+  gen.add_instr(IGen::ret(), i10);
+
+  if (optimize) {
+    gen.optimize_function(func);
+  }
+  gen.generate_data_v3(&ts);
+  return {debug_info.function_by_name("test-func").generated_code, gen.get_stats()};
+}
+
+u64 run(const std::vector<u8>& code, u64 a, u64 b) {
+  CodeTester tester;
+  tester.init_code_buffer(1024);
+  for (auto x : code) {
+    tester.emit_data(x);
+  }
+  return tester.execute(a, b, 0, 0);
+}
+
+}  // namespace
+
+TEST(ObjectGenerator, Peephole) {
+  CodeTester tester;
+  auto arg0 = tester.get_c_abi_arg_reg(0);
+  auto arg1 = tester.get_c_abi_arg_reg(1);
+  auto plain = generate(false, arg0, arg1);
+  auto optimized = generate(true, arg0, arg1);
+
+  EXPECT_EQ(plain.stats.code_bytes, plain.stats.code_bytes_before);
+  EXPECT_EQ(plain.stats.jumps_shortened, 0);
+  EXPECT_EQ(optimized.stats.code_bytes_before, plain.stats.code_bytes);
+  EXPECT_EQ(optimized.stats.code_bytes, (int)optimized.code.size());
+  EXPECT_LT(optimized.code.size(), plain.code.size());
+  EXPECT_EQ(optimized.stats.jumps_threaded, 1);
+  EXPECT_EQ(optimized.stats.jumps_removed, 1);
+  EXPECT_EQ(optimized.stats.branches_fused, 1);
+  // the second move of the loop body and the load.
+  EXPECT_EQ(optimized.stats.moves_removed, 2);
+  // the loop jumps and the fused branch, but not the jump over the padding.
+  EXPECT_EQ(optimized.stats.jumps_shortened, 3);
+
+  for (u64 a : {0, 1, 3, 50}) {
+    for (u64 b : {0, 1, 7, 40}) {
+      u64 expected = a * b <= 100 ? a * b + 1000 : a * b;
+      EXPECT_EQ(run(plain.code, a, b), expected);
+      EXPECT_EQ(run(optimized.code, a, b), expected);
+    }
+  }
+}
@@ -146,6 +146,36 @@ TEST(TypeSystem, TypeSpecEquality) {
   EXPECT_FALSE(pointer_to_string == pointer_to_function);
 }
 
+TEST(TypeSystem, TypeSpecCopies) {
+  // base types are shared
+  TypeSpec a("string");
+  TypeSpec b(std::string("str") + "ing");
+  EXPECT_EQ(a.interned_base_type(), b.interned_base_type());
+  EXPECT_EQ(a.hash(), b.hash());
+  EXPECT_EQ(TypeSpec().base_type(), "");
+
+  // arguments are copied when modified, so copies don't see the change.
+  TypeSpec ptr("pointer", {TypeSpec("int")});
+  TypeSpec copy = ptr;
+  copy.set_arg(0, TypeSpec("uint"));
+  copy.add_arg(TypeSpec("float"));
+  EXPECT_EQ(ptr.print(), "(pointer int)");
+  EXPECT_EQ(copy.print(), "(pointer uint float)");
+  EXPECT_NE(ptr, copy);
+  TypeSpec copy_of_copy = copy;
+  copy.set_last_arg(TypeSpec("int"));
+  EXPECT_EQ(copy_of_copy.print(), "(pointer uint float)");
+  EXPECT_EQ(copy.print(), "(pointer uint int)");
+
+  auto method = TypeSpec("function", {TypeSpec("_type_"), TypeSpec("none")});
+  auto substituted = method.substitute_for_method_call("basic");
+  EXPECT_EQ(method.print(), "(function _type_ none)");
+  EXPECT_EQ(substituted.print(), "(function basic none)");
+  EXPECT_EQ(substituted, TypeSpec("function", {TypeSpec("basic"), TypeSpec("none")}));
+  EXPECT_EQ(substituted.hash(),
+            TypeSpec("function", {TypeSpec("basic"), TypeSpec("none")}).hash());
+}
+
 TEST(TypeSystem, RuntimeTypes) {
   TypeSystem ts;
   ts.add_builtin_types(GameVersion::Jak1);
@@ -525,4 +555,61 @@ TEST(Deftype, deftype) {
   EXPECT_EQ(f5.is_inline(), false);
 }
 
+TEST(TypeSystem, LookupRecorder) {
+  TypeSystem ts;
+  ts.add_builtin_types(GameVersion::Jak1);
+
+  // nothing is recorded without a recorder.
+  ts.lookup_type("basic");
+
+  TypeLookupRecorder outer;
+  ts.lookup_type("string");
+  {
+    TypeLookupRecorder inner;
+    ts.lookup_type_no_throw("pair");
+    EXPECT_EQ(inner.names, std::unordered_set<std::string>({"pair"}));
+  }
+  ts.fully_defined_type_exists("symbol");
+  EXPECT_EQ(outer.names, std::unordered_set<std::string>({"string", "symbol"}));
+}
+
+TEST(TypeSystem, QueriesAfterTypeChanges) {
+  TypeSystem ts;
+  ts.add_builtin_types(GameVersion::Jak1);
+  ts.forward_declare_type_as("test-child", "basic");
+  EXPECT_TRUE(ts.tc(ts.make_typespec("basic"), ts.make_typespec("test-child")));
+  EXPECT_FALSE(ts.tc(ts.make_typespec("string"), ts.make_typespec("test-child")));
+
+  // remembered query results must be recorded again.
+  {
+    TypeLookupRecorder recorder;
+    EXPECT_TRUE(ts.tc(ts.make_typespec("basic"), ts.make_typespec("test-child")));
+    EXPECT_TRUE(recorder.names.count("test-child"));
+  }
+
+  // defining the type changes the answers.
+  auto type = std::make_unique<BasicType>("string", "test-child", false, 0);
+  type->inherit(ts.get_type_of_type<BasicType>("string"));
+  ts.add_type("test-child", std::move(type));
+  EXPECT_TRUE(ts.tc(ts.make_typespec("string"), ts.make_typespec("test-child")));
+  EXPECT_EQ(ts.lowest_common_ancestor(ts.make_typespec("string"), ts.make_typespec("test-child")),
+            ts.make_typespec("string"));
+}
+
+TEST(TypeSystem, TypeDefinitionText) {
+  TypeSystem ts;
+  ts.add_builtin_types(GameVersion::Jak1);
+
+  auto before = ts.type_definition_text("basic");
+  EXPECT_FALSE(before.empty());
+  EXPECT_EQ(before, ts.type_definition_text("basic"));
+  ts.declare_method(ts.lookup_type("basic"), "test-method-1", "test docstring", false,
+                    ts.make_function_typespec({"integer"}, "string"), false);
+  EXPECT_NE(before, ts.type_definition_text("basic"));
+
+  EXPECT_TRUE(ts.type_definition_text("not-a-type").empty());
+  ts.forward_declare_type_as("not-a-type", "basic");
+  EXPECT_FALSE(ts.type_definition_text("not-a-type").empty());
+}
+
 // TODO - a big test to make sure all the builtin types are what we expect.
@@ -1,5 +1,6 @@
 #include <cstdio>
 #include <stdexcept>
+#include <utility>
 
 #include "common/util/DgoReader.h"
 #include "common/util/FileUtil.h"
@@ -32,7 +33,7 @@ int run(int argc, char** argv) {
              int(data.size()), 100.f * original_size / data.size());
     }
     // read as a DGO
-    auto dgo = DgoReader(base, data);
+    auto dgo = DgoReader(base, std::move(data));
     // write dgo description
     file_util::create_dir_if_needed(out_path);
     file_util::write_text_file(file_util::combine_path(out_path, base + ".txt"),
@@ -1,5 +1,7 @@
+#include <cstdlib>
 #include <fstream>
 #include <iomanip>
+#include <map>
 #include <optional>
 #include <string>
 
@@ -8,7 +10,11 @@
 #include "common/symbols.h"
 #include "common/type_system/TypeSystem.h"
 #include "common/util/Assert.h"
+#include "common/util/BitUtils.h"
 #include "common/util/FileUtil.h"
+#include "common/util/SimpleThreadGroup.h"
+#include "common/util/Timer.h"
+#include "common/util/math_util.h"
 #include "common/util/unicode_util.h"
 
 #include "decompiler/util/DecompilerTypeSystem.h"
@@ -229,6 +235,8 @@ std::unordered_map<u32, std::string> build_type_map(const Ram& ram,
 
 const std::vector<std::string> ignored_types = {"symbol", "string", "function", "object",
                                                 "integer"};
+// the census counts memory, so it includes strings.
+const std::vector<std::string> census_ignored_types = {"symbol", "function", "object", "integer"};
 
 std::unordered_map<std::string, std::vector<u32>> find_basics(
     const Ram& ram,
@@ -606,12 +614,586 @@ void inspect_symbols(const Ram& ram,
   }
 }
 
+/*!
+ * Read the value of a symbol, from the symbol address in the SymbolMap.
+ */
+u32 symbol_value(const Ram& ram, const GameVersion& game_version, u32 sym) {
+  return ram.word(game_version == GameVersion::Jak1 ? sym : sym - 1);
+}
+
+/*!
+ * A kheap, and the objects the census found in it.
+ */
+struct HeapCensus {
+  std::string name;
+  u32 base = 0;
+  u32 top = 0;
+  u32 current = 0;
+  u32 top_base = 0;
+
+  int object_count = 0;
+  u64 object_bytes = 0;
+  int stale_count = 0;  // objects left over in the free space of the heap, not counted as live.
+
+  u32 size() const { return top_base - base; }
+  u32 used() const { return (current - base) + (top_base - top); }
+  u32 free() const { return top - current; }
+  bool contains(u32 addr) const { return addr >= base && addr < top_base; }
+  bool in_free_space(u32 addr) const { return addr >= current && addr < top; }
+};
+
+struct TypeCensus {
+  int count = 0;
+  u64 bytes = 0;
+  int unreachable_count = 0;
+  u64 unreachable_bytes = 0;
+};
+
+struct CensusObject {
+  u32 addr = 0;  // the address of the type tag, like find_basics.
+  u32 size = 0;
+  u32 type = 0;
+  int heap = -1;
+};
+
+struct Census {
+  std::vector<HeapCensus> heaps;
+  std::map<std::string, TypeCensus> types;
+  std::vector<CensusObject> objects;  // live objects, sorted by address.
+  std::vector<u64> retained;          // per object, the bytes it keeps alive.
+  int overlapping_tags = 0;
+};
+
+std::optional<HeapCensus> read_heap(const Ram& ram, const std::string& name, u32 addr) {
+  if (!ram.word_in_memory(addr) || !ram.word_in_memory(addr + 12)) {
+    return {};
+  }
+  HeapCensus heap;
+  heap.name = name;
+  heap.base = ram.word(addr);
+  heap.top = ram.word(addr + 4);
+  heap.current = ram.word(addr + 8);
+  heap.top_base = ram.word(addr + 12);
+  if (!heap.base || heap.base > heap.current || heap.current > heap.top ||
+      heap.top > heap.top_base || heap.top_base > ram.size) {
+    return {};
+  }
+  return heap;
+}
+
+/*!
+ * Find the global, debug, and level heaps.
+ */
+std::vector<HeapCensus> find_heaps(const Ram& ram,
+                                   const SymbolMap& symbols,
+                                   const TypeSystem& type_system,
+                                   const GameVersion& game_version) {
+  std::vector<HeapCensus> result;
+  for (const char* name : {"global", "debug"}) {
+    auto it = symbols.name_to_addr.find(name);
+    if (it != symbols.name_to_addr.end()) {
+      auto heap = read_heap(ram, name, symbol_value(ram, game_version, it->second));
+      if (heap) {
+        result.push_back(*heap);
+      }
+    }
+  }
+
+  // the level heaps are inline in the levels, which are inline in *level*.
+  auto level_sym = symbols.name_to_addr.find("*level*");
+  if (level_sym == symbols.name_to_addr.end() ||
+      !type_system.fully_defined_type_exists("level-group") ||
+      !type_system.fully_defined_type_exists("level")) {
+    lg::warn("couldn't find the levels, level heaps won't be in the census");
+    return result;
+  }
+  auto group_type = dynamic_cast<StructureType*>(type_system.lookup_type("level-group"));
+  auto level_type = dynamic_cast<StructureType*>(type_system.lookup_type("level"));
+  Field levels, level_name, level_heap;
+  if (!group_type || !level_type || !group_type->lookup_field("level", &levels) ||
+      !level_type->lookup_field("name", &level_name) ||
+      !level_type->lookup_field("heap", &level_heap)) {
+    lg::warn("level types are missing fields, level heaps won't be in the census");
+    return result;
+  }
+
+  u32 group_addr = symbol_value(ram, game_version, level_sym->second) - BASIC_OFFSET;
+  int stride = align(level_type->get_size_in_memory(),
+                     level_type->get_inline_array_stride_alignment());
+  for (int i = 0; i < levels.array_size(); i++) {
+    u32 level_addr = group_addr + levels.offset() + i * stride;
+    if (!ram.word_in_memory(level_addr + level_name.offset())) {
+      continue;
+    }
+    auto name_it = symbols.addr_to_name.find(ram.word(level_addr + level_name.offset()));
+    auto name = fmt::format("level {}", name_it == symbols.addr_to_name.end() ? std::to_string(i)
+                                                                              : name_it->second);
+    auto heap = read_heap(ram, name, level_addr + level_heap.offset());
+    if (heap) {
+      result.push_back(*heap);
+    }
+  }
+  return result;
+}
+
+/*!
+ * Get the size of a basic, rounded up to the 16 bytes the heaps allocate in. Strings and arrays
+ * include their data, other types with dynamic fields are just their type's size.
+ */
+u32 object_size(const Ram& ram,
+                u32 addr,
+                u32 type_addr,
+                const std::string& type_name,
+                const std::unordered_map<u32, std::string>& types,
+                const TypeSystem& type_system) {
+  u32 type_size = ram.read<u16>(type_addr + 8);
+  u32 size = type_size;
+  if (type_name == "string" && ram.word_in_memory(addr + 4)) {
+    size += ram.word(addr + 4) + 1;
+  } else if (type_name == "array" && ram.word_in_memory(addr + 12)) {
+    u32 elt_size = 4;
+    auto content_it = types.find(ram.word(addr + 12));
+    if (content_it != types.end() && type_system.fully_defined_type_exists(content_it->second)) {
+      auto content_type = type_system.lookup_type(content_it->second);
+      if (dynamic_cast<ValueType*>(content_type)) {
+        elt_size = content_type->get_load_size();
+      }
+    }
+    size += ram.word(addr + 8) * elt_size;
+  }
+  // garbage lengths just count as the type.
+  if (size < type_size || addr + size > ram.size) {
+    size = type_size;
+  }
+  return align16(size);
+}
+
+/*!
+ * Scan memory for basics, in parallel. Tags that are inside an earlier object are skipped, as they
+ * are usually data that happens to look like a type.
+ */
+std::vector<CensusObject> scan_objects(const Ram& ram,
+                                       const std::unordered_map<u32, std::string>& types,
+                                       const TypeSystem& type_system,
+                                       int* overlapping_tags) {
+  constexpr int NUM_CHUNKS = 64;
+  const u32 start = 1 << 20;
+  const u32 chunk_size = ((ram.size - start) / NUM_CHUNKS) & ~15;
+
+  std::vector<std::vector<CensusObject>> chunks(NUM_CHUNKS);
+  SimpleThreadGroup threads;
+  threads.run(
+      [&](int chunk_idx) {
+        u32 chunk_start = start + chunk_idx * chunk_size;
+        u32 chunk_end = chunk_idx == NUM_CHUNKS - 1 ? ram.size : chunk_start + chunk_size;
+        for (u32 addr = chunk_start; addr < chunk_end; addr += 16) {
+          u32 tag = ram.word(addr);
+          auto iter = types.find(tag);
+          if (iter == types.end() ||
+              std::find(census_ignored_types.begin(), census_ignored_types.end(),
+                        iter->second) != census_ignored_types.end()) {
+            continue;
+          }
+          auto& obj = chunks[chunk_idx].emplace_back();
+          obj.addr = addr;
+          obj.type = tag;
+          obj.size = object_size(ram, addr, tag, iter->second, types, type_system);
+        }
+      },
+      NUM_CHUNKS);
+  threads.join();
+
+  std::vector<CensusObject> result;
+  u32 end_of_last = 0;
+  for (auto& chunk : chunks) {
+    for (auto& obj : chunk) {
+      if (obj.addr < end_of_last) {
+        (*overlapping_tags)++;
+        continue;
+      }
+      end_of_last = obj.addr + obj.size;
+      result.push_back(obj);
+    }
+  }
+  return result;
+}
+
+/*!
+ * Find the immediate dominator of each node, with the algorithm from "A Simple, Fast Dominance
+ * Algorithm" by Cooper, Harvey, and Kennedy. Returns -1 for nodes that can't be reached from root.
+ * The postorder of the reachable nodes is stored in postorder.
+ */
+std::vector<int> find_dominators(const std::vector<std::vector<u32>>& succs,
+                                 const std::vector<std::vector<u32>>& preds,
+                                 int root,
+                                 std::vector<int>* postorder) {
+  std::vector<int> po_idx(succs.size(), -1);
+  std::vector<bool> visited(succs.size(), false);
+  std::vector<std::pair<u32, size_t>> stack = {{root, 0}};
+  visited[root] = true;
+  while (!stack.empty()) {
+    auto& [node, next] = stack.back();
+    if (next < succs[node].size()) {
+      u32 succ = succs[node][next++];
+      if (!visited[succ]) {
+        visited[succ] = true;
+        stack.push_back({succ, 0});
+      }
+    } else {
+      po_idx[node] = postorder->size();
+      postorder->push_back(node);
+      stack.pop_back();
+    }
+  }
+
+  std::vector<int> idom(succs.size(), -1);
+  idom[root] = root;
+  auto intersect = [&](int a, int b) {
+    while (a != b) {
+      while (po_idx[a] < po_idx[b]) {
+        a = idom[a];
+      }
+      while (po_idx[b] < po_idx[a]) {
+        b = idom[b];
+      }
+    }
+    return a;
+  };
+
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (auto it = postorder->rbegin(); it != postorder->rend(); ++it) {
+      int node = *it;
+      if (node == root) {
+        continue;
+      }
+      int new_idom = -1;
+      for (auto pred : preds[node]) {
+        if (idom[pred] != -1) {
+          new_idom = new_idom == -1 ? (int)pred : intersect(pred, new_idom);
+        }
+      }
+      if (idom[node] != new_idom) {
+        idom[node] = new_idom;
+        changed = true;
+      }
+    }
+  }
+  return idom;
+}
+
+/*!
+ * Build the graph of references between objects and find the retained size of each: the bytes that
+ * would be unreachable without it. The roots are the symbols.
+ */
+void find_retained_sizes(const Ram& ram,
+                         const SymbolMap& symbols,
+                         const std::unordered_map<u32, std::string>& types,
+                         const GameVersion& game_version,
+                         Census& census) {
+  const auto& objects = census.objects;
+  auto find_object = [&](u32 ptr) -> int {
+    if ((ptr & 0x7) != BASIC_OFFSET) {
+      return -1;
+    }
+    auto it = std::lower_bound(objects.begin(), objects.end(), ptr - BASIC_OFFSET,
+                               [](const CensusObject& obj, u32 addr) { return obj.addr < addr; });
+    if (it == objects.end() || it->addr != ptr - BASIC_OFFSET) {
+      return -1;
+    }
+    return it - objects.begin();
+  };
+
+  // any word in an object that points to another object is a reference.
+  const int root = objects.size();
+  std::vector<std::vector<u32>> succs(objects.size() + 1);
+  SimpleThreadGroup threads;
+  threads.run(
+      [&](int obj_idx) {
+        const auto& obj = objects[obj_idx];
+        for (u32 addr = obj.addr + 4; addr + 4 <= obj.addr + obj.size; addr += 4) {
+          int ref = find_object(ram.word(addr));
+          if (ref >= 0 && ref != obj_idx) {
+            succs[obj_idx].push_back(ref);
+          }
+        }
+      },
+      objects.size());
+  threads.join();
+  for (const auto& [name, addr] : symbols.name_to_addr) {
+    int ref = find_object(symbol_value(ram, game_version, addr));
+    if (ref >= 0) {
+      succs[root].push_back(ref);
+    }
+  }
+
+  std::vector<std::vector<u32>> preds(succs.size());
+  size_t num_edges = 0;
+  for (size_t i = 0; i < succs.size(); i++) {
+    for (auto succ : succs[i]) {
+      preds[succ].push_back(i);
+    }
+    num_edges += succs[i].size();
+  }
+  lg::info("reference graph has {} edges", num_edges);
+
+  std::vector<int> postorder;
+  auto idom = find_dominators(succs, preds, root, &postorder);
+
+  census.retained.assign(objects.size(), 0);
+  for (auto node : postorder) {
+    if (node == root) {
+      continue;
+    }
+    census.retained[node] += objects[node].size;
+    if (idom[node] != root) {
+      census.retained[idom[node]] += census.retained[node];
+    }
+  }
+
+  for (size_t i = 0; i < objects.size(); i++) {
+    if (idom[i] == -1) {
+      auto& type = census.types.at(types.at(objects[i].type));
+      type.unreachable_count++;
+      type.unreachable_bytes += objects[i].size;
+    }
+  }
+}
+
+Census run_census(const Ram& ram,
+                  const SymbolMap& symbols,
+                  const std::unordered_map<u32, std::string>& types,
+                  const TypeSystem& type_system,
+                  const GameVersion& game_version) {
+  lg::info("Taking census of objects...");
+  Timer timer;
+  Census census;
+  census.heaps = find_heaps(ram, symbols, type_system, game_version);
+
+  // objects go in the smallest heap that has them, so level heaps win over the global heap.
+  std::vector<int> heap_order(census.heaps.size());
+  for (size_t i = 0; i < heap_order.size(); i++) {
+    heap_order[i] = i;
+  }
+  std::sort(heap_order.begin(), heap_order.end(),
+            [&](int a, int b) { return census.heaps[a].size() < census.heaps[b].size(); });
+
+  for (auto& obj : scan_objects(ram, types, type_system, &census.overlapping_tags)) {
+    for (auto heap_idx : heap_order) {
+      if (census.heaps[heap_idx].contains(obj.addr)) {
+        obj.heap = heap_idx;
+        break;
+      }
+    }
+    if (obj.heap >= 0) {
+      auto& heap = census.heaps[obj.heap];
+      if (heap.in_free_space(obj.addr)) {
+        heap.stale_count++;
+        continue;
+      }
+      heap.object_count++;
+      heap.object_bytes += obj.size;
+    }
+    auto& type = census.types[types.at(obj.type)];
+    type.count++;
+    type.bytes += obj.size;
+    census.objects.push_back(obj);
+  }
+
+  find_retained_sizes(ram, symbols, types, game_version, census);
+  lg::info("Census of {} objects took {:.2f} s", census.objects.size(), timer.getSeconds());
+  return census;
+}
+
+void print_census(const Census& census, const std::unordered_map<u32, std::string>& types) {
+  u64 total_bytes = 0;
+  for (const auto& obj : census.objects) {
+    total_bytes += obj.size;
+  }
+  fmt::print("Census: {} objects, {} KB ({} tags inside other objects were skipped)\n\n",
+             census.objects.size(), total_bytes / 1024, census.overlapping_tags);
+
+  // "other" is used heap space that isn't in a basic: structures, process heaps, and so on.
+  fmt::print("{:24s} {:>9s} {:>9s} {:>9s} {:>9s} {:>9s} {:>9s} {:>6s}\n", "heap", "size KB",
+             "used KB", "free KB", "objects", "obj KB", "other KB", "stale");
+  for (const auto& heap : census.heaps) {
+    fmt::print("{:24s} {:>9} {:>9} {:>9} {:>9} {:>9} {:>9} {:>6}\n", heap.name, heap.size() / 1024,
+               heap.used() / 1024, heap.free() / 1024, heap.object_count, heap.object_bytes / 1024,
+               ((s64)heap.used() - (s64)heap.object_bytes) / 1024, heap.stale_count);
+  }
+
+  std::vector<std::string> sorted_type_names;
+  for (const auto& [name, type] : census.types) {
+    sorted_type_names.push_back(name);
+  }
+  std::sort(sorted_type_names.begin(), sorted_type_names.end(), [&](const auto& a, const auto& b) {
+    return census.types.at(a).bytes > census.types.at(b).bytes;
+  });
+  sorted_type_names.resize(std::min(sorted_type_names.size(), size_t(40)));
+  fmt::print("\n{:40s} {:>9s} {:>9s} {:>12s} {:>16s}\n", "type", "count", "KB", "unreachable",
+             "unreachable KB");
+  for (const auto& name : sorted_type_names) {
+    const auto& type = census.types.at(name);
+    fmt::print("{:40s} {:>9} {:>9} {:>12} {:>16}\n", name, type.count, type.bytes / 1024,
+               type.unreachable_count, type.unreachable_bytes / 1024);
+  }
+
+  std::vector<size_t> largest(census.objects.size());
+  for (size_t i = 0; i < largest.size(); i++) {
+    largest[i] = i;
+  }
+  size_t num_largest = std::min(largest.size(), size_t(20));
+  std::partial_sort(largest.begin(), largest.begin() + num_largest, largest.end(),
+                    [&](size_t a, size_t b) { return census.retained[a] > census.retained[b]; });
+  fmt::print("\n{:10s} {:40s} {:24s} {:>11s}\n", "address", "type", "heap", "retained KB");
+  for (size_t i = 0; i < num_largest; i++) {
+    const auto& obj = census.objects[largest[i]];
+    fmt::print("#x{:08x} {:40s} {:24s} {:>11}\n", obj.addr + BASIC_OFFSET, types.at(obj.type),
+               obj.heap >= 0 ? census.heaps[obj.heap].name : "-",
+               census.retained[largest[i]] / 1024);
+  }
+}
+
+void print_census_diff(const Census& before, const Census& after) {
+  fmt::print("{:24s} {:>10s} {:>10s} {:>10s} {:>10s}\n", "heap", "used KB", "free KB", "objects",
+             "obj KB");
+  for (const auto& heap : after.heaps) {
+    auto it = std::find_if(before.heaps.begin(), before.heaps.end(),
+                           [&](const HeapCensus& h) { return h.name == heap.name; });
+    if (it == before.heaps.end()) {
+      fmt::print("{:24s} (new)\n", heap.name);
+      continue;
+    }
+    fmt::print("{:24s} {:>+10} {:>+10} {:>+10} {:>+10}\n", heap.name,
+               ((s64)heap.used() - (s64)it->used()) / 1024,
+               ((s64)heap.free() - (s64)it->free()) / 1024, heap.object_count - it->object_count,
+               ((s64)heap.object_bytes - (s64)it->object_bytes) / 1024);
+  }
+
+  struct TypeDiff {
+    std::string name;
+    s64 count = 0;
+    s64 bytes = 0;
+    s64 unreachable_count = 0;
+  };
+  std::map<std::string, TypeDiff> diffs;
+  for (const auto& [name, type] : after.types) {
+    auto& diff = diffs[name];
+    diff.count += type.count;
+    diff.bytes += type.bytes;
+    diff.unreachable_count += type.unreachable_count;
+  }
+  for (const auto& [name, type] : before.types) {
+    auto& diff = diffs[name];
+    diff.count -= type.count;
+    diff.bytes -= type.bytes;
+    diff.unreachable_count -= type.unreachable_count;
+  }
+  std::vector<TypeDiff> sorted;
+  for (auto& [name, diff] : diffs) {
+    if (diff.count || diff.bytes) {
+      diff.name = name;
+      sorted.push_back(diff);
+    }
+  }
+  std::sort(sorted.begin(), sorted.end(), [](const TypeDiff& a, const TypeDiff& b) {
+    return std::abs(a.bytes) > std::abs(b.bytes);
+  });
+  sorted.resize(std::min(sorted.size(), size_t(40)));
+  fmt::print("\n{:40s} {:>10s} {:>10s} {:>12s}\n", "type", "count", "KB", "unreachable");
+  for (const auto& diff : sorted) {
+    fmt::print("{:40s} {:>+10} {:>+10} {:>+12}\n", diff.name, diff.count, diff.bytes / 1024,
+               diff.unreachable_count);
+  }
+}
+
+nlohmann::json census_to_json(const Census& census) {
+  nlohmann::json result;
+  for (const auto& heap : census.heaps) {
+    auto& h = result["heaps"][heap.name];
+    h["size"] = heap.size();
+    h["used"] = heap.used();
+    h["free"] = heap.free();
+    h["objects"] = heap.object_count;
+    h["object-bytes"] = heap.object_bytes;
+    h["stale-objects"] = heap.stale_count;
+  }
+  for (const auto& [name, type] : census.types) {
+    auto& t = result["types"][name];
+    t["count"] = type.count;
+    t["bytes"] = type.bytes;
+    t["unreachable-count"] = type.unreachable_count;
+    t["unreachable-bytes"] = type.unreachable_bytes;
+  }
+  return result;
+}
+
+/*!
+ * Read a dump, adding the first MB if it's missing.
+ */
+std::optional<std::vector<u8>> load_dump(const fs::path& dump_path) {
+  if (dump_path.extension() == "p2s") {
+    lg::error("PCSX2 savestates are not directly supported. Please extract contents beforehand");
+    return {};
+  }
+
+  lg::info("Loading memory from '{}'", dump_path.string());
+  auto data = file_util::read_binary_file(dump_path);
+
+  u32 one_mb = (1 << 20);
+
+  if (data.size() == 32 * one_mb) {
+    lg::info("Got 32MB file");
+  } else if (data.size() == 128 * one_mb) {
+    lg::info("Got 128MB file");
+  } else if (data.size() == 127 * one_mb) {
+    lg::warn("Got a 127MB file. Assuming this is a dump with the first 1 MB missing.\n");
+    data.insert(data.begin(), one_mb, 0);
+    if (data.size() != 128 * one_mb) {
+      lg::error("it was not!");
+      return {};
+    }
+  } else {
+    lg::error("Invalid size: {} bytes", data.size());
+    return {};
+  }
+  return data;
+}
+
+std::optional<Census> census_dump(const fs::path& dump_path,
+                                  const GameVersion& game_version,
+                                  const TypeSystem& type_system,
+                                  const fs::path& json_path) {
+  auto data = load_dump(dump_path);
+  if (!data) {
+    return {};
+  }
+  Ram ram(data->data(), data->size());
+  u32 s7 = scan_for_symbol_table(ram, game_version, 1 << 20, 2 << 20);
+  if (!s7) {
+    lg::error("Failed to find symbol table");
+    return {};
+  }
+  auto symbol_map = build_symbol_map(game_version, ram, s7);
+  auto types = build_type_map(ram, symbol_map, game_version, s7);
+  auto census = run_census(ram, symbol_map, types, type_system, game_version);
+  print_census(census, types);
+
+  std::ofstream o(json_path);
+  o << std::setw(2) << census_to_json(census) << std::endl;
+  lg::info("Wrote census to {}", json_path.string());
+  return census;
+}
+
 int main(int argc, char** argv) {
   ArgumentGuard u8_guard(argc, argv);
 
   fs::path dump_path;
   fs::path output_path;
+  fs::path diff_path;
   std::string game_name = "jak1";
+  bool census = false;
 
   lg::initialize();
 
@@ -620,6 +1202,10 @@ int main(int argc, char** argv) {
   app.add_option("--output-path", output_path,
                  "Where the output files should be sent, defaults to current directory otherwise");
   app.add_option("-g,--game", game_name, "Specify the game name, defaults to 'jak1'");
+  app.add_flag("--census", census,
+               "Count the objects of each type in each heap, and find what keeps them alive");
+  app.add_option("--diff-with", diff_path,
+                 "Take a census of this earlier dump too, and print what changed since it");
   app.validate_positionals();
   CLI11_PARSE(app, argc, argv);
 
@@ -634,9 +1220,8 @@ int main(int argc, char** argv) {
 
   decompiler::DecompilerTypeSystem dts(game_version);
 
-  // TODO - this could be better (have a `jak1` folder)
   if (game_version == GameVersion::Jak1) {
-    dts.parse_type_defs({"decompiler", "config", "all-types.gc"});
+    dts.parse_type_defs({"decompiler", "config", "jak1", "all-types.gc"});
   } else if (game_version == GameVersion::Jak2) {
     dts.parse_type_defs({"decompiler", "config", "jak2", "all-types.gc"});
   } else {
@@ -644,40 +1229,41 @@ int main(int argc, char** argv) {
     return 1;
   }
 
-  fs::path output_folder;
+  fs::path output_folder = output_path;
 
   if (output_folder.empty() || !fs::exists(output_folder)) {
     lg::warn("Output folder not found or not provided, defaulting to current directory");
     output_folder = "./";
   }
 
-  if (dump_path.extension() == "p2s") {
-    lg::error("PCSX2 savestates are not directly supported. Please extract contents beforehand");
-    return 1;
-  }
-
-  lg::info("Loading memory from '{}'", dump_path.string());
-  auto data = file_util::read_binary_file(dump_path);
-
-  u32 one_mb = (1 << 20);
-
-  if (data.size() == 32 * one_mb) {
-    lg::info("Got 32MB file");
-  } else if (data.size() == 128 * one_mb) {
-    lg::info("Got 128MB file");
-  } else if (data.size() == 127 * one_mb) {
-    lg::warn("Got a 127MB file. Assuming this is a dump with the first 1 MB missing.\n");
-    data.insert(data.begin(), one_mb, 0);
-    if (data.size() != 128 * one_mb) {
-      lg::error("it was not!");
+  if (census || !diff_path.empty()) {
+    std::optional<Census> before;
+    if (!diff_path.empty()) {
+      before = census_dump(diff_path, game_version, dts.ts,
+                           output_folder / fmt::format("census-before-{}.json", game_name));
+      if (!before) {
+        return 1;
+      }
+    }
+    auto after = census_dump(dump_path, game_version, dts.ts,
+                             output_folder / fmt::format("census-{}.json", game_name));
+    if (!after) {
       return 1;
     }
-  } else {
-    lg::error("Invalid size: {} bytes", data.size());
+    if (before) {
+      fmt::print("\nChanges since {}:\n", diff_path.string());
+      print_census_diff(*before, *after);
+    }
+    return 0;
+  }
+
+  auto data = load_dump(dump_path);
+  if (!data) {
     return 1;
   }
 
-  Ram ram(data.data(), data.size());
+  u32 one_mb = (1 << 20);
+  Ram ram(data->data(), data->size());
 
   u32 s7 = scan_for_symbol_table(ram, game_version, one_mb, 2 * one_mb);
   if (!s7) {
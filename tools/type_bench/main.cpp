@@ -0,0 +1,133 @@
+// Benchmark for the type system queries that the decompiler's type analysis and the compiler make
+// most: typecheck, lowest_common_ancestor and TypeSpec copies between every pair of a sample of
+// the types in a game's all-types.gc, then reverse field lookups at every offset of each
+// structure. The first run is with empty query caches, the later runs reuse them. It only uses the
+// TypeSystem interface, so it can be built on older trees to compare.
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "common/log/log.h"
+#include "common/util/FileUtil.h"
+#include "common/util/Timer.h"
+#include "common/util/unicode_util.h"
+
+#include "decompiler/util/DecompilerTypeSystem.h"
+
+#include "fmt/core.h"
+#include "third-party/CLI11.hpp"
+
+namespace {
+/*!
+ * Run typecheck, lowest_common_ancestor, a copy and a compare on pairs of types. Returns the number
+ * of pairs, and adds a result to sink so the work isn't optimized out.
+ */
+int run_pair_queries(const TypeSystem& ts, const std::vector<TypeSpec>& types, u64& sink) {
+  int count = 0;
+  for (size_t i = 0; i < types.size(); i += 3) {
+    for (size_t j = 0; j < types.size(); j += 5) {
+      sink += ts.tc(types[i], types[j]);
+      sink += ts.lowest_common_ancestor(types[i], types[j]).arg_count();
+      TypeSpec copy = types[j];
+      sink += copy == types[i];
+      count++;
+    }
+  }
+  return count;
+}
+
+/*!
+ * Look up a 4 byte load at every word of each structure, up to 256 bytes in.
+ */
+int run_reverse_lookups(const TypeSystem& ts, const std::vector<std::string>& names, u64& sink) {
+  int count = 0;
+  for (const auto& name : names) {
+    auto* type = dynamic_cast<StructureType*>(ts.lookup_type_no_throw(name));
+    if (!type || type->is_dynamic()) {
+      continue;
+    }
+    const int size = std::min(256, type->get_size_in_memory());
+    for (int offset = 0; offset < size; offset += 4) {
+      FieldReverseLookupInput input;
+      input.base_type = ts.make_pointer_typespec(name);
+      input.offset = offset;
+      DerefKind deref;
+      deref.size = 4;
+      deref.is_store = false;
+      deref.sign_extend = false;
+      deref.reg_kind = RegClass::GPR_64;
+      input.deref = deref;
+      sink += ts.reverse_field_lookup(input).success;
+      count++;
+    }
+  }
+  return count;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  ArgumentGuard u8_guard(argc, argv);
+
+  std::string game_name = "jak1";
+  int num_runs = 3;
+
+  lg::initialize();
+
+  CLI::App app{"OpenGOAL Type System Benchmark"};
+  app.add_option("-g,--game", game_name, "Specify the game name, defaults to 'jak1'");
+  app.add_option("-n,--runs", num_runs, "Number of runs, defaults to 3");
+  app.validate_positionals();
+  CLI11_PARSE(app, argc, argv);
+
+  auto ok = file_util::setup_project_path({});
+  if (!ok) {
+    lg::error("couldn't setup project path, exiting");
+    return 1;
+  }
+  if (!valid_game_version(game_name)) {
+    lg::error("unsupported game version {}", game_name);
+    return 1;
+  }
+
+  decompiler::DecompilerTypeSystem dts(game_name_to_version(game_name));
+  dts.parse_type_defs({"decompiler", "config", game_name, "all-types.gc"});
+
+  auto names = dts.ts.get_all_type_names();
+  std::sort(names.begin(), names.end());
+  std::vector<TypeSpec> types;
+  for (const auto& name : names) {
+    if (dts.ts.fully_defined_type_exists(name)) {
+      types.emplace_back(name);
+    }
+  }
+  // and some types with arguments, including pointers to these.
+  for (size_t i = 0; i < types.size(); i += 7) {
+    TypeSpec pointer("pointer", {types[i]});
+    types.push_back(pointer);
+  }
+  fmt::print("{} types\n", types.size());
+
+  u64 sink = 0;
+  for (int run = 0; run < num_runs; run++) {
+    Timer timer;
+    int num_pairs = 0;
+    for (int pass = 0; pass < 4; pass++) {
+      num_pairs += run_pair_queries(dts.ts, types, sink);
+    }
+    const double pairs_ms = timer.getMs();
+
+    timer.start();
+    int num_lookups = 0;
+    for (int pass = 0; pass < 4; pass++) {
+      num_lookups += run_reverse_lookups(dts.ts, names, sink);
+    }
+    const double lookups_ms = timer.getMs();
+
+    fmt::print("run {}: typecheck/lca/copy of {} pairs in {:.1f} ms, ", run, num_pairs, pairs_ms);
+    fmt::print("{} reverse lookups in {:.1f} ms\n", num_lookups, lookups_ms);
+  }
+  // print this so the queries aren't optimized out.
+  fmt::print("({})\n", sink);
+  return 0;
+}